@@ -42,6 +42,8 @@
 #include <wicked/util.h>
 
 #include "netinfo_priv.h"
+#include "util_priv.h"
+#include "json.h"
 
 struct arp_ops;
 
@@ -423,31 +425,27 @@ do_arp_verify_send(struct arp_handle *handle)
 	return ret;
 }
 
-static void
-do_arp_verify_recv(struct arp_handle *handle, const ni_arp_packet_t *pkt)
+/*
+ * Check if an arp reply from another host reports the address in use
+ */
+static ni_bool_t
+do_arp_verify_conflict(const char *ifname, ni_arp_socket_t *sock,
+			const ni_arp_packet_t *pkt)
 {
 	ni_netconfig_t *nc = ni_global_state_handle(0);
-	ni_arp_socket_t *sock = handle->sock;
 	const ni_netdev_t *ifp;
 	ni_bool_t false_alarm = FALSE;
 	ni_bool_t found_addr = FALSE;
 	const ni_address_t *ap;
 	ni_sockaddr_t addr;
 
-	/* Is it about the address we're validating at all? */
-	if (pkt->sip.s_addr != handle->ipaddr.sin.sin_addr.s_addr) {
-		ni_debug_application("%s: report about different address",
-				handle->ifname);
-		return;
-	}
-
 	/* Ignore any ARP replies that seem to come from our own
 	 * MAC address. Some helpful switches seem to generate
 	 * these. */
 	if (ni_link_address_equal(&sock->dev_info.hwaddr, &pkt->sha)) {
 		ni_debug_application("%s: adress in use by ourself",
-				handle->ifname);
-		return;
+				ifname);
+		return FALSE;
 	}
 
 	/* As well as ARP replies that seem to come from our own
@@ -480,13 +478,28 @@ do_arp_verify_recv(struct arp_handle *handle, const ni_arp_packet_t *pkt)
 	}
 	if (false_alarm && !found_addr) {
 		ni_debug_application("%s: reply from one of our interfaces",
-				handle->ifname);
-		return;
+				ifname);
+		return FALSE;
 	}
 
 	ni_debug_application("%s: IP address %s in use reported by %s",
-			handle->ifname, inet_ntoa(pkt->sip),
+			ifname, inet_ntoa(pkt->sip),
 			ni_link_address_print(&pkt->sha));
+	return TRUE;
+}
+
+static void
+do_arp_verify_recv(struct arp_handle *handle, const ni_arp_packet_t *pkt)
+{
+	/* Is it about the address we're validating at all? */
+	if (pkt->sip.s_addr != handle->ipaddr.sin.sin_addr.s_addr) {
+		ni_debug_application("%s: report about different address",
+				handle->ifname);
+		return;
+	}
+
+	if (!do_arp_verify_conflict(handle->ifname, handle->sock, pkt))
+		return;
 
 	handle->hwaddr = pkt->sha;
 	do_arp_handle_close(handle);
@@ -1021,6 +1034,663 @@ do_arp_ping_status(struct arp_handle *handle, int status)
 	return status;
 }
 
+/*
+ * sweep
+ *
+ * Runs ping and verify checks for a list of (interface, mode, target)
+ * tuples concurrently: one arp socket per interface is shared by all
+ * targets on it and a single timer drives the send rounds of all the
+ * targets. The results are reported as one JSON array.
+ */
+enum arp_sweep_mode {
+	ARP_SWEEP_PING,
+	ARP_SWEEP_VERIFY,
+};
+
+struct arp_sweep_link;
+
+struct arp_sweep_target {
+	struct arp_sweep_target *	next;
+	struct arp_sweep_target *	link_next;
+	struct arp_sweep_link *		link;
+
+	enum arp_sweep_mode		mode;
+	ni_sockaddr_t			ipaddr;
+	ni_sockaddr_t			fromip;
+	ni_hwaddr_t			hwaddr;
+	const char *			error;
+	ni_bool_t			done;
+
+	unsigned int			sent_cnt;
+	unsigned int			recv_cnt;
+	struct timeval			sent_time;
+	struct timeval			last_time;
+
+	unsigned long			rtt_min;
+	unsigned long			rtt_max;
+	unsigned long			rtt_sum;
+};
+
+struct arp_sweep_link {
+	struct arp_sweep_link *		next;
+	struct arp_sweep *		sweep;
+	char *				ifname;
+	ni_arp_socket_t *		sock;
+	struct arp_sweep_target *	targets;
+};
+
+struct arp_sweep {
+	unsigned int			count;
+	unsigned int			interval;
+	unsigned int			replies;
+	unsigned int			deadline;
+
+	struct arp_sweep_link *		links;
+	struct arp_sweep_target *	targets;
+	struct arp_sweep_target **	tail;
+	unsigned int			pending;
+
+	const ni_timer_t *		timer;
+	const ni_timer_t *		deadline_timer;
+};
+
+static const char *
+do_arp_sweep_mode_name(enum arp_sweep_mode mode)
+{
+	return mode == ARP_SWEEP_VERIFY ? "verify" : "ping";
+}
+
+static struct arp_sweep_link *
+do_arp_sweep_link(struct arp_sweep *sweep, const char *ifname)
+{
+	struct arp_sweep_link *link, **pos;
+
+	for (pos = &sweep->links; (link = *pos); pos = &link->next) {
+		if (ni_string_eq(link->ifname, ifname))
+			return link;
+	}
+
+	link = xcalloc(1, sizeof(*link));
+	ni_string_dup(&link->ifname, ifname);
+	link->sweep = sweep;
+	*pos = link;
+	return link;
+}
+
+static ni_bool_t
+do_arp_sweep_add(struct arp_sweep *sweep, const char *ifname,
+		const char *mode, const char *ipaddr)
+{
+	struct arp_sweep_target *target;
+	struct arp_sweep_link *link;
+	ni_sockaddr_t addr;
+
+	if (ni_string_empty(ifname)) {
+		ni_error("sweep: empty interface name");
+		return FALSE;
+	}
+	if (ni_sockaddr_parse(&addr, ipaddr, AF_INET) != 0) {
+		ni_error("sweep: cannot parse '%s' as IPv4 address", ipaddr);
+		return FALSE;
+	}
+
+	target = xcalloc(1, sizeof(*target));
+	if (ni_string_eq(mode, "ping")) {
+		target->mode = ARP_SWEEP_PING;
+	} else
+	if (ni_string_eq(mode, "verify") || ni_string_eq(mode, "probe")) {
+		target->mode = ARP_SWEEP_VERIFY;
+	} else {
+		ni_error("sweep: unsupported mode '%s'", mode);
+		free(target);
+		return FALSE;
+	}
+	target->ipaddr = addr;
+
+	link = do_arp_sweep_link(sweep, ifname);
+	target->link = link;
+	target->link_next = link->targets;
+	link->targets = target;
+
+	*sweep->tail = target;
+	sweep->tail = &target->next;
+	return TRUE;
+}
+
+/*
+ * Read "<ifname> <mode> <IP address>" lines; empty lines
+ * and lines starting with a '#' are ignored.
+ */
+static ni_bool_t
+do_arp_sweep_read(struct arp_sweep *sweep, const char *filename)
+{
+	char line[512], *ifname, *mode, *ipaddr, *rest;
+	unsigned int lineno = 0;
+	ni_bool_t ret = TRUE;
+	FILE *fp;
+
+	if (ni_string_eq(filename, "-")) {
+		fp = stdin;
+	} else
+	if (!(fp = fopen(filename, "r"))) {
+		ni_error("sweep: unable to open %s: %m", filename);
+		return FALSE;
+	}
+
+	while (ret && fgets(line, sizeof(line), fp)) {
+		lineno++;
+		if (!(ifname = strtok(line, " \t\r\n")) || *ifname == '#')
+			continue;
+
+		mode   = strtok(NULL, " \t\r\n");
+		ipaddr = strtok(NULL, " \t\r\n");
+		rest   = strtok(NULL, " \t\r\n");
+		if (!mode || !ipaddr || (rest && *rest != '#')) {
+			ni_error("sweep: %s:%u: expected <ifname> <mode> <IP address>",
+					filename, lineno);
+			ret = FALSE;
+		} else {
+			ret = do_arp_sweep_add(sweep, ifname, mode, ipaddr);
+		}
+	}
+
+	if (fp != stdin)
+		fclose(fp);
+	return ret;
+}
+
+static void
+do_arp_sweep_target_done(struct arp_sweep_target *target, const char *error)
+{
+	if (target->done)
+		return;
+
+	target->done = TRUE;
+	target->error = error;
+	target->link->sweep->pending--;
+}
+
+static void
+do_arp_sweep_recv(ni_arp_socket_t *sock, const ni_arp_packet_t *pkt, void *user_data)
+{
+	struct arp_sweep_link *link = user_data;
+	struct arp_sweep_target *target;
+	struct arp_sweep *sweep = link->sweep;
+	struct timeval now, delta;
+	unsigned long rtt;
+
+	if (!sock || !pkt || pkt->op != ARPOP_REPLY)
+		return;
+
+	ni_timer_get_time(&now);
+	for (target = link->targets; target; target = target->link_next) {
+		if (target->done || !target->sent_cnt)
+			continue;
+		if (target->ipaddr.sin.sin_addr.s_addr != pkt->sip.s_addr)
+			continue;
+
+		if (target->mode == ARP_SWEEP_VERIFY) {
+			if (!do_arp_verify_conflict(link->ifname, sock, pkt))
+				continue;
+
+			target->hwaddr = pkt->sha;
+			do_arp_sweep_target_done(target, NULL);
+			continue;
+		}
+
+		/* ping replies are matched to the last request sent */
+		if (!timerisset(&target->sent_time))
+			continue;
+
+		if (timercmp(&now, &target->sent_time, >))
+			timersub(&now, &target->sent_time, &delta);
+		else
+			timerclear(&delta);
+		timerclear(&target->sent_time);
+
+		rtt = delta.tv_sec * 1000000UL + delta.tv_usec;
+		if (!target->recv_cnt || rtt < target->rtt_min)
+			target->rtt_min = rtt;
+		if (rtt > target->rtt_max)
+			target->rtt_max = rtt;
+		target->rtt_sum += rtt;
+		target->hwaddr = pkt->sha;
+		target->recv_cnt++;
+
+		if (target->recv_cnt >= sweep->replies)
+			do_arp_sweep_target_done(target, NULL);
+	}
+}
+
+static ni_bool_t
+do_arp_sweep_send(struct arp_sweep_target *target, const struct timeval *now)
+{
+	static const struct in_addr null = { 0 };
+	struct in_addr from;
+
+	from = target->mode == ARP_SWEEP_VERIFY ? null : target->fromip.sin.sin_addr;
+	if (ni_arp_send_request(target->link->sock, from, target->ipaddr.sin.sin_addr) <= 0)
+		return FALSE;
+
+	do {
+		target->sent_cnt++;
+	} while (!target->sent_cnt);
+	target->sent_time = *now;
+	target->last_time = *now;
+	return TRUE;
+}
+
+/*
+ * One send round: every pending target sends its next request or,
+ * when all requests are sent, is done after waiting one interval
+ * for the last reply.
+ */
+static void
+do_arp_sweep_round(void *user_data, const ni_timer_t *timer)
+{
+	struct arp_sweep *sweep = user_data;
+	struct arp_sweep_target *target;
+	struct timeval now;
+
+	ni_assert(sweep && sweep->timer == timer);
+	sweep->timer = NULL;
+
+	ni_timer_get_time(&now);
+	for (target = sweep->targets; target; target = target->next) {
+		if (target->done)
+			continue;
+
+		if (target->sent_cnt >= sweep->count) {
+			do_arp_sweep_target_done(target, NULL);
+			continue;
+		}
+
+		timerclear(&target->sent_time);
+		if (!do_arp_sweep_send(target, &now))
+			do_arp_sweep_target_done(target, "cannot send arp request");
+	}
+
+	if (sweep->pending)
+		sweep->timer = ni_timer_register(sweep->interval, do_arp_sweep_round, sweep);
+}
+
+static void
+do_arp_sweep_deadline(void *user_data, const ni_timer_t *timer)
+{
+	struct arp_sweep *sweep = user_data;
+	struct arp_sweep_target *target;
+
+	ni_assert(sweep && sweep->deadline_timer == timer);
+	sweep->deadline_timer = NULL;
+
+	for (target = sweep->targets; target; target = target->next)
+		do_arp_sweep_target_done(target, NULL);
+}
+
+static void
+do_arp_sweep_source(struct arp_sweep_target *target, const ni_netdev_t *dev)
+{
+	const ni_address_t *ap;
+
+	for (ap = dev->addrs; ap; ap = ap->next) {
+		if (ap->family != AF_INET)
+			continue;
+
+		if (ni_sockaddr_prefix_match(ap->prefixlen, &ap->local_addr, &target->ipaddr)) {
+			ni_sockaddr_set_ipv4(&target->fromip, ap->local_addr.sin.sin_addr, 0);
+			return;
+		}
+		if (target->fromip.ss_family != AF_INET)
+			ni_sockaddr_set_ipv4(&target->fromip, ap->local_addr.sin.sin_addr, 0);
+	}
+	target->fromip.ss_family = AF_INET;
+}
+
+static void
+do_arp_sweep_link_fail(struct arp_sweep_link *link, const char *error)
+{
+	struct arp_sweep_target *target;
+
+	ni_debug_application("%s: %s", link->ifname, error);
+	for (target = link->targets; target; target = target->link_next)
+		do_arp_sweep_target_done(target, error);
+}
+
+static void
+do_arp_sweep_link_open(struct arp_sweep_link *link, ni_netconfig_t *nc)
+{
+	struct arp_sweep_target *target;
+	ni_capture_devinfo_t dev_info;
+	ni_netdev_t *dev;
+
+	if (!(dev = ni_netdev_by_name(nc, link->ifname))) {
+		do_arp_sweep_link_fail(link, "interface not found");
+		return;
+	}
+	if (!ni_netdev_supports_arp(dev)) {
+		do_arp_sweep_link_fail(link, "arp is not supported/enabled");
+		return;
+	}
+	if (!ni_netdev_link_is_up(dev)) {
+		do_arp_sweep_link_fail(link, "link is not up");
+		return;
+	}
+	if (ni_capture_devinfo_init(&dev_info, dev->name, &dev->link) < 0) {
+		do_arp_sweep_link_fail(link, "cannot initialize capture");
+		return;
+	}
+	if (!(link->sock = ni_arp_socket_open(&dev_info, do_arp_sweep_recv, link))) {
+		do_arp_sweep_link_fail(link, "cannot initialize arp socket");
+		return;
+	}
+
+	for (target = link->targets; target; target = target->link_next) {
+		if (target->mode == ARP_SWEEP_PING)
+			do_arp_sweep_source(target, dev);
+	}
+}
+
+static ni_json_t *
+do_arp_sweep_target_json(const struct arp_sweep_target *target)
+{
+	ni_json_t *object = ni_json_new_object();
+	const char *result;
+
+	ni_json_object_set(object, "interface", ni_json_new_string(target->link->ifname));
+	ni_json_object_set(object, "mode", ni_json_new_string(do_arp_sweep_mode_name(target->mode)));
+	ni_json_object_set(object, "target", ni_json_new_string(ni_sockaddr_print(&target->ipaddr)));
+
+	if (target->error)
+		result = "error";
+	else
+	if (target->mode == ARP_SWEEP_VERIFY)
+		result = target->hwaddr.len ? "in-use" : "free";
+	else
+		result = target->recv_cnt ? "reachable" : "unreachable";
+	ni_json_object_set(object, "result", ni_json_new_string(result));
+	if (target->error)
+		ni_json_object_set(object, "error", ni_json_new_string(target->error));
+
+	ni_json_object_set(object, "sent", ni_json_new_int64(target->sent_cnt));
+	if (target->mode == ARP_SWEEP_PING)
+		ni_json_object_set(object, "received", ni_json_new_int64(target->recv_cnt));
+	if (target->hwaddr.len)
+		ni_json_object_set(object, "hwaddr",
+				ni_json_new_string(ni_link_address_print(&target->hwaddr)));
+	if (target->recv_cnt) {
+		ni_json_object_set(object, "rtt-min", ni_json_new_double(target->rtt_min / 1000.0));
+		ni_json_object_set(object, "rtt-avg", ni_json_new_double(target->rtt_sum / 1000.0 /
+								target->recv_cnt));
+		ni_json_object_set(object, "rtt-max", ni_json_new_double(target->rtt_max / 1000.0));
+	}
+	return object;
+}
+
+static int
+do_arp_sweep_status(const struct arp_sweep *sweep, ni_bool_t verbose)
+{
+	const struct arp_sweep_target *target;
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	int status = NI_WICKED_RC_SUCCESS;
+	ni_json_t *results;
+
+	results = ni_json_new_array();
+	for (target = sweep->targets; target; target = target->next) {
+		ni_json_array_append(results, do_arp_sweep_target_json(target));
+
+		if (target->error)
+			status = NI_WICKED_RC_ERROR;
+		else
+		if (status == NI_WICKED_RC_ERROR)
+			continue;
+		else
+		if (target->mode == ARP_SWEEP_VERIFY && target->hwaddr.len)
+			status = NI_WICKED_RC_NOT_ALLOWED;
+		else
+		if (status == NI_WICKED_RC_NOT_ALLOWED)
+			continue;
+		else
+		if (target->mode == ARP_SWEEP_PING && !target->recv_cnt)
+			status = NI_WICKED_RC_NOT_RUNNING;
+	}
+
+	if (verbose && ni_json_format_string(&buf, results, NULL)) {
+		fprintf(stdout, "%s\n", buf.string);
+		fflush(stdout);
+	}
+	ni_stringbuf_destroy(&buf);
+	ni_json_free(results);
+	return status;
+}
+
+static void
+do_arp_sweep_destroy(struct arp_sweep *sweep)
+{
+	struct arp_sweep_target *target;
+	struct arp_sweep_link *link;
+
+	if (sweep->timer) {
+		ni_timer_cancel(sweep->timer);
+		sweep->timer = NULL;
+	}
+	if (sweep->deadline_timer) {
+		ni_timer_cancel(sweep->deadline_timer);
+		sweep->deadline_timer = NULL;
+	}
+	while ((link = sweep->links)) {
+		sweep->links = link->next;
+		if (link->sock)
+			ni_arp_socket_close(link->sock);
+		ni_string_free(&link->ifname);
+		free(link);
+	}
+	while ((target = sweep->targets)) {
+		sweep->targets = target->next;
+		free(target);
+	}
+	sweep->tail = &sweep->targets;
+}
+
+static int
+do_arp_sweep_run(struct arp_sweep *sweep, ni_bool_t verbose)
+{
+	struct arp_sweep_target *target;
+	struct arp_sweep_link *link;
+	ni_netconfig_t *nc;
+
+	nc = ni_global_state_handle(0);
+	ni_netconfig_set_family_filter(nc, AF_INET);
+	ni_netconfig_set_discover_filter(nc,
+			NI_NETCONFIG_DISCOVER_LINK_EXTERN |
+			NI_NETCONFIG_DISCOVER_ROUTE_RULES);
+
+	if (!(nc = ni_global_state_handle(1))) {
+		ni_error("Cannot refresh interface list!");
+		return NI_WICKED_RC_ERROR;
+	}
+
+	for (target = sweep->targets; target; target = target->next)
+		sweep->pending++;
+
+	for (link = sweep->links; link; link = link->next)
+		do_arp_sweep_link_open(link, nc);
+
+	if (sweep->deadline)
+		sweep->deadline_timer = ni_timer_register(sweep->deadline,
+						do_arp_sweep_deadline, sweep);
+
+	/* the first round is sent immediately */
+	sweep->timer = ni_timer_register(0, do_arp_sweep_round, sweep);
+
+	while (!ni_caught_terminal_signal()) {
+		long timeout;
+
+		/* expired timers run here and may finish the sweep */
+		timeout = ni_timer_next_timeout();
+		if (!sweep->pending)
+			break;
+		if (ni_socket_wait(timeout) != 0)
+			break;
+	}
+
+	return do_arp_sweep_status(sweep, verbose);
+}
+
+static int
+do_arp_sweep(const char *caller, int argc, char **argv, ni_bool_t verbose)
+{
+	enum {
+		OPT_QUIET, OPT_VERBOSE, OPT_HELP, OPT_INTERVAL, OPT_COUNT,
+		OPT_TIMEOUT, OPT_REPLIES, OPT_FILE
+	};
+	static struct option      options[] = {
+		{ "help",         no_argument,       NULL, OPT_HELP        },
+		{ "quiet",        no_argument,       NULL, OPT_QUIET       },
+		{ "verbose",      no_argument,       NULL, OPT_VERBOSE     },
+
+		{ "count",        required_argument, NULL, OPT_COUNT       },
+		{ "interval",     required_argument, NULL, OPT_INTERVAL    },
+		{ "timeout",      required_argument, NULL, OPT_TIMEOUT     },
+		{ "replies",      required_argument, NULL, OPT_REPLIES     },
+		{ "file",         required_argument, NULL, OPT_FILE        },
+
+		{ NULL,           no_argument,       NULL, 0               }
+	};
+	int opt, status = NI_WICKED_RC_USAGE;
+	struct arp_sweep sweep;
+	char *command   = NULL;
+
+	memset(&sweep, 0, sizeof(sweep));
+	sweep.tail = &sweep.targets;
+
+	if (ni_string_printf(&command, "%s %s",
+				caller  ? caller  : "wicked arp",
+				argv[0] ? argv[0] : "sweep")) {
+		caller  = argv[0];
+		argv[0] = command;
+	} else {
+		command = (char *)caller;
+	}
+
+	optind = 1;
+	while ((opt = getopt_long(argc, argv, "+", options, NULL)) != EOF) {
+		switch (opt) {
+		case OPT_HELP:
+			status = NI_WICKED_RC_SUCCESS;
+			/* fall through */
+		default:
+		usage:
+			fprintf(stderr,
+				"Usage:\n"
+				"  %s [options ...] [<ifname> <mode> <IP address> ...]\n"
+				"\n"
+				"Supported modes:\n"
+				"  ping\n"
+				"      ARP ping the neighbour with the IP address\n"
+				"  verify\n"
+				"      Verify the IP address for duplicates (DAD)\n"
+				"\n"
+				"Supported options:\n"
+				"  --help\n"
+				"      Show this help text.\n"
+				"  --quiet\n"
+				"      Return exit status only\n"
+				"  --verbose\n"
+				"      Show the results as JSON array (default)\n"
+				"\n"
+				"  --file <filename> | -\n"
+				"      Read '<ifname> <mode> <IP address>' lines\n"
+				"  --count <count>\n"
+				"      Send <count> requests per target (default: 3)\n"
+				"  --interval <msec>\n"
+				"      Interval between the send rounds in msec\n"
+				"      (default: 1000)\n"
+				"  --replies <count>\n"
+				"      Ping replies needed per target (default: 1)\n"
+				"  --timeout <msec>\n"
+				"      Finish the whole sweep after given timeout in msec\n"
+				, argv[0]
+			);
+			goto cleanup;
+
+		case OPT_QUIET:
+			verbose = FALSE;
+			break;
+
+		case OPT_VERBOSE:
+			verbose = TRUE;
+			break;
+
+		case OPT_COUNT:
+			if (ni_parse_uint(optarg, &sweep.count, 10) || !sweep.count) {
+				ni_error("%s: Cannot parse sweep count '%s'",
+						argv[0], optarg);
+				goto cleanup;
+			}
+			break;
+
+		case OPT_INTERVAL:
+			if (ni_parse_uint(optarg, &sweep.interval, 10) || !sweep.interval) {
+				ni_error("%s: Cannot parse sweep interval '%s'",
+						argv[0], optarg);
+				goto cleanup;
+			}
+			break;
+
+		case OPT_TIMEOUT:
+			if (ni_parse_uint(optarg, &sweep.deadline, 10)) {
+				ni_error("%s: Cannot parse sweep timeout '%s'",
+						argv[0], optarg);
+				goto cleanup;
+			}
+			break;
+
+		case OPT_REPLIES:
+			if (ni_parse_uint(optarg, &sweep.replies, 10) || !sweep.replies) {
+				ni_error("%s: Cannot parse sweep replies count '%s'",
+						argv[0], optarg);
+				goto cleanup;
+			}
+			break;
+
+		case OPT_FILE:
+			if (!do_arp_sweep_read(&sweep, optarg)) {
+				status = NI_WICKED_RC_ERROR;
+				goto cleanup;
+			}
+			break;
+		}
+	}
+
+	if ((argc - optind) % 3)
+		goto usage;
+
+	for (; optind + 2 < argc; optind += 3) {
+		if (!do_arp_sweep_add(&sweep, argv[optind], argv[optind + 1], argv[optind + 2])) {
+			status = NI_WICKED_RC_ERROR;
+			goto cleanup;
+		}
+	}
+	if (!sweep.targets)
+		goto usage;
+
+	if (!sweep.count)
+		sweep.count = 3;
+	if (!sweep.interval)
+		sweep.interval = 1000;
+	if (!sweep.replies)
+		sweep.replies = 1;
+
+	status = do_arp_sweep_run(&sweep, verbose);
+
+cleanup:
+	do_arp_sweep_destroy(&sweep);
+	if (command != caller)
+		argv[0] = (char *)caller;
+	ni_string_free(&command);
+	return status;
+}
+
 /*
  * main
  */
@@ -1117,6 +1787,9 @@ ni_do_arp(const char *caller, int argc, char **argv)
 				"  ping   [options] <ifname> <IP address>\n"
 				"        ARP ping the specified neigbour\n"
 				"\n"
+				"  sweep  [options] [<ifname> <mode> <IP address> ...]\n"
+				"        Ping or verify many targets concurrently\n"
+				"\n"
 				, argv[0]
 			);
 			goto cleanup;
@@ -1210,6 +1883,9 @@ ni_do_arp(const char *caller, int argc, char **argv)
 		if (ni_string_eq(action, "ping")) {
 			handle.ops = &do_arp_ping_ops;
 			status = do_arp_ping_run(&handle, command, argc - optind, argv + optind);
+		} else
+		if (ni_string_eq(action, "sweep")) {
+			status = do_arp_sweep(command, argc - optind, argv + optind, handle.verbose);
 		} else {
 			ni_error("%s: Unknown action '%s'\n", argv[0], action);
 			goto usage;
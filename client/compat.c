@@ -2709,6 +2709,10 @@ ni_compat_generate_ifnode_content(xml_node_t *ifnode, const ni_compat_netdev_t *
 			xml_node_new_element(NI_CLIENT_STATE_XML_USERCONTROL_NODE, child,
 				ni_format_boolean(control->usercontrol));
 		}
+		if (control->priority != NI_IFWORKER_PRIORITY_NORMAL) {
+			xml_node_new_element("priority", child,
+				ni_ifworker_priority_name(control->priority));
+		}
 
 		if (control->link_timeout || control->link_priority || ni_tristate_is_set(control->link_required)) {
 			linkdet = xml_node_create(child, "link-detection");
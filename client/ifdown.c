@@ -266,6 +266,10 @@ usage:
 		ni_note("ifdown: no matching interfaces");
 		status = NI_WICKED_RC_SUCCESS;
 	} else {
+		/* Delete the virtual devices in one batch once they are down */
+		if (max_state == NI_FSM_STATE_DEVICE_DOWN)
+			ni_fsm_teardown_fast(fsm);
+
 		if (ni_fsm_schedule(fsm) != 0)
 			ni_fsm_mainloop(fsm);
 
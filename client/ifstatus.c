@@ -46,6 +46,7 @@
 #include <wicked/bridge.h>
 #include <wicked/vlan.h>
 #include <wicked/fsm.h>
+#include <wicked/snapshot.h>
 
 #include "wicked-client.h"
 #include "appconfig.h"
@@ -635,11 +636,35 @@ ni_ifstatus_to_retcode(int status, ni_bool_t mandatory)
 	}
 }
 
+/*
+ * The addresses and routes as published by wickedd in the state
+ * snapshot, without transferring them over dbus. The snapshot has
+ * routes only when wickedd tracks them.
+ */
+static ni_netconfig_t *
+ni_ifstatus_read_snapshot(ni_bool_t *routes)
+{
+	ni_state_snapshot_t *snap;
+	ni_netconfig_t *nc = NULL;
+
+	*routes = FALSE;
+	if (!(snap = ni_state_snapshot_open(NULL)) ||
+	    ni_state_snapshot_read(snap, &nc) < 0 || !nc) {
+		ni_warn("unable to read the state snapshot, using the dbus state");
+		ni_netconfig_free(nc);
+		nc = NULL;
+	} else {
+		*routes = ni_state_snapshot_has_routes(snap);
+	}
+	ni_state_snapshot_free(snap);
+	return nc;
+}
+
 int
 ni_do_ifstatus(int argc, char **argv)
 {
 	enum  { OPT_QUIET, OPT_BRIEF, OPT_NORMAL, OPT_VERBOSE,
-		OPT_HELP, OPT_SHOW, OPT_IFCONFIG, OPT_TRANSIENT };
+		OPT_HELP, OPT_SHOW, OPT_IFCONFIG, OPT_TRANSIENT, OPT_SNAPSHOT };
 	static struct option ifcheck_options[] = {
 		{ "help",         no_argument,       NULL, OPT_HELP        },
 		{ "quiet",        no_argument,       NULL, OPT_QUIET       },
@@ -647,6 +672,7 @@ ni_do_ifstatus(int argc, char **argv)
 		{ "verbose",      no_argument,       NULL, OPT_VERBOSE     },
 		{ "ifconfig",     required_argument, NULL, OPT_IFCONFIG    },
 		{ "transient",    no_argument,       NULL, OPT_TRANSIENT },
+		{ "snapshot",     no_argument,       NULL, OPT_SNAPSHOT    },
 
 		{ NULL,           no_argument,       NULL, 0               }
 	};
@@ -659,6 +685,9 @@ ni_do_ifstatus(int argc, char **argv)
 	ni_bool_t         multiple = FALSE;
 	ni_bool_t         all = FALSE;
 	ni_bool_t         opt_transient = FALSE;
+	ni_bool_t         opt_snapshot = FALSE;
+	ni_netconfig_t *  snapshot = NULL;
+	ni_bool_t         snapshot_routes = FALSE;
 	ni_bool_t         check_config;
 	ni_fsm_t *        fsm;
 	unsigned int      i, nmarked;
@@ -697,6 +726,8 @@ ni_do_ifstatus(int argc, char **argv)
 				"      Show only a brief status, no additional info\n"
 				"  --verbose\n"
 				"      Show a more detailed information\n"
+				"  --snapshot\n"
+				"      Show addresses and routes from the state snapshot of wickedd\n"
 				"\n"
 				"  --ifconfig <filename>\n"
 				"      Read interface configuration(s) from file\n"
@@ -717,6 +748,10 @@ ni_do_ifstatus(int argc, char **argv)
 		case OPT_TRANSIENT:
 			opt_transient = TRUE;
 			break;
+
+		case OPT_SNAPSHOT:
+			opt_snapshot = TRUE;
+			break;
 		}
 	}
 
@@ -740,6 +775,9 @@ ni_do_ifstatus(int argc, char **argv)
 		goto cleanup;
 	}
 
+	if (opt_snapshot)
+		snapshot = ni_ifstatus_read_snapshot(&snapshot_routes);
+
 	if (check_config && opt_ifconfig.count == 0) {
 		const ni_string_array_t *sources = ni_config_sources("ifconfig");
 
@@ -771,7 +809,7 @@ ni_do_ifstatus(int argc, char **argv)
 
 	for (i = 0, nmarked = 0; i < fsm->workers.count; ++i) {
 		ni_ifworker_t *w = fsm->workers.data[i];
-		ni_netdev_t *dev = w->device;
+		ni_netdev_t *dev = w->device, *sdev;
 		unsigned int st = NI_WICKED_ST_NO_DEVICE;
 		ni_bool_t mandatory = TRUE;
 
@@ -809,8 +847,10 @@ ni_do_ifstatus(int argc, char **argv)
 			ni_ifstatus_show_config (dev, opt_verbose > OPT_NORMAL);
 			ni_ifstatus_show_leases (dev, opt_verbose > OPT_NORMAL);
 
-			ni_ifstatus_show_addrs  (dev, opt_verbose > OPT_NORMAL);
-			ni_ifstatus_show_routes (dev, opt_verbose > OPT_NORMAL);
+			sdev = snapshot ? ni_netdev_by_index(snapshot, dev->link.ifindex) : NULL;
+			ni_ifstatus_show_addrs  (sdev ? sdev : dev, opt_verbose > OPT_NORMAL);
+			ni_ifstatus_show_routes (sdev && snapshot_routes ? sdev : dev,
+						opt_verbose > OPT_NORMAL);
 		}
 	}
 
@@ -850,6 +890,8 @@ ni_do_ifstatus(int argc, char **argv)
 	}
 
 cleanup:
+	if (snapshot)
+		ni_netconfig_free(snapshot);
 	ni_uint_array_destroy(&stcodes);
 	ni_uint_array_destroy(&stflags);
 	ni_string_array_destroy(&ifnames);
@@ -265,22 +265,26 @@ ni_ifup_hire_nanny(ni_ifworker_array_t *array, ni_bool_t set_persistent)
 	unsigned int i;
 	ni_bool_t rv = TRUE;
 	ni_string_array_t names = NI_STRING_ARRAY_INIT;
+	ni_ifworker_priority_t priority;
 
-	/* Send policies to nanny */
-	for (i = 0; i < array->count; i++) {
-		ni_ifworker_t *w = array->data[i];
+	/* Send policies to nanny, priority interfaces first */
+	for (priority = __NI_IFWORKER_PRIORITY_MAX; priority-- > 0; ) {
+		for (i = 0; i < array->count; i++) {
+			ni_ifworker_t *w = array->data[i];
 
-		if (!w || xml_node_is_empty(w->config.node))
-			continue;
+			if (!w || xml_node_is_empty(w->config.node) ||
+			    w->control.priority != priority)
+				continue;
 
-		if (set_persistent)
-			ni_client_state_set_persistent(w->config.node);
+			if (set_persistent)
+				ni_client_state_set_persistent(w->config.node);
 
-		if (!ni_ifup_start_policy(w))
-			rv = FALSE;
-		else {
-			ni_info("%s: configuration applied to nanny", w->name);
-			ni_string_array_append(&names, w->name);
+			if (!ni_ifup_start_policy(w))
+				rv = FALSE;
+			else {
+				ni_info("%s: configuration applied to nanny", w->name);
+				ni_string_array_append(&names, w->name);
+			}
 		}
 	}
 
@@ -528,6 +528,27 @@ __dump_fake_xml(const ni_dbus_variant_t *variant, unsigned int indent, const cha
 	}
 }
 
+/*
+ * Address and route lists too long to be sent as properties
+ * have to be fetched separately.
+ */
+static void
+__dump_object_paged_lists(const char *object_path, ni_dbus_variant_t *dict)
+{
+	static const char *lists[] = { "addresses", "routes", NULL };
+	char paged[32];
+	dbus_bool_t value;
+	const char **name;
+
+	for (name = lists; *name; ++name) {
+		snprintf(paged, sizeof(paged), "%s-paged", *name);
+		if (!ni_dbus_dict_get_bool(dict, paged, &value) || !value)
+			continue;
+		if (ni_call_device_get_list_property(object_path, *name, dict) < 0)
+			ni_warn("%s: unable to retrieve the %s list", object_path, *name);
+	}
+}
+
 static ni_bool_t
 __dump_object_xml(const char *object_path, const ni_dbus_variant_t *variant,
 	ni_xs_scope_t *schema, xml_node_t *parent, const ni_string_array_t *filter)
@@ -562,6 +583,9 @@ __dump_object_xml(const char *object_path, const ni_dbus_variant_t *variant,
 		if (!ni_string_startswith(interface_name, NI_OBJECTMODEL_NAMESPACE))
 			continue;
 
+		if (ni_string_eq(interface_name, NI_OBJECTMODEL_NETIF_INTERFACE))
+			__dump_object_paged_lists(object_path, &entry->datum);
+
 		ni_dbus_xml_deserialize_properties(schema, interface_name, &entry->datum, object_node);
 	}
 
@@ -29,6 +29,7 @@
 #include <wicked/logging.h>
 #include <wicked/xml.h>
 #include <wicked/fsm.h>
+#include <wicked/resolver.h>
 
 #include "wicked-client.h"
 
@@ -41,6 +42,7 @@ typedef struct ni_reachability_check {
 	int			family;
 
 	ni_bool_t		address_valid;
+	ni_bool_t		resolving;
 	ni_sockaddr_t		address;
 } ni_reachability_check_t;
 
@@ -49,22 +51,36 @@ static ni_bool_t
 ni_fsm_require_check_reachable(ni_fsm_t *fsm, ni_ifworker_t *w, ni_fsm_require_t *req)
 {
 	ni_reachability_check_t *check = req->user_data;
+	unsigned int generation;
+	int rv;
 
 	/* Do not check too often. If the dhcp or routing info didn't change,
-	 * there is no point wasting time on another lookup. */
-	if (req->event_seq == fsm->last_event_seq[NI_EVENT_ADDRESS_ACQUIRED]) {
+	 * there is no point wasting time on another lookup -- except we're
+	 * waiting for a result of an asynchronous lookup we've started. */
+	if (!check->resolving && req->event_seq == fsm->last_event_seq[NI_EVENT_ADDRESS_ACQUIRED]) {
 		ni_debug_application("check reachability: %s SKIP", check->hostname);
 		return FALSE;
 	}
 	/* Force another lookup if the resolver was updated in the meantime */
-	if (req->event_seq < fsm->last_event_seq[NI_EVENT_RESOLVER_UPDATED])
+	generation = fsm->last_event_seq[NI_EVENT_RESOLVER_UPDATED];
+	if (req->event_seq < generation)
 		check->address_valid = FALSE;
 	req->event_seq = fsm->event_seq;
 
-	if (!check->address_valid
-	 && ni_resolve_hostname_timed(check->hostname, check->family, &check->address, 1) <= 0) {
-		ni_debug_application("check reachability: %s not resolvable", check->hostname);
-		return FALSE;
+	if (!check->address_valid) {
+		/* Never block the fsm (and all other workers) on a lookup,
+		 * the socket loop wakes us up again when it is finished. */
+		rv = ni_resolve_hostname_async(check->hostname, check->family,
+						generation, &check->address);
+		check->resolving = rv == 0;
+		if (rv == 0) {
+			ni_debug_application("check reachability: %s resolving", check->hostname);
+			return FALSE;
+		}
+		if (rv < 0) {
+			ni_debug_application("check reachability: %s not resolvable", check->hostname);
+			return FALSE;
+		}
 	}
 	check->address_valid = TRUE;
 
@@ -108,7 +108,7 @@ static char *			__ni_suse_default_hostname;
 static ni_sysconfig_t *		__ni_suse_config_defaults;
 static ni_sysconfig_t *		__ni_suse_dhcp_defaults;
 static ni_route_table_t *	__ni_suse_global_routes;
-static ni_var_array_t		__ni_suse_global_ifsysctl;
+static ni_ifsysctl_t *		__ni_suse_global_ifsysctl;
 static ni_bool_t		__ni_ipv6_disbled;
 
 /* compat: no default script scheme as a safeguard (boo#907215, bsc#920070, bsc#919496) */
@@ -331,7 +331,8 @@ __ni_suse_read_global_ifsysctl(const char *root, const char *path)
 	unsigned int i;
 	struct utsname u;
 
-	ni_var_array_destroy(&__ni_suse_global_ifsysctl);
+	ni_ifsysctl_free(__ni_suse_global_ifsysctl);
+	__ni_suse_global_ifsysctl = ni_ifsysctl_new(NULL);
 
 	/*
 	 * first /boot/sysctl.conf-<kernelversion>
@@ -399,7 +400,7 @@ __ni_suse_read_global_ifsysctl(const char *root, const char *path)
 
 	for (i = 0; i < files.count; ++i) {
 		name = files.data[i];
-		ni_ifsysctl_file_load(&__ni_suse_global_ifsysctl, name);
+		ni_ifsysctl_load(__ni_suse_global_ifsysctl, name);
 	}
 	return TRUE;
 }
@@ -499,7 +500,8 @@ __ni_suse_free_globals(void)
 
 	ni_route_tables_destroy(&__ni_suse_global_routes);
 
-	ni_var_array_destroy(&__ni_suse_global_ifsysctl);
+	ni_ifsysctl_free(__ni_suse_global_ifsysctl);
+	__ni_suse_global_ifsysctl = NULL;
 }
 
 /*
@@ -1612,19 +1614,19 @@ __ni_suse_startmode(const ni_sysconfig_t *sc)
 		ni_ifworker_control_t	control;
 	} __ni_suse_control_params[] = {
 		/* manual is the default in ifcfg */
-		{ "manual",	{ "manual",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
+		{ "manual",	{ "manual",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
 
-		{ "auto",	{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
-		{ "boot",	{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
-		{ "onboot",	{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
-		{ "on",		{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
+		{ "auto",	{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
+		{ "boot",	{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
+		{ "onboot",	{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
+		{ "on",		{ "boot",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
 
-		{ "nfsroot",	{ "boot",	"localfs",	TRUE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
+		{ "nfsroot",	{ "boot",	"localfs",	TRUE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
 
-		{ "hotplug",	{ "hotplug",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
-		{ "ifplugd",	{ "ifplugd",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
+		{ "hotplug",	{ "hotplug",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
+		{ "ifplugd",	{ "ifplugd",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
 
-		{ "off",	{ "off",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0 } },
+		{ "off",	{ "off",	NULL,		FALSE,	FALSE,	NI_TRISTATE_DEFAULT,	0, 0,	NI_IFWORKER_PRIORITY_NORMAL } },
 
 		{ NULL }
 	};
@@ -1669,6 +1671,12 @@ __ni_suse_startmode(const ni_sysconfig_t *sc)
 			else
 				ni_parse_uint(value, &control->link_timeout, 10);
 		}
+
+		if ((value = ni_sysconfig_get_value(sc, "STARTPRIORITY")) &&
+		    !ni_ifworker_priority_from_name(value, &control->priority)) {
+			ni_warn("%s: ignoring unknown STARTPRIORITY='%s'",
+					sc->pathname, value);
+		}
 	}
 	return control;
 }
@@ -6001,40 +6009,24 @@ ni_suse_ifcfg_get_firewall(const ni_sysconfig_t *sc, ni_compat_netdev_t *compat)
 /*
  * Read ifsysctl file
  */
-static const ni_var_t *
-__ifsysctl_get_var(ni_var_array_t *vars, const char *path, const char *ifname, const char *attr)
-{
-	const char *names[] = { "all", "default", ifname, NULL };
-	const char **name;
-	const ni_var_t *ret = NULL;
-	const ni_var_t *var;
-
-	for (name = names; *name; name++) {
-		var = ni_ifsysctl_vars_get(vars, "%s/%s/%s", path, *name, attr);
-		if (!var || ni_string_empty(var->value))
-			continue;
-		ret = var;
-	}
-	return ret;
-}
-
 static const char *
-__ifsysctl_get_str(ni_var_array_t *vars, const char *path, const char *ifname, const char *attr)
+__ifsysctl_get_str(const ni_ifsysctl_t *vars, unsigned int family, const char *ifname,
+					const char *attr)
 {
 	const ni_var_t *var;
 
-	if ((var = __ifsysctl_get_var(vars, path, ifname, attr)))
+	if ((var = ni_ifsysctl_lookup(vars, family, ifname, attr)))
 		return var->value;
 	return NULL;
 }
 
 static ni_bool_t
-__ifsysctl_get_int(ni_var_array_t *vars, const char *path, const char *ifname,
+__ifsysctl_get_int(const ni_ifsysctl_t *vars, unsigned int family, const char *ifname,
 					const char *attr, int *value, int base)
 {
 	const ni_var_t *var;
 
-	if (!(var = __ifsysctl_get_var(vars, path, ifname, attr)))
+	if (!(var = ni_ifsysctl_lookup(vars, family, ifname, attr)))
 		return FALSE;
 
 	if (ni_parse_int(var->value, value, base) < 0) {
@@ -6049,13 +6041,13 @@ __ifsysctl_get_int(ni_var_array_t *vars, const char *path, const char *ifname,
 }
 
 static ni_bool_t
-__ifsysctl_get_ipv6(ni_var_array_t *vars, const char *path, const char *ifname,
+__ifsysctl_get_ipv6(const ni_ifsysctl_t *vars, unsigned int family, const char *ifname,
 					const char *attr, struct in6_addr *ipv6)
 {
 	ni_sockaddr_t addr;
 	const char *str;
 
-	str = __ifsysctl_get_str(vars, path, ifname, attr);
+	str = __ifsysctl_get_str(vars, family, ifname, attr);
 	if (!str || ni_sockaddr_parse(&addr, str, AF_INET6) < 0)
 		return FALSE;
 
@@ -6064,12 +6056,12 @@ __ifsysctl_get_ipv6(ni_var_array_t *vars, const char *path, const char *ifname,
 }
 
 static void
-__ifsysctl_get_tristate(ni_var_array_t *vars, const char *path, const char *ifname,
+__ifsysctl_get_tristate(const ni_ifsysctl_t *vars, unsigned int family, const char *ifname,
 			const char *attr, ni_tristate_t *tristate)
 {
 	int value = NI_TRISTATE_DEFAULT;
 
-	__ifsysctl_get_int(vars, path, ifname, attr, &value, 10);
+	__ifsysctl_get_int(vars, family, ifname, attr, &value, 10);
 	if (ni_tristate_is_set(value))
 		ni_tristate_set(tristate, value);
 }
@@ -6077,7 +6069,7 @@ __ifsysctl_get_tristate(ni_var_array_t *vars, const char *path, const char *ifna
 static ni_bool_t
 __ni_suse_read_ifsysctl(ni_sysconfig_t *sc, ni_compat_netdev_t *compat)
 {
-	ni_var_array_t ifsysctl = NI_VAR_ARRAY_INIT;
+	ni_ifsysctl_t *ifsysctl;
 	ni_netdev_t *dev = compat->dev;
 	char pathbuf[PATH_MAX];
 	const char *dirname;
@@ -6089,38 +6081,39 @@ __ni_suse_read_ifsysctl(ni_sysconfig_t *sc, ni_compat_netdev_t *compat)
 	if (ni_string_empty(dirname))
 		return FALSE;
 
-	ni_var_array_copy(&ifsysctl, &__ni_suse_global_ifsysctl);
+	/* the ifsysctl-<ifname> file overrides the global settings */
+	ifsysctl = ni_ifsysctl_new(__ni_suse_global_ifsysctl);
 	snprintf(pathbuf, sizeof(pathbuf), "%s/%s-%s", dirname,
 			__NI_SUSE_IFSYSCTL_FILE, dev->name);
 	if (ni_isreg(pathbuf)) {
-		ni_ifsysctl_file_load(&ifsysctl, pathbuf);
+		ni_ifsysctl_load(ifsysctl, pathbuf);
 	}
 
 	ipv4 = ni_netdev_get_ipv4(dev);
 	ni_tristate_set(&ipv4->conf.enabled, TRUE);
 	/* no conf.enable and conf.arp-verify in sysctl */
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv4/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET, dev->name,
 				"forwarding", &ipv4->conf.forwarding);
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv4/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET, dev->name,
 				"arp_notify", &ipv4->conf.arp_notify);
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv4/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET, dev->name,
 				"accept_redirects", &ipv4->conf.accept_redirects);
 
 	ipv6 = ni_netdev_get_ipv6(dev);
 	ni_tristate_set(&ipv6->conf.enabled, !__ni_ipv6_disbled);
 	if (__ni_ipv6_disbled) {
-		ni_var_array_destroy(&ifsysctl);
+		ni_ifsysctl_free(ifsysctl);
 		return TRUE;
 	}
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET6, dev->name,
 				"disable_ipv6", &disable_ipv6);
 	if (ni_tristate_is_set(disable_ipv6))
 		ni_tristate_set(&ipv6->conf.enabled, !disable_ipv6);
 
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET6, dev->name,
 				"forwarding", &ipv6->conf.forwarding);
 
-	__ifsysctl_get_int(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_int(ifsysctl, AF_INET6, dev->name,
 				"accept_ra", &ipv6->conf.accept_ra, 10);
 	if (ipv6->conf.accept_ra > NI_IPV6_ACCEPT_RA_ROUTER)
 		ipv6->conf.accept_ra = NI_IPV6_ACCEPT_RA_ROUTER;
@@ -6128,7 +6121,7 @@ __ni_suse_read_ifsysctl(ni_sysconfig_t *sc, ni_compat_netdev_t *compat)
 	if (ipv6->conf.accept_ra < NI_IPV6_ACCEPT_RA_DEFAULT)
 		ipv6->conf.accept_ra = NI_IPV6_ACCEPT_RA_DEFAULT;
 
-	__ifsysctl_get_int(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_int(ifsysctl, AF_INET6, dev->name,
 				"accept_dad", &ipv6->conf.accept_dad, 10);
 	if (ipv6->conf.accept_dad > NI_IPV6_ACCEPT_DAD_FAIL_PROTOCOL)
 		ipv6->conf.accept_dad = NI_IPV6_ACCEPT_DAD_FAIL_PROTOCOL;
@@ -6136,25 +6129,26 @@ __ni_suse_read_ifsysctl(ni_sysconfig_t *sc, ni_compat_netdev_t *compat)
 	if (ipv6->conf.accept_dad < NI_IPV6_ACCEPT_DAD_DEFAULT)
 		ipv6->conf.accept_dad = NI_IPV6_ACCEPT_DAD_DEFAULT;
 
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET6, dev->name,
 				"autoconf", &ipv6->conf.autoconf);
 
-	__ifsysctl_get_int(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_int(ifsysctl, AF_INET6, dev->name,
 				"use_tempaddr", &ipv6->conf.privacy, 10);
 	if (ipv6->conf.privacy > NI_IPV6_PRIVACY_PREFER_TEMPORARY)
 		ipv6->conf.privacy = NI_IPV6_PRIVACY_PREFER_TEMPORARY;
 	else if (ipv6->conf.privacy < NI_IPV6_PRIVACY_DEFAULT)
 		ipv6->conf.privacy = NI_IPV6_PRIVACY_DISABLED;
 
-	__ifsysctl_get_tristate(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_tristate(ifsysctl, AF_INET6, dev->name,
 				"accept_redirects", &ipv6->conf.accept_redirects);
 
-	__ifsysctl_get_int(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_int(ifsysctl, AF_INET6, dev->name,
 				"addr_gen_mode", &ipv6->conf.privacy, 10);
 
-	__ifsysctl_get_ipv6(&ifsysctl, "net/ipv6/conf", dev->name,
+	__ifsysctl_get_ipv6(ifsysctl, AF_INET6, dev->name,
 				"stable_secret", &ipv6->conf.stable_secret);
 
+	ni_ifsysctl_free(ifsysctl);
 	return TRUE;
 }
 
@@ -6213,7 +6207,8 @@ __ni_suse_set_link_master(ni_netdev_t *dev, const char *master, const char *ifcf
 static ni_compat_netdev_t *
 __ni_suse_create_compat_slave(ni_compat_netdev_array_t *netdevs, ni_compat_netdev_t *master, const char *master_name, const char *slave)
 {
-	ni_ifworker_control_t control = { "hotplug", NULL, FALSE, FALSE, NI_TRISTATE_DEFAULT, 0, 0 };
+	ni_ifworker_control_t control = { "hotplug", NULL, FALSE, FALSE, NI_TRISTATE_DEFAULT, 0, 0,
+					  NI_IFWORKER_PRIORITY_NORMAL };
 	ni_compat_netdev_t *compat;
 	ni_client_state_t *m_cs;
 	ni_client_state_t *s_cs;
@@ -6317,7 +6312,8 @@ static void
 __ni_suse_adjust_ovs_system(ni_compat_netdev_t *compat)
 {
 	static const ni_ifworker_control_t control = {
-		"hotplug", NULL, FALSE, FALSE, NI_TRISTATE_DISABLE, 0, 0
+		"hotplug", NULL, FALSE, FALSE, NI_TRISTATE_DISABLE, 0, 0,
+		NI_IFWORKER_PRIORITY_NORMAL
 	};
 	ni_ipv4_devinfo_t *ipv4;
 	ni_ipv6_devinfo_t *ipv6;
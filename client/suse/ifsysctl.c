@@ -31,10 +31,27 @@
 #include <limits.h>
 #include <errno.h>
 #include <ctype.h>
+#include <sys/socket.h>
 
 #include <wicked/logging.h>
+#include "util_priv.h"
+#include "hashmap.h"
 #include "ifsysctl.h"
 
+typedef struct ni_ifsysctl_entry	ni_ifsysctl_entry_t;
+
+struct ni_ifsysctl_entry {
+	ni_ifsysctl_entry_t *	next;
+	ni_var_t		var;
+};
+
+struct ni_ifsysctl {
+	const ni_ifsysctl_t *	parent;
+
+	ni_ifsysctl_entry_t *	entries;
+	ni_hashmap_t *		map;
+};
+
 static char *
 __ni_string_strip_spaces(char *string)
 {
@@ -139,8 +156,8 @@ __ni_sysctl_rewrite_to_dot(char *ptr)
 }
 
 ni_bool_t
-__ni_sysctl_file_load(ni_var_array_t *vars, const char *filename,
-		 void (*process)(ni_var_array_t *, const char *, const char *))
+__ni_sysctl_file_load(void *data, const char *filename,
+		 void (*process)(void *, const char *, const char *))
 {
 	char buffer[PATH_MAX + 1] = {'\0'};
 	char *key, *val;
@@ -168,7 +185,7 @@ __ni_sysctl_file_load(ni_var_array_t *vars, const char *filename,
 
 		if(*key && *val) {
 			__ni_sysctl_rewrite_to_dot(key);
-			process(vars, key, val);
+			process(data, key, val);
 		}
 	}
 
@@ -221,10 +238,13 @@ ni_ifsysctl_vars_set(ni_var_array_t *vars, const char *value, const char *keyfmt
 	return TRUE;
 }
 
-void
-__ni_ifsysctl_vars_map(ni_var_array_t *vars, const char *key, const char *val)
+/*
+ * Map the key of a sysctl file into the net.ipv4.conf and net.ipv6.conf
+ * keys we're interested in; returns NULL for all other keys.
+ */
+static const char *
+__ni_ifsysctl_key_map(const char *key, ni_stringbuf_t *buf)
 {
-	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
 	const char *ptr;
 
 	/* Normalize the net.ipv4.ip_forward alias */
@@ -236,32 +256,41 @@ __ni_ifsysctl_vars_map(ni_var_array_t *vars, const char *key, const char *val)
 	 */
 	if (strncmp(key, "net.ipv4.conf.", sizeof("net.ipv4.conf.")-1)
 	&&  strncmp(key, "net.ipv6.conf.", sizeof("net.ipv6.conf.")-1))
-		return;
+		return NULL;
 
 	/*
 	 * Resolve $INTERFACE and $SYSCTL_IF wildcard crap
 	 */
 	if ((ptr = strstr(key, "$INTERFACE"))) {
-		ni_stringbuf_puts(&buf, key);
-		ni_stringbuf_truncate(&buf, ptr - key);
-		ni_stringbuf_puts(&buf, "default");
+		ni_stringbuf_puts(buf, key);
+		ni_stringbuf_truncate(buf, ptr - key);
+		ni_stringbuf_puts(buf, "default");
 		ptr += sizeof("$INTERFACE")-1;
-		ni_stringbuf_puts(&buf, ptr);
-		key = buf.string;
+		ni_stringbuf_puts(buf, ptr);
+		key = buf->string;
 	} else
 	if ((ptr = strstr(key, "$SYSCTL_IF"))) {
-		ni_stringbuf_puts(&buf, key);
-		ni_stringbuf_truncate(&buf, ptr - key);
-		ni_stringbuf_puts(&buf, "default");
+		ni_stringbuf_puts(buf, key);
+		ni_stringbuf_truncate(buf, ptr - key);
+		ni_stringbuf_puts(buf, "default");
 		ptr += sizeof("$SYSCTL_IF")-1;
-		ni_stringbuf_puts(&buf, ptr);
-		key = buf.string;
+		ni_stringbuf_puts(buf, ptr);
+		key = buf->string;
 	}
+	return key;
+}
+
+void
+__ni_ifsysctl_vars_map(void *data, const char *key, const char *val)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_var_array_t *vars = data;
 
 	/*
 	 * And finally add it to the array
 	 */
-	ni_var_array_set(vars, key, val);
+	if ((key = __ni_ifsysctl_key_map(key, &buf)))
+		ni_var_array_set(vars, key, val);
 	ni_stringbuf_destroy(&buf);
 }
 
@@ -274,3 +303,164 @@ ni_ifsysctl_file_load(ni_var_array_t *vars, const char *filename)
 	ni_debug_readwrite("Reading sysctl file '%s'", filename);
 	return __ni_sysctl_file_load(vars, filename, __ni_ifsysctl_vars_map);
 }
+
+/*
+ * The hashed ifsysctl store, keyed by "<family>/<ifname>/<attr>";
+ * interface names can't contain a slash. The map refers to the
+ * entries, which are owned by the store.
+ */
+static const char *
+__ni_ifsysctl_key(ni_stringbuf_t *key, unsigned int family,
+		const char *ifname, const char *attr)
+{
+	ni_stringbuf_printf(key, "%u/%s/%s", family, ifname, attr);
+	return key->string;
+}
+
+ni_ifsysctl_t *
+ni_ifsysctl_new(const ni_ifsysctl_t *parent)
+{
+	ni_ifsysctl_t *store;
+
+	store = xcalloc(1, sizeof(*store));
+	store->parent = parent;
+	store->map = ni_hashmap_new();
+	return store;
+}
+
+void
+ni_ifsysctl_free(ni_ifsysctl_t *store)
+{
+	ni_ifsysctl_entry_t *entry;
+
+	if (!store)
+		return;
+
+	while ((entry = store->entries) != NULL) {
+		store->entries = entry->next;
+		ni_var_destroy(&entry->var);
+		free(entry);
+	}
+	ni_hashmap_free(store->map);
+	free(store);
+}
+
+/*
+ * Set a value, the key may be in dot or slash format
+ */
+ni_bool_t
+ni_ifsysctl_set(ni_ifsysctl_t *store, const char *key, const char *value)
+{
+	ni_stringbuf_t hkey = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_ifsysctl_entry_t *entry;
+	char *name = NULL, *ifname, *attr, *p;
+	unsigned int family;
+	size_t len;
+
+	if (!store || ni_string_empty(key) || !value)
+		return FALSE;
+
+	ni_string_dup(&name, key);
+	__ni_sysctl_rewrite_to_dot(name);
+
+	if (!strncmp(name, "net.ipv4.conf.", sizeof("net.ipv4.conf.")-1))
+		family = AF_INET;
+	else
+	if (!strncmp(name, "net.ipv6.conf.", sizeof("net.ipv6.conf.")-1))
+		family = AF_INET6;
+	else
+		goto failure;
+
+	/* "net.ipv?.conf.<ifname>.<attr>", with a '/' for each '.' in ifname */
+	ifname = name + sizeof("net.ipv4.conf.")-1;
+	if (!(attr = strchr(ifname, '.')) || ifname == attr || !*++attr)
+		goto failure;
+
+	len = attr - ifname - 1;
+	p = xcalloc(1, len + 1);
+	memcpy(p, ifname, len);
+	for (ifname = p; *p; ++p) {
+		if (*p == '/')
+			*p = '.';
+	}
+	__ni_ifsysctl_key(&hkey, family, ifname, attr);
+	free(ifname);
+
+	if ((entry = ni_hashmap_get(store->map, hkey.string))) {
+		ni_string_dup(&entry->var.value, value);
+		ni_stringbuf_destroy(&hkey);
+		free(name);
+		return TRUE;
+	}
+
+	entry = xcalloc(1, sizeof(*entry));
+	entry->var.name = name;
+	ni_string_dup(&entry->var.value, value);
+	entry->next = store->entries;
+	store->entries = entry;
+
+	ni_hashmap_set(store->map, hkey.string, entry);
+	ni_stringbuf_destroy(&hkey);
+	return TRUE;
+
+failure:
+	ni_string_free(&name);
+	return FALSE;
+}
+
+static void
+__ni_ifsysctl_store_map(void *data, const char *key, const char *val)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_ifsysctl_t *store = data;
+
+	if ((key = __ni_ifsysctl_key_map(key, &buf)))
+		ni_ifsysctl_set(store, key, val);
+	ni_stringbuf_destroy(&buf);
+}
+
+ni_bool_t
+ni_ifsysctl_load(ni_ifsysctl_t *store, const char *filename)
+{
+	if (!store || ni_string_empty(filename))
+		return FALSE;
+
+	ni_debug_readwrite("Reading sysctl file '%s'", filename);
+	return __ni_sysctl_file_load(store, filename, __ni_ifsysctl_store_map);
+}
+
+const ni_var_t *
+ni_ifsysctl_get(const ni_ifsysctl_t *store, unsigned int family,
+		const char *ifname, const char *attr)
+{
+	ni_stringbuf_t key = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_ifsysctl_entry_t *entry = NULL;
+
+	if (!store || !ifname || !attr)
+		return NULL;
+
+	__ni_ifsysctl_key(&key, family, ifname, attr);
+	for (; store && !entry; store = store->parent)
+		entry = ni_hashmap_get(store->map, key.string);
+	ni_stringbuf_destroy(&key);
+
+	return entry ? &entry->var : NULL;
+}
+
+const ni_var_t *
+ni_ifsysctl_lookup(const ni_ifsysctl_t *store, unsigned int family,
+		const char *ifname, const char *attr)
+{
+	const char *names[] = { "all", "default", ifname, NULL };
+	const ni_var_t *ret = NULL;
+	const ni_var_t *var;
+	const char **name;
+
+	for (name = names; *name; name++) {
+		var = ni_ifsysctl_get(store, family, *name, attr);
+		if (!var || ni_string_empty(var->value))
+			continue;
+		ret = var;
+	}
+	return ret;
+}
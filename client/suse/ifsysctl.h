@@ -64,4 +64,39 @@ extern ni_bool_t	ni_ifsysctl_vars_set(ni_var_array_t *vars,
 					const char *value,
 					const char *keyfmt, ...);
 
+/*
+ * A hashed store of the net.ipv4.conf and net.ipv6.conf settings.
+ * The keys are split into the address family, the interface name
+ * ("all", "default" or the real interface name, with dots) and the
+ * attribute when loading, so lookups neither format nor allocate.
+ *
+ * A store may refer to a parent store it overrides, e.g. the
+ * settings of an ifsysctl-<ifname> file over the global ones.
+ */
+typedef struct ni_ifsysctl	ni_ifsysctl_t;
+
+extern ni_ifsysctl_t *	ni_ifsysctl_new(const ni_ifsysctl_t *parent);
+extern void		ni_ifsysctl_free(ni_ifsysctl_t *);
+
+/*
+ * Loads the net.ipv4.conf and net.ipv6.conf settings from a file,
+ * overriding the settings loaded before.
+ */
+extern ni_bool_t	ni_ifsysctl_load(ni_ifsysctl_t *, const char *filename);
+extern ni_bool_t	ni_ifsysctl_set(ni_ifsysctl_t *, const char *key,
+					const char *value);
+
+/*
+ * Returns the setting for exactly the given interface name
+ */
+extern const ni_var_t *	ni_ifsysctl_get(const ni_ifsysctl_t *, unsigned int family,
+					const char *ifname, const char *attr);
+
+/*
+ * Returns the effective non-empty setting of an interface, that is
+ * the interface setting, the "default" or the "all" setting.
+ */
+extern const ni_var_t *	ni_ifsysctl_lookup(const ni_ifsysctl_t *, unsigned int family,
+					const char *ifname, const char *attr);
+
 #endif /* __WICKED_CLIENT_SUSE_IFSYSCTL_H__ */
@@ -12,6 +12,7 @@
 
 typedef struct ni_call_error_context ni_call_error_context_t;
 typedef int			ni_call_error_handler_t(ni_call_error_context_t *, const DBusError *);
+typedef struct ni_call_compound	ni_call_compound_t;
 
 extern xml_node_t *		ni_call_error_context_get_node(ni_call_error_context_t *, const char *);
 extern int			ni_call_error_context_get_retries(ni_call_error_context_t *, const DBusError *);
@@ -32,10 +33,23 @@ extern int			ni_call_set_client_state_control(ni_dbus_object_t *, const ni_clien
 extern int			ni_call_set_client_state_config(ni_dbus_object_t *, const ni_client_state_config_t *);
 extern int			ni_call_set_client_state_scripts(ni_dbus_object_t *, const ni_client_state_scripts_t *);
 
+extern ni_call_compound_t *	ni_call_compound_new(ni_dbus_object_t *);
+extern void			ni_call_compound_free(ni_call_compound_t *);
+extern int			ni_call_compound_execute(ni_call_compound_t *);
+extern int			ni_call_compound_set_client_state_control(ni_call_compound_t *, const ni_client_state_control_t *);
+extern int			ni_call_compound_set_client_state_config(ni_call_compound_t *, const ni_client_state_config_t *);
+extern int			ni_call_compound_set_client_state_scripts(ni_call_compound_t *, const ni_client_state_scripts_t *);
+extern int			ni_call_compound_clear_event_filters(ni_call_compound_t *);
+
 extern int			ni_call_link_monitor(ni_dbus_object_t *);
 extern int			ni_call_clear_event_filters(ni_dbus_object_t *);
+extern int			ni_call_delete_devices(const ni_uint_array_t *, ni_uint_array_t *);
 
 extern int			ni_call_install_lease_xml(ni_dbus_object_t *, xml_node_t *);
 
+extern int			ni_call_device_get_addresses(ni_dbus_object_t *, unsigned int, ni_address_t **);
+extern int			ni_call_device_get_routes(ni_dbus_object_t *, unsigned int, ni_route_table_t **);
+extern int			ni_call_device_get_list_property(const char *, const char *, ni_dbus_variant_t *);
+
 #endif /* __WICKED_CLIENT_H__ */
 
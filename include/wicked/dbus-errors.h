@@ -31,6 +31,8 @@
 #define NI_DBUS_ERROR_POLICY_EXISTS		__NI_DBUS_ERROR(PolicyExists)
 #define NI_DBUS_ERROR_POLICY_DOESNOTEXIST	__NI_DBUS_ERROR(PolicyDoesNotExist)
 #define NI_DBUS_ERROR_RADIO_DISABLED		__NI_DBUS_ERROR(RadioDisabled)
+#define NI_DBUS_ERROR_RETRY_OPERATION		__NI_DBUS_ERROR(RetryOperation)
+#define NI_DBUS_ERROR_PEER_CLOSED		__NI_DBUS_ERROR(PeerClosed)
 
 /* Map dbus error strings to our internal error codes and vice versa */
 extern int		ni_dbus_get_error(const DBusError *error, char **detail);
@@ -59,6 +59,9 @@ struct ni_dbus_variant {
 	};
 
 	ni_dbus_message_t *	__message;
+
+	/* key index of large dicts, built on lookup */
+	struct ni_dbus_dict_index *__dict_index;
 };
 
 #define NI_DBUS_VARIANT_MAGIC	0x1234babe
@@ -165,6 +168,24 @@ extern ni_dbus_object_t *	ni_dbus_server_find_object_by_handle(ni_dbus_server_t
 extern dbus_bool_t		ni_dbus_server_send_signal(ni_dbus_server_t *server, ni_dbus_object_t *object,
 					const char *interface, const char *signal_name,
 					unsigned int nargs, const ni_dbus_variant_t *args);
+extern dbus_bool_t		ni_dbus_server_send_signal_to(ni_dbus_server_t *server,
+					const char *destination, ni_dbus_object_t *object,
+					const char *interface, const char *signal_name,
+					unsigned int nargs, const ni_dbus_variant_t *args);
+extern void			ni_dbus_server_add_signal_handler(ni_dbus_server_t *server,
+					const char *sender, const char *object_path,
+					const char *object_interface,
+					ni_dbus_signal_handler_t *callback, void *user_data);
+extern dbus_bool_t		ni_dbus_server_listen_peer(ni_dbus_server_t *, const char *path);
+extern void			ni_dbus_server_stop_peers(ni_dbus_server_t *);
+extern void			ni_dbus_server_close_peers(ni_dbus_server_t *, unsigned int timeout);
+extern dbus_bool_t		ni_dbus_server_allow_replacement(ni_dbus_server_t *,
+					const char *bus_name, ni_bool_t);
+extern dbus_bool_t		ni_dbus_server_call_compound(ni_dbus_object_t *object,
+					const ni_dbus_method_t *method,
+					unsigned int argc, const ni_dbus_variant_t *argv,
+					uid_t caller_uid, ni_dbus_message_t *reply,
+					DBusError *error);
 
 extern dbus_bool_t		ni_dbus_class_is_subclass(const ni_dbus_class_t *sub, const ni_dbus_class_t *super);
 
@@ -339,6 +360,7 @@ extern dbus_bool_t		ni_dbus_struct_get_string(const ni_dbus_variant_t *, unsigne
  */
 extern ni_dbus_client_t *	ni_dbus_client_open(const char *bus_type, const char *bus_name);
 extern void			ni_dbus_client_free(ni_dbus_client_t *);
+extern ni_bool_t		ni_dbus_client_connect_peer(ni_dbus_client_t *, const char *path);
 extern void			ni_dbus_client_add_signal_handler(ni_dbus_client_t *client,
 					const char *sender,
 					const char *object_path,
@@ -13,6 +13,7 @@
 #include <wicked/objectmodel.h>
 #include <wicked/dbus.h>
 #include <wicked/xml.h>
+#include <wicked/snapshot.h>
 
 #include "client/client_state.h"
 
@@ -108,6 +109,18 @@ typedef enum {
 	NI_IFWORKER_TYPE_MODEM,
 } ni_ifworker_type_t;
 
+/*
+ * Bring-up priority classes; the fsm runs the transitions of a higher
+ * class before it calls any of a lower one.
+ */
+typedef enum {
+	NI_IFWORKER_PRIORITY_NORMAL = 0,
+	NI_IFWORKER_PRIORITY_HIGH,
+	NI_IFWORKER_PRIORITY_CRITICAL,
+
+	__NI_IFWORKER_PRIORITY_MAX
+} ni_ifworker_priority_t;
+
 typedef struct ni_ifworker_control {
 	char *			mode;
 	char *			boot_stage;
@@ -116,6 +129,7 @@ typedef struct ni_ifworker_control {
 	ni_tristate_t		link_required;
 	unsigned int		link_priority;
 	unsigned int		link_timeout;
+	ni_ifworker_priority_t	priority;
 } ni_ifworker_control_t;
 
 struct ni_ifworker {
@@ -139,9 +153,14 @@ struct ni_ifworker {
 				done		: 1,
 				kickstarted	: 1,
 				pending		: 1,
-				readonly	: 1;
+				readonly	: 1,
+				feed_synced	: 1,
+				teardown	: 1;	/* deleted in a batch */
+
+	uint64_t		feed_generation;	/* last state feed update */
 
 	ni_ifworker_control_t	control;
+	ni_ifworker_priority_t	priority;	/* inherited from upper devices */
 
 	struct {
 		xml_node_t *			node;
@@ -257,6 +276,10 @@ struct ni_fsm {
 	ni_fsm_policy_t *	policies;
 
 	ni_dbus_object_t *	client_root_object;
+	ni_state_feed_t *	state_feed;
+
+	/* next worker to schedule in each priority class */
+	unsigned int		schedule_pos[__NI_IFWORKER_PRIORITY_MAX];
 };
 
 typedef struct ni_ifmatcher {
@@ -298,9 +321,12 @@ extern const char *		ni_fsm_policy_name(const ni_fsm_policy_t *);
 extern const xml_node_t *	ni_fsm_policy_node(const ni_fsm_policy_t *);
 extern const xml_location_t *	ni_fsm_policy_location(const ni_fsm_policy_t *);
 extern const char *		ni_fsm_policy_get_origin(const ni_fsm_policy_t *);
+extern ni_ifworker_priority_t	ni_fsm_policy_priority(const ni_fsm_policy_t *);
 extern ni_bool_t		ni_fsm_policies_changed_since(const ni_fsm_t *, unsigned int *tstamp);
 
 extern ni_dbus_client_t *	ni_fsm_create_client(ni_fsm_t *);
+extern void			ni_fsm_set_state_feed(ni_fsm_t *, ni_state_feed_t *);
+extern void			ni_fsm_sync_state_feed(ni_fsm_t *);
 extern ni_bool_t		ni_fsm_refresh_state(ni_fsm_t *);
 extern unsigned int		ni_fsm_schedule(ni_fsm_t *);
 extern ni_bool_t		ni_fsm_do(ni_fsm_t *fsm, long *timeout_p);
@@ -309,6 +335,7 @@ extern void			ni_fsm_set_process_event_callback(ni_fsm_t *, void (*)(ni_fsm_t *,
 extern unsigned int		ni_fsm_get_matching_workers(ni_fsm_t *, ni_ifmatcher_t *, ni_ifworker_array_t *);
 extern unsigned int		ni_fsm_mark_matching_workers(ni_fsm_t *, ni_ifworker_array_t *, const ni_ifmarker_t *);
 extern unsigned int		ni_fsm_start_matching_workers(ni_fsm_t *, ni_ifworker_array_t *);
+extern unsigned int		ni_fsm_teardown_fast(ni_fsm_t *);
 extern void			ni_fsm_reset_matching_workers(ni_fsm_t *, ni_ifworker_array_t *, const ni_uint_range_t *, ni_bool_t);
 extern void			ni_fsm_print_config_hierarchy(const ni_fsm_t *);
 extern void			ni_fsm_print_system_hierarchy(const ni_fsm_t *);
@@ -333,6 +360,8 @@ extern const char *		ni_ifworker_type_to_string(ni_ifworker_type_t);
 extern ni_ifworker_type_t	ni_ifworker_type_from_object_path(const char *, const char **);
 extern ni_bool_t		ni_ifworker_state_in_range(const ni_uint_range_t *, const unsigned int);
 extern const char *		ni_ifworker_state_name(ni_fsm_state_t state);
+extern const char *		ni_ifworker_priority_name(ni_ifworker_priority_t);
+extern ni_bool_t		ni_ifworker_priority_from_name(const char *, ni_ifworker_priority_t *);
 extern ni_bool_t		ni_ifworker_state_from_name(const char *, unsigned int *);
 extern ni_fsm_require_t *	ni_ifworker_reachability_check_new(xml_node_t *);
 extern ni_bool_t		ni_ifworker_match_netdev_name(const ni_ifworker_t *, const char *);
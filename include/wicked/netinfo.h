@@ -41,6 +41,8 @@ struct ni_linkinfo {
 	unsigned int		mtu;
 	unsigned int		metric;
 	unsigned int		txqlen;
+	unsigned int		group;
+	int			netnsid;
 	ni_netdev_ref_t		lowerdev;
 	ni_netdev_ref_t		masterdev;
 	ni_slaveinfo_t		slave;
@@ -56,9 +58,13 @@ struct ni_linkinfo {
 struct ni_netdev {
 	ni_netdev_t *		next;
 	unsigned int		seq;
+	unsigned int		addr_gen;	/* addrs changed */
+	unsigned int		route_gen;	/* routes changed */
 	unsigned int		modified : 1,
 				deleted : 1,
-				created : 1;
+				created : 1,
+				addrs_paged : 1,	/* client: lists have to be */
+				routes_paged : 1;	/* fetched via get{Addresses,Routes} */
 
 	char *			name;
 	ni_linkinfo_t		link;
@@ -138,6 +144,7 @@ extern int		ni_server_enable_interface_prefix_events(void (*handler)(ni_netdev_t
 extern int		ni_server_enable_interface_nduseropt_events(void (*handler)(ni_netdev_t *, ni_event_t));
 extern int		ni_server_enable_route_events(void (*handler)(ni_netconfig_t *, ni_event_t, const ni_route_t *));
 extern int		ni_server_enable_rule_events(void (*handler)(ni_netconfig_t *, ni_event_t, const ni_rule_t *));
+extern int		ni_server_enable_netns_events(void);
 extern int		ni_server_enable_interface_uevents(void);
 extern void		ni_server_disable_interface_uevents(void);
 extern void		ni_server_trace_interface_addr_events(ni_netdev_t *, ni_event_t, const ni_address_t *);
@@ -149,8 +156,10 @@ extern void		ni_server_deactivate_interface_events(void);
 extern void		ni_server_deactivate_interface_uevents(void);
 extern ni_bool_t	ni_server_disabled_uevents(void);
 extern ni_bool_t	ni_server_listens_uevents(void);
+extern ni_bool_t	ni_server_listens_route_events(void);
 extern void		ni_server_listen_other_events(void (*handler)(ni_event_t));
 extern ni_dbus_server_t *ni_server_listen_dbus(const char *bus_name);
+extern ni_bool_t	ni_server_listen_dbus_peer(ni_dbus_server_t *, const char *bus_name);
 extern ni_xs_scope_t *	ni_server_dbus_xml_schema(void);
 extern const char *	ni_config_piddir(void);
 extern const char *	ni_config_statedir(void);
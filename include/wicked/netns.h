@@ -0,0 +1,68 @@
+/*
+ *	Network namespaces managed next to the daemon's own one
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_NETNS_H__
+#define __WICKED_NETNS_H__
+
+#include <wicked/types.h>
+
+/*
+ * A network namespace is opened by its name in NI_NETNS_RUN_DIR, as
+ * created by "ip netns add", or by an absolute path to a namespace
+ * file, e.g. /proc/<pid>/ns/net.
+ *
+ * Opening assigns the namespace an id (nsid) in the daemon's own
+ * namespace if it has none yet, so the rtnetlink event listener can
+ * receive the events of all opened namespaces on its socket. Each
+ * namespace has its own netlink and ioctl sockets, and its own
+ * ni_netconfig_t. The devices in it carry the nsid in link.netnsid;
+ * devices in the own namespace have NI_NETNS_ID_NONE there.
+ */
+#define NI_NETNS_RUN_DIR		"/run/netns"
+#define NI_NETNS_ID_NONE		-1
+
+typedef struct ni_netns		ni_netns_t;
+
+extern ni_netns_t *		ni_netns_open(const char *name);
+extern void			ni_netns_close(ni_netns_t *);
+extern void			ni_netns_close_all(void);
+
+extern ni_netns_t *		ni_netns_list(void);
+extern ni_netns_t *		ni_netns_next(const ni_netns_t *);
+extern unsigned int		ni_netns_count(void);
+extern ni_netns_t *		ni_netns_by_name(const char *);
+extern ni_netns_t *		ni_netns_by_id(int nsid);
+extern int			ni_netns_own_id(void);
+
+extern const char *		ni_netns_name(const ni_netns_t *);
+extern int			ni_netns_id(const ni_netns_t *);
+extern ni_netconfig_t *		ni_netns_state_handle(ni_netns_t *, int refresh);
+
+/*
+ * Switch the calling thread, the global netlink handle and the ioctl
+ * socket into a namespace and back, so the ni_system_* functions and
+ * the /proc/sys/net sysctls act on it. Switching does not nest; the
+ * netns_enter of another namespace replaces the current one.
+ * Note that sysfs still shows the devices of the namespace it was
+ * mounted in.
+ */
+extern int			ni_netns_enter(const ni_netns_t *);
+extern void			ni_netns_leave(void);
+extern const ni_netns_t *	ni_netns_current(void);
+
+#endif /* __WICKED_NETNS_H__ */
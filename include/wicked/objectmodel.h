@@ -9,6 +9,7 @@
 
 #include <wicked/secret.h>
 #include <wicked/dbus.h>
+#include <wicked/address.h>
 
 #include "client/client_state.h"
 
@@ -61,6 +62,7 @@ extern ni_dbus_class_t *	ni_objectmodel_class_new(const char *, const ni_dbus_cl
 #define NI_OBJECTMODEL_OBJECT_PATH		NI_OBJECTMODEL_OBJECT_ROOT
 #define NI_OBJECTMODEL_NETIF_LIST_PATH		NI_OBJECTMODEL_OBJECT_ROOT "/Interface"
 #define NI_OBJECTMODEL_MODEM_LIST_PATH		NI_OBJECTMODEL_OBJECT_ROOT "/Modem"
+#define NI_OBJECTMODEL_NETNS_LIST_PATH		NI_OBJECTMODEL_OBJECT_ROOT "/Namespace"
 /* The following live in wickedd-nanny */
 #define NI_OBJECTMODEL_NANNY_PATH		NI_OBJECTMODEL_OBJECT_ROOT "/Nanny"
 #define NI_OBJECTMODEL_MANAGED_NETIF_LIST_PATH	NI_OBJECTMODEL_OBJECT_ROOT "/Nanny/Interface"
@@ -147,6 +149,7 @@ extern ni_dbus_object_t *	ni_objectmodel_get_netif_object(ni_dbus_server_t *, co
 extern dbus_bool_t		ni_objectmodel_send_netif_event(ni_dbus_server_t *, ni_dbus_object_t *,
 					ni_event_t, const ni_uuid_t *);
 extern dbus_bool_t		ni_objectmodel_addrconf_send_event(ni_netdev_t *, ni_event_t, ni_uuid_t *);
+extern void			ni_objectmodel_addrconf_forwarders_resume(ni_netconfig_t *);
 extern void			ni_objectmodel_addrconf_fallback_action(ni_netdev_t *, ni_event_t,
 					unsigned int, ni_addrconf_lease_t *);
 
@@ -158,6 +161,11 @@ extern const char *		ni_objectmodel_modem_get_classname(ni_modem_type_t);
 extern const ni_dbus_class_t *	ni_objectmodel_modem_get_class(ni_modem_type_t);
 
 extern dbus_bool_t		ni_objectmodel_other_event(ni_dbus_server_t *, ni_event_t, const ni_uuid_t *);
+extern void			ni_objectmodel_subscriptions_address_event(ni_dbus_server_t *,
+					const ni_netdev_t *, ni_event_t, const ni_address_t *);
+extern ni_bool_t		ni_objectmodel_track_routes(void);
+extern void			ni_objectmodel_subscriptions_save(xml_node_t *);
+extern ni_bool_t		ni_objectmodel_subscriptions_restore(ni_dbus_server_t *, const xml_node_t *);
 
 extern dbus_bool_t		ni_objectmodel_marshal_netdev_request(const ni_netdev_req_t *, ni_dbus_variant_t *, DBusError *);
 extern dbus_bool_t		ni_objectmodel_unmarshal_netdev_request(ni_netdev_req_t *, const ni_dbus_variant_t *, DBusError *);
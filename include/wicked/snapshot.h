@@ -0,0 +1,85 @@
+/*
+ *	Read-only shared memory snapshot of the network state
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_SNAPSHOT_H__
+#define __WICKED_SNAPSHOT_H__
+
+#include <wicked/types.h>
+
+/*
+ * wickedd publishes the devices, addresses, routes and leases of its
+ * ni_netconfig_t in a seqlock protected file in the state directory,
+ * which local readers map and decode without any dbus traffic.
+ */
+#define NI_STATE_SNAPSHOT_VERSION	1U
+#define NI_STATE_SNAPSHOT_FILE		"state.snapshot"
+
+typedef struct ni_state_snapshot	ni_state_snapshot_t;
+
+extern const char *		ni_state_snapshot_default_path(void);
+
+/* writer side, used by wickedd */
+extern ni_state_snapshot_t *	ni_state_snapshot_create(const char *path);
+extern int			ni_state_snapshot_publish(ni_state_snapshot_t *, ni_netconfig_t *);
+extern void			ni_state_snapshot_notify(void);
+extern void			ni_state_snapshot_track_routes(ni_bool_t);
+
+/* reader side */
+extern ni_state_snapshot_t *	ni_state_snapshot_open(const char *path);
+extern int			ni_state_snapshot_read(ni_state_snapshot_t *, ni_netconfig_t **);
+extern uint64_t			ni_state_snapshot_generation(const ni_state_snapshot_t *);
+extern ni_bool_t		ni_state_snapshot_has_routes(const ni_state_snapshot_t *);
+
+extern void			ni_state_snapshot_free(ni_state_snapshot_t *);
+
+/* payload format */
+extern int			ni_state_snapshot_encode(ni_buffer_t *, ni_netconfig_t *);
+extern ni_netconfig_t *		ni_state_snapshot_decode(const void *, size_t);
+
+/*
+ * Along with the snapshot, wickedd appends the device and lease state
+ * of every device it sends an event signal for to a shared ring, the
+ * state feed. Entries carry increasing generation numbers and are
+ * written before the signal is sent, so a reader draining the feed on
+ * a signal sees at least the state the signal is about.
+ */
+#define NI_STATE_FEED_VERSION		1U
+#define NI_STATE_FEED_FILE		"state.feed"
+
+typedef struct ni_state_feed		ni_state_feed_t;
+
+/* dev is NULL for deleted devices */
+typedef void				ni_state_feed_fn_t(uint64_t generation, ni_event_t,
+						unsigned int ifindex, const ni_netdev_t *dev,
+						void *user_data);
+
+extern const char *		ni_state_feed_default_path(void);
+
+/* writer side, used by wickedd */
+extern ni_state_feed_t *	ni_state_feed_create(const char *path, unsigned int capacity);
+extern int			ni_state_feed_append(ni_state_feed_t *, const ni_netdev_t *, ni_event_t);
+extern void			ni_state_feed_notify(const ni_netdev_t *, ni_event_t);
+
+/* reader side */
+extern ni_state_feed_t *	ni_state_feed_open(const char *path);
+extern int			ni_state_feed_read(ni_state_feed_t *, ni_state_feed_fn_t *, void *);
+extern uint64_t			ni_state_feed_generation(const ni_state_feed_t *);
+
+extern void			ni_state_feed_free(ni_state_feed_t *);
+
+#endif /* __WICKED_SNAPSHOT_H__ */
@@ -49,6 +49,7 @@ extern ni_bool_t	ni_socket_activate(ni_socket_t *);
 extern ni_bool_t	ni_socket_deactivate(ni_socket_t *);
 extern void		ni_socket_deactivate_all(void);
 extern int		ni_socket_wait(long timeout);
+extern void		ni_socket_stall_report(void);
 
 extern void		ni_socket_close(ni_socket_t *);
 
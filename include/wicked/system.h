@@ -8,6 +8,7 @@
 #define __WICKED_SYSTEM_H__
 
 #include <wicked/types.h>
+#include <wicked/util.h>
 
 extern int		ni_system_interface_link_change(ni_netdev_t *, const ni_netdev_req_t *);
 extern int		ni_system_interface_link_monitor(ni_netdev_t *);
@@ -16,6 +17,8 @@ extern int		ni_system_interface_link_monitor(ni_netdev_t *);
  * Most of this stuff will go as we move things into extension scripts:
  */
 extern int		ni_system_interface_stats_refresh(ni_netconfig_t *, ni_netdev_t *);
+extern int		ni_system_interfaces_delete(ni_netconfig_t *, const ni_uint_array_t *,
+				ni_uint_array_t *);
 extern int		ni_system_ipv4_setup(ni_netconfig_t *, ni_netdev_t *, const ni_ipv4_devconf_t *);
 extern int		ni_system_ipv6_setup(ni_netconfig_t *, ni_netdev_t *, const ni_ipv6_devconf_t *);
 extern int		ni_system_mtu_change(ni_netconfig_t *, ni_netdev_t *,
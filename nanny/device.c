@@ -95,6 +95,8 @@ ni_managed_device_free(ni_managed_device_t *mdev)
 	ni_debug_nanny("%s(%s): obj=%p", __func__, w ? w->name : "anon", mdev->object);
 	ni_assert(mdev->object == NULL);
 
+	if (mdev->registered)
+		ni_nanny_registry_remove(&mdev->nanny->registry, mdev);
 	ni_secret_array_destroy(&mdev->secrets);
 	free(mdev);
 }
@@ -140,6 +142,10 @@ ni_managed_device_get_worker(const ni_managed_device_t *mdev)
 	if (!mdev || !mdev->nanny || !(fsm = mdev->nanny->fsm))
 		return NULL;
 
+	/* a deleted worker gets its ifindex reset, then ask the fsm */
+	if ((w = mdev->worker) && w->ifindex && w->ifindex == mdev->ifindex)
+		return w;
+
 	if (!(w = ni_fsm_ifworker_by_ifindex(fsm, mdev->ifindex)))
 		ni_debug_nanny("%s: no corresponding worker for ifindex %d", __func__, mdev->ifindex);
 
@@ -519,24 +525,24 @@ ni_managed_state_to_string(ni_managed_state_t state)
 }
 
 /*
- * Look up managed device for a given ifindex
+ * Look up managed device for a given ifindex or name
  */
 ni_managed_device_t *
 ni_nanny_get_device_by_ifindex(ni_nanny_t *mgr, unsigned int ifindex)
 {
-	ni_managed_device_t *mdev;
-
-	for (mdev = mgr->device_list; mdev; mdev = mdev->next) {
-		if (mdev->ifindex == ifindex)
-			return mdev;
-	}
+	return ni_nanny_registry_by_ifindex(&mgr->registry, ifindex);
+}
 
-	return NULL;
+ni_managed_device_t *
+ni_nanny_get_device_by_name(ni_nanny_t *mgr, const char *name)
+{
+	return ni_nanny_registry_by_name(&mgr->registry, name);
 }
 
 void
 ni_nanny_remove_device(ni_nanny_t *mgr, ni_managed_device_t *mdev)
 {
+	ni_nanny_registry_remove(&mgr->registry, mdev);
 	ni_managed_device_list_unlink(mdev);
 }
 
@@ -89,6 +89,7 @@ ni_nanny_start(ni_nanny_t *mgr)
 	mgr->server = ni_server_listen_dbus(NI_OBJECTMODEL_DBUS_BUS_NAME_NANNY);
 	if (!mgr->server)
 		ni_fatal("Cannot create server, giving up.");
+	ni_server_listen_dbus_peer(mgr->server, NI_OBJECTMODEL_DBUS_BUS_NAME_NANNY);
 
 	mgr->fsm = ni_fsm_new();
 	mgr->fsm->worker_timeout = NI_IFWORKER_INFINITE_TIMEOUT;
@@ -117,6 +118,9 @@ ni_nanny_start(ni_nanny_t *mgr)
 	if (ni_config_use_nanny()) {
 		if (!ni_fsm_create_client(mgr->fsm))
 			ni_fatal("Unable to create FSM client");
+
+		/* device updates without refreshing them via dbus */
+		ni_fsm_set_state_feed(mgr->fsm, ni_state_feed_open(NULL));
 	}
 	ni_fsm_events_unblock(mgr->fsm);
 }
@@ -133,6 +137,9 @@ ni_nanny_free(ni_nanny_t *mgr)
 		}
 	}
 
+	ni_nanny_policy_store_free(mgr->policy_store);
+	mgr->policy_store = NULL;
+
 	ni_fatal("%s(): incomplete", __func__);
 }
 
@@ -212,18 +219,59 @@ ni_nanny_recheck(ni_nanny_t *mgr, ni_ifworker_t *w)
 	return count;
 }
 
+static inline ni_bool_t
+ni_nanny_recheck_pending(const ni_ifworker_t *w)
+{
+	return !w->dead && !w->pending && !w->kickstarted && !w->done && !w->failed;
+}
+
+/*
+ * The priority class a device is going to be started with: the one
+ * of the policy to apply or of the config it got before.
+ */
+static ni_ifworker_priority_t
+ni_nanny_recheck_priority(ni_nanny_t *mgr, ni_ifworker_t *w)
+{
+	static const unsigned int MAX_POLICIES = 20;
+	const ni_fsm_policy_t *policies[MAX_POLICIES];
+	ni_ifworker_priority_t priority = w->control.priority;
+	unsigned int count;
+
+	count = ni_fsm_policy_get_applicable_policies(mgr->fsm, w, policies, MAX_POLICIES);
+	if (count && ni_fsm_policy_priority(policies[count-1]) > priority)
+		priority = ni_fsm_policy_priority(policies[count-1]);
+
+	return priority;
+}
+
 unsigned int
 ni_nanny_recheck_do(ni_nanny_t *mgr)
 {
+	ni_ifworker_array_t classes[__NI_IFWORKER_PRIORITY_MAX];
+	ni_ifworker_priority_t priority;
 	unsigned int i, count = 0;
 	ni_fsm_t *fsm = mgr->fsm;
 
 	ni_assert(fsm);
+	memset(classes, 0, sizeof(classes));
 	for (i = 0; i < mgr->recheck.count; ++i) {
 		ni_ifworker_t *w = mgr->recheck.data[i];
 
-		if (!w->dead && !w->pending && !w->kickstarted && !w->done && !w->failed)
-			count += ni_nanny_recheck(mgr, w);
+		if (ni_nanny_recheck_pending(w))
+			ni_ifworker_array_append(&classes[ni_nanny_recheck_priority(mgr, w)], w);
+	}
+
+	/* apply the policies of priority devices and start them first */
+	for (priority = __NI_IFWORKER_PRIORITY_MAX; priority-- > 0; ) {
+		ni_ifworker_array_t *array = &classes[priority];
+
+		for (i = 0; i < array->count; ++i) {
+			ni_ifworker_t *w = array->data[i];
+
+			if (ni_nanny_recheck_pending(w))
+				count += ni_nanny_recheck(mgr, w);
+		}
+		ni_ifworker_array_destroy(array);
 	}
 
 	return count;
@@ -301,15 +349,9 @@ ni_nanny_rfkill_event(ni_nanny_t *mgr, ni_rfkill_type_t type, ni_bool_t blocked)
 int
 ni_nanny_create_policy(ni_dbus_object_t **policy_object, ni_nanny_t *mgr, xml_document_t *doc, ni_bool_t schedule)
 {
-	xml_node_t *root, *pnode = NULL;
-	ni_fsm_policy_t *policy = NULL;
-	const char *pname;
-	ni_fsm_t *fsm;
+	xml_node_t *root;
 	int rv = -1;
 
-	fsm = mgr->fsm;
-	ni_assert(fsm);
-
 	if (!doc || xml_document_is_empty(doc)) {
 		ni_error("Invalid policy document");
 		goto error;
@@ -326,7 +368,27 @@ ni_nanny_create_policy(ni_dbus_object_t **policy_object, ni_nanny_t *mgr, xml_do
 		goto error;
 	}
 
-	pnode = root->children;
+	rv = ni_nanny_create_policy_node(policy_object, mgr, root->children, TRUE);
+
+error:
+	return rv;
+}
+
+/*
+ * Create and register a policy from a <policy> node. Nodes loaded
+ * from the policy store are already migrated to the current schema.
+ */
+int
+ni_nanny_create_policy_node(ni_dbus_object_t **policy_object, ni_nanny_t *mgr, xml_node_t *pnode, ni_bool_t migrate)
+{
+	ni_fsm_policy_t *policy = NULL;
+	const char *pname;
+	ni_fsm_t *fsm;
+	int rv = -1;
+
+	fsm = mgr->fsm;
+	ni_assert(fsm);
+
 	if (!ni_ifconfig_is_policy(pnode)) {
 		pname = xml_node_get_attr(pnode, "name");
 		ni_error("No valid policy document \"%s\"",
@@ -347,7 +409,7 @@ ni_nanny_create_policy(ni_dbus_object_t **policy_object, ni_nanny_t *mgr, xml_do
 		rv = 0;
 		goto error;
 	}
-	if (ni_ifconfig_migrate(pnode))
+	if (migrate && ni_ifconfig_migrate(pnode))
 		ni_debug_nanny("Migrated policy \"%s\" to current schema", pname);
 	if ((policy = ni_fsm_policy_new(fsm, pname, pnode))) {
 		ni_managed_policy_t *mpolicy;
@@ -453,6 +515,7 @@ ni_nanny_register_device(ni_nanny_t *mgr, ni_ifworker_t *w)
 
 	if (!(mdev = ni_managed_device_new(mgr, w->ifindex, &mgr->device_list)))
 		return;
+	ni_nanny_registry_insert(&mgr->registry, mdev, w);
 
 	if (w->type == NI_IFWORKER_TYPE_NETDEV) {
 		if ((mdev->object = ni_objectmodel_register_managed_netdev(mgr->server, mdev)))
@@ -743,6 +806,7 @@ ni_objectmodel_nanny_unwrap(const ni_dbus_object_t *object, DBusError *error)
 static void
 ni_nanny_process_rename_event(ni_nanny_t *mgr, ni_ifworker_t *w)
 {
+	ni_managed_device_t *mdev;
 	ni_ifworker_t *c;
 	unsigned int i;
 	ni_bool_t rebuild = FALSE;
@@ -750,6 +814,10 @@ ni_nanny_process_rename_event(ni_nanny_t *mgr, ni_ifworker_t *w)
 	if (!mgr || !mgr->fsm)
 		return;
 
+	/* keep the registry in sync with the new worker name */
+	if ((mdev = ni_nanny_get_device(mgr, w)))
+		ni_nanny_registry_rename(&mgr->registry, mdev, w->name);
+
 	if (!w || !ni_netdev_device_is_ready(w->device))
 		return;
 
@@ -847,11 +915,11 @@ ni_objectmodel_nanny_get_device(ni_dbus_object_t *object, const ni_dbus_method_t
 	if (argc != 1 || !ni_dbus_variant_get_string(&argv[0], &ifname))
 		return ni_dbus_error_invalid_args(error, ni_dbus_object_get_path(object), method->name);
 
-	/* XXX: scalability. Use ni_call_identify_device() */
-	w = ni_fsm_ifworker_by_name(mgr->fsm, NI_IFWORKER_TYPE_NETDEV, ifname);
-
-	if (w)
-		mdev = ni_nanny_get_device(mgr, w);
+	if ((mdev = ni_nanny_get_device_by_name(mgr, ifname))) {
+		w = ni_managed_device_get_worker(mdev);
+		if (!w || w->type != NI_IFWORKER_TYPE_NETDEV || !ni_string_eq(w->name, ifname))
+			mdev = NULL;
+	}
 
 	if (mdev == NULL) {
 		dbus_set_error(error, NI_DBUS_ERROR_DEVICE_NOT_KNOWN, "No such device: %s", ifname);
@@ -920,20 +988,26 @@ ni_objectmodel_nanny_create_policy(ni_dbus_object_t *object, const ni_dbus_metho
 	xml_document_free(doc);
 
 	if (!ni_objectmodel_managed_policy_save(policy_object)) {
-		ni_warn("Unable to save created managed nanny policy %s",
-			ni_dbus_object_get_path(policy_object));
+		dbus_set_error(error, DBUS_ERROR_FAILED,
+			"Unable to save created policy %s in call to %s.%s",
+			ni_dbus_object_get_path(policy_object),
+			ni_dbus_object_get_path(object), method->name);
+		return FALSE;
 	}
 
 	return ni_dbus_message_append_object_path(reply, ni_dbus_object_get_path(policy_object));
 }
 
 ni_bool_t
-ni_nanny_policy_drop(const char *pname)
+ni_nanny_policy_drop(ni_nanny_t *mgr, const char *pname)
 {
 	char path[PATH_MAX] = {'\0'};
 
-	ni_managed_policy_filename(pname, path, sizeof(path));
+	if (!ni_nanny_policy_store_drop(ni_nanny_get_policy_store(mgr), pname))
+		return FALSE;
 
+	/* remove a not yet imported policy file */
+	ni_managed_policy_filename(pname, path, sizeof(path));
 	if (unlink(path) < 0) {
 		if (errno == ENOENT)
 			return TRUE;
@@ -978,10 +1052,15 @@ ni_objectmodel_nanny_delete_policy(ni_dbus_object_t *object, const ni_dbus_metho
 			ni_dbus_server_t *server;
 			ni_ifworker_t *w = NULL;
 
-			if (!ni_fsm_policy_remove(mgr->fsm, policy))
+			if (!ni_nanny_policy_drop(mgr, name)) {
+				dbus_set_error(error, DBUS_ERROR_FAILED,
+					"Unable to remove saved policy %s in call to %s.%s",
+					name, ni_dbus_object_get_path(object), method->name);
 				return FALSE;
+			}
 
-			ni_nanny_policy_drop(name);
+			if (!ni_fsm_policy_remove(mgr->fsm, policy))
+				return FALSE;
 			ni_debug_nanny("Removed FSM policy %s", name);
 
 			w = ni_fsm_ifworker_by_policy_name(mgr->fsm, NI_IFWORKER_TYPE_NETDEV, name);
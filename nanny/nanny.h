@@ -12,8 +12,10 @@
 
 #include <wicked/fsm.h>
 #include <wicked/types.h>
+#include <wicked/socket.h>
 #include <wicked/secret.h>
 #include "appconfig.h"
+#include "hashmap.h"
 
 typedef struct ni_nanny		ni_nanny_t;
 typedef struct ni_managed_device ni_managed_device_t;
@@ -53,8 +55,40 @@ struct ni_managed_device {
 	xml_node_t *		selected_config;
 
 	ni_secret_array_t	secrets;
+
+	/* registry index links, see registry.c */
+	ni_bool_t		registered;
+	char *			name;
+	ni_ifworker_t *		worker;
+	ni_managed_device_t *	ifindex_next;
 };
 
+typedef struct ni_nanny_registry_table {
+	unsigned int		size;
+	unsigned int		count;
+	ni_managed_device_t **	buckets;
+} ni_nanny_registry_table_t;
+
+typedef struct ni_nanny_registry {
+	ni_nanny_registry_table_t by_ifindex;
+	ni_hashmap_t *		by_name;
+} ni_nanny_registry_t;
+
+typedef ni_bool_t		ni_nanny_policy_store_write_fn_t(FILE *, void *);
+
+typedef struct ni_nanny_policy_store {
+	char *			path;
+	char *			journal;
+	unsigned int		delay;		/* msec */
+
+	ni_bool_t		dirty;		/* changes not in the store */
+	ni_bool_t		broken;		/* store not moved aside yet */
+	const ni_timer_t *	timer;
+
+	ni_nanny_policy_store_write_fn_t *write;
+	void *			user_data;
+} ni_nanny_policy_store_t;
+
 typedef struct ni_nanny_user	ni_nanny_user_t;
 struct ni_nanny_user {
 	ni_nanny_user_t *	next;
@@ -68,6 +102,7 @@ struct ni_managed_policy {
 	ni_managed_policy_t **	pprev;
 	ni_managed_policy_t *	next;
 
+	ni_nanny_t *		nanny;		// back pointer at mgr
 	uid_t			owner;
 	unsigned int		seqno;
 	ni_fsm_policy_t *	fsm_policy;
@@ -94,6 +129,7 @@ struct ni_nanny {
 	ni_fsm_t *		fsm;
 
 	ni_managed_device_t *	device_list;
+	ni_nanny_registry_t	registry;
 	ni_managed_policy_t *	policy_list;
 
 	unsigned int		last_policy_seq;
@@ -103,6 +139,8 @@ struct ni_nanny {
 	ni_nanny_user_t *	users;
 
 	ni_nanny_devmatch_t *	enable;
+
+	ni_nanny_policy_store_t *policy_store;
 };
 
 extern ni_dbus_class_t		ni_objectmodel_managed_netdev_class;
@@ -126,6 +164,7 @@ extern unsigned int		ni_nanny_down_do(ni_nanny_t *mgr);
 extern void			ni_nanny_register_device(ni_nanny_t *, ni_ifworker_t *);
 extern void			ni_nanny_unregister_device(ni_nanny_t *, ni_ifworker_t *);
 extern ni_managed_device_t *	ni_nanny_get_device_by_ifindex(ni_nanny_t *, unsigned int);
+extern ni_managed_device_t *	ni_nanny_get_device_by_name(ni_nanny_t *, const char *);
 extern void			ni_nanny_remove_device(ni_nanny_t *, ni_managed_device_t *);
 extern ni_managed_policy_t *	ni_nanny_get_policy(ni_nanny_t *, const ni_fsm_policy_t *);
 extern ni_nanny_user_t *	ni_nanny_get_user(ni_nanny_t *, uid_t);
@@ -135,7 +174,19 @@ extern void			ni_nanny_clear_secrets(ni_nanny_t *mgr,
 extern ni_secret_t *		ni_nanny_get_secret(ni_nanny_t *, uid_t, const ni_security_id_t *, const char *);
 extern void			ni_nanny_rfkill_event(ni_nanny_t *mgr, ni_rfkill_type_t type, ni_bool_t blocked);
 extern int			ni_nanny_create_policy(ni_dbus_object_t **, ni_nanny_t *, xml_document_t *, ni_bool_t);
-extern ni_bool_t		ni_nanny_policy_drop(const char *);
+extern int			ni_nanny_create_policy_node(ni_dbus_object_t **, ni_nanny_t *, xml_node_t *, ni_bool_t);
+extern ni_bool_t		ni_nanny_policy_drop(ni_nanny_t *, const char *);
+extern ni_bool_t		ni_nanny_policy_load(ni_nanny_t *);
+extern ni_nanny_policy_store_t *ni_nanny_get_policy_store(ni_nanny_t *);
+
+extern ni_nanny_policy_store_t *ni_nanny_policy_store_new(const char *,
+						ni_nanny_policy_store_write_fn_t *, void *);
+extern void			ni_nanny_policy_store_free(ni_nanny_policy_store_t *);
+extern xml_node_t *		ni_nanny_policy_store_load(ni_nanny_policy_store_t *);
+extern ni_bool_t		ni_nanny_policy_store_save(ni_nanny_policy_store_t *, const xml_node_t *);
+extern ni_bool_t		ni_nanny_policy_store_drop(ni_nanny_policy_store_t *, const char *);
+extern ni_bool_t		ni_nanny_policy_store_commit(ni_nanny_policy_store_t *);
+extern ni_bool_t		ni_nanny_policy_store_flush(ni_nanny_policy_store_t *);
 
 extern ni_bool_t		ni_managed_netdev_enable(ni_managed_device_t *);
 extern void			ni_managed_netdev_apply_policy(ni_managed_device_t *, ni_managed_policy_t *, ni_fsm_t *);
@@ -161,6 +212,14 @@ extern void			ni_managed_policy_free(ni_managed_policy_t *);
 
 extern const char *		ni_managed_state_to_string(ni_managed_state_t);
 
+extern void			ni_nanny_registry_insert(ni_nanny_registry_t *, ni_managed_device_t *, ni_ifworker_t *);
+extern void			ni_nanny_registry_remove(ni_nanny_registry_t *, ni_managed_device_t *);
+extern void			ni_nanny_registry_rename(ni_nanny_registry_t *, ni_managed_device_t *, const char *);
+extern ni_managed_device_t *	ni_nanny_registry_by_ifindex(const ni_nanny_registry_t *, unsigned int);
+extern ni_managed_device_t *	ni_nanny_registry_by_name(const ni_nanny_registry_t *, const char *);
+extern unsigned int		ni_nanny_registry_count(const ni_nanny_registry_t *);
+extern void			ni_nanny_registry_destroy(ni_nanny_registry_t *);
+
 extern ni_dbus_object_t *	ni_objectmodel_register_managed_netdev(ni_dbus_server_t *, ni_managed_device_t *);
 extern ni_dbus_object_t *	ni_objectmodel_register_managed_modem(ni_dbus_server_t *, ni_managed_device_t *);
 extern ni_dbus_object_t *	ni_objectmodel_register_managed_policy(ni_dbus_server_t *, ni_managed_policy_t *);
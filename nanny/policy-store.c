@@ -0,0 +1,391 @@
+/*
+ *	Store of the policies managed by the nanny
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/socket.h>
+#include <wicked/xml.h>
+
+#include "util_priv.h"
+#include "nanny.h"
+#include "client/ifconfig.h"
+
+/*
+ * All managed policies are kept in a single store file. A policy
+ * change acknowledged to a client, e.g. by createPolicy, is appended
+ * to a journal before the reply is sent: a <policy> record replaces
+ * the policy of the same name, a <delete name=".."/> record drops it.
+ * A timer compacts the journal into the store, which is rewritten
+ * as a whole, so a burst of changes results in a single store write.
+ *
+ * The policies are written after ni_ifconfig_migrate; a store with
+ * the current version is loaded without migrating again. A store or
+ * journal which cannot be loaded is moved aside, so it is not
+ * overwritten with the policies created meanwhile. When the store
+ * cannot be moved, the changes are kept in the journal and moving
+ * it is retried on every compaction.
+ */
+#define NI_NANNY_POLICY_STORE_NAME	"policies.xml"
+#define NI_NANNY_POLICY_JOURNAL_NAME	"policies.journal"
+#define NI_NANNY_POLICY_STORE_VERSION	1
+#define NI_NANNY_POLICY_STORE_DELAY	1000	/* msec */
+#define NI_NANNY_POLICY_STORE_RETRY	60000	/* msec */
+
+ni_nanny_policy_store_t *
+ni_nanny_policy_store_new(const char *dir, ni_nanny_policy_store_write_fn_t *write, void *user_data)
+{
+	ni_nanny_policy_store_t *store;
+
+	if (ni_string_empty(dir) || !write)
+		return NULL;
+
+	store = xcalloc(1, sizeof(*store));
+	ni_string_printf(&store->path, "%s/%s", dir, NI_NANNY_POLICY_STORE_NAME);
+	ni_string_printf(&store->journal, "%s/%s", dir, NI_NANNY_POLICY_JOURNAL_NAME);
+	store->delay = NI_NANNY_POLICY_STORE_DELAY;
+	store->write = write;
+	store->user_data = user_data;
+	return store;
+}
+
+void
+ni_nanny_policy_store_free(ni_nanny_policy_store_t *store)
+{
+	if (!store)
+		return;
+
+	if (store->timer)
+		ni_timer_cancel(store->timer);
+	ni_string_free(&store->path);
+	ni_string_free(&store->journal);
+	free(store);
+}
+
+static void
+ni_nanny_policy_store_timeout(void *user_data, const ni_timer_t *timer)
+{
+	ni_nanny_policy_store_t *store = user_data;
+
+	if (store->timer != timer)
+		return;
+
+	store->timer = NULL;
+	if (store->dirty)
+		ni_nanny_policy_store_commit(store);
+}
+
+static void
+ni_nanny_policy_store_schedule(ni_nanny_policy_store_t *store, unsigned int msec)
+{
+	if (store->timer)
+		return;
+
+	store->timer = ni_timer_register(msec, ni_nanny_policy_store_timeout, store);
+}
+
+/*
+ * Move a file which failed to load aside
+ */
+static ni_bool_t
+ni_nanny_policy_store_move_aside(const char *path)
+{
+	char *broken = NULL;
+	ni_bool_t ret = TRUE;
+
+	ni_string_printf(&broken, "%s.broken", path);
+	if (rename(path, broken) == 0) {
+		ni_warn("Moved %s which failed to load to %s", path, broken);
+	} else
+	if (errno != ENOENT) {
+		ni_error("Cannot move %s aside: %m", path);
+		ret = FALSE;
+	}
+	ni_string_free(&broken);
+	return ret;
+}
+
+static xml_node_t *
+ni_nanny_policy_store_find(xml_node_t *list, const char *name)
+{
+	xml_node_t *pnode;
+
+	for (pnode = list->children; pnode; pnode = pnode->next) {
+		if (ni_string_eq(ni_ifpolicy_get_name(pnode), name))
+			return pnode;
+	}
+	return NULL;
+}
+
+static ni_bool_t
+ni_nanny_policy_store_read(ni_nanny_policy_store_t *store, xml_node_t *list)
+{
+	xml_node_t *root, *pnode;
+	unsigned int version = 0;
+	xml_document_t *doc;
+
+	if (!(doc = xml_document_read(store->path))) {
+		ni_error("Unable to read policy store %s", store->path);
+		return FALSE;
+	}
+
+	root = xml_document_root(doc);
+	root = root ? xml_node_get_child(root, "policies") : NULL;
+	if (!root) {
+		ni_error("Policy store %s does not contain a <policies> node", store->path);
+		xml_document_free(doc);
+		return FALSE;
+	}
+
+	xml_node_get_attr_uint(root, "version", &version);
+	while ((pnode = root->children)) {
+		if (version != NI_NANNY_POLICY_STORE_VERSION) {
+			if (ni_ifconfig_migrate(pnode))
+				ni_debug_nanny("Migrated policy \"%s\" to current schema",
+						ni_ifpolicy_get_name(pnode));
+			store->dirty = TRUE;
+		}
+		xml_node_reparent(list, pnode);
+	}
+	xml_document_free(doc);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_nanny_policy_store_replay(ni_nanny_policy_store_t *store, xml_node_t *list)
+{
+	xml_node_t *root, *rec, *pnode;
+	xml_document_t *doc;
+
+	if (!(doc = xml_document_read(store->journal))) {
+		ni_error("Unable to read policy journal %s", store->journal);
+		return FALSE;
+	}
+
+	root = xml_document_root(doc);
+	while (root && (rec = root->children)) {
+		if (!ni_string_eq(rec->name, "policy") && !ni_string_eq(rec->name, "delete")) {
+			xml_node_delete_child_node(root, rec);
+			continue;
+		}
+
+		if ((pnode = ni_nanny_policy_store_find(list, xml_node_get_attr(rec, "name"))))
+			xml_node_delete_child_node(list, pnode);
+
+		if (ni_string_eq(rec->name, "policy"))
+			xml_node_reparent(list, rec);
+		else
+			xml_node_delete_child_node(root, rec);
+		store->dirty = TRUE;
+	}
+	xml_document_free(doc);
+	return TRUE;
+}
+
+/*
+ * Load the store and replay the journal on top of it. Returns the
+ * resulting <policy> nodes as children of the returned node.
+ */
+xml_node_t *
+ni_nanny_policy_store_load(ni_nanny_policy_store_t *store)
+{
+	xml_node_t *list;
+
+	if (!store)
+		return NULL;
+
+	list = xml_node_new(NULL, NULL);
+	if (ni_file_exists(store->path) && !ni_nanny_policy_store_read(store, list)) {
+		if (!ni_nanny_policy_store_move_aside(store->path))
+			store->broken = TRUE;
+		store->dirty = TRUE;
+	}
+
+	if (ni_file_exists(store->journal) && !ni_nanny_policy_store_replay(store, list)) {
+		/* a broken journal can't be appended to */
+		if (!ni_nanny_policy_store_move_aside(store->journal))
+			unlink(store->journal);
+		store->dirty = TRUE;
+	}
+	return list;
+}
+
+static ni_bool_t
+ni_nanny_policy_store_append(ni_nanny_policy_store_t *store, const xml_node_t *rec)
+{
+	struct stat stb;
+	size_t len, done;
+	ssize_t n;
+	char *data;
+	int fd;
+
+	if (!store || !(data = xml_node_sprint(rec)))
+		return FALSE;
+
+	if ((fd = open(store->journal, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600)) < 0 ||
+	    fstat(fd, &stb) < 0) {
+		ni_error("Cannot open policy journal %s: %m", store->journal);
+		if (fd >= 0)
+			close(fd);
+		free(data);
+		return FALSE;
+	}
+
+	len = strlen(data);
+	for (done = 0; done < len; done += n) {
+		if ((n = write(fd, data + done, len - done)) < 0) {
+			if (errno == EINTR) {
+				n = 0;
+				continue;
+			}
+			ni_error("Cannot write into policy journal %s: %m", store->journal);
+			/* drop the partial record */
+			if (ftruncate(fd, stb.st_size) < 0)
+				unlink(store->journal);
+			break;
+		}
+	}
+	close(fd);
+	free(data);
+	if (done < len)
+		return FALSE;
+
+	store->dirty = TRUE;
+	ni_nanny_policy_store_schedule(store, store->delay);
+	return TRUE;
+}
+
+ni_bool_t
+ni_nanny_policy_store_save(ni_nanny_policy_store_t *store, const xml_node_t *pnode)
+{
+	if (xml_node_is_empty(pnode) || ni_string_empty(ni_ifpolicy_get_name(pnode)))
+		return FALSE;
+
+	return ni_nanny_policy_store_append(store, pnode);
+}
+
+ni_bool_t
+ni_nanny_policy_store_drop(ni_nanny_policy_store_t *store, const char *name)
+{
+	xml_node_t *rec;
+	ni_bool_t ret;
+
+	if (ni_string_empty(name))
+		return FALSE;
+
+	rec = xml_node_new("delete", NULL);
+	xml_node_add_attr(rec, "name", name);
+	ret = ni_nanny_policy_store_append(store, rec);
+	xml_node_free(rec);
+	return ret;
+}
+
+/*
+ * Rewrite the store with the current policies and drop the journal
+ */
+ni_bool_t
+ni_nanny_policy_store_commit(ni_nanny_policy_store_t *store)
+{
+	char *temp = NULL;
+	FILE *fp = NULL;
+	int fd;
+
+	if (!store)
+		return FALSE;
+
+	if (store->timer) {
+		ni_timer_cancel(store->timer);
+		store->timer = NULL;
+	}
+
+	if (store->broken) {
+		if (!ni_nanny_policy_store_move_aside(store->path)) {
+			ni_error("Keeping policy changes in journal %s", store->journal);
+			goto retry;
+		}
+		store->broken = FALSE;
+	}
+
+	ni_string_printf(&temp, "%s.XXXXXX", store->path);
+	if ((fd = mkstemp(temp)) < 0) {
+		ni_error("Cannot create %s policy store temp file", store->path);
+		goto retry;
+	}
+
+	if (!(fp = fdopen(fd, "we"))) {
+		close(fd);
+		ni_error("Cannot create %s policy store temp file", store->path);
+		goto failure;
+	}
+
+	fprintf(fp, "<policies version=\"%u\">\n", NI_NANNY_POLICY_STORE_VERSION);
+	if (!store->write(fp, store->user_data) ||
+	    fprintf(fp, "</policies>\n") < 0 || fflush(fp) != 0) {
+		ni_error("Cannot write into %s policy store temp file", store->path);
+		goto failure;
+	}
+
+	if (fsync(fd) < 0) {
+		ni_error("Cannot sync %s policy store temp file: %m", store->path);
+		goto failure;
+	}
+
+	if (rename(temp, store->path) < 0) {
+		ni_error("Cannot move temp file to policy store %s", store->path);
+		goto failure;
+	}
+
+	fclose(fp);
+	ni_string_free(&temp);
+
+	if (unlink(store->journal) < 0 && errno != ENOENT)
+		ni_warn("Cannot remove policy journal %s: %m", store->journal);
+
+	store->dirty = FALSE;
+	ni_debug_nanny("Committed policy store %s", store->path);
+	return TRUE;
+
+failure:
+	if (fp)
+		fclose(fp);
+	unlink(temp);
+retry:
+	ni_string_free(&temp);
+	ni_nanny_policy_store_schedule(store, NI_NANNY_POLICY_STORE_RETRY);
+	return FALSE;
+}
+
+ni_bool_t
+ni_nanny_policy_store_flush(ni_nanny_policy_store_t *store)
+{
+	if (!store || !store->dirty)
+		return TRUE;
+
+	return ni_nanny_policy_store_commit(store);
+}
@@ -44,68 +44,145 @@ ni_managed_policy_filename(const char *name, char *path, size_t size)
 	return FALSE;
 }
 
+/*
+ * Write the managed policies into the policy store
+ */
 static ni_bool_t
-ni_managed_policy_save_node(const xml_node_t *pnode)
+ni_nanny_policy_store_write_policies(FILE *fp, void *user_data)
 {
-	char path[PATH_MAX] = {'\0'};
-	char temp[PATH_MAX] = {'\0'};
-	const char *pname;
-	FILE *fp;
-	int fd;
-
-	if (xml_node_is_empty(pnode))
-		return FALSE;
+	const ni_managed_policy_t **array, *mpolicy;
+	ni_nanny_t *mgr = user_data;
+	const xml_node_t *pnode;
+	unsigned int count = 0;
+	ni_bool_t ret = TRUE;
+
+	for (mpolicy = mgr->policy_list; mpolicy; mpolicy = mpolicy->next)
+		count++;
+
+	array = xcalloc(count + 1, sizeof(*array));
+	for (mpolicy = mgr->policy_list; mpolicy; mpolicy = mpolicy->next)
+		array[--count] = mpolicy;
+
+	/* policy_list is LIFO, write oldest first to retain the order on load */
+	for (count = 0; (mpolicy = array[count]); ++count) {
+		pnode = ni_fsm_policy_node(mpolicy->fsm_policy);
+		if (xml_node_is_empty(pnode))
+			continue;
+
+		if (xml_node_print(pnode, fp) < 0) {
+			ret = FALSE;
+			break;
+		}
+	}
 
-	pname = ni_ifpolicy_get_name(pnode);
-	if (ni_string_empty(pname))
-		return FALSE;
+	free(array);
+	return ret && !ferror(fp);
+}
 
-	ni_managed_policy_filename(pname, path, sizeof(path));
-	snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+ni_nanny_policy_store_t *
+ni_nanny_get_policy_store(ni_nanny_t *mgr)
+{
+	if (!mgr)
+		return NULL;
 
-	if ((fd = mkstemp(temp)) < 0) {
-		ni_error("Cannot create %s policy temp file", path);
-		return FALSE;
+	if (!mgr->policy_store) {
+		mgr->policy_store = ni_nanny_policy_store_new(ni_nanny_statedir(),
+					ni_nanny_policy_store_write_policies, mgr);
 	}
+	return mgr->policy_store;
+}
 
-	if (!(fp = fdopen(fd, "we"))) {
-		close(fd);
-		ni_error("Cannot create %s policy temp file", path);
-		goto failure;
-	}
+/*
+ * Import policy files saved per policy by previous versions.
+ * The imported files are removed once they have been committed
+ * to the store.
+ */
+static unsigned int
+ni_nanny_policy_store_import(ni_nanny_t *mgr, const char *nanny_dir)
+{
+	ni_string_array_t files = NI_STRING_ARRAY_INIT;
+	ni_string_array_t imported = NI_STRING_ARRAY_INIT;
+	char path[PATH_MAX];
+	xml_document_t *doc;
+	unsigned int i;
+
+	if (ni_scandir(nanny_dir, "policy*.xml", &files) == 0)
+		return 0;
 
-	if (xml_node_print(pnode, fp) < 0) {
-		ni_error("Cannot write into %s policy temp file", path);
-		goto failure;
+	for (i = 0; i < files.count; ++i) {
+		snprintf(path, sizeof(path), "%s/%s", nanny_dir, files.data[i]);
+		doc = xml_document_read(path);
+		if (doc == NULL) {
+			ni_error("Unable to read policy file %s: %m", path);
+			continue;
+		}
+
+		if (ni_nanny_create_policy(NULL, mgr, doc, TRUE) < 0)
+			ni_error("Unable to create policy from file '%s'", path);
+		else
+			ni_string_array_append(&imported, path);
+		xml_document_free(doc);
 	}
+	ni_string_array_destroy(&files);
 
-	if (rename(temp, path) < 0) {
-		ni_error("Cannot move temp file to policy file %s", path);
-		goto failure;
+	if (imported.count && ni_nanny_policy_store_commit(ni_nanny_get_policy_store(mgr))) {
+		for (i = 0; i < imported.count; ++i) {
+			ni_debug_nanny("Imported policy file %s", imported.data[i]);
+			unlink(imported.data[i]);
+		}
 	}
 
-	fclose(fp);
+	i = imported.count;
+	ni_string_array_destroy(&imported);
+	return i;
+}
 
-	return TRUE;
+ni_bool_t
+ni_nanny_policy_load(ni_nanny_t *mgr)
+{
+	char nanny_dir[PATH_MAX] = { '\0' };
+	ni_nanny_policy_store_t *store;
+	xml_node_t *list, *pnode;
+	unsigned int count = 0;
+
+	ni_assert(mgr);
+	ni_debug_application("Loading previously saved policies:");
 
-failure:
-	if (fp) {
-		fclose(fp);
+	snprintf(nanny_dir, sizeof(nanny_dir), "%s", ni_nanny_statedir());
+	if (!(store = ni_nanny_get_policy_store(mgr)))
+		return FALSE;
+
+	if ((list = ni_nanny_policy_store_load(store))) {
+		for (pnode = list->children; pnode; pnode = pnode->next) {
+			if (ni_nanny_create_policy_node(NULL, mgr, pnode, FALSE) > 0)
+				count++;
+		}
+		xml_node_free(list);
 	}
-	unlink(temp);
-	return FALSE;
+	count += ni_nanny_policy_store_import(mgr, nanny_dir);
+
+	/* compact a replayed journal or rewrite a migrated store */
+	ni_nanny_policy_store_flush(store);
+
+	if (count)
+		ni_nanny_recheck_policies(mgr, NULL);
+
+	return TRUE;
 }
 
+/*
+ * Called before a policy change is acknowledged to the client.
+ * The change is appended to the policy journal, which is then
+ * compacted into the store by a timer.
+ */
 static ni_bool_t
 ni_managed_policy_save(const ni_managed_policy_t *mpolicy)
 {
-	const xml_node_t *node;
-
-	if (!mpolicy)
+	if (!mpolicy || !mpolicy->nanny)
 		return FALSE;
 
-	node = ni_fsm_policy_node(mpolicy->fsm_policy);
-	return ni_managed_policy_save_node(node);
+	return ni_nanny_policy_store_save(ni_nanny_get_policy_store(mpolicy->nanny),
+				ni_fsm_policy_node(mpolicy->fsm_policy));
 }
 
 void
@@ -161,6 +238,7 @@ ni_managed_policy_new(ni_nanny_t *mgr, ni_fsm_policy_t *policy)
 
 	mpolicy = xcalloc(1, sizeof(*mpolicy));
 	mpolicy->refcount = 1;
+	mpolicy->nanny = mgr;
 	mpolicy->fsm_policy = ni_fsm_policy_ref(policy);
 
 	__ni_managed_policy_list_insert(&mgr->policy_list, mpolicy);
@@ -335,8 +413,10 @@ ni_objectmodel_managed_policy_update(ni_dbus_object_t *object, const ni_dbus_met
 	mpolicy->seqno++;
 
 	if (!ni_managed_policy_save(mpolicy)) {
-		ni_warn("Unable to save updated managed nanny policy %s",
-			ni_dbus_object_get_path(object));
+		dbus_set_error(error, DBUS_ERROR_FAILED,
+				"Unable to save updated policy in call to %s.%s",
+				ni_dbus_object_get_path(object), method->name);
+		return FALSE;
 	}
 
 	return TRUE;
@@ -0,0 +1,229 @@
+/*
+ * Managed device registry, indexing the managed devices of nanny
+ * by ifindex and by name.
+ *
+ * Copyright (C) 2026 SUSE LLC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/fsm.h>
+#include "util_priv.h"
+#include "nanny.h"
+
+#define NI_NANNY_REGISTRY_MIN_SIZE	64
+
+/*
+ * The ifindex table chains the devices through their ifindex_next
+ * link, the names are kept in a ni_hashmap_t. A name refers to the
+ * device registered or renamed to it last.
+ */
+static unsigned int
+ni_nanny_registry_ifindex_hash(unsigned int ifindex)
+{
+	return ifindex * 2654435761U;
+}
+
+static void
+ni_nanny_registry_table_resize(ni_nanny_registry_table_t *table, unsigned int size)
+{
+	ni_managed_device_t **buckets, *mdev, *next;
+	unsigned int i, pos;
+
+	buckets = xcalloc(size, sizeof(buckets[0]));
+	for (i = 0; i < table->size; ++i) {
+		for (mdev = table->buckets[i]; mdev; mdev = next) {
+			next = mdev->ifindex_next;
+			pos = ni_nanny_registry_ifindex_hash(mdev->ifindex) & (size - 1);
+			mdev->ifindex_next = buckets[pos];
+			buckets[pos] = mdev;
+		}
+	}
+	free(table->buckets);
+	table->buckets = buckets;
+	table->size = size;
+}
+
+static void
+ni_nanny_registry_table_insert(ni_nanny_registry_table_t *table, ni_managed_device_t *mdev)
+{
+	unsigned int pos;
+
+	if (!table->size)
+		ni_nanny_registry_table_resize(table, NI_NANNY_REGISTRY_MIN_SIZE);
+	else
+	if (table->count >= table->size)
+		ni_nanny_registry_table_resize(table, table->size << 1);
+
+	pos = ni_nanny_registry_ifindex_hash(mdev->ifindex) & (table->size - 1);
+	mdev->ifindex_next = table->buckets[pos];
+	table->buckets[pos] = mdev;
+	table->count++;
+}
+
+static ni_bool_t
+ni_nanny_registry_table_remove(ni_nanny_registry_table_t *table, ni_managed_device_t *mdev)
+{
+	ni_managed_device_t **pos;
+
+	if (!table->size)
+		return FALSE;
+
+	pos = &table->buckets[ni_nanny_registry_ifindex_hash(mdev->ifindex) & (table->size - 1)];
+	for (; *pos; pos = &(*pos)->ifindex_next) {
+		if (*pos == mdev) {
+			*pos = mdev->ifindex_next;
+			mdev->ifindex_next = NULL;
+			table->count--;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static void
+ni_nanny_registry_table_destroy(ni_nanny_registry_table_t *table)
+{
+	free(table->buckets);
+	memset(table, 0, sizeof(*table));
+}
+
+static void
+ni_nanny_registry_name_insert(ni_nanny_registry_t *reg, ni_managed_device_t *mdev)
+{
+	if (!mdev->name)
+		return;
+
+	if (!reg->by_name)
+		reg->by_name = ni_hashmap_new();
+	ni_hashmap_set(reg->by_name, mdev->name, mdev);
+}
+
+static void
+ni_nanny_registry_name_remove(ni_nanny_registry_t *reg, ni_managed_device_t *mdev)
+{
+	if (mdev->name && ni_hashmap_get(reg->by_name, mdev->name) == mdev)
+		ni_hashmap_remove(reg->by_name, mdev->name);
+}
+
+/*
+ * Add a device and remember the worker it has been registered for
+ */
+void
+ni_nanny_registry_insert(ni_nanny_registry_t *reg, ni_managed_device_t *mdev, ni_ifworker_t *w)
+{
+	if (!reg || !mdev || mdev->registered)
+		return;
+
+	ni_string_dup(&mdev->name, w ? w->name : NULL);
+	if (w)
+		mdev->worker = ni_ifworker_get(w);
+
+	ni_nanny_registry_table_insert(&reg->by_ifindex, mdev);
+	ni_nanny_registry_name_insert(reg, mdev);
+	mdev->registered = TRUE;
+}
+
+void
+ni_nanny_registry_remove(ni_nanny_registry_t *reg, ni_managed_device_t *mdev)
+{
+	if (!reg || !mdev || !mdev->registered)
+		return;
+
+	ni_nanny_registry_table_remove(&reg->by_ifindex, mdev);
+	ni_nanny_registry_name_remove(reg, mdev);
+	mdev->registered = FALSE;
+
+	ni_string_free(&mdev->name);
+	if (mdev->worker) {
+		ni_ifworker_release(mdev->worker);
+		mdev->worker = NULL;
+	}
+}
+
+/*
+ * Move a device to its new name after a rename event
+ */
+void
+ni_nanny_registry_rename(ni_nanny_registry_t *reg, ni_managed_device_t *mdev, const char *name)
+{
+	if (!reg || !mdev || !mdev->registered || ni_string_eq(mdev->name, name))
+		return;
+
+	ni_nanny_registry_name_remove(reg, mdev);
+	ni_string_dup(&mdev->name, name);
+	ni_nanny_registry_name_insert(reg, mdev);
+}
+
+ni_managed_device_t *
+ni_nanny_registry_by_ifindex(const ni_nanny_registry_t *reg, unsigned int ifindex)
+{
+	const ni_nanny_registry_table_t *table = &reg->by_ifindex;
+	ni_managed_device_t *mdev;
+
+	if (!table->size)
+		return NULL;
+
+	mdev = table->buckets[ni_nanny_registry_ifindex_hash(ifindex) & (table->size - 1)];
+	for (; mdev; mdev = mdev->ifindex_next) {
+		if (mdev->ifindex == ifindex)
+			return mdev;
+	}
+	return NULL;
+}
+
+ni_managed_device_t *
+ni_nanny_registry_by_name(const ni_nanny_registry_t *reg, const char *name)
+{
+	if (!name)
+		return NULL;
+
+	return ni_hashmap_get(reg->by_name, name);
+}
+
+unsigned int
+ni_nanny_registry_count(const ni_nanny_registry_t *reg)
+{
+	return reg ? reg->by_ifindex.count : 0;
+}
+
+/*
+ * Drop the index tables; the devices themselves are owned by the
+ * device list and their dbus objects.
+ */
+void
+ni_nanny_registry_destroy(ni_nanny_registry_t *reg)
+{
+	ni_managed_device_t *mdev;
+	unsigned int i;
+
+	if (!reg)
+		return;
+
+	for (i = 0; i < reg->by_ifindex.size; ++i) {
+		while ((mdev = reg->by_ifindex.buckets[i]) != NULL)
+			ni_nanny_registry_remove(reg, mdev);
+	}
+	ni_nanny_registry_table_destroy(&reg->by_ifindex);
+	ni_hashmap_free(reg->by_name);
+	reg->by_name = NULL;
+}
@@ -31,9 +31,16 @@
 #include <wicked/objectmodel.h>
 #include <wicked/wireless.h>
 #include <wicked/modem.h>
+#include <wicked/snapshot.h>
+#include <wicked/netns.h>
 #include "netinfo_priv.h"
+#include "appconfig.h"
+#include "dbus-common.h"
 #include "udev-utils.h"
 #include "auto6.h"
+#include "workpool.h"
+#include "handoff.h"
+#include "client/client_state.h"
 
 enum {
 	OPT_HELP,
@@ -46,6 +53,7 @@ enum {
 
 	OPT_FOREGROUND,
 	OPT_RECOVER,
+	OPT_HANDOFF,
 #ifdef MODEM
 	OPT_NOMODEMMGR,
 #endif
@@ -66,6 +74,7 @@ static struct option	options[] = {
 
 	/* specific */
 	{ "recover",		no_argument,		NULL,	OPT_RECOVER },
+	{ "handoff",		no_argument,		NULL,	OPT_HANDOFF },
 #ifdef MODEM
 	{ "no-modem-manager",	no_argument,		NULL,	OPT_NOMODEMMGR },
 #endif
@@ -74,10 +83,15 @@ static struct option	options[] = {
 	{ NULL }
 };
 
+#define NI_SERVER_WORKER_THREADS	2
+#define NI_SERVER_HANDOFF_TIMEOUT	10000	/* msec */
+#define NI_SERVER_PEER_CLOSE_TIMEOUT	1000	/* msec */
+
 static const char *	program_name;
 static const char *	opt_log_target;
 static ni_bool_t	opt_foreground;
 static ni_bool_t	opt_recover_state;
+static ni_bool_t	opt_handoff;
 /* FIXME: ModemManager changed to ModemManager1 - new API -> disabled */
 #ifdef MODEM
 static ni_bool_t	opt_no_modem_manager = TRUE;
@@ -85,9 +99,14 @@ static ni_bool_t	opt_no_modem_manager = TRUE;
 static ni_bool_t	opt_systemd;
 static char *		opt_state_file;
 static ni_dbus_server_t *dbus_server;
+static ni_state_snapshot_t *state_snapshot;
+static ni_state_feed_t *state_feed;
+static ni_handoff_t *	handoff_server;
+static ni_bool_t	handed_off;
 
 static void		run_interface_server(void);
-static void		discover_state(ni_dbus_server_t *);
+static void		discover_state(ni_dbus_server_t *, const xml_node_t *);
+static void		discover_netns_state(ni_dbus_server_t *);
 static void		recover_state(const char *filename);
 static void		handle_interface_event(ni_netdev_t *, ni_event_t);
 static void		handle_interface_addr_events(ni_netdev_t *, ni_event_t, const ni_address_t *);
@@ -95,6 +114,9 @@ static void		handle_interface_prefix_events(ni_netdev_t *, ni_event_t, const ni_
 static void		handle_interface_nduseropt_events(ni_netdev_t *, ni_event_t);
 static void		handle_rfkill_event(ni_rfkill_type_t, ni_bool_t, void *);
 static void		handle_other_event(ni_event_t);
+static ni_bool_t	handle_handoff_request(void *);
+static void		handle_handoff_cancel(void *);
+static void		handle_name_lost(ni_dbus_connection_t *, ni_dbus_message_t *, void *);
 #ifdef MODEM
 static void		handle_modem_event(ni_modem_t *, ni_event_t);
 #endif
@@ -130,6 +152,8 @@ main(int argc, char **argv)
 				"        Tell the daemon to not background itself at startup.\n"
 				"  --recover\n"
 				"        Restart of address configuration daemons and keep state information.\n"
+				"  --handoff\n"
+				"        Take over the state of the running daemon and replace it.\n"
 #ifdef MODEM
 				"  --no-modem-manager\n"
 				"        Skip start of modem-manager.\n"
@@ -180,6 +204,12 @@ main(int argc, char **argv)
 		case OPT_RECOVER:
 			opt_recover_state = TRUE;
 			break;
+
+		case OPT_HANDOFF:
+			/* the pid file is still in use by the old instance */
+			opt_handoff = TRUE;
+			opt_foreground = TRUE;
+			break;
 #ifdef MODEM
 		case OPT_NOMODEMMGR:
 			opt_no_modem_manager = TRUE;
@@ -229,11 +259,23 @@ main(int argc, char **argv)
 void
 run_interface_server(void)
 {
+	xml_node_t *	handoff_state = NULL;
+	ni_handoff_t *	handoff = NULL;
 	ni_xs_scope_t *	schema;
 
+	/* Once a running instance granted the handoff, creating the
+	 * service takes over its bus name and incoming calls queue up
+	 * here until we enter the main loop. */
+	if (opt_handoff && !(handoff = ni_handoff_connect(NULL, NI_SERVER_HANDOFF_TIMEOUT)))
+		ni_warn("no running instance to take over from, starting up normally");
+
 	dbus_server = ni_objectmodel_create_service();
 	if (!dbus_server)
 		ni_fatal("Cannot create server, giving up.");
+
+	/* offload blocking file I/O, e.g. lease files */
+	if (!ni_workpool_global_init(NI_SERVER_WORKER_THREADS))
+		ni_warn("unable to start worker threads, using blocking I/O");
 #ifdef MODEM
 	if (!opt_no_modem_manager) {
 		if (!ni_modem_manager_init(handle_modem_event))
@@ -254,6 +296,8 @@ run_interface_server(void)
 		ni_fatal("unable to initialize netlink prefix listener");
 	if (ni_server_enable_interface_nduseropt_events(handle_interface_nduseropt_events) < 0)
 		ni_fatal("unable to initialize netlink nduseropt listener");
+	if (ni_global.config->rtnl_event.track_routes && !ni_objectmodel_track_routes())
+		ni_fatal("unable to initialize netlink route listener");
 
 	if (ni_udev_is_active() && ni_udev_net_subsystem_available()) {
 		if (ni_server_enable_interface_uevents() < 0)
@@ -277,18 +321,44 @@ run_interface_server(void)
 			ni_fatal("unable to background server");
 	}
 
-	discover_state(dbus_server);
+	/* the old instance sends its state as soon as it lost the name */
+	if (handoff) {
+		handoff_state = ni_handoff_receive(handoff, NI_SERVER_HANDOFF_TIMEOUT);
+		ni_handoff_free(handoff);
+	}
+
+	discover_state(dbus_server, handoff_state);
+	discover_netns_state(dbus_server);
 
+	if (handoff_state) {
+		ni_objectmodel_subscriptions_restore(dbus_server, handoff_state);
+		ni_objectmodel_addrconf_forwarders_resume(ni_global_state_handle(0));
+		xml_node_free(handoff_state);
+	} else
 	if (opt_recover_state)
 		recover_state(opt_state_file);
 
+	/* allow the next instance to take over */
+	handoff_server = ni_handoff_listen(NULL, handle_handoff_request,
+					handle_handoff_cancel, NULL);
+	ni_dbus_server_add_signal_handler(dbus_server, NI_DBUS_BUS_NAME,
+					NI_DBUS_OBJECT_PATH, NI_DBUS_INTERFACE,
+					handle_name_lost, NULL);
+
+	/* publish the state for local readers */
+	if ((state_snapshot = ni_state_snapshot_create(NULL)) != NULL)
+		ni_state_snapshot_publish(state_snapshot, ni_global_state_handle(0));
+	state_feed = ni_state_feed_create(NULL, 0);
+
 #ifdef HAVE_SYSTEMD_SD_DAEMON_H
 	if (opt_systemd) {
+		if (opt_handoff)
+			sd_notifyf(0, "MAINPID=%lu", (unsigned long)getpid());
 		sd_notify(0, "READY=1");
 	}
 #endif
 
-	while (!ni_caught_terminal_signal()) {
+	while (!ni_caught_terminal_signal() && !handed_off) {
 		long timeout;
 
 		do {
@@ -299,9 +369,21 @@ run_interface_server(void)
 			ni_fatal("ni_socket_wait failed");
 	}
 
+	/* the new instance owns the state and the files now; let the
+	 * clients resend the calls on their peer connections to it */
+	if (handed_off) {
+		ni_dbus_server_close_peers(dbus_server, NI_SERVER_PEER_CLOSE_TIMEOUT);
+		exit(0);
+	}
+
 	if (opt_recover_state)
 		ni_objectmodel_save_state(opt_state_file);
 
+	ni_state_feed_free(state_feed);
+	ni_state_snapshot_free(state_snapshot);
+	ni_netns_close_all();
+	ni_workpool_global_free();
+	ni_socket_stall_report();
 	exit(0);
 }
 
@@ -332,8 +414,11 @@ discover_udev_netdev_state(ni_netdev_t *dev)
 }
 
 void
-discover_state(ni_dbus_server_t *server)
+discover_state(ni_dbus_server_t *server, const xml_node_t *handoff_state)
 {
+	ni_uint_array_t saved = NI_UINT_ARRAY_INIT;
+	ni_uint_array_t restored = NI_UINT_ARRAY_INIT;
+	ni_bool_t scanned;
 	ni_netconfig_t *nc;
 	ni_netdev_t *ifp;
 #ifdef MODEM
@@ -345,14 +430,28 @@ discover_state(ni_dbus_server_t *server)
 		ni_fatal("failed to discover interface state");
 
 	if (server) {
+		/* a handed off state replaces udev and state file lookups */
+		if (handoff_state && ni_handoff_state_restore(nc, handoff_state, &restored) < 0)
+			ni_error("unable to restore the handed off state");
+
+		/* look up the existing state files once instead of per device */
+		scanned = ni_client_state_scan(&saved);
 		for (ifp = ni_netconfig_devlist(nc); ifp; ifp = ifp->next) {
-			discover_udev_netdev_state(ifp);
+			if (ni_uint_array_contains(&restored, ifp->link.ifindex))
+				ni_system_ethtool_refresh(ifp);
+			else
+				discover_udev_netdev_state(ifp);
 			ni_objectmodel_register_netif(server, ifp, NULL);
 			if (!ni_client_state_is_valid(ifp->client_state)) {
+				if (scanned && !ni_client_state_scan_contains(&saved, ifp->link.ifindex))
+					ni_netdev_discover_client_state(ifp);
+				else
 				if (!ni_netdev_load_client_state(ifp))
 					ni_netdev_discover_client_state(ifp);
 			}
 		}
+		ni_uint_array_destroy(&restored);
+		ni_uint_array_destroy(&saved);
 #ifdef MODEM
 		for (modem = ni_netconfig_modem_list(nc); modem; modem = modem->list.next)
 			ni_objectmodel_register_modem(server, modem);
@@ -360,6 +459,45 @@ discover_state(ni_dbus_server_t *server)
 	}
 }
 
+/*
+ * Discover the devices of the network namespaces listed in the config
+ * and publish them read-only below their namespace id. All of them are
+ * opened first, so the event listener is set up before the discovery.
+ */
+void
+discover_netns_state(ni_dbus_server_t *server)
+{
+	const ni_string_array_t *names = &ni_global.config->netns;
+	ni_netns_t *ns, *next;
+	ni_netconfig_t *nc;
+	ni_netdev_t *ifp;
+	unsigned int i;
+
+	for (i = 0; i < names->count; ++i) {
+		if (!ni_netns_open(names->data[i]))
+			ni_error("unable to open network namespace %s", names->data[i]);
+	}
+	if (!ni_netns_count())
+		return;
+
+	if (ni_server_enable_netns_events() < 0)
+		ni_fatal("unable to initialize netlink namespace listener");
+
+	for (ns = ni_netns_list(); ns; ns = next) {
+		next = ni_netns_next(ns);
+
+		if (!(nc = ni_netns_state_handle(ns, 1))) {
+			ni_netns_close(ns);
+			continue;
+		}
+		if (!server)
+			continue;
+
+		for (ifp = ni_netconfig_devlist(nc); ifp; ifp = ifp->next)
+			ni_objectmodel_register_netif(server, ifp, NULL);
+	}
+}
+
 /*
  * Recover lease information from the state.xml file.
  * Note that this does *not* restart address configuration protocols like DHCP automatically;
@@ -398,10 +536,13 @@ handle_interface_event(ni_netdev_t *dev, ni_event_t event)
 {
 	const ni_uuid_t *event_uuid = NULL;
 
+	ni_state_snapshot_notify();
 	if (dbus_server) {
 		ni_dbus_object_t *object;
 
-		ni_auto6_on_netdev_event(dev, event);
+		/* addrconf runs in the own namespace only */
+		if (dev->link.netnsid == NI_NETNS_ID_NONE)
+			ni_auto6_on_netdev_event(dev, event);
 
 		object = ni_objectmodel_get_netif_object(dbus_server, dev);
 		if (!object && event == NI_EVENT_DEVICE_CREATE) {
@@ -459,6 +600,11 @@ handle_interface_addr_events(ni_netdev_t *dev, ni_event_t event, const ni_addres
 	ni_addrconf_lease_t *lease, *next;
 
 	ni_server_trace_interface_addr_events(dev, event, ap);
+	ni_state_snapshot_notify();
+	if (dev->link.netnsid != NI_NETNS_ID_NONE)
+		return;
+
+	ni_objectmodel_subscriptions_address_event(dbus_server, dev, event, ap);
 
 	if (ap->family != AF_INET6)
 		return;
@@ -495,24 +641,86 @@ static void
 handle_interface_prefix_events(ni_netdev_t *dev, ni_event_t event, const ni_ipv6_ra_pinfo_t *pi)
 {
 	ni_server_trace_interface_prefix_events(dev, event, pi);
-	ni_auto6_on_prefix_event(dev, event, pi);
+	if (dev->link.netnsid == NI_NETNS_ID_NONE)
+		ni_auto6_on_prefix_event(dev, event, pi);
 }
 
 static void
 handle_interface_nduseropt_events(ni_netdev_t *dev, ni_event_t event)
 {
 	ni_server_trace_interface_nduseropt_events(dev, event);
-	ni_auto6_on_nduseropt_events(dev, event);
+	if (dev->link.netnsid == NI_NETNS_ID_NONE)
+		ni_auto6_on_nduseropt_events(dev, event);
 }
 
 static void
 handle_other_event(ni_event_t event)
 {
 	ni_debug_events("%s(%s)", __func__, ni_event_type_to_name(event));
+	ni_state_snapshot_notify();
 	if (dbus_server)
 		ni_objectmodel_other_event(dbus_server, event, NULL);
 }
 
+/*
+ * Handoff to a new instance: let it take over the bus name and send
+ * it the state once we lost the name, i.e. after the last call routed
+ * to us was processed. We exit then without touching the system.
+ */
+static ni_bool_t
+handle_handoff_request(void *user_data)
+{
+	return ni_dbus_server_allow_replacement(dbus_server,
+			NI_OBJECTMODEL_DBUS_BUS_NAME, TRUE);
+}
+
+static void
+handle_handoff_cancel(void *user_data)
+{
+	ni_dbus_server_allow_replacement(dbus_server,
+			NI_OBJECTMODEL_DBUS_BUS_NAME, FALSE);
+}
+
+static void
+handle_name_lost(ni_dbus_connection_t *conn, ni_dbus_message_t *msg, void *user_data)
+{
+	const char *name = NULL;
+	xml_node_t *state;
+
+	if (!ni_string_eq(dbus_message_get_member(msg), "NameLost") ||
+	    !ni_string_eq(dbus_message_get_sender(msg), NI_DBUS_BUS_NAME))
+		return;
+
+	if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID) ||
+	    !ni_string_eq(name, NI_OBJECTMODEL_DBUS_BUS_NAME))
+		return;
+
+	if (!ni_handoff_pending(handoff_server)) {
+		ni_error("lost dbus name %s", name);
+		return;
+	}
+
+	/* answer the calls received on peer connections, the new
+	 * instance listens on the peer socket now */
+	ni_dbus_server_stop_peers(dbus_server);
+
+	/* finish the queued lease file writes before handing them off */
+	ni_workpool_global_free();
+
+	state = ni_handoff_state_save(ni_global_state_handle(0));
+	ni_objectmodel_subscriptions_save(state);
+	if (ni_handoff_send(handoff_server, state) == 0) {
+		ni_note("state handed off, exiting");
+		handed_off = TRUE;
+	} else {
+		/* the new instance is gone, take the name back; the
+		 * clients use the bus instead of the stopped peers */
+		ni_workpool_global_init(NI_SERVER_WORKER_THREADS);
+		handle_handoff_cancel(NULL);
+	}
+	xml_node_free(state);
+}
+
 /*
  * Modem event - device was plugged
  */
@@ -66,12 +66,28 @@ typedef struct ni_server_preference {
 	int			weight;
 } ni_server_preference_t;
 
+/*
+ * rtnetlink event classes, each received on a separate socket
+ * and processed in this order of priority
+ */
+typedef enum {
+	NI_CONFIG_RTNL_EVENT_LINK = 0,
+	NI_CONFIG_RTNL_EVENT_ADDR,
+	NI_CONFIG_RTNL_EVENT_RULE,
+	NI_CONFIG_RTNL_EVENT_ROUTE,
+
+	NI_CONFIG_RTNL_EVENT_CLASS_MAX
+} ni_config_rtnl_event_class_t;
+
 typedef struct ni_config_rtnl_event {
 	/*
 	 * rtnetlink event related tunables
 	 */
 	unsigned int	recv_buff_length;
+	unsigned int	class_recv_buff_length[NI_CONFIG_RTNL_EVENT_CLASS_MAX];
 	unsigned int	mesg_buff_length;
+	unsigned int	ingest_queue_length;
+	ni_bool_t	track_routes;
 } ni_config_rtnl_event_t;
 
 typedef enum {
@@ -172,6 +188,7 @@ typedef struct ni_config {
 
 	struct {
 	    unsigned int		default_allow_update;
+	    ni_bool_t			leaseinfo_index;
 
 	    ni_config_dhcp4_t		dhcp4;
 	    ni_config_dhcp6_t		dhcp6;
@@ -193,8 +210,10 @@ typedef struct ni_config {
 
 	char *			dbus_name;
 	char *			dbus_type;
+	ni_bool_t		dbus_peer;
 
 	ni_config_rtnl_event_t	rtnl_event;
+	ni_string_array_t	netns;
 
 	ni_config_bonding_t	bonding;
 	ni_config_teamd_t	teamd;
@@ -216,6 +235,8 @@ extern const ni_config_dhcp6_t *	ni_config_dhcp6_find_device(const char *);
 
 extern ni_config_bonding_ctl_t	ni_config_bonding_ctl(void);
 
+extern const char *	ni_config_rtnl_event_class_to_name(ni_config_rtnl_event_class_t);
+
 extern ni_bool_t	ni_config_teamd_enable(ni_config_teamd_ctl_t);
 extern ni_bool_t	ni_config_teamd_disable(void);
 extern ni_bool_t	ni_config_teamd_enabled(void);
@@ -12,6 +12,7 @@
 #include <wicked/logging.h>
 #include <wicked/socket.h>
 #include <stdlib.h>
+#include <fcntl.h>
 
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -21,7 +22,10 @@
 #include <netdb.h>
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 
+#include "socket_priv.h"
+#include "util_priv.h"
 
 /*
  * Build a getaddrinfo_a request
@@ -197,6 +201,298 @@ ni_resolve_hostnames_timed(int af, unsigned int count, const char *hostnames[],
 	return 0;
 }
 
+/*
+ * Asynchronous hostname resolution integrated into the socket
+ * event loop. The getaddrinfo_a completion notification wakes
+ * up ni_socket_wait via a pipe; results are kept in a cache
+ * shared by all callers and refreshed when they expire or the
+ * caller passes a newer resolver generation. Entries nobody asked
+ * for within a TTL after they expired are dropped, and the cache
+ * never holds more than NI_RESOLVE_ASYNC_CACHE_MAX entries, pending
+ * ones included: new lookups are rejected while all of them are.
+ */
+#define NI_RESOLVE_ASYNC_CACHE_TTL	60	/* sec */
+#define NI_RESOLVE_ASYNC_CACHE_MAX	256
+#define NI_RESOLVE_ASYNC_RETRY_TIME	1	/* sec */
+
+typedef enum {
+	NI_RESOLVE_ASYNC_PENDING,
+	NI_RESOLVE_ASYNC_RESOLVED,
+	NI_RESOLVE_ASYNC_FAILED,
+} ni_resolve_async_state_t;
+
+typedef struct ni_resolve_async	ni_resolve_async_t;
+struct ni_resolve_async {
+	ni_resolve_async_t *		next;
+
+	char *				hostname;
+	int				family;
+	unsigned int			generation;
+
+	ni_resolve_async_state_t	state;
+	struct gaicb *			cb;
+	ni_sockaddr_t			address;
+	struct timeval			expires;
+};
+
+static ni_resolve_async_t *		ni_resolve_async_cache;
+static unsigned int			ni_resolve_async_count;
+static ni_socket_t *			ni_resolve_async_sock;
+
+/* the pipe write end, used by the resolver threads */
+static pthread_mutex_t			ni_resolve_async_lock = PTHREAD_MUTEX_INITIALIZER;
+static int				ni_resolve_async_wfd = -1;
+
+static void
+ni_resolve_async_notify(union sigval sv)
+{
+	static const char c = 0;
+
+	/* runs in a resolver thread: just wake up the main loop */
+	pthread_mutex_lock(&ni_resolve_async_lock);
+	if (ni_resolve_async_wfd >= 0 && write(ni_resolve_async_wfd, &c, sizeof(c)) < 0) {
+		/* pipe full: main loop has a wakeup already */
+	}
+	pthread_mutex_unlock(&ni_resolve_async_lock);
+}
+
+static void
+ni_resolve_async_free(ni_resolve_async_t *req)
+{
+	if (req->cb)
+		gaicb_free(req->cb);
+	ni_string_free(&req->hostname);
+	free(req);
+}
+
+/*
+ * Drop the entries which are stale for a TTL; when the cache is
+ * still full, drop the one which expired first. Pending requests
+ * stay, the resolver threads still refer to them.
+ */
+static void
+ni_resolve_async_expire(const struct timeval *now)
+{
+	ni_resolve_async_t **pos, **oldest = NULL, *req;
+
+	for (pos = &ni_resolve_async_cache; (req = *pos); ) {
+		if (req->state == NI_RESOLVE_ASYNC_PENDING) {
+			pos = &req->next;
+			continue;
+		}
+
+		if (now->tv_sec >= req->expires.tv_sec + NI_RESOLVE_ASYNC_CACHE_TTL) {
+			*pos = req->next;
+			ni_resolve_async_free(req);
+			ni_resolve_async_count--;
+			continue;
+		}
+
+		if (!oldest || timercmp(&req->expires, &(*oldest)->expires, <))
+			oldest = pos;
+		pos = &req->next;
+	}
+
+	if (ni_resolve_async_count >= NI_RESOLVE_ASYNC_CACHE_MAX && oldest) {
+		req = *oldest;
+		*oldest = req->next;
+		ni_debug_application("resolver cache full, dropping %s", req->hostname);
+		ni_resolve_async_free(req);
+		ni_resolve_async_count--;
+	}
+}
+
+static void
+ni_resolve_async_complete(ni_resolve_async_t *req)
+{
+	struct timeval now;
+	int gerr;
+
+	ni_timer_get_time(&now);
+	req->expires = now;
+
+	gerr = gaicb_get_address(req->cb, &req->address);
+	if (gerr == 0) {
+		req->state = NI_RESOLVE_ASYNC_RESOLVED;
+		req->expires.tv_sec += NI_RESOLVE_ASYNC_CACHE_TTL;
+		ni_debug_application("resolved %s to %s", req->hostname,
+				ni_sockaddr_print(&req->address));
+	} else {
+		req->state = NI_RESOLVE_ASYNC_FAILED;
+		req->expires.tv_sec += NI_RESOLVE_ASYNC_RETRY_TIME;
+		memset(&req->address, 0, sizeof(req->address));
+		ni_debug_application("cannot resolve %s: %s", req->hostname,
+				gai_strerror(gerr));
+	}
+
+	gaicb_free(req->cb);
+	req->cb = NULL;
+}
+
+static void
+ni_resolve_async_receive(ni_socket_t *sock)
+{
+	ni_resolve_async_t *req;
+	char buf[64];
+
+	while (read(sock->__fd, buf, sizeof(buf)) > 0)
+		;
+
+	for (req = ni_resolve_async_cache; req; req = req->next) {
+		if (req->state != NI_RESOLVE_ASYNC_PENDING || !req->cb)
+			continue;
+
+		if (gai_error(req->cb) != EAI_INPROGRESS)
+			ni_resolve_async_complete(req);
+	}
+}
+
+static void
+ni_resolve_async_close(ni_socket_t *sock)
+{
+	if (sock->__fd >= 0)
+		close(sock->__fd);
+	sock->__fd = -1;
+
+	pthread_mutex_lock(&ni_resolve_async_lock);
+	if (ni_resolve_async_wfd >= 0)
+		close(ni_resolve_async_wfd);
+	ni_resolve_async_wfd = -1;
+	pthread_mutex_unlock(&ni_resolve_async_lock);
+
+	if (ni_resolve_async_sock == sock)
+		ni_resolve_async_sock = NULL;
+}
+
+static ni_bool_t
+ni_resolve_async_init(void)
+{
+	int pfd[2];
+
+	if (ni_resolve_async_sock)
+		return TRUE;
+
+	if (pipe(pfd) < 0) {
+		ni_error("%s: unable to create pipe: %m", __func__);
+		return FALSE;
+	}
+	fcntl(pfd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pfd[1], F_SETFD, FD_CLOEXEC);
+	fcntl(pfd[0], F_SETFL, O_NONBLOCK);
+	fcntl(pfd[1], F_SETFL, O_NONBLOCK);
+
+	if (!(ni_resolve_async_sock = ni_socket_wrap(pfd[0], SOCK_STREAM))) {
+		close(pfd[0]);
+		close(pfd[1]);
+		return FALSE;
+	}
+	pthread_mutex_lock(&ni_resolve_async_lock);
+	ni_resolve_async_wfd = pfd[1];
+	pthread_mutex_unlock(&ni_resolve_async_lock);
+	ni_resolve_async_sock->receive = ni_resolve_async_receive;
+	ni_resolve_async_sock->close = ni_resolve_async_close;
+	ni_socket_activate(ni_resolve_async_sock);
+	return TRUE;
+}
+
+static ni_resolve_async_t *
+ni_resolve_async_find(const char *hostname, int af)
+{
+	ni_resolve_async_t *req;
+
+	for (req = ni_resolve_async_cache; req; req = req->next) {
+		if (req->family == af && ni_string_eq(req->hostname, hostname))
+			return req;
+	}
+	return NULL;
+}
+
+static int
+ni_resolve_async_start(ni_resolve_async_t *req, unsigned int generation)
+{
+	struct sigevent sev;
+	int rv;
+
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify = SIGEV_THREAD;
+	sev.sigev_notify_function = ni_resolve_async_notify;
+
+	req->generation = generation;
+	req->cb = gaicb_new(req->hostname, req->family);
+	rv = getaddrinfo_a(GAI_NOWAIT, &req->cb, 1, &sev);
+	if (rv != 0) {
+		ni_error("getaddrinfo_a: %s", gai_strerror(rv));
+		gaicb_free(req->cb);
+		req->cb = NULL;
+
+		req->state = NI_RESOLVE_ASYNC_FAILED;
+		ni_timer_get_time(&req->expires);
+		req->expires.tv_sec += NI_RESOLVE_ASYNC_RETRY_TIME;
+		return -1;
+	}
+
+	req->state = NI_RESOLVE_ASYNC_PENDING;
+	return 0;
+}
+
+/*
+ * Resolve a hostname without blocking.
+ *
+ * Returns 1 and the address when resolved, 0 when the request
+ * is in progress (the socket loop wakes up on completion) and
+ * -1 when the hostname is not resolvable (retried later).
+ * A generation newer than the cached one forces a new lookup,
+ * e.g. after a resolver configuration change.
+ */
+int
+ni_resolve_hostname_async(const char *hostname, int af, unsigned int generation, ni_sockaddr_t *addr)
+{
+	ni_resolve_async_t *req;
+	struct timeval now;
+
+	if (ni_string_empty(hostname) || !addr)
+		return -1;
+
+	if (!ni_resolve_async_init())
+		return ni_resolve_hostname_timed(hostname, af, addr, 1) > 0 ? 1 : -1;
+
+	if (!(req = ni_resolve_async_find(hostname, af))) {
+		ni_timer_get_time(&now);
+		ni_resolve_async_expire(&now);
+		if (ni_resolve_async_count >= NI_RESOLVE_ASYNC_CACHE_MAX) {
+			ni_debug_application("resolver cache full of pending lookups, "
+					"rejecting %s", hostname);
+			return -1;
+		}
+
+		req = xcalloc(1, sizeof(*req));
+		ni_string_dup(&req->hostname, hostname);
+		req->family = af;
+		req->next = ni_resolve_async_cache;
+		ni_resolve_async_cache = req;
+		ni_resolve_async_count++;
+
+		return ni_resolve_async_start(req, generation) < 0 ? -1 : 0;
+	}
+
+	if (req->state == NI_RESOLVE_ASYNC_PENDING) {
+		/* completion may be still unnoticed by the socket loop */
+		if (gai_error(req->cb) == EAI_INPROGRESS)
+			return 0;
+		ni_resolve_async_complete(req);
+	}
+
+	ni_timer_get_time(&now);
+	if (req->generation < generation || timercmp(&now, &req->expires, >=))
+		return ni_resolve_async_start(req, generation) < 0 ? -1 : 0;
+
+	if (req->state != NI_RESOLVE_ASYNC_RESOLVED)
+		return -1;
+
+	*addr = req->address;
+	return 1;
+}
+
 static int
 __ni_resolve_reverse(const ni_sockaddr_t *addr, char **hostname)
 {
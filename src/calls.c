@@ -22,6 +22,8 @@
 #include <wicked/dbus-service.h>
 
 #include "client/wicked-client.h"
+#include "dbus-objects/model.h"
+#include "util_priv.h"
 
 /*
  * Error context - this is an opaque type.
@@ -43,6 +45,15 @@ struct ni_call_error_context {
 
 static void	ni_call_error_context_destroy(ni_call_error_context_t *);
 
+/*
+ * Compound call - this is an opaque type, too.
+ * The steps are kept in the form of the callCompound argument.
+ */
+struct ni_call_compound {
+	ni_dbus_object_t *	object;
+	ni_dbus_variant_t	steps;
+};
+
 /*
  * Create the client and return the handle of the root object
  */
@@ -451,52 +462,240 @@ ni_call_device_method_xml(ni_dbus_object_t *object, const char *method_name, xml
 	return ni_call_common_xml(object, service, method, config, callback_list, NULL);
 }
 
+/*
+ * Compound calls execute an ordered list of method calls on one
+ * device using a single Interface.callCompound() round trip.
+ * When the server does not provide it (or there is only a single
+ * step), the steps are executed one by one.
+ */
+ni_call_compound_t *
+ni_call_compound_new(ni_dbus_object_t *object)
+{
+	ni_call_compound_t *compound;
+
+	if (!object)
+		return NULL;
+
+	compound = xcalloc(1, sizeof(*compound));
+	compound->object = object;
+	ni_dbus_dict_array_init(&compound->steps);
+	return compound;
+}
+
+void
+ni_call_compound_free(ni_call_compound_t *compound)
+{
+	if (compound) {
+		ni_dbus_variant_destroy(&compound->steps);
+		free(compound);
+	}
+}
+
+/*
+ * Append a step; the argument variants are taken over by the compound.
+ */
+static int
+ni_call_compound_add_step(ni_call_compound_t *compound,
+				const ni_dbus_service_t *service, const ni_dbus_method_t *method,
+				unsigned int argc, ni_dbus_variant_t *argv)
+{
+	ni_dbus_variant_t *step, *args;
+	unsigned int i;
+
+	if (!(step = ni_dbus_dict_array_add(&compound->steps)))
+		return -NI_ERROR_GENERAL_FAILURE;
+
+	ni_dbus_dict_add_string(step, "interface", service->name);
+	ni_dbus_dict_add_string(step, "method", method->name);
+	args = ni_dbus_dict_add(step, "arguments");
+	ni_dbus_variant_init_variant_array(args);
+	for (i = 0; i < argc; ++i) {
+		*ni_dbus_variant_append_variant_element(args) = argv[i];
+		memset(&argv[i], 0, sizeof(argv[i]));
+	}
+	return 0;
+}
+
+static int
+ni_call_compound_step_call(ni_dbus_object_t *object, const ni_dbus_variant_t *step)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	DBusError error = DBUS_ERROR_INIT;
+	const char *interface = NULL;
+	const char *method = NULL;
+	const ni_dbus_variant_t *args;
+	unsigned int argc = 0;
+	int rv = 0;
+
+	ni_dbus_dict_get_string(step, "interface", &interface);
+	ni_dbus_dict_get_string(step, "method", &method);
+	if ((args = ni_dbus_dict_get(step, "arguments")))
+		argc = args->array.len;
+
+	if (!ni_dbus_object_call_variant(object, interface, method,
+				argc, argc ? args->variant_array_value : NULL,
+				1, &result, &error)) {
+		ni_dbus_print_error(&error, "%s.%s() failed", interface, method);
+		rv = ni_dbus_get_error(&error, NULL);
+	}
+
+	ni_dbus_variant_destroy(&result);
+	dbus_error_free(&error);
+	return rv;
+}
+
+static int
+ni_call_compound_call(ni_call_compound_t *compound, const ni_dbus_service_t *service,
+			ni_bool_t *supported)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	DBusError error = DBUS_ERROR_INIT;
+	const char *interface, *method, *name, *message;
+	const ni_dbus_variant_t *res;
+	unsigned int i;
+	int rv = 0;
+
+	if (!ni_dbus_object_call_variant(compound->object, service->name, "callCompound",
+				1, &compound->steps, 1, &result, &error)) {
+		if (dbus_error_has_name(&error, DBUS_ERROR_UNKNOWN_METHOD)) {
+			*supported = FALSE;
+		} else {
+			ni_dbus_print_error(&error, "%s.callCompound() failed", service->name);
+			rv = ni_dbus_get_error(&error, NULL);
+		}
+		goto done;
+	}
+
+	if (!ni_dbus_variant_is_dict_array(&result)) {
+		ni_error("%s: unexpected %s.callCompound() result",
+				compound->object->path, service->name);
+		rv = -NI_ERROR_GENERAL_FAILURE;
+		goto done;
+	}
+
+	for (i = 0; i < result.array.len; ++i) {
+		res = &result.variant_array_value[i];
+		if (!ni_dbus_dict_get_string(res, "error-name", &name))
+			continue;
+
+		interface = method = message = NULL;
+		ni_dbus_dict_get_string(res, "interface", &interface);
+		ni_dbus_dict_get_string(res, "method", &method);
+		ni_dbus_dict_get_string(res, "error-message", &message);
+
+		dbus_set_error(&error, name, "%s", message ?: "");
+		ni_dbus_print_error(&error, "%s.%s() failed", interface, method);
+		if (rv == 0)
+			rv = ni_dbus_get_error(&error, NULL);
+		dbus_error_free(&error);
+	}
+
+	if (result.array.len < compound->steps.array.len) {
+		ni_error("%s: %s.callCompound() executed %u of %u steps",
+				compound->object->path, service->name,
+				result.array.len, compound->steps.array.len);
+		if (rv == 0)
+			rv = -NI_ERROR_DEVICE_NOT_KNOWN;
+	}
+
+done:
+	ni_dbus_variant_destroy(&result);
+	dbus_error_free(&error);
+	return rv;
+}
+
+/*
+ * The steps are independent, a failing step does not stop the
+ * following ones. Every failed step is reported; the error of the
+ * first one is returned.
+ */
 int
-ni_call_set_client_state_control(ni_dbus_object_t *object, const ni_client_state_control_t *ctrl)
+ni_call_compound_execute(ni_call_compound_t *compound)
+{
+	const ni_dbus_service_t *service;
+	unsigned int i;
+	int rv, ret = 0;
+
+	if (!compound || !compound->steps.array.len)
+		return 0;
+
+	if (compound->steps.array.len > 1 &&
+	    (service = ni_dbus_object_get_service_for_method(compound->object, "callCompound"))) {
+		ni_bool_t supported = TRUE;
+
+		rv = ni_call_compound_call(compound, service, &supported);
+		if (supported)
+			return rv;
+	}
+
+	for (i = 0; i < compound->steps.array.len; ++i) {
+		rv = ni_call_compound_step_call(compound->object,
+				&compound->steps.variant_array_value[i]);
+		if (rv < 0 && ret == 0)
+			ret = rv;
+	}
+	return ret;
+}
+
+static int
+ni_call_compound_single(ni_call_compound_t *compound, int rv)
+{
+	if (rv == 0)
+		rv = ni_call_compound_execute(compound);
+	ni_call_compound_free(compound);
+	return rv;
+}
+
+int
+ni_call_compound_set_client_state_control(ni_call_compound_t *compound, const ni_client_state_control_t *ctrl)
 {
 	const ni_dbus_service_t *service;
 	const ni_dbus_method_t *method;
 	ni_dbus_variant_t dict;
 	int rv;
 
-	if ((rv = ni_get_device_method(object, "setClientControl", &service, &method)) < 0)
+	if (!compound || !ctrl)
+		return -NI_ERROR_INVALID_ARGS;
+
+	if ((rv = ni_get_device_method(compound->object, "setClientControl", &service, &method)) < 0)
 		return rv;
 
 	memset(&dict, 0, sizeof(dict));
 	ni_dbus_variant_init_dict(&dict);
-	if (!ni_objectmodel_netif_client_state_control_to_dict(ctrl, &dict))
+	if (!ni_objectmodel_netif_client_state_control_to_dict(ctrl, &dict)) {
+		ni_dbus_variant_destroy(&dict);
 		return -1;
+	}
 
-	rv = ni_call_device_method_common(object, service, method, 1, &dict, NULL, NULL);
-
-	ni_dbus_variant_destroy(&dict);
-	return rv;
+	return ni_call_compound_add_step(compound, service, method, 1, &dict);
 }
 
 int
-ni_call_set_client_state_config(ni_dbus_object_t *object, const ni_client_state_config_t *conf)
+ni_call_compound_set_client_state_config(ni_call_compound_t *compound, const ni_client_state_config_t *conf)
 {
 	const ni_dbus_service_t *service;
 	const ni_dbus_method_t *method;
 	ni_dbus_variant_t dict;
 	int rv;
 
-	if ((rv = ni_get_device_method(object, "setClientConfig", &service, &method)) < 0)
+	if (!compound || !conf)
+		return -NI_ERROR_INVALID_ARGS;
+
+	if ((rv = ni_get_device_method(compound->object, "setClientConfig", &service, &method)) < 0)
 		return rv;
 
 	memset(&dict, 0, sizeof(dict));
 	ni_dbus_variant_init_dict(&dict);
-	if (!ni_objectmodel_netif_client_state_config_to_dict(conf, &dict))
+	if (!ni_objectmodel_netif_client_state_config_to_dict(conf, &dict)) {
+		ni_dbus_variant_destroy(&dict);
 		return -1;
+	}
 
-	rv = ni_call_device_method_common(object, service, method, 1, &dict, NULL, NULL);
-
-	ni_dbus_variant_destroy(&dict);
-	return rv;
+	return ni_call_compound_add_step(compound, service, method, 1, &dict);
 }
 
 int
-ni_call_set_client_state_scripts(ni_dbus_object_t *object, const ni_client_state_scripts_t *scripts)
+ni_call_compound_set_client_state_scripts(ni_call_compound_t *compound, const ni_client_state_scripts_t *scripts)
 {
 	ni_dbus_xml_validate_context_t ctx;
 	const ni_dbus_service_t *service;
@@ -505,7 +704,10 @@ ni_call_set_client_state_scripts(ni_dbus_object_t *object, const ni_client_state
 	xml_node_t *node;
 	int rv, argc;
 
-	if ((rv = ni_get_device_method(object, "setClientScripts", &service, &method)) < 0)
+	if (!compound || !scripts)
+		return -NI_ERROR_INVALID_ARGS;
+
+	if ((rv = ni_get_device_method(compound->object, "setClientScripts", &service, &method)) < 0)
 		return rv;
 
 	node = scripts->node;
@@ -528,13 +730,56 @@ ni_call_set_client_state_scripts(ni_dbus_object_t *object, const ni_client_state
 		}
 	}
 
-	rv = ni_call_device_method_common(object, service, method, argc, argv, NULL, NULL);
+	rv = ni_call_compound_add_step(compound, service, method, argc, argv);
 out:
 	while (argc--)
 		ni_dbus_variant_destroy(&argv[argc]);
 	return rv;
 }
 
+int
+ni_call_compound_clear_event_filters(ni_call_compound_t *compound)
+{
+	const ni_dbus_service_t *service;
+	const ni_dbus_method_t *method;
+	int rv;
+
+	if (!compound)
+		return -NI_ERROR_INVALID_ARGS;
+
+	if ((rv = ni_get_device_method(compound->object, "clearEventFilters", &service, &method)) < 0)
+		return rv;
+
+	return ni_call_compound_add_step(compound, service, method, 0, NULL);
+}
+
+int
+ni_call_set_client_state_control(ni_dbus_object_t *object, const ni_client_state_control_t *ctrl)
+{
+	ni_call_compound_t *compound = ni_call_compound_new(object);
+
+	return ni_call_compound_single(compound,
+			ni_call_compound_set_client_state_control(compound, ctrl));
+}
+
+int
+ni_call_set_client_state_config(ni_dbus_object_t *object, const ni_client_state_config_t *conf)
+{
+	ni_call_compound_t *compound = ni_call_compound_new(object);
+
+	return ni_call_compound_single(compound,
+			ni_call_compound_set_client_state_config(compound, conf));
+}
+
+int
+ni_call_set_client_state_scripts(ni_dbus_object_t *object, const ni_client_state_scripts_t *scripts)
+{
+	ni_call_compound_t *compound = ni_call_compound_new(object);
+
+	return ni_call_compound_single(compound,
+			ni_call_compound_set_client_state_scripts(compound, scripts));
+}
+
 /*
  * Call setMonitor(bool) on a device
  */
@@ -556,15 +801,254 @@ ni_call_link_monitor(ni_dbus_object_t *object)
  */
 int
 ni_call_clear_event_filters(ni_dbus_object_t *object)
+{
+	ni_call_compound_t *compound = ni_call_compound_new(object);
+
+	return ni_call_compound_single(compound,
+			ni_call_compound_clear_event_filters(compound));
+}
+
+/*
+ * Delete several devices using a single InterfaceList.deleteDevices call.
+ * The ifindexes of the devices actually deleted are returned in deleted.
+ */
+int
+ni_call_delete_devices(const ni_uint_array_t *ifindexes, ni_uint_array_t *deleted)
+{
+	ni_dbus_variant_t args = NI_DBUS_VARIANT_INIT;
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	DBusError error = DBUS_ERROR_INIT;
+	const ni_dbus_variant_t *var = NULL;
+	ni_dbus_object_t *list_object;
+	unsigned int i, ifindex;
+	int rv = 0;
+
+	if (!ifindexes || !deleted)
+		return -NI_ERROR_INVALID_ARGS;
+	if (!(list_object = ni_call_get_netif_list_object()))
+		return -NI_ERROR_GENERAL_FAILURE;
+
+	ni_dbus_variant_init_dict(&args);
+	for (i = 0; i < ifindexes->count; ++i)
+		ni_dbus_dict_add_uint32(&args, "ifindex", ifindexes->data[i]);
+
+	if (!ni_dbus_object_call_variant(list_object, NI_OBJECTMODEL_NETIFLIST_INTERFACE,
+				"deleteDevices", 1, &args, 1, &result, &error)) {
+		ni_dbus_print_error(&error, "%s.deleteDevices() failed", list_object->path);
+		rv = ni_dbus_get_error(&error, NULL);
+	} else {
+		while ((var = ni_dbus_dict_get_next(&result, "ifindex", var))) {
+			if (ni_dbus_variant_get_uint32(var, &ifindex))
+				ni_uint_array_append(deleted, ifindex);
+		}
+	}
+
+	ni_dbus_variant_destroy(&args);
+	ni_dbus_variant_destroy(&result);
+	dbus_error_free(&error);
+	return rv;
+}
+
+/*
+ * Retrieve the address or route list of a device page by page,
+ * using Interface.getAddresses or Interface.getRoutes.
+ * A route walk passes the "resume" key of the previous page back,
+ * so wickedd continues it when the routes changed meanwhile; when
+ * the addresses change between two pages, wickedd refuses to
+ * continue the walk and we start over.
+ */
+#define NI_CALL_LIST_PAGE_SIZE		1024
+#define NI_CALL_LIST_MAX_RESTARTS	3
+
+typedef struct ni_call_list_ops {
+	dbus_bool_t	(*add)(void *, const ni_dbus_variant_t *, DBusError *);
+	void		(*reset)(void *);
+} ni_call_list_ops_t;
+
+static int
+ni_call_device_get_list(ni_dbus_object_t *object, const char *method, const char *name,
+			unsigned int family, const ni_call_list_ops_t *ops, void *list)
+{
+	ni_dbus_variant_t args = NI_DBUS_VARIANT_INIT;
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	DBusError error = DBUS_ERROR_INIT;
+	const ni_dbus_variant_t *page;
+	uint32_t cursor = 0, generation = 0;
+	unsigned int restarts = 0;
+	const char *key;
+	char *resume = NULL;
+	ni_bool_t more;
+	int rv = 0;
+
+	do {
+		ni_dbus_variant_init_dict(&args);
+		ni_dbus_dict_add_uint32(&args, "family", family);
+		ni_dbus_dict_add_uint32(&args, "cursor", cursor);
+		ni_dbus_dict_add_uint32(&args, "generation", generation);
+		ni_dbus_dict_add_uint32(&args, "count", NI_CALL_LIST_PAGE_SIZE);
+		if (cursor && resume)
+			ni_dbus_dict_add_string(&args, "resume", resume);
+
+		more = FALSE;
+		if (!ni_dbus_object_call_variant(object, NI_OBJECTMODEL_NETIF_INTERFACE,
+					method, 1, &args, 1, &result, &error)) {
+			rv = ni_dbus_get_error(&error, NULL);
+			if (rv == -NI_ERROR_RETRY_OPERATION &&
+			    restarts++ < NI_CALL_LIST_MAX_RESTARTS) {
+				ni_debug_dbus("%s.%s(): list changed, restarting",
+						object->path, method);
+				ops->reset(list);
+				cursor = generation = 0;
+				ni_string_free(&resume);
+				more = TRUE;
+				rv = 0;
+			} else {
+				ni_dbus_print_error(&error, "%s.%s() failed",
+						object->path, method);
+			}
+		} else
+		if (!(page = ni_dbus_dict_get(&result, name))
+		 || !ops->add(list, page, &error)) {
+			ni_error("%s.%s(): unexpected result", object->path, method);
+			rv = -NI_ERROR_GENERAL_FAILURE;
+		} else
+		if (ni_dbus_dict_get_uint32(&result, "cursor", &cursor) && cursor) {
+			if (!ni_dbus_dict_get_uint32(&result, "generation", &generation))
+				generation = 0;
+			if (ni_dbus_dict_get_string(&result, "resume", &key))
+				ni_string_dup(&resume, key);
+			more = TRUE;
+		}
+
+		ni_dbus_variant_destroy(&args);
+		ni_dbus_variant_destroy(&result);
+		dbus_error_free(&error);
+	} while (rv == 0 && more);
+
+	ni_string_free(&resume);
+	return rv;
+}
+
+static dbus_bool_t
+ni_call_device_add_addresses(void *list, const ni_dbus_variant_t *page, DBusError *error)
+{
+	return __ni_objectmodel_add_address_list(list, page, error);
+}
+
+static void
+ni_call_device_reset_addresses(void *list)
+{
+	ni_address_list_destroy(list);
+}
+
+static dbus_bool_t
+ni_call_device_add_routes(void *list, const ni_dbus_variant_t *page, DBusError *error)
+{
+	return __ni_objectmodel_add_route_list(list, page, error);
+}
+
+static void
+ni_call_device_reset_routes(void *list)
+{
+	ni_route_tables_destroy(list);
+}
+
+static const ni_call_list_ops_t		ni_call_device_address_ops = {
+	.add	= ni_call_device_add_addresses,
+	.reset	= ni_call_device_reset_addresses,
+};
+static const ni_call_list_ops_t		ni_call_device_route_ops = {
+	.add	= ni_call_device_add_routes,
+	.reset	= ni_call_device_reset_routes,
+};
+
+/*
+ * The list is replaced only when the whole list has been retrieved;
+ * on failure, the caller keeps the list it had.
+ */
+int
+ni_call_device_get_addresses(ni_dbus_object_t *object, unsigned int family, ni_address_t **list)
+{
+	ni_address_t *addrs = NULL;
+	int rv;
+
+	if (!object || !list)
+		return -NI_ERROR_INVALID_ARGS;
+
+	rv = ni_call_device_get_list(object, "getAddresses", "addresses", family,
+					&ni_call_device_address_ops, &addrs);
+	if (rv == 0) {
+		ni_address_list_destroy(list);
+		*list = addrs;
+	} else {
+		ni_address_list_destroy(&addrs);
+	}
+	return rv;
+}
+
+int
+ni_call_device_get_routes(ni_dbus_object_t *object, unsigned int family, ni_route_table_t **list)
+{
+	ni_route_table_t *routes = NULL;
+	int rv;
+
+	if (!object || !list)
+		return -NI_ERROR_INVALID_ARGS;
+
+	rv = ni_call_device_get_list(object, "getRoutes", "routes", family,
+					&ni_call_device_route_ops, &routes);
+	if (rv == 0) {
+		ni_route_tables_destroy(list);
+		*list = routes;
+	} else {
+		ni_route_tables_destroy(&routes);
+	}
+	return rv;
+}
+
+/*
+ * Fetch the "addresses" or "routes" list of a device that was too long
+ * to be sent as property and add it to the Interface property dict, as
+ * if it had been sent along with the other properties.
+ */
+int
+ni_call_device_get_list_property(const char *object_path, const char *name, ni_dbus_variant_t *dict)
 {
 	const ni_dbus_service_t *service;
-	const ni_dbus_method_t *method;
+	ni_dbus_object_t *object;
+	ni_address_t *addrs = NULL;
+	ni_route_table_t *routes = NULL;
+	ni_dbus_variant_t *var;
 	int rv;
 
-	if ((rv = ni_get_device_method(object, "clearEventFilters", &service, &method)) < 0)
-		return rv;
+	if (!object_path || !name || !dict)
+		return -NI_ERROR_INVALID_ARGS;
 
-	return ni_call_device_method_common(object, service, method, 0, NULL, NULL, NULL);
+	if (!(service = ni_objectmodel_service_by_name(NI_OBJECTMODEL_NETIF_INTERFACE)) ||
+	    !(object = __ni_call_get_proxy_object(service, object_path)))
+		return -NI_ERROR_DEVICE_NOT_KNOWN;
+
+	if (ni_string_eq(name, "addresses")) {
+		if ((rv = ni_call_device_get_addresses(object, AF_UNSPEC, &addrs)) == 0) {
+			var = ni_dbus_dict_add(dict, name);
+			ni_dbus_dict_array_init(var);
+			if (!__ni_objectmodel_get_address_list(addrs, var, NULL))
+				rv = -NI_ERROR_GENERAL_FAILURE;
+		}
+		ni_address_list_destroy(&addrs);
+	} else
+	if (ni_string_eq(name, "routes")) {
+		if ((rv = ni_call_device_get_routes(object, AF_UNSPEC, &routes)) == 0) {
+			var = ni_dbus_dict_add(dict, name);
+			ni_dbus_dict_array_init(var);
+			if (!__ni_objectmodel_get_route_list(routes, var, NULL))
+				rv = -NI_ERROR_GENERAL_FAILURE;
+		}
+		ni_route_tables_destroy(&routes);
+	} else {
+		rv = -NI_ERROR_INVALID_ARGS;
+	}
+	return rv;
 }
 
 /*
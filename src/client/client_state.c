@@ -11,7 +11,9 @@
 #include "config.h"
 #endif
 #include <sys/time.h>
+#include <dirent.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <limits.h>
 #include <errno.h>
 #include <unistd.h>
@@ -553,6 +555,57 @@ ni_client_state_move(unsigned int ifindex_old, unsigned int ifindex_new)
 	return TRUE;
 }
 
+/*
+ * Collect the sorted interface indexes having a state file with a
+ * single directory scan, so discovery of many interfaces does not
+ * need to probe for a (mostly missing) state file of each of them.
+ */
+static int
+__ni_client_state_ifindex_cmp(const void *a, const void *b)
+{
+	unsigned int x = *(const unsigned int *)a;
+	unsigned int y = *(const unsigned int *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+ni_bool_t
+ni_client_state_scan(ni_uint_array_t *ifindexes)
+{
+	const char *dirname = ni_config_statedir();
+	struct dirent *dp;
+	unsigned int ifindex;
+	char dummy;
+	DIR *dir;
+
+	if (!ifindexes || !(dir = opendir(dirname)))
+		return FALSE;
+
+	ni_uint_array_destroy(ifindexes);
+	while ((dp = readdir(dir)) != NULL) {
+		if (sscanf(dp->d_name, "state-%u.xm%c", &ifindex, &dummy) != 2 ||
+		    dummy != 'l' || !ifindex)
+			continue;
+		ni_uint_array_append(ifindexes, ifindex);
+	}
+	closedir(dir);
+
+	if (ifindexes->count > 1)
+		qsort(ifindexes->data, ifindexes->count, sizeof(ifindexes->data[0]),
+				__ni_client_state_ifindex_cmp);
+	return TRUE;
+}
+
+ni_bool_t
+ni_client_state_scan_contains(const ni_uint_array_t *ifindexes, unsigned int ifindex)
+{
+	if (!ifindexes || !ifindexes->count)
+		return FALSE;
+
+	return bsearch(&ifindex, ifindexes->data, ifindexes->count,
+			sizeof(ifindexes->data[0]), __ni_client_state_ifindex_cmp) != NULL;
+}
+
 ni_bool_t
 ni_client_state_drop(unsigned int ifindex)
 {
@@ -82,6 +82,8 @@ extern ni_bool_t	ni_client_state_load(ni_client_state_t *, unsigned int);
 extern ni_bool_t	ni_client_state_save(const ni_client_state_t *, unsigned int);
 extern ni_bool_t	ni_client_state_move(unsigned int, unsigned int);
 extern ni_bool_t	ni_client_state_drop(unsigned int);
+extern ni_bool_t	ni_client_state_scan(ni_uint_array_t *);
+extern ni_bool_t	ni_client_state_scan_contains(const ni_uint_array_t *, unsigned int);
 extern ni_bool_t	ni_client_state_set_persistent(xml_node_t *);
 
 extern void		ni_client_state_control_debug(const char *, const ni_client_state_control_t *, const char *);
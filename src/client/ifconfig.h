@@ -58,6 +58,7 @@
 #define NI_NANNY_IFPOLICY_NAME			"name"
 #define NI_NANNY_IFPOLICY_ORIGIN		"origin"
 #define NI_NANNY_IFPOLICY_UUID			"uuid"
+#define NI_NANNY_IFPOLICY_PRIORITY		"priority"
 
 extern ni_bool_t		ni_ifpolicy_match_add_min_state(xml_node_t *, unsigned int);
 extern ni_bool_t		ni_ifpolicy_match_add_link_type(xml_node_t *, unsigned int);
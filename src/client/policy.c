@@ -217,6 +217,7 @@ xml_node_t *
 ni_convert_cfg_into_policy_node(const xml_node_t *ifcfg, xml_node_t *match, const char *name, const char *origin)
 {
 	xml_node_t *ifpolicy;
+	const xml_node_t *prio;
 	ni_uuid_t uuid;
 	xml_node_t *node;
 
@@ -232,6 +233,11 @@ ni_convert_cfg_into_policy_node(const xml_node_t *ifcfg, xml_node_t *match, cons
 	ni_uuid_generate(&uuid);
 	xml_node_add_attr(ifpolicy, NI_NANNY_IFPOLICY_UUID, ni_uuid_print(&uuid));
 
+	/* let nanny see the priority class before it applies the policy */
+	if ((prio = xml_node_get_child(xml_node_get_child(ifcfg, "control"), "priority")) &&
+	    !ni_string_empty(prio->cdata))
+		xml_node_add_attr(ifpolicy, NI_NANNY_IFPOLICY_PRIORITY, prio->cdata);
+
 	/* clone <interface> into policy and rename to <merge> */
 	node = xml_node_clone(ifcfg, ifpolicy);
 	ni_string_dup(&node->name, NI_NANNY_IFPOLICY_MERGE);
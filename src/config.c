@@ -26,6 +26,7 @@
 #include "util_priv.h"
 #include "appconfig.h"
 #include "xml-schema.h"
+#include "xml-cache.h"
 #include "dhcp.h"
 #include "duid.h"
 
@@ -49,6 +50,7 @@ static ni_bool_t	ni_config_parse_system_updater(ni_extension_t **, xml_node_t *)
 static ni_bool_t	ni_config_parse_extension(ni_extension_t *, xml_node_t *);
 static ni_bool_t	ni_config_parse_sources(ni_config_t *, xml_node_t *);
 static ni_bool_t	ni_config_parse_rtnl_event(ni_config_rtnl_event_t *, xml_node_t *);
+static ni_bool_t	ni_config_parse_netns(ni_string_array_t *, xml_node_t *);
 static ni_bool_t	ni_config_parse_bonding(ni_config_bonding_t *, const xml_node_t *);
 static ni_bool_t	ni_config_parse_teamd(ni_config_teamd_t *, const xml_node_t *);
 static ni_c_binding_t *	ni_c_binding_new(ni_c_binding_t **, const char *name, const char *lib, const char *symbol);
@@ -88,9 +90,11 @@ ni_config_new()
 	ni_config_fslocation_init(&conf->storedir, WICKED_STOREDIR, 0755);
 
 	conf->use_nanny = FALSE;
+	conf->dbus_peer = TRUE;
 
 	conf->rtnl_event.recv_buff_length = 1024 * 1024;
 	conf->rtnl_event.mesg_buff_length = 0;
+	conf->rtnl_event.ingest_queue_length = 0;
 
 	/* we enable it explicitly in wickedd only */
 	conf->teamd.enabled = FALSE;
@@ -242,6 +246,7 @@ void
 ni_config_free(ni_config_t *conf)
 {
 	ni_string_array_destroy(&conf->sources.ifconfig);
+	ni_string_array_destroy(&conf->netns);
 	ni_extension_list_destroy(&conf->dbus_extensions);
 	ni_extension_list_destroy(&conf->ns_extensions);
 	ni_extension_list_destroy(&conf->fw_extensions);
@@ -267,7 +272,7 @@ __ni_config_parse(ni_config_t *conf, const char *filename, ni_init_appdata_callb
 	xml_node_t *node, *child;
 
 	ni_debug_wicked("Reading config file %s", filename);
-	doc = xml_document_read(filename);
+	doc = xml_document_read_cached(filename);
 	if (!doc) {
 		ni_error("%s: error parsing configuration file", filename);
 		goto failed;
@@ -351,6 +356,12 @@ __ni_config_parse(ni_config_t *conf, const char *filename, ni_init_appdata_callb
 				if (!strcmp(gchild->name, "schema")) {
 					if ((attrval = xml_node_get_attr(gchild, "name")) != NULL)
 						ni_string_dup(&conf->dbus_xml_schema_file, attrval);
+				} else
+				if (!strcmp(gchild->name, "peer")) {
+					if ((attrval = xml_node_get_attr(gchild, "enabled")) != NULL &&
+					    ni_parse_boolean(attrval, &conf->dbus_peer) != 0)
+						ni_warn("%s: invalid <dbus><peer enabled=\"%s\"/> value",
+							xml_node_location(gchild), attrval);
 				}
 			}
 		} else 
@@ -368,6 +379,13 @@ __ni_config_parse(ni_config_t *conf, const char *filename, ni_init_appdata_callb
 				if (!strcmp(gchild->name, "default-allow-update"))
 					ni_config_parse_update_targets(&conf->addrconf.default_allow_update, gchild);
 
+				if (!strcmp(gchild->name, "leaseinfo-index")
+				 && ni_parse_boolean(gchild->cdata, &conf->addrconf.leaseinfo_index)) {
+					ni_error("%s: invalid <%s>%s</%s> element value",
+						filename, gchild->name, gchild->cdata, gchild->name);
+					goto failed;
+				}
+
 				if (!strcmp(gchild->name, "dhcp4")
 				 && !ni_config_parse_addrconf_dhcp4(conf, gchild))
 					goto failed;
@@ -409,6 +427,10 @@ __ni_config_parse(ni_config_t *conf, const char *filename, ni_init_appdata_callb
 			if (!ni_config_parse_rtnl_event(&conf->rtnl_event, child))
 				goto failed;
 		} else
+		if (strcmp(child->name, "network-namespaces") == 0) {
+			if (!ni_config_parse_netns(&conf->netns, child))
+				goto failed;
+		} else
 		if (strcmp(child->name, "bonding") == 0) {
 			if (!ni_config_parse_bonding(&conf->bonding, child))
 				goto failed;
@@ -1529,6 +1551,41 @@ ni_config_sources(const char *type)
 	return retval;
 }
 
+static const ni_intmap_t	config_rtnl_event_class_names[] = {
+	{ "link",		NI_CONFIG_RTNL_EVENT_LINK	},
+	{ "address",		NI_CONFIG_RTNL_EVENT_ADDR	},
+	{ "rule",		NI_CONFIG_RTNL_EVENT_RULE	},
+	{ "route",		NI_CONFIG_RTNL_EVENT_ROUTE	},
+	{ NULL,			-1U				}
+};
+
+const char *
+ni_config_rtnl_event_class_to_name(ni_config_rtnl_event_class_t class)
+{
+	return ni_format_uint_mapped(class, config_rtnl_event_class_names);
+}
+
+/*
+ * The receive buffer length without a class attribute applies to
+ * all event sockets, with one to the socket of this class only.
+ */
+static ni_bool_t
+ni_config_parse_rtnl_event_recv_buff(ni_config_rtnl_event_t *conf, const xml_node_t *node)
+{
+	const char *attrval;
+	unsigned int class;
+
+	if (!(attrval = xml_node_get_attr(node, "class")))
+		return ni_parse_uint(node->cdata, &conf->recv_buff_length, 0) == 0;
+
+	if (ni_parse_uint_mapped(attrval, config_rtnl_event_class_names, &class) != 0) {
+		ni_error("%s: unknown netlink event class \"%s\"",
+				xml_node_location(node), attrval);
+		return FALSE;
+	}
+	return ni_parse_uint(node->cdata, &conf->class_recv_buff_length[class], 0) == 0;
+}
+
 ni_bool_t
 ni_config_parse_rtnl_event(ni_config_rtnl_event_t *conf, xml_node_t *node)
 {
@@ -1539,13 +1596,44 @@ ni_config_parse_rtnl_event(ni_config_rtnl_event_t *conf, xml_node_t *node)
 
 	for (child = node->children; child; child = child->next) {
 		if (ni_string_eq(child->name, "receive-buffer-length")) {
-			if (ni_parse_uint(child->cdata, &conf->recv_buff_length, 0))
+			if (!ni_config_parse_rtnl_event_recv_buff(conf, child))
 				return FALSE;
 		} else
 		if (ni_string_eq(child->name, "message-buffer-length")) {
 			if (ni_parse_uint(child->cdata, &conf->mesg_buff_length, 0))
 				return FALSE;
+		} else
+		if (ni_string_eq(child->name, "ingest-queue-length")) {
+			if (ni_parse_uint(child->cdata, &conf->ingest_queue_length, 0))
+				return FALSE;
+		} else
+		if (ni_string_eq(child->name, "track-routes")) {
+			if (ni_parse_boolean(child->cdata, &conf->track_routes))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * network namespaces to monitor next to the own one
+ */
+static ni_bool_t
+ni_config_parse_netns(ni_string_array_t *names, xml_node_t *node)
+{
+	xml_node_t *child;
+
+	for (child = node->children; child; child = child->next) {
+		if (!ni_string_eq(child->name, "netns"))
+			continue;
+
+		if (ni_string_empty(child->cdata) || strchr(child->cdata, '/')) {
+			ni_error("%s: invalid <netns>%s</netns> element value",
+					xml_node_location(child), child->cdata);
+			return FALSE;
 		}
+		if (ni_string_array_index(names, child->cdata) < 0)
+			ni_string_array_append(names, child->cdata);
 	}
 	return TRUE;
 }
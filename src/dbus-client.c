@@ -21,6 +21,7 @@
 
 struct ni_dbus_client {
 	ni_dbus_connection_t *	connection;
+	ni_dbus_connection_t *	peer;		/* direct connection for calls */
 	char *			bus_name;
 	unsigned int		call_timeout;
 	const ni_intmap_t *	error_map;
@@ -78,6 +79,10 @@ ni_dbus_client_free(ni_dbus_client_t *dbc)
 	if (!dbc)
 		return;
 
+	if (dbc->peer)
+		ni_dbus_connection_free(dbc->peer);
+	dbc->peer = NULL;
+
 	if (dbc->connection)
 		ni_dbus_connection_free(dbc->connection);
 	dbc->connection = NULL;
@@ -200,11 +205,75 @@ ni_dbus_client_set_call_timeout(ni_dbus_client_t *dbc, unsigned int msec)
 }
 
 /*
- * Place a synchronous call
+ * Connect to the private peer-to-peer socket of the server.
+ * Method calls are sent over it, bypassing the bus daemon, while
+ * signals are still received via the bus connection.
+ *
+ * There is no ordering between the two: signals emitted while the
+ * server handled a call may be received before or after its reply.
+ * The bus connection is not dispatched while a call blocks on the
+ * peer connection, so a callback signal (e.g. for linkUp) is only
+ * processed from the main loop, after the caller registered the
+ * callback returned in the reply. Signals must not be taken as
+ * newer than a reply, e.g. to update properties retrieved by a call.
+ */
+ni_bool_t
+ni_dbus_client_connect_peer(ni_dbus_client_t *client, const char *path)
+{
+	ni_dbus_connection_t *peer;
+
+	if (!client || !(peer = ni_dbus_connection_open_peer(path)))
+		return FALSE;
+
+	if (client->peer)
+		ni_dbus_connection_free(client->peer);
+	client->peer = peer;
+
+	ni_debug_dbus("Using dbus peer connection %s for calls to %s", path, client->bus_name);
+	return TRUE;
+}
+
+/*
+ * Select the connection to send a call on; fall back to the bus
+ * when the server closed the peer connection, e.g. on restart.
+ */
+static ni_dbus_connection_t *
+__ni_dbus_client_call_connection(ni_dbus_client_t *client)
+{
+	if (client->peer && ni_dbus_connection_is_connected(client->peer))
+		return client->peer;
+	return client->connection;
+}
+
+/*
+ * Place a synchronous call.
+ * A call is resent via the bus only when it could not be sent over the
+ * closed peer connection, or the server answered that it stopped
+ * serving it, e.g. when handing off to a new instance; otherwise the
+ * server may have executed it, so a missing reply is reported to the
+ * caller instead of calling e.g. deleteDevice twice.
  */
 ni_dbus_message_t *
 ni_dbus_client_call(ni_dbus_client_t *client, ni_dbus_message_t *call, DBusError *error)
 {
+	ni_dbus_connection_t *connection = __ni_dbus_client_call_connection(client);
+	ni_dbus_message_t *reply;
+
+	reply = ni_dbus_connection_call(connection, call, client->call_timeout, error);
+	if (reply || connection != client->peer)
+		return reply;
+
+	if (dbus_error_has_name(error, NI_DBUS_ERROR_PEER_CLOSED)) {
+		ni_debug_dbus("dbus peer connection stopped, retrying call via bus");
+		ni_dbus_connection_free(client->peer);
+		client->peer = NULL;
+	} else
+	if (dbus_error_has_name(error, DBUS_ERROR_DISCONNECTED)) {
+		ni_debug_dbus("dbus peer connection closed, retrying call via bus");
+	} else
+		return NULL;
+
+	dbus_error_free(error);
 	return ni_dbus_connection_call(client->connection, call, client->call_timeout, error);
 }
 
@@ -461,7 +530,7 @@ ni_dbus_object_call_async(ni_dbus_object_t *proxy,
 		ni_error("%s: unable to build %s message", __FUNCTION__, method);
 		rv = -NI_ERROR_INVALID_ARGS;
 	} else {
-		rv = ni_dbus_connection_call_async(client->connection,
+		rv = ni_dbus_connection_call_async(__ni_dbus_client_call_connection(client),
 			call, client->call_timeout,
 			callback, proxy);
 		dbus_message_unref(call);
@@ -13,6 +13,7 @@
 #include "socket_priv.h"
 #include "dbus-common.h"
 #include "dbus-dict.h"
+#include "hashmap.h"
 #include "debug.h"
 
 int
@@ -166,6 +167,12 @@ ni_dbus_variant_is_string_array(const ni_dbus_variant_t *var)
 	return __ni_dbus_is_array(var, DBUS_TYPE_STRING_AS_STRING);
 }
 
+dbus_bool_t
+ni_dbus_variant_is_variant_array(const ni_dbus_variant_t *var)
+{
+	return __ni_dbus_is_array(var, DBUS_TYPE_VARIANT_AS_STRING);
+}
+
 /*
  * Get/set functions for variant values
  */
@@ -573,17 +580,36 @@ ni_dbus_variant_is_byte_array(const ni_dbus_variant_t *var)
  * Helper function for handling arrays
  */
 #define NI_DBUS_ARRAY_CHUNK		32
-#define NI_DBUS_ARRAY_ALLOCATION(len)	(((len) + NI_DBUS_ARRAY_CHUNK - 1) & ~(NI_DBUS_ARRAY_CHUNK - 1))
+#define NI_DBUS_ARRAY_LINEAR_MAX	1024
+
+/*
+ * The allocation is derived from the length. Small arrays grow by
+ * chunks, large ones double, so that building an array with a huge
+ * number of elements (e.g. routes) does not copy it over and over.
+ */
+static inline unsigned int
+__ni_dbus_array_allocation(unsigned int len)
+{
+	unsigned int max = NI_DBUS_ARRAY_LINEAR_MAX;
+
+	if (len <= NI_DBUS_ARRAY_LINEAR_MAX)
+		return (len + NI_DBUS_ARRAY_CHUNK - 1) & ~(NI_DBUS_ARRAY_CHUNK - 1);
+
+	while (max < len)
+		max <<= 1;
+	return max;
+}
+
 static inline void
 __ni_dbus_array_grow(ni_dbus_variant_t *var, size_t element_size, unsigned int grow_by)
 {
-	unsigned int max = NI_DBUS_ARRAY_ALLOCATION(var->array.len);
+	unsigned int max = __ni_dbus_array_allocation(var->array.len);
 	unsigned int len = var->array.len;
 
 	if (len + grow_by >= max) {
 		void *new_data;
 
-		max = NI_DBUS_ARRAY_ALLOCATION(len + grow_by);
+		max = __ni_dbus_array_allocation(len + grow_by);
 		new_data = xcalloc(max, element_size);
 		if (new_data == NULL)
 			ni_fatal("%s: out of memory try to grow array to %u elements",
@@ -595,6 +621,94 @@ __ni_dbus_array_grow(ni_dbus_variant_t *var, size_t element_size, unsigned int g
 	}
 }
 
+/*
+ * Lookups in large dicts use an index mapping each key to the position
+ * of its first entry. It is built on the first lookup, kept current
+ * while entries are appended and dropped on any other modification.
+ * Entries changed behind our back are detected by the array pointer
+ * and length not matching the index anymore.
+ */
+#define NI_DBUS_DICT_INDEX_THRESHOLD	16
+
+typedef struct ni_dbus_dict_index	ni_dbus_dict_index_t;
+struct ni_dbus_dict_index {
+	ni_hashmap_t *			keys;
+	const ni_dbus_dict_entry_t *	entries;
+	unsigned int			len;
+};
+
+static void
+__ni_dbus_dict_index_free(ni_dbus_variant_t *dict)
+{
+	ni_dbus_dict_index_t *index = dict->__dict_index;
+
+	if (index) {
+		ni_hashmap_free(index->keys);
+		free(index);
+		dict->__dict_index = NULL;
+	}
+}
+
+static inline ni_bool_t
+__ni_dbus_dict_index_valid(const ni_dbus_variant_t *dict, unsigned int len)
+{
+	const ni_dbus_dict_index_t *index = dict->__dict_index;
+
+	return index && index->entries == dict->dict_array_value && index->len == len;
+}
+
+static void
+__ni_dbus_dict_index_insert(ni_dbus_dict_index_t *index, const ni_dbus_dict_entry_t *entry,
+		unsigned int pos)
+{
+	/* the first entry of a duplicate key wins, as in the linear scan */
+	if (entry->key)
+		ni_hashmap_add(index->keys, entry->key, (void *)(uintptr_t)(pos + 1));
+}
+
+static ni_dbus_dict_index_t *
+__ni_dbus_dict_index_get(ni_dbus_variant_t *dict)
+{
+	ni_dbus_dict_index_t *index;
+	unsigned int i;
+
+	if (__ni_dbus_dict_index_valid(dict, dict->array.len))
+		return dict->__dict_index;
+
+	__ni_dbus_dict_index_free(dict);
+	index = xcalloc(1, sizeof(*index));
+	index->keys = ni_hashmap_new();
+	for (i = 0; i < dict->array.len; ++i)
+		__ni_dbus_dict_index_insert(index, &dict->dict_array_value[i], i);
+	index->entries = dict->dict_array_value;
+	index->len = dict->array.len;
+
+	dict->__dict_index = index;
+	return index;
+}
+
+/*
+ * Called after an entry has been added to the end of the dict
+ */
+static void
+__ni_dbus_dict_index_append(ni_dbus_variant_t *dict)
+{
+	ni_dbus_dict_index_t *index = dict->__dict_index;
+	unsigned int pos = dict->array.len - 1;
+
+	if (!index)
+		return;
+
+	/* the array may have been reallocated, compare with the old length only */
+	if (index->len != pos) {
+		__ni_dbus_dict_index_free(dict);
+		return;
+	}
+	__ni_dbus_dict_index_insert(index, &dict->dict_array_value[pos], pos);
+	index->entries = dict->dict_array_value;
+	index->len = dict->array.len;
+}
+
 void
 ni_dbus_variant_init_byte_array(ni_dbus_variant_t *var)
 {
@@ -788,6 +902,7 @@ ni_dbus_variant_destroy(ni_dbus_variant_t *var)
 	if (var->__message)
 		dbus_message_unref(var->__message);
 
+	__ni_dbus_dict_index_free(var);
 	memset(var, 0, sizeof(*var));
 	var->type = DBUS_TYPE_INVALID;
 	var->__magic = NI_DBUS_VARIANT_MAGIC;
@@ -1185,6 +1300,7 @@ ni_dbus_dict_add(ni_dbus_variant_t *dict, const char *key)
 	__ni_dbus_array_grow(dict, sizeof(ni_dbus_dict_entry_t), 1);
 	dst = &dict->dict_array_value[dict->array.len++];
 	dst->key = key;
+	__ni_dbus_dict_index_append(dict);
 
 	return &dst->datum;
 }
@@ -1342,6 +1458,14 @@ ni_dbus_dict_get(const ni_dbus_variant_t *dict, const char *key)
 	if (!ni_dbus_variant_is_dict(dict))
 		return NULL;
 
+	if (dict->array.len >= NI_DBUS_DICT_INDEX_THRESHOLD && key) {
+		/* the index is a cache, it does not change the dict itself */
+		ni_dbus_dict_index_t *index = __ni_dbus_dict_index_get((ni_dbus_variant_t *) dict);
+
+		i = (uintptr_t) ni_hashmap_get(index->keys, key);
+		return i ? &dict->dict_array_value[i - 1].datum : NULL;
+	}
+
 	for (i = 0; i < dict->array.len; ++i) {
 		entry = &dict->dict_array_value[i];
 		if (entry->key && !strcmp(entry->key, key))
@@ -1527,6 +1651,7 @@ ni_dbus_dict_delete_entry(ni_dbus_variant_t *dict, const char *key)
 	for (i = 0; i < dict->array.len; ++i, ++entry) {
 		if (entry->key && !strcmp(entry->key, key)) {
 			ni_dbus_variant_destroy(&entry->datum);
+			__ni_dbus_dict_index_free(dict);
 			dict->array.len--;
 
 			/* Shift down all entries */
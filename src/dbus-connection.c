@@ -8,6 +8,9 @@
 #endif
 
 #include <sys/poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <limits.h>
 #include <errno.h>
 
 #include <wicked/util.h>
@@ -52,6 +55,10 @@ struct ni_dbus_sigaction {
 struct ni_dbus_connection {
 	DBusConnection *	conn;
 	ni_bool_t		private;
+	ni_bool_t		peer;
+
+	ni_dbus_connection_disconnect_fn_t *disconnect;
+	void *			disconnect_data;
 
 	ni_dbus_async_client_call_t *async_client_calls;
 	ni_dbus_async_server_call_t *async_server_calls;
@@ -85,11 +92,23 @@ static void			__ni_dbus_async_client_call_free(ni_dbus_async_client_call_t *);
 static void			__ni_dbus_notify_async(DBusPendingCall *, void *);
 static dbus_bool_t		__ni_dbus_add_watch(DBusWatch *, void *);
 static void			__ni_dbus_remove_watch(DBusWatch *, void *);
+static void			__ni_dbus_toggle_watch(DBusWatch *, void *);
 static DBusHandlerResult	__ni_dbus_signal_filter(DBusConnection *, DBusMessage *, void *);
 static void			__ni_dbus_connection_dispatch(ni_dbus_connection_t *);
 
 static int			ni_dbus_use_socket_mainloop = 1;
 
+/*
+ * Listener for private peer-to-peer connections
+ */
+struct ni_dbus_peer_server {
+	DBusServer *		server;
+	char *			path;
+
+	ni_dbus_peer_accept_fn_t *accept;
+	void *			user_data;
+};
+
 #ifdef DEBUG_WATCH_VERBOSE
 static const char *
 __ni_dbus_wd_state_name(enum ni_dbus_wd_state state)
@@ -121,6 +140,20 @@ __ni_put_dbus_watch_data(ni_dbus_watch_data_t *wd)
 	}
 }
 
+static void
+__ni_dbus_connection_setup(ni_dbus_connection_t *connection)
+{
+	dbus_connection_add_filter(connection->conn, __ni_dbus_signal_filter, connection, NULL);
+	if (ni_dbus_use_socket_mainloop) {
+		dbus_connection_set_watch_functions(connection->conn,
+				__ni_dbus_add_watch,
+				__ni_dbus_remove_watch,
+				__ni_dbus_toggle_watch,
+				connection,		/* data */
+				NULL);			/* free_data_function */
+	}
+}
+
 /*
  * Constructor for DBus connection handle
  */
@@ -189,16 +222,7 @@ ni_dbus_connection_open(const char *bus_type_string, const char *bus_name)
 		ni_debug_dbus("Successfully acquired bus name \"%s\"", bus_name);
 	}
 
-	dbus_connection_add_filter(connection->conn, __ni_dbus_signal_filter, connection, NULL);
-	if (ni_dbus_use_socket_mainloop) {
-		dbus_connection_set_watch_functions(connection->conn,
-				__ni_dbus_add_watch,
-				__ni_dbus_remove_watch,
-				NULL,			/* toggle_function */
-				connection,		/* data */
-				NULL);			/* free_data_function */
-	}
-
+	__ni_dbus_connection_setup(connection);
 	return connection;
 
 failed_unexpectedly:
@@ -210,6 +234,101 @@ failed:
 	return NULL;
 }
 
+/*
+ * Let another connection take over our bus name, e.g. a new instance
+ * the state is handed off to. Requesting an owned name again updates
+ * its flags only; when we lost it, the name is requested again.
+ */
+ni_bool_t
+ni_dbus_connection_allow_replacement(ni_dbus_connection_t *connection,
+				const char *bus_name, ni_bool_t allow)
+{
+	DBusError error = DBUS_ERROR_INIT;
+	unsigned int flags = DBUS_NAME_FLAG_REPLACE_EXISTING;
+	int rv;
+
+	if (!connection || connection->peer || ni_string_empty(bus_name))
+		return FALSE;
+
+	if (allow)
+		flags |= DBUS_NAME_FLAG_ALLOW_REPLACEMENT;
+
+	rv = dbus_bus_request_name(connection->conn, bus_name, flags, &error);
+	if (dbus_error_is_set(&error)) {
+		ni_error("Failed to update dbus bus name \"%s\" (%s)",
+				bus_name, error.message);
+		dbus_error_free(&error);
+		return FALSE;
+	}
+	if (rv != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER &&
+	    rv != DBUS_REQUEST_NAME_REPLY_ALREADY_OWNER) {
+		ni_error("%s: not the owner of dbus name %s (rv=%d)", __func__, bus_name, rv);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Open a private peer-to-peer connection to a DBus server listening
+ * on a unix socket, bypassing the bus daemon.
+ */
+ni_dbus_connection_t *
+ni_dbus_connection_open_peer(const char *path)
+{
+	ni_dbus_connection_t *connection;
+	DBusError error = DBUS_ERROR_INIT;
+	char address[PATH_MAX + 16];
+
+	if (ni_string_empty(path))
+		return NULL;
+
+	NI_TRACE_ENTER_ARGS("path=%s", path);
+
+	snprintf(address, sizeof(address), "unix:path=%s", path);
+	connection = calloc(1, sizeof(*connection));
+	connection->private = TRUE;
+	connection->peer = TRUE;
+	connection->conn = dbus_connection_open_private(address, &error);
+	if (connection->conn == NULL) {
+		ni_debug_dbus("Cannot open dbus peer connection to %s (%s)",
+				path, error.message);
+		ni_dbus_connection_free(connection);
+		dbus_error_free(&error);
+		return NULL;
+	}
+
+	dbus_connection_set_exit_on_disconnect(connection->conn, FALSE);
+	__ni_dbus_connection_setup(connection);
+	return connection;
+}
+
+ni_bool_t
+ni_dbus_connection_is_peer(const ni_dbus_connection_t *connection)
+{
+	return connection && connection->peer;
+}
+
+ni_bool_t
+ni_dbus_connection_is_connected(const ni_dbus_connection_t *connection)
+{
+	if (!connection || !connection->conn)
+		return FALSE;
+
+	/* read a close of the peer we did not notice yet */
+	if (connection->peer && dbus_connection_get_is_connected(connection->conn))
+		dbus_connection_read_write(connection->conn, 0);
+
+	return dbus_connection_get_is_connected(connection->conn);
+}
+
+void
+ni_dbus_connection_set_disconnect_handler(ni_dbus_connection_t *connection,
+			ni_dbus_connection_disconnect_fn_t *func, void *user_data)
+{
+	connection->disconnect = func;
+	connection->disconnect_data = user_data;
+}
+
 /*
  * Destructor for DBus connection handle
  */
@@ -318,6 +437,7 @@ ni_dbus_connection_call(ni_dbus_connection_t *connection,
 		return NULL;
 	}
 	if (!pending) {
+		/* not sent; callers rely on this error name to resend */
 		dbus_set_error (error, DBUS_ERROR_DISCONNECTED, "Connection is closed");
 		return NULL;
 	}
@@ -389,6 +509,23 @@ __ni_dbus_notify_async(DBusPendingCall *pending, void *call_data)
 	__ni_dbus_process_pending(conn, pending);
 }
 
+/*
+ * Read and dispatch the messages received on a connection outside
+ * of the main loop, waiting up to timeout msec for them, and send
+ * the replies. Returns FALSE once the connection is closed.
+ */
+ni_bool_t
+ni_dbus_connection_process(ni_dbus_connection_t *connection, int timeout)
+{
+	if (!connection || !connection->conn || connection->dispatching)
+		return FALSE;
+
+	dbus_connection_read_write(connection->conn, timeout);
+	__ni_dbus_connection_dispatch(connection);
+	dbus_connection_flush(connection->conn);
+	return dbus_connection_get_is_connected(connection->conn);
+}
+
 /*
  * Send a message out
  */
@@ -468,6 +605,14 @@ ni_dbus_add_signal_handler(ni_dbus_connection_t *connection,
 	}
 	arg = specbuf;
 
+	if (connection->peer) {
+		/* signals are sent to us directly, nothing to subscribe */
+		sigact = __ni_sigaction_new(object_interface, callback, user_data);
+		sigact->next = connection->sighandlers;
+		connection->sighandlers = sigact;
+		return;
+	}
+
 	call = dbus_message_new_method_call(NI_DBUS_BUS_NAME,
 			NI_DBUS_OBJECT_PATH, NI_DBUS_INTERFACE, "AddMatch");
 	if (!dbus_message_append_args(call, DBUS_TYPE_STRING, &arg, 0))
@@ -507,6 +652,13 @@ __ni_dbus_signal_filter(DBusConnection *conn, DBusMessage *msg, void *user_data)
 	if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_SIGNAL)
 		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 
+	if (connection->peer && dbus_message_is_signal(msg, DBUS_INTERFACE_LOCAL, "Disconnected")) {
+		ni_debug_dbus("dbus peer connection %p disconnected", connection);
+		if (connection->disconnect)
+			connection->disconnect(connection, connection->disconnect_data);
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
 	interface = dbus_message_get_interface(msg);
 	for (sigact = connection->sighandlers; sigact; sigact = sigact->next) {
 		if (!strcmp(sigact->object_interface, interface)) {
@@ -532,6 +684,13 @@ ni_dbus_connection_register_object(ni_dbus_connection_t *connection, ni_dbus_obj
 			object);
 }
 
+void
+ni_dbus_connection_register_fallback(ni_dbus_connection_t *connection, const char *path,
+			const DBusObjectPathVTable *vtable, void *user_data)
+{
+	dbus_connection_register_fallback(connection->conn, path, vtable, user_data);
+}
+
 void
 ni_dbus_connection_unregister_object(ni_dbus_connection_t *connection, ni_dbus_object_t *object)
 {
@@ -640,6 +799,17 @@ ni_dbus_connection_get_caller_uid(ni_dbus_connection_t *conn, const char *name,
 	uint32_t user_id;
 	int rv = 0;
 
+	if (conn->peer) {
+		unsigned long peer_uid;
+
+		/* no bus daemon, ask for the authenticated peer credentials */
+		if (!dbus_connection_get_unix_user(conn->conn, &peer_uid))
+			return -NI_ERROR_PERMISSION_DENIED;
+		if (uidp)
+			*uidp = peer_uid;
+		return 0;
+	}
+
 	call = dbus_message_new_method_call("org.freedesktop.DBus",
 					"/org/freedesktop/DBus",
 					"org.freedesktop.DBus",
@@ -708,11 +878,35 @@ __ni_dbus_watch_flags(int flags)
 	return "???";
 }
 
+/*
+ * The events to poll the socket for, from the enabled watches on it
+ */
+static int
+__ni_dbus_watch_poll_flags(const ni_socket_t *sock)
+{
+	ni_dbus_watch_data_t *wd;
+	int flags, poll_flags = 0;
+
+	for (wd = ni_dbus_watches; wd; wd = wd->next) {
+		if (wd->socket != sock || wd->state != DBUS_WD_STATE_ACTIVE)
+			continue;
+		if (!dbus_watch_get_enabled(wd->watch))
+			continue;
+
+		flags = dbus_watch_get_flags(wd->watch);
+		if (flags & DBUS_WATCH_READABLE)
+			poll_flags |= POLLIN;
+		if (flags & DBUS_WATCH_WRITABLE)
+			poll_flags |= POLLOUT;
+	}
+	return poll_flags;
+}
+
 static inline void
 __ni_dbus_watch_handle(const char *func, ni_socket_t *sock, int flags)
 {
 	ni_dbus_watch_data_t *wd;
-	int found = 0, poll_flags = 0;
+	int found = 0;
 
 	/* All of this is somewhat more complicated than it may need to be.
 	 * For some odd reason, libdbus insists on maintaining two watches
@@ -721,9 +915,8 @@ __ni_dbus_watch_handle(const char *func, ni_socket_t *sock, int flags)
 	 */
 restart:
 	for (wd = ni_dbus_watches; wd; wd = wd->next) {
-		int new_watch_flags;
 #ifdef DEBUG_WATCH_VERBOSE
-		int old_watch_flags;
+		int old_watch_flags, new_watch_flags;
 #endif
 
 		if (wd->socket != sock)
@@ -749,18 +942,11 @@ restart:
 			goto restart;
 		}
 
-		if (flags & (DBUS_WATCH_READABLE | DBUS_WATCH_WRITABLE))
+		if (wd->connection && (flags & (DBUS_WATCH_READABLE | DBUS_WATCH_WRITABLE)))
 			__ni_dbus_connection_dispatch(wd->connection);
 
-		new_watch_flags = dbus_watch_get_flags(wd->watch);
-		if (dbus_watch_get_enabled(wd->watch)) {
-			if (new_watch_flags & DBUS_WATCH_READABLE)
-				poll_flags |= POLLIN;
-			if (new_watch_flags & DBUS_WATCH_WRITABLE)
-				poll_flags |= POLLOUT;
-		}
-
 #ifdef DEBUG_WATCH_VERBOSE
+		new_watch_flags = dbus_watch_get_flags(wd->watch);
 		if (old_watch_flags != new_watch_flags) {
 			ni_debug_dbus("%s: changing watch flags %s to %s",
 					__func__,
@@ -771,7 +957,9 @@ restart:
 		__ni_put_dbus_watch_data(wd);
 	}
 
-	sock->poll_flags = poll_flags;
+	/* handling a watch may have toggled the others on the socket,
+	 * e.g. enabled reading once the auth reply was written */
+	sock->poll_flags = __ni_dbus_watch_poll_flags(sock);
 	if (!found)
 		ni_warn("%s: dead socket", func);
 }
@@ -833,7 +1021,8 @@ __ni_dbus_add_watch(DBusWatch *watch, void *data)
 	ni_socket_t *sock = NULL;
 
 	for (wd = ni_dbus_watches; wd; wd = wd->next) {
-		if (wd->connection == connection) {
+		if (wd->connection == connection && wd->socket &&
+		    wd->socket->__fd == dbus_watch_get_socket(watch)) {
 			sock = wd->socket;
 			break;
 		}
@@ -871,6 +1060,20 @@ __ni_dbus_add_watch(DBusWatch *watch, void *data)
 	return 1;
 }
 
+static void
+__ni_dbus_toggle_watch(DBusWatch *watch, void *dummy)
+{
+	ni_dbus_watch_data_t *wd;
+
+	for (wd = ni_dbus_watches; wd; wd = wd->next) {
+		if (wd->watch == watch) {
+			if (wd->socket)
+				wd->socket->poll_flags = __ni_dbus_watch_poll_flags(wd->socket);
+			return;
+		}
+	}
+}
+
 void
 __ni_dbus_remove_watch(DBusWatch *watch, void *dummy)
 {
@@ -907,3 +1110,104 @@ __ni_dbus_connection_dispatch(ni_dbus_connection_t *connection)
 		;
 	connection->dispatching = FALSE;
 }
+
+/*
+ * Accept private peer-to-peer connections of local root clients
+ * on a unix socket, e.g. to let the client bypass the bus daemon.
+ */
+static dbus_bool_t
+__ni_dbus_peer_server_allow_user(DBusConnection *conn, unsigned long uid, void *user_data)
+{
+	if (uid != 0) {
+		ni_debug_dbus("Rejecting dbus peer connection of uid %lu", uid);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+__ni_dbus_peer_server_new_connection(DBusServer *server, DBusConnection *conn, void *user_data)
+{
+	ni_dbus_peer_server_t *ps = user_data;
+	ni_dbus_connection_t *connection;
+
+	dbus_connection_set_unix_user_function(conn, __ni_dbus_peer_server_allow_user, NULL, NULL);
+	dbus_connection_set_allow_anonymous(conn, FALSE);
+
+	connection = calloc(1, sizeof(*connection));
+	connection->conn = dbus_connection_ref(conn);
+	connection->private = TRUE;
+	connection->peer = TRUE;
+	__ni_dbus_connection_setup(connection);
+
+	ni_debug_dbus("Accepted dbus peer connection %p on %s", connection, ps->path);
+	if (ps->accept)
+		ps->accept(connection, ps->user_data);
+	else
+		ni_dbus_connection_free(connection);
+}
+
+ni_dbus_peer_server_t *
+ni_dbus_peer_server_listen(const char *path, ni_dbus_peer_accept_fn_t *accept, void *user_data)
+{
+	static const char *mechanisms[] = { "EXTERNAL", NULL };
+	DBusError error = DBUS_ERROR_INIT;
+	char address[PATH_MAX + 16];
+	ni_dbus_peer_server_t *ps;
+	struct stat stb;
+
+	if (ni_string_empty(path))
+		return NULL;
+
+	/* remove a stale socket left over by a previous instance */
+	if (lstat(path, &stb) == 0 && S_ISSOCK(stb.st_mode))
+		unlink(path);
+
+	ps = calloc(1, sizeof(*ps));
+	ni_string_dup(&ps->path, path);
+	ps->accept = accept;
+	ps->user_data = user_data;
+
+	snprintf(address, sizeof(address), "unix:path=%s", path);
+	ps->server = dbus_server_listen(address, &error);
+	if (ps->server == NULL) {
+		ni_error("Cannot listen for dbus peer connections on %s (%s)",
+				path, error.message);
+		dbus_error_free(&error);
+		ni_dbus_peer_server_free(ps);
+		return NULL;
+	}
+	if (chmod(path, S_IRUSR | S_IWUSR) < 0)
+		ni_warn("Cannot restrict permissions of %s: %m", path);
+
+	dbus_server_set_auth_mechanisms(ps->server, mechanisms);
+	dbus_server_set_new_connection_function(ps->server,
+				__ni_dbus_peer_server_new_connection, ps, NULL);
+	if (ni_dbus_use_socket_mainloop) {
+		dbus_server_set_watch_functions(ps->server,
+				__ni_dbus_add_watch,
+				__ni_dbus_remove_watch,
+				__ni_dbus_toggle_watch,
+				NULL,			/* data */
+				NULL);			/* free_data_function */
+	}
+
+	ni_debug_dbus("Listening for dbus peer connections on %s", path);
+	return ps;
+}
+
+void
+ni_dbus_peer_server_free(ni_dbus_peer_server_t *ps)
+{
+	if (!ps)
+		return;
+
+	if (ps->server) {
+		dbus_server_disconnect(ps->server);
+		dbus_server_unref(ps->server);
+		ps->server = NULL;
+		unlink(ps->path);
+	}
+	ni_string_free(&ps->path);
+	free(ps);
+}
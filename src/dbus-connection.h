@@ -11,8 +11,20 @@
 #include <dbus/dbus.h>
 #include "dbus-common.h"
 
+typedef struct ni_dbus_peer_server	ni_dbus_peer_server_t;
+typedef void			ni_dbus_peer_accept_fn_t(ni_dbus_connection_t *, void *);
+typedef void			ni_dbus_connection_disconnect_fn_t(ni_dbus_connection_t *, void *);
+
 extern ni_dbus_connection_t *	ni_dbus_connection_open(const char *bus_type, const char *bus_name);
+extern ni_dbus_connection_t *	ni_dbus_connection_open_peer(const char *path);
+extern ni_bool_t		ni_dbus_connection_allow_replacement(ni_dbus_connection_t *,
+					const char *bus_name, ni_bool_t);
+extern ni_bool_t		ni_dbus_connection_is_peer(const ni_dbus_connection_t *);
+extern ni_bool_t		ni_dbus_connection_is_connected(const ni_dbus_connection_t *);
+extern void			ni_dbus_connection_set_disconnect_handler(ni_dbus_connection_t *,
+					ni_dbus_connection_disconnect_fn_t *, void *);
 extern void			ni_dbus_connection_free(ni_dbus_connection_t *);
+extern ni_bool_t		ni_dbus_connection_process(ni_dbus_connection_t *, int timeout);
 extern ni_dbus_message_t *	ni_dbus_connection_call(ni_dbus_connection_t *connection,
 					ni_dbus_message_t *call, unsigned int call_timeout, DBusError *error);
 extern int			ni_dbus_connection_call_async(ni_dbus_connection_t *connection,
@@ -27,6 +39,8 @@ extern void			ni_dbus_add_signal_handler(ni_dbus_connection_t *conn,
 					ni_dbus_signal_handler_t *callback,
 					void *user_data);
 extern void			ni_dbus_connection_register_object(ni_dbus_connection_t *, ni_dbus_object_t *);
+extern void			ni_dbus_connection_register_fallback(ni_dbus_connection_t *, const char *,
+					const DBusObjectPathVTable *, void *);
 extern void			ni_dbus_connection_unregister_object(ni_dbus_connection_t *, ni_dbus_object_t *);
 extern int			ni_dbus_async_server_call_run_command(ni_dbus_connection_t *conn,
 					ni_dbus_object_t *object,
@@ -37,4 +51,8 @@ extern void			ni_dbus_mainloop(ni_dbus_connection_t *);
 
 extern int			ni_dbus_connection_get_caller_uid(ni_dbus_connection_t *, const char *, uid_t *);
 
+extern ni_dbus_peer_server_t *	ni_dbus_peer_server_listen(const char *path,
+					ni_dbus_peer_accept_fn_t *, void *);
+extern void			ni_dbus_peer_server_free(ni_dbus_peer_server_t *);
+
 #endif /* __WICKED_DBUS_CONNECTION_H__ */
@@ -32,6 +32,8 @@ static ni_intmap_t	__ni_dbus_errors[] = {
 	{ NI_DBUS_ERROR_UNREACHABLE_ADDRESS,		NI_ERROR_UNREACHABLE_ADDRESS		},
 	{ NI_DBUS_ERROR_POLICY_EXISTS,			NI_ERROR_POLICY_EXISTS			},
 	{ NI_DBUS_ERROR_RADIO_DISABLED,			NI_ERROR_RADIO_DISABLED			},
+	{ NI_DBUS_ERROR_RETRY_OPERATION,		NI_ERROR_RETRY_OPERATION		},
+	{ NI_DBUS_ERROR_PEER_CLOSED,			NI_ERROR_RETRY_OPERATION		},
 
 	{ DBUS_ERROR_SERVICE_UNKNOWN,			NI_ERROR_SERVICE_UNKNOWN		},
 	{ DBUS_ERROR_UNKNOWN_METHOD,			NI_ERROR_METHOD_NOT_SUPPORTED		},
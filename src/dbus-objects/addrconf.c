@@ -734,6 +734,29 @@ ni_objectmodel_addrconf_forward_release(ni_dbus_addrconf_forwarder_t *forwarder,
 /*
  * Create client handle for addrconf forwarder
  */
+static dbus_bool_t
+ni_objectmodel_addrconf_forwarder_connect(ni_dbus_addrconf_forwarder_t *forwarder,
+				DBusError *error)
+{
+	if (forwarder->supplicant.client)
+		return TRUE;
+
+	forwarder->supplicant.client = ni_create_dbus_client(forwarder->supplicant.bus_name);
+	if (forwarder->supplicant.client == NULL) {
+		dbus_set_error(error, DBUS_ERROR_FAILED, "unable to create call forwarder for %s",
+				forwarder->supplicant.bus_name);
+		return FALSE;
+	}
+
+	ni_dbus_client_add_signal_handler(forwarder->supplicant.client,
+			forwarder->supplicant.bus_name,		/* sender must be the supplicant */
+			NULL,					/* any object */
+			NI_OBJECTMODEL_ADDRCONF_INTERFACE,	/* interface */
+			ni_objectmodel_addrconf_signal_handler,
+			forwarder);
+	return TRUE;
+}
+
 static dbus_bool_t
 ni_objectmodel_addrconf_forwarder_call(ni_dbus_addrconf_forwarder_t *forwarder,
 				ni_netdev_t *dev, const char *method_name,
@@ -746,21 +769,8 @@ ni_objectmodel_addrconf_forwarder_call(ni_dbus_addrconf_forwarder_t *forwarder,
 	int argc = 0;
 	dbus_bool_t rv;
 
-	if (forwarder->supplicant.client == NULL) {
-		forwarder->supplicant.client = ni_create_dbus_client(forwarder->supplicant.bus_name);
-		if (forwarder->supplicant.client == NULL) {
-			dbus_set_error(error, DBUS_ERROR_FAILED, "unable to create call forwarder for %s",
-					forwarder->supplicant.bus_name);
-			return FALSE;
-		}
-
-		ni_dbus_client_add_signal_handler(forwarder->supplicant.client,
-				forwarder->supplicant.bus_name,		/* sender must be the supplicant */
-				NULL,					/* any object */
-				NI_OBJECTMODEL_ADDRCONF_INTERFACE,	/* interface */
-				ni_objectmodel_addrconf_signal_handler,
-				forwarder);
-	}
+	if (!ni_objectmodel_addrconf_forwarder_connect(forwarder, error))
+		return FALSE;
 
 	/* Build the path of the object to talk to in the supplicant service */
 	snprintf(object_path, sizeof(object_path), "%s/%u",
@@ -926,6 +936,34 @@ static ni_dbus_addrconf_forwarder_t auto4_forwarder = {
 	}
 };
 
+/*
+ * The leases taken over from another wickedd instance were requested
+ * by it; listen to the lease events of their supplicants right away.
+ */
+void
+ni_objectmodel_addrconf_forwarders_resume(ni_netconfig_t *nc)
+{
+	static ni_dbus_addrconf_forwarder_t *forwarders[] = {
+		&dhcp4_forwarder, &dhcp6_forwarder, &auto4_forwarder, NULL
+	};
+	ni_dbus_addrconf_forwarder_t **fp, *forwarder;
+	DBusError error = DBUS_ERROR_INIT;
+	ni_netdev_t *dev;
+
+	for (fp = forwarders; (forwarder = *fp); ++fp) {
+		for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+			if (!ni_netdev_get_lease(dev, forwarder->addrfamily, forwarder->addrconf))
+				continue;
+
+			if (!ni_objectmodel_addrconf_forwarder_connect(forwarder, &error)) {
+				ni_error("%s", error.message);
+				dbus_error_free(&error);
+			}
+			break;
+		}
+	}
+}
+
 static dbus_bool_t
 ni_objectmodel_addrconf_ipv4_auto_request(ni_dbus_object_t *object, const ni_dbus_method_t *method,
 			unsigned int argc, const ni_dbus_variant_t *argv,
@@ -18,11 +18,14 @@
 
 #include <wicked/netinfo.h>
 #include <wicked/addrconf.h>
+#include <wicked/route.h>
 #include <wicked/logging.h>
 #include <wicked/dbus-errors.h>
 #include <wicked/dbus-service.h>
 #include <wicked/system.h>
 #include <wicked/xml.h>
+#include <wicked/snapshot.h>
+#include <wicked/netns.h>
 #include "netinfo_priv.h"
 #include "dbus-common.h"
 #include "xml-schema.h"
@@ -458,10 +461,71 @@ ni_objectmodel_netif_list_get_addresses(ni_dbus_object_t *object, const ni_dbus_
 	return rv;
 }
 
+/*
+ * InterfaceList.deleteDevices
+ *
+ * Delete the devices given as "ifindex" entries of the argument dict in
+ * one go, in the given order. Returns a dict with the ifindexes of the
+ * deleted devices; the others have to be deleted using their deleteDevice
+ * method.
+ */
+static dbus_bool_t
+ni_objectmodel_netif_list_delete_devices(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+	ni_uint_array_t ifindexes = NI_UINT_ARRAY_INIT;
+	ni_uint_array_t deleted = NI_UINT_ARRAY_INIT;
+	const ni_dbus_variant_t *var = NULL;
+	unsigned int i, ifindex;
+	dbus_bool_t rv;
+
+	if (!nc || argc != 1 || !ni_dbus_variant_is_dict(&argv[0])) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+				"%s.%s: expected ifindex dict argument",
+				object->path, method->name);
+		return FALSE;
+	}
+
+	while ((var = ni_dbus_dict_get_next(&argv[0], "ifindex", var))) {
+		if (!ni_dbus_variant_get_uint32(var, &ifindex) || !ifindex) {
+			dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+					"%s.%s: invalid ifindex argument",
+					object->path, method->name);
+			ni_uint_array_destroy(&ifindexes);
+			return FALSE;
+		}
+		ni_uint_array_append(&ifindexes, ifindex);
+	}
+
+	ni_system_interfaces_delete(nc, &ifindexes, &deleted);
+
+	ni_dbus_variant_init_dict(&result);
+	for (i = 0; i < deleted.count; ++i)
+		ni_dbus_dict_add_uint32(&result, "ifindex", deleted.data[i]);
+
+	rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+	ni_dbus_variant_destroy(&result);
+	ni_uint_array_destroy(&ifindexes);
+	ni_uint_array_destroy(&deleted);
+	return rv;
+}
+
 static ni_dbus_method_t		ni_objectmodel_netif_list_methods[] = {
 	{ "deviceByName",	"s",		.handler = ni_objectmodel_netif_list_device_by_name },
 	{ "identifyDevice",	"sa{sv}",	.handler = ni_objectmodel_netif_list_identify_device },
 	{ "getAddresses",	"a{sv}",	.handler = ni_objectmodel_netif_list_get_addresses },
+	{ "subscribe",		"a{sv}",	.handler = ni_objectmodel_netif_list_subscribe },
+	{ "unsubscribe",	"u",		.handler = ni_objectmodel_netif_list_unsubscribe },
+	{ "deleteDevices",	"a{sv}",	.handler = ni_objectmodel_netif_list_delete_devices },
+	{ NULL }
+};
+
+static ni_dbus_method_t		ni_objectmodel_netif_list_signals[] = {
+	{ "addressChange",	"a{sv}",	.handler = NULL },
+	{ "routeChange",	"a{sv}",	.handler = NULL },
 	{ NULL }
 };
 
@@ -469,6 +533,7 @@ static ni_dbus_service_t	ni_objectmodel_netif_list_service = {
 	.name		= NI_OBJECTMODEL_NETIFLIST_INTERFACE,
 	.compatible	= &ni_objectmodel_netif_list_class,
 	.methods	= ni_objectmodel_netif_list_methods,
+	.signals	= ni_objectmodel_netif_list_signals,
 };
 
 /*
@@ -569,14 +634,19 @@ ni_objectmodel_unregister_netif(ni_dbus_server_t *server, ni_netdev_t *ifp)
 }
 
 /*
- * Return the canonical object path for an interface object
+ * Return the canonical object path for an interface object.
+ * Devices in other network namespaces live below the namespace id.
  */
 const char *
 ni_objectmodel_netif_path(const ni_netdev_t *ifp)
 {
 	static char object_path[256];
 
-	snprintf(object_path, sizeof(object_path), "Interface/%u", ifp->link.ifindex);
+	if (ifp->link.netnsid != NI_NETNS_ID_NONE)
+		snprintf(object_path, sizeof(object_path), "Namespace/%d/Interface/%u",
+				ifp->link.netnsid, ifp->link.ifindex);
+	else
+		snprintf(object_path, sizeof(object_path), "Interface/%u", ifp->link.ifindex);
 	return object_path;
 }
 
@@ -585,7 +655,8 @@ ni_objectmodel_netif_full_path(const ni_netdev_t *ifp)
 {
 	static char object_path[256];
 
-	snprintf(object_path, sizeof(object_path), NI_OBJECTMODEL_OBJECT_PATH "/Interface/%u", ifp->link.ifindex);
+	snprintf(object_path, sizeof(object_path), NI_OBJECTMODEL_OBJECT_PATH "/%s",
+			ni_objectmodel_netif_path(ifp));
 	return object_path;
 }
 
@@ -663,8 +734,8 @@ ni_objectmodel_wrap_netif_request(ni_netdev_req_t *req)
 	return ni_dbus_object_new(&ni_objectmodel_ifreq_class, NULL, req);
 }
 
-ni_netdev_t *
-ni_objectmodel_unwrap_netif(const ni_dbus_object_t *object, DBusError *error)
+static ni_netdev_t *
+__ni_objectmodel_unwrap_netif(const ni_dbus_object_t *object, DBusError *error)
 {
 	ni_netdev_t *dev;
 
@@ -686,6 +757,27 @@ ni_objectmodel_unwrap_netif(const ni_dbus_object_t *object, DBusError *error)
 	return NULL;
 }
 
+/*
+ * The methods act on the daemon's own network namespace only;
+ * devices in other namespaces are published read-only.
+ */
+ni_netdev_t *
+ni_objectmodel_unwrap_netif(const ni_dbus_object_t *object, DBusError *error)
+{
+	ni_netdev_t *dev;
+
+	if (!(dev = __ni_objectmodel_unwrap_netif(object, error)))
+		return NULL;
+
+	if (error && dev->link.netnsid != NI_NETNS_ID_NONE) {
+		dbus_set_error(error, NI_DBUS_ERROR_DEVICE_NOT_COMPATIBLE,
+				"%s: device is in network namespace %d, not managed here",
+				object->path, dev->link.netnsid);
+		return NULL;
+	}
+	return dev;
+}
+
 ni_netdev_req_t *
 ni_objectmodel_unwrap_netif_request(const ni_dbus_object_t *object, DBusError *error)
 {
@@ -1218,6 +1310,9 @@ ni_objectmodel_send_netif_event(ni_dbus_server_t *server, ni_dbus_object_t *obje
 		return FALSE;
 	}
 
+	/* the state feed has to be ahead of the signal */
+	ni_state_feed_notify(ni_objectmodel_unwrap_netif(object, NULL), ifevent);
+
 	return __ni_objectmodel_device_event(server, object, NI_OBJECTMODEL_NETIF_INTERFACE, ifevent, uuid);
 }
 
@@ -1250,6 +1345,9 @@ __ni_objectmodel_device_event(ni_dbus_server_t *server, ni_dbus_object_t *object
 			ni_dbus_object_get_path(object), uuid ? ni_uuid_print(uuid) : "");
 	ni_dbus_server_send_signal(server, object, interface, signal_name, argc, &arg);
 
+	/* e.g. lease state changes, refresh the local state snapshot */
+	ni_state_snapshot_notify();
+
 	ni_dbus_variant_destroy(&arg);
 	return TRUE;
 }
@@ -1313,6 +1411,180 @@ ni_objectmodel_netif_wait_device_ready(ni_dbus_object_t *object, const ni_dbus_m
 	return __ni_objectmodel_return_callback_info(reply, NI_EVENT_DEVICE_READY, uuid, NULL, error);
 }
 
+/*
+ * Interface.getAddresses, Interface.getRoutes
+ *
+ * Return the address or route list of a device page by page, so that
+ * huge tables neither exceed the dbus message size limits nor block
+ * the main loop while one message is built. The argument dict may
+ * contain a "family" filter, the "cursor" and "generation" returned
+ * by the previous call (cursor 0 to start) and the page size in "count".
+ *
+ * The lists may change between two calls. An address walk then fails
+ * with RetryOperation and the client has to start over. Route tables
+ * are too large to start over under normal churn; a route walk resumes
+ * after the route the previous page ended with, which is returned as
+ * "resume" key along with the cursor.
+ */
+#define NI_OBJECTMODEL_NETIF_PAGE_SIZE		1024
+#define NI_OBJECTMODEL_NETIF_PAGE_MAX		16384
+
+/* where the last address page ended, to not walk the list from its head */
+static struct {
+	unsigned int		addr_gen;
+	unsigned int		cursor;
+	const ni_address_t *	next;
+} ni_objectmodel_netif_address_page;
+
+static dbus_bool_t
+ni_objectmodel_netif_page_args(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			unsigned int *family, unsigned int *cursor, unsigned int *count,
+			unsigned int *gen, DBusError *error)
+{
+	uint32_t u32;
+
+	*family = AF_UNSPEC;
+	*cursor = 0;
+	*count = NI_OBJECTMODEL_NETIF_PAGE_SIZE;
+	*gen = 0;
+
+	if (argc != 1 || !ni_dbus_variant_is_dict(&argv[0]))
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	if (ni_dbus_dict_get_uint32(&argv[0], "family", &u32))
+		*family = u32;
+	if (ni_dbus_dict_get_uint32(&argv[0], "cursor", &u32))
+		*cursor = u32;
+	if (ni_dbus_dict_get_uint32(&argv[0], "count", &u32))
+		*count = u32;
+	if (ni_dbus_dict_get_uint32(&argv[0], "generation", &u32))
+		*gen = u32;
+
+	if (!*count || *count > NI_OBJECTMODEL_NETIF_PAGE_MAX)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	return TRUE;
+}
+
+static dbus_bool_t
+ni_objectmodel_netif_list_changed(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			DBusError *error)
+{
+	dbus_set_error(error, NI_DBUS_ERROR_RETRY_OPERATION,
+			"%s: list changed since the previous %s call",
+			object->path, method->name);
+	return FALSE;
+}
+
+static dbus_bool_t
+ni_objectmodel_netif_get_addresses(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	unsigned int family, cursor, count, gen;
+	const ni_address_t *next;
+	ni_dbus_variant_t *list;
+	ni_netdev_t *dev;
+	dbus_bool_t rv;
+
+	if (!(dev = ni_objectmodel_unwrap_netif(object, error)))
+		return FALSE;
+
+	if (!ni_objectmodel_netif_page_args(object, method, argc, argv,
+					&family, &cursor, &count, &gen, error))
+		return FALSE;
+
+	if (cursor && gen != dev->addr_gen)
+		return ni_objectmodel_netif_list_changed(object, method, error);
+
+	/* a non-zero generation is unique, so the list is still the same */
+	if (!cursor || !dev->addr_gen ||
+	    dev->addr_gen != ni_objectmodel_netif_address_page.addr_gen ||
+	    cursor != ni_objectmodel_netif_address_page.cursor)
+		next = NULL;
+	else
+		next = ni_objectmodel_netif_address_page.next;
+
+	ni_dbus_variant_init_dict(&result);
+	list = ni_dbus_dict_add(&result, "addresses");
+	ni_dbus_dict_array_init(list);
+
+	rv = __ni_objectmodel_get_address_list_page(dev->addrs, family,
+						&cursor, &next, count, list, error);
+	if (rv && cursor) {
+		ni_objectmodel_netif_address_page.addr_gen = dev->addr_gen;
+		ni_objectmodel_netif_address_page.cursor = cursor;
+		ni_objectmodel_netif_address_page.next = next;
+		ni_dbus_dict_add_uint32(&result, "cursor", cursor);
+		ni_dbus_dict_add_uint32(&result, "generation", dev->addr_gen);
+	}
+	if (rv)
+		rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+
+	ni_dbus_variant_destroy(&result);
+	return rv;
+}
+
+static dbus_bool_t
+ni_objectmodel_netif_get_routes(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	unsigned int family, cursor, count, gen;
+	const ni_route_t *last = NULL;
+	const char *resume = NULL;
+	ni_dbus_variant_t *list;
+	ni_netdev_t *dev;
+	dbus_bool_t rv;
+	char *key;
+
+	if (!(dev = ni_objectmodel_unwrap_netif(object, error)))
+		return FALSE;
+
+	if (!ni_objectmodel_netif_page_args(object, method, argc, argv,
+					&family, &cursor, &count, &gen, error))
+		return FALSE;
+
+	if (cursor)
+		ni_dbus_dict_get_string(&argv[0], "resume", &resume);
+
+	if (cursor && gen != dev->route_gen) {
+		if (ni_string_empty(resume))
+			return ni_objectmodel_netif_list_changed(object, method, error);
+
+		cursor = __ni_objectmodel_route_list_resume(dev->routes, cursor, resume);
+		ni_debug_dbus("%s.%s(): route list changed, resuming at %u",
+				object->path, method->name, cursor);
+	}
+
+	ni_dbus_variant_init_dict(&result);
+	list = ni_dbus_dict_add(&result, "routes");
+	ni_dbus_dict_array_init(list);
+
+	rv = __ni_objectmodel_get_route_list_page(dev->routes, family,
+						&cursor, count, &last, list, error);
+	if (rv && cursor) {
+		ni_dbus_dict_add_uint32(&result, "cursor", cursor);
+		ni_dbus_dict_add_uint32(&result, "generation", dev->route_gen);
+		if (last && (key = __ni_objectmodel_route_list_resume_key(last))) {
+			ni_dbus_dict_add_string(&result, "resume", key);
+			free(key);
+		} else
+		if (!ni_string_empty(resume)) {
+			/* nothing matched the family filter on this page */
+			ni_dbus_dict_add_string(&result, "resume", resume);
+		}
+	}
+	if (rv)
+		rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+
+	ni_dbus_variant_destroy(&result);
+	return rv;
+}
+
 const char *
 ni_objectmodel_event_to_signal(ni_event_t event)
 {
@@ -1372,6 +1644,9 @@ static ni_dbus_method_t		ni_objectmodel_netif_methods[] = {
 	{ "clearEventFilters",	"",		.handler = ni_objectmodel_netif_clear_event_filters },
 	{ "waitDeviceReady",	"",		.handler = ni_objectmodel_netif_wait_device_ready },
 	{ "waitLinkUp",		"",		.handler = ni_objectmodel_netif_wait_link_up },
+	{ "getAddresses",	"a{sv}",	.handler = ni_objectmodel_netif_get_addresses },
+	{ "getRoutes",		"a{sv}",	.handler = ni_objectmodel_netif_get_routes },
+	{ "callCompound",	"aa{sv}",	.handler_ex = ni_dbus_server_call_compound },
 	{ NULL }
 };
 
@@ -1381,9 +1656,45 @@ static ni_dbus_method_t		ni_objectmodel_netif_methods[] = {
 static void *
 ni_objectmodel_get_netdev(const ni_dbus_object_t *object, ni_bool_t write_access, DBusError *error)
 {
+	if (!write_access)
+		return __ni_objectmodel_unwrap_netif(object, error);
 	return ni_objectmodel_unwrap_netif(object, error);
 }
 
+/*
+ * Address and route lists longer than this are not returned as
+ * properties; the addresses-paged or routes-paged property is set
+ * instead and the client has to use getAddresses or getRoutes.
+ */
+#define NI_OBJECTMODEL_NETIF_LIST_MAX		4096
+
+static ni_bool_t
+__ni_objectmodel_netif_addresses_paged(const ni_netdev_t *ifp)
+{
+	const ni_address_t *ap;
+	unsigned int count = 0;
+
+	for (ap = ifp->addrs; ap; ap = ap->next) {
+		if (++count > NI_OBJECTMODEL_NETIF_LIST_MAX)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static ni_bool_t
+__ni_objectmodel_netif_routes_paged(const ni_netdev_t *ifp)
+{
+	const ni_route_table_t *tab;
+	unsigned int count = 0;
+
+	for (tab = ifp->routes; tab; tab = tab->next) {
+		count += tab->routes.count;
+		if (count > NI_OBJECTMODEL_NETIF_LIST_MAX)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /*
  * Property Interface.addrs
  * This one is rather complex
@@ -1396,6 +1707,9 @@ __ni_objectmodel_netif_get_addresses(const ni_dbus_object_t *object,
 {
 	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
 
+	if (__ni_objectmodel_netif_addresses_paged(ifp))
+		return FALSE;
+
 	ni_dbus_dict_array_init(result);
 	return __ni_objectmodel_get_address_list(ifp->addrs, result, error);
 }
@@ -1408,6 +1722,7 @@ __ni_objectmodel_netif_set_addresses(ni_dbus_object_t *object,
 {
 	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
 
+	ifp->addrs_paged = FALSE;
 	return __ni_objectmodel_set_address_list(&ifp->addrs, argument, error);
 }
 
@@ -1423,6 +1738,9 @@ __ni_objectmodel_netif_get_routes(const ni_dbus_object_t *object,
 {
 	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
 
+	if (__ni_objectmodel_netif_routes_paged(ifp))
+		return FALSE;
+
 	ni_dbus_dict_array_init(result);
 	return __ni_objectmodel_get_route_list(ifp->routes, result, error);
 }
@@ -1435,9 +1753,75 @@ __ni_objectmodel_netif_set_routes(ni_dbus_object_t *object,
 {
 	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
 
+	ifp->routes_paged = FALSE;
 	return __ni_objectmodel_set_route_list(&ifp->routes, argument, error);
 }
 
+/*
+ * Properties Interface.addresses-paged and Interface.routes-paged
+ */
+static dbus_bool_t
+__ni_objectmodel_netif_get_addresses_paged(const ni_dbus_object_t *object,
+				const ni_dbus_property_t *property,
+				ni_dbus_variant_t *result,
+				DBusError *error)
+{
+	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
+
+	if (!__ni_objectmodel_netif_addresses_paged(ifp))
+		return FALSE;
+
+	ni_dbus_variant_set_bool(result, TRUE);
+	return TRUE;
+}
+
+static dbus_bool_t
+__ni_objectmodel_netif_set_addresses_paged(ni_dbus_object_t *object,
+				const ni_dbus_property_t *property,
+				const ni_dbus_variant_t *argument,
+				DBusError *error)
+{
+	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
+	dbus_bool_t paged;
+
+	if (!ni_dbus_variant_get_bool(argument, &paged))
+		return FALSE;
+
+	ifp->addrs_paged = paged;
+	return TRUE;
+}
+
+static dbus_bool_t
+__ni_objectmodel_netif_get_routes_paged(const ni_dbus_object_t *object,
+				const ni_dbus_property_t *property,
+				ni_dbus_variant_t *result,
+				DBusError *error)
+{
+	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
+
+	if (!__ni_objectmodel_netif_routes_paged(ifp))
+		return FALSE;
+
+	ni_dbus_variant_set_bool(result, TRUE);
+	return TRUE;
+}
+
+static dbus_bool_t
+__ni_objectmodel_netif_set_routes_paged(ni_dbus_object_t *object,
+				const ni_dbus_property_t *property,
+				const ni_dbus_variant_t *argument,
+				DBusError *error)
+{
+	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
+	dbus_bool_t paged;
+
+	if (!ni_dbus_variant_get_bool(argument, &paged))
+		return FALSE;
+
+	ifp->routes_paged = paged;
+	return TRUE;
+}
+
 /*
  * Property Interface.client_state
  */
@@ -1707,6 +2091,12 @@ static ni_dbus_property_t	ni_objectmodel_netif_properties[] = {
 	/* addresses and routes is an array of dicts */
 	NETIF_PROPERTY_SIGNATURE(NI_DBUS_DICT_ARRAY_SIGNATURE, addresses, RO),
 	NETIF_PROPERTY_SIGNATURE(NI_DBUS_DICT_ARRAY_SIGNATURE, routes, RO),
+	___NI_DBUS_PROPERTY(DBUS_TYPE_BOOLEAN_AS_STRING,
+				addresses-paged, addresses_paged,
+				__ni_objectmodel_netif, RO),
+	___NI_DBUS_PROPERTY(DBUS_TYPE_BOOLEAN_AS_STRING,
+				routes-paged, routes_paged,
+				__ni_objectmodel_netif, RO),
 
 	{ NULL }
 };
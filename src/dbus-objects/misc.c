@@ -35,7 +35,6 @@
 #include "dhcp6/options.h"
 
 static dbus_bool_t		__ni_objectmodel_callback_info_to_dict(const ni_objectmodel_callback_info_t *, ni_dbus_variant_t *);
-static dbus_bool_t		__ni_objectmodel_route_to_dict(const ni_route_t *, ni_dbus_variant_t *);
 static ni_route_t *		__ni_objectmodel_route_from_dict(ni_route_table_t **, const ni_dbus_variant_t *);
 static dbus_bool_t		ni_objectmodel_rule_to_dict(const ni_rule_t *, ni_dbus_variant_t *);
 static dbus_bool_t		ni_objectmodel_rule_from_dict(ni_rule_t *, const ni_dbus_variant_t *);
@@ -438,6 +437,76 @@ dbus_bool_t
 __ni_objectmodel_set_address_list(ni_address_t **list,
 				const ni_dbus_variant_t *argument,
 				DBusError *error)
+{
+	if (!list || !argument || !ni_dbus_variant_is_dict_array(argument)) {
+		if (error) {
+			dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+					"%s: argument type mismatch",
+					__FUNCTION__);
+		}
+		return FALSE;
+	}
+
+	ni_address_list_destroy(list);
+	return __ni_objectmodel_add_address_list(list, argument, error);
+}
+
+/*
+ * Retrieve a page of an address list as an array of dbus dicts.
+ *
+ * The cursor is the position in the unfiltered list to start at; it
+ * is updated to the position to continue at, or 0 when the end of
+ * the list has been reached. When next is set, it is the address at
+ * the cursor, so the list is not walked from the head; it is updated
+ * along with the cursor.
+ */
+dbus_bool_t
+__ni_objectmodel_get_address_list_page(ni_address_t *list, unsigned int family,
+				unsigned int *cursor, const ni_address_t **next,
+				unsigned int count, ni_dbus_variant_t *result,
+				DBusError *error)
+{
+	const ni_address_t *ap;
+	unsigned int pos = 0;
+	dbus_bool_t rv = TRUE;
+
+	if (next && *next) {
+		ap = *next;
+		pos = *cursor;
+	} else {
+		for (ap = list; ap && pos < *cursor; ap = ap->next)
+			pos++;
+	}
+
+	for (; ap && rv && count; ap = ap->next, pos++) {
+		ni_dbus_variant_t *dict;
+
+		if (ap->family != ap->local_addr.ss_family)
+			continue;
+		if (family != AF_UNSPEC && family != ap->family)
+			continue;
+
+		if (!(dict = ni_dbus_dict_array_add(result)))
+			return FALSE;
+		ni_dbus_variant_init_dict(dict);
+
+		rv = __ni_objectmodel_address_to_dict(ap, dict);
+		count--;
+	}
+
+	*cursor = ap ? pos : 0;
+	if (next)
+		*next = ap;
+	return rv;
+}
+
+/*
+ * Append the addresses of a (page of an) address list to the list
+ */
+dbus_bool_t
+__ni_objectmodel_add_address_list(ni_address_t **list,
+				const ni_dbus_variant_t *argument,
+				DBusError *error)
 {
 	unsigned int i;
 
@@ -450,7 +519,6 @@ __ni_objectmodel_set_address_list(ni_address_t **list,
 		return FALSE;
 	}
 
-	ni_address_list_destroy(list);
 	for (i = 0; i < argument->array.len; ++i) {
 		ni_dbus_variant_t *dict = &argument->variant_array_value[i];
 
@@ -750,6 +818,144 @@ dbus_bool_t
 __ni_objectmodel_set_route_list(ni_route_table_t **list,
 				const ni_dbus_variant_t *argument,
 				DBusError *error)
+{
+	if (!ni_dbus_variant_is_dict_array(argument)) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+				"%s: argument type mismatch",
+				__FUNCTION__);
+		return FALSE;
+	}
+
+	ni_route_tables_destroy(list);
+	return __ni_objectmodel_add_route_list(list, argument, error);
+}
+
+/*
+ * Retrieve a page of a route list as an array of dbus dicts, with
+ * a cursor counting the routes of all tables; see above. When last
+ * is set, it is updated to the last route added to the page.
+ */
+dbus_bool_t
+__ni_objectmodel_get_route_list_page(ni_route_table_t *list, unsigned int family,
+				unsigned int *cursor, unsigned int count,
+				const ni_route_t **last, ni_dbus_variant_t *result,
+				DBusError *error)
+{
+	const ni_route_table_t *tab;
+	const ni_route_t *rp;
+	unsigned int pos = 0, i;
+	dbus_bool_t rv = TRUE;
+
+	if (last)
+		*last = NULL;
+
+	for (tab = list; tab && pos + tab->routes.count <= *cursor; tab = tab->next)
+		pos += tab->routes.count;
+
+	for (i = tab ? *cursor - pos : 0, pos = *cursor; tab; tab = tab->next, i = 0) {
+		for (; i < tab->routes.count; ++i, ++pos) {
+			ni_dbus_variant_t *dict;
+
+			if (!rv || !count) {
+				*cursor = pos;
+				return rv;
+			}
+
+			if ((rp = tab->routes.data[i]) == NULL)
+				continue;
+			if (rp->family != rp->destination.ss_family)
+				continue;
+			if (family != AF_UNSPEC && family != rp->family)
+				continue;
+
+			if (!(dict = ni_dbus_dict_array_add(result)))
+				return FALSE;
+			ni_dbus_variant_init_dict(dict);
+
+			rv = __ni_objectmodel_route_to_dict(rp, dict);
+			if (last)
+				*last = rp;
+			count--;
+		}
+	}
+
+	*cursor = 0;
+	return rv;
+}
+
+/*
+ * The key of the route a page ended with, to resume the walk at
+ * after the route list changed: its table, metric and destination.
+ */
+char *
+__ni_objectmodel_route_list_resume_key(const ni_route_t *rp)
+{
+	char *key = NULL;
+
+	if (!rp)
+		return NULL;
+
+	ni_string_printf(&key, "%u %u %s", rp->table, rp->priority,
+			ni_sockaddr_prefix_print(&rp->destination, rp->prefixlen));
+	return key;
+}
+
+static ni_bool_t
+__ni_objectmodel_route_list_resume_match(const ni_route_t *rp, unsigned int metric,
+				const ni_sockaddr_t *dst, unsigned int prefixlen)
+{
+	return rp && rp->priority == metric && rp->prefixlen == prefixlen &&
+		ni_sockaddr_equal(&rp->destination, dst);
+}
+
+/*
+ * Find the position after the route with the resume key. Routes are
+ * removed from and appended to their table, so the route is searched
+ * backwards from the previous cursor first. When the route is gone,
+ * the walk continues at the previous cursor.
+ */
+unsigned int
+__ni_objectmodel_route_list_resume(const ni_route_table_t *list, unsigned int cursor,
+				const char *key)
+{
+	unsigned int table, metric, prefixlen, pos = 0, i, n;
+	const ni_route_table_t *tab;
+	char prefix[64];
+	ni_sockaddr_t dst;
+
+	if (!key || sscanf(key, "%u %u %63s", &table, &metric, prefix) != 3 ||
+	    !ni_sockaddr_prefix_parse(prefix, &dst, &prefixlen))
+		return cursor;
+
+	for (tab = list; tab && tab->tid != table; tab = tab->next)
+		pos += tab->routes.count;
+	if (!tab || !tab->routes.count)
+		return cursor;
+
+	n = cursor > pos ? cursor - pos : 0;
+	if (n > tab->routes.count)
+		n = tab->routes.count;
+
+	for (i = n; i-- > 0; ) {
+		if (__ni_objectmodel_route_list_resume_match(tab->routes.data[i],
+						metric, &dst, prefixlen))
+			return pos + i + 1;
+	}
+	for (i = n; i < tab->routes.count; ++i) {
+		if (__ni_objectmodel_route_list_resume_match(tab->routes.data[i],
+						metric, &dst, prefixlen))
+			return pos + i + 1;
+	}
+	return cursor;
+}
+
+/*
+ * Add the routes of a (page of a) route list to the route tables
+ */
+dbus_bool_t
+__ni_objectmodel_add_route_list(ni_route_table_t **list,
+				const ni_dbus_variant_t *argument,
+				DBusError *error)
 {
 	unsigned int i;
 
@@ -760,7 +966,6 @@ __ni_objectmodel_set_route_list(ni_route_table_t **list,
 		return FALSE;
 	}
 
-	ni_route_tables_destroy(list);
 	for (i = 0; i < argument->array.len; ++i) {
 		ni_dbus_variant_t *dict = &argument->variant_array_value[i];
 
@@ -951,7 +1156,7 @@ __ni_objectmodel_set_rule_dict(ni_rule_array_t **rules, unsigned int family,
 /*
  * Common functions to represent an assigned route as a dict
  */
-static dbus_bool_t
+dbus_bool_t
 __ni_objectmodel_route_to_dict(const ni_route_t *rp, ni_dbus_variant_t *dict)
 {
 	const ni_route_nexthop_t *nh;
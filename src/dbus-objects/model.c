@@ -65,6 +65,7 @@ ni_objectmodel_create_service(void)
 	server = ni_server_listen_dbus(NI_OBJECTMODEL_DBUS_BUS_NAME);
 	if (server == NULL)
 		ni_fatal("unable to initialize dbus service");
+	ni_server_listen_dbus_peer(server, NI_OBJECTMODEL_DBUS_BUS_NAME);
 
 	__ni_objectmodel_server = server;
 	return server;
@@ -145,6 +145,23 @@ extern dbus_bool_t		__ni_objectmodel_get_route_list(ni_route_table_t *list,
 extern dbus_bool_t		__ni_objectmodel_set_route_list(ni_route_table_t **list,
 						const ni_dbus_variant_t *result,
 						DBusError *error);
+extern dbus_bool_t		__ni_objectmodel_get_address_list_page(ni_address_t *list,
+						unsigned int family, unsigned int *cursor,
+						const ni_address_t **next, unsigned int count,
+						ni_dbus_variant_t *result, DBusError *error);
+extern dbus_bool_t		__ni_objectmodel_add_address_list(ni_address_t **list,
+						const ni_dbus_variant_t *argument,
+						DBusError *error);
+extern dbus_bool_t		__ni_objectmodel_get_route_list_page(ni_route_table_t *list,
+						unsigned int family, unsigned int *cursor,
+						unsigned int count, const ni_route_t **last,
+						ni_dbus_variant_t *result, DBusError *error);
+extern char *			__ni_objectmodel_route_list_resume_key(const ni_route_t *);
+extern unsigned int		__ni_objectmodel_route_list_resume(const ni_route_table_t *list,
+						unsigned int cursor, const char *key);
+extern dbus_bool_t		__ni_objectmodel_add_route_list(ni_route_table_t **list,
+						const ni_dbus_variant_t *argument,
+						DBusError *error);
 extern dbus_bool_t		__ni_objectmodel_get_addrconf_lease(const ni_addrconf_lease_t *lease,
 						ni_dbus_variant_t *result,
 						DBusError *error);
@@ -152,6 +169,41 @@ extern dbus_bool_t		__ni_objectmodel_set_addrconf_lease(ni_addrconf_lease_t *lea
 						const ni_dbus_variant_t *result,
 						DBusError *error);
 
+/*
+ * Filters of address and route change subscriptions
+ */
+typedef enum {
+	NI_OBJECTMODEL_SUBSCRIBE_ADDRESSES = 1,
+	NI_OBJECTMODEL_SUBSCRIBE_ROUTES,
+} ni_objectmodel_subscription_kind_t;
+
+typedef struct ni_objectmodel_subscription_filter {
+	unsigned int		kind;
+	unsigned int		family;		/* 0: any */
+	unsigned int		ifindex;	/* 0: any */
+	unsigned int		table;		/* 0: any */
+	int			scope;		/* -1: any */
+	ni_sockaddr_t		prefix;		/* unspec: any */
+	unsigned int		prefixlen;
+} ni_objectmodel_subscription_filter_t;
+
+extern dbus_bool_t		ni_objectmodel_subscription_filter_parse(ni_objectmodel_subscription_filter_t *,
+						const ni_dbus_variant_t *, DBusError *);
+extern ni_bool_t		ni_objectmodel_subscription_match_address(const ni_objectmodel_subscription_filter_t *,
+						const ni_netdev_t *, const ni_address_t *);
+extern ni_bool_t		ni_objectmodel_subscription_match_route(const ni_objectmodel_subscription_filter_t *,
+						const ni_route_t *);
+extern void			ni_objectmodel_subscriptions_route_event(ni_dbus_server_t *,
+						ni_event_t, const ni_route_t *);
+extern dbus_bool_t		ni_objectmodel_netif_list_subscribe(ni_dbus_object_t *,
+						const ni_dbus_method_t *, unsigned int,
+						const ni_dbus_variant_t *, ni_dbus_message_t *,
+						DBusError *);
+extern dbus_bool_t		ni_objectmodel_netif_list_unsubscribe(ni_dbus_object_t *,
+						const ni_dbus_method_t *, unsigned int,
+						const ni_dbus_variant_t *, ni_dbus_message_t *,
+						DBusError *);
+
 extern void			ni_objectmodel_create_netif_list(ni_dbus_server_t *);
 extern void			ni_objectmodel_create_modem_list(ni_dbus_server_t *);
 
@@ -173,6 +225,7 @@ extern dbus_bool_t		__ni_objectmodel_set_address_dict(ni_address_t **list, const
 extern dbus_bool_t		__ni_objectmodel_address_to_dict(const ni_address_t *, ni_dbus_variant_t *);
 extern ni_address_t *		__ni_objectmodel_address_from_dict(ni_address_t **, const ni_dbus_variant_t *);
 
+extern dbus_bool_t		__ni_objectmodel_route_to_dict(const ni_route_t *, ni_dbus_variant_t *);
 extern dbus_bool_t		__ni_objectmodel_get_route_dict(ni_route_table_t *list,
 						ni_dbus_variant_t *result,
 						DBusError *error);
@@ -0,0 +1,522 @@
+/*
+ * Filtered address and route change subscriptions
+ *
+ * Clients register a filter via InterfaceList.subscribe and receive
+ * addressChange or routeChange signals for matching changes only,
+ * sent to them directly instead of being broadcast.
+ *
+ * Copyright (C) 2026 SUSE LLC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <netlink/netlink.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/address.h>
+#include <wicked/route.h>
+#include <wicked/logging.h>
+#include <wicked/xml.h>
+#include <wicked/dbus-errors.h>
+#include <wicked/dbus-service.h>
+#include <wicked/objectmodel.h>
+#include <wicked/snapshot.h>
+#include "dbus-common.h"
+#include "netinfo_priv.h"
+#include "util_priv.h"
+#include "model.h"
+#include "debug.h"
+
+#define NI_OBJECTMODEL_SUBSCRIPTIONS_MAX	1024
+
+typedef struct ni_objectmodel_subscription	ni_objectmodel_subscription_t;
+struct ni_objectmodel_subscription {
+	ni_objectmodel_subscription_t *		next;
+	unsigned int				id;
+	char *					owner;
+	ni_objectmodel_subscription_filter_t	filter;
+};
+
+static struct {
+	ni_objectmodel_subscription_t *		list;
+	unsigned int				count;
+	unsigned int				last_id;
+	ni_dbus_object_t *			object;
+	ni_bool_t				watching;
+} ni_objectmodel_subscriptions;
+
+static const ni_intmap_t	ni_objectmodel_subscription_kinds[] = {
+	{ "addresses",		NI_OBJECTMODEL_SUBSCRIBE_ADDRESSES	},
+	{ "routes",		NI_OBJECTMODEL_SUBSCRIBE_ROUTES		},
+	{ NULL,			0					}
+};
+
+/*
+ * Parse the filter dict of a subscribe call
+ */
+dbus_bool_t
+ni_objectmodel_subscription_filter_parse(ni_objectmodel_subscription_filter_t *filter,
+				const ni_dbus_variant_t *dict, DBusError *error)
+{
+	const char *kind = NULL, *prefix = NULL;
+	uint32_t u32;
+
+	memset(filter, 0, sizeof(*filter));
+	filter->scope = -1;
+
+	if (!ni_dbus_variant_is_dict(dict)) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS, "filter is not a dict");
+		return FALSE;
+	}
+
+	if (!ni_dbus_dict_get_string(dict, "kind", &kind) ||
+	    ni_parse_uint_mapped(kind, ni_objectmodel_subscription_kinds, &filter->kind) < 0) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+				"filter requires a kind of \"addresses\" or \"routes\"");
+		return FALSE;
+	}
+
+	if (ni_dbus_dict_get_uint32(dict, "family", &u32))
+		filter->family = u32;
+	if (ni_dbus_dict_get_uint32(dict, "ifindex", &u32))
+		filter->ifindex = u32;
+	if (ni_dbus_dict_get_uint32(dict, "table", &u32))
+		filter->table = u32;
+	if (ni_dbus_dict_get_uint32(dict, "scope", &u32)) {
+		if (u32 > RT_SCOPE_NOWHERE) {
+			dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+					"invalid scope %u in filter", u32);
+			return FALSE;
+		}
+		filter->scope = u32;
+	}
+	if (ni_dbus_dict_get_string(dict, "prefix", &prefix)) {
+		if (!ni_sockaddr_prefix_parse(prefix, &filter->prefix, &filter->prefixlen) ||
+		    (filter->family && filter->family != filter->prefix.ss_family)) {
+			dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+					"invalid prefix \"%s\" in filter", prefix);
+			return FALSE;
+		}
+		filter->family = filter->prefix.ss_family;
+	}
+
+	if (filter->family != AF_UNSPEC && filter->family != AF_INET &&
+	    filter->family != AF_INET6) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+				"invalid family %u in filter", filter->family);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Check an address or route against a filter
+ */
+ni_bool_t
+ni_objectmodel_subscription_match_address(const ni_objectmodel_subscription_filter_t *filter,
+				const ni_netdev_t *dev, const ni_address_t *ap)
+{
+	if (filter->kind != NI_OBJECTMODEL_SUBSCRIBE_ADDRESSES)
+		return FALSE;
+	if (filter->family && filter->family != ap->family)
+		return FALSE;
+	if (filter->ifindex && filter->ifindex != dev->link.ifindex)
+		return FALSE;
+	if (filter->scope >= 0 && filter->scope != ap->scope)
+		return FALSE;
+	if (filter->prefix.ss_family &&
+	    !ni_sockaddr_prefix_match(filter->prefixlen, &filter->prefix, &ap->local_addr))
+		return FALSE;
+	return TRUE;
+}
+
+ni_bool_t
+ni_objectmodel_subscription_match_route(const ni_objectmodel_subscription_filter_t *filter,
+				const ni_route_t *rp)
+{
+	const ni_route_nexthop_t *nh;
+
+	if (filter->kind != NI_OBJECTMODEL_SUBSCRIBE_ROUTES)
+		return FALSE;
+	if (filter->family && filter->family != rp->family)
+		return FALSE;
+	if (filter->table && filter->table != rp->table)
+		return FALSE;
+	if (filter->scope >= 0 && (unsigned int)filter->scope != rp->scope)
+		return FALSE;
+	if (filter->prefix.ss_family) {
+		/* routes to the prefix itself or more specific ones */
+		if (rp->prefixlen < filter->prefixlen)
+			return FALSE;
+		if (!ni_sockaddr_prefix_match(filter->prefixlen, &filter->prefix, &rp->destination))
+			return FALSE;
+	}
+	if (filter->ifindex) {
+		for (nh = &rp->nh; nh; nh = nh->next) {
+			if (nh->device.index == filter->ifindex)
+				return TRUE;
+		}
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Subscribers are bus clients; forget their subscriptions as soon
+ * as they disconnect from the bus.
+ */
+static void
+ni_objectmodel_subscriptions_drop(const char *owner, unsigned int id)
+{
+	ni_objectmodel_subscription_t **pos, *sub;
+
+	for (pos = &ni_objectmodel_subscriptions.list; (sub = *pos) != NULL; ) {
+		if (!ni_string_eq(sub->owner, owner) || (id && sub->id != id)) {
+			pos = &sub->next;
+			continue;
+		}
+
+		ni_debug_dbus("dropping subscription %u of %s", sub->id, sub->owner);
+		*pos = sub->next;
+		ni_objectmodel_subscriptions.count--;
+		ni_string_free(&sub->owner);
+		free(sub);
+	}
+}
+
+static void
+ni_objectmodel_subscriptions_name_owner_changed(ni_dbus_connection_t *conn,
+				ni_dbus_message_t *msg, void *user_data)
+{
+	const char *name = NULL, *old_owner = NULL, *new_owner = NULL;
+
+	if (!ni_string_eq(dbus_message_get_member(msg), "NameOwnerChanged"))
+		return;
+
+	if (!dbus_message_get_args(msg, NULL,
+				DBUS_TYPE_STRING, &name,
+				DBUS_TYPE_STRING, &old_owner,
+				DBUS_TYPE_STRING, &new_owner,
+				DBUS_TYPE_INVALID))
+		return;
+
+	if (ni_string_empty(new_owner))
+		ni_objectmodel_subscriptions_drop(name, 0);
+}
+
+static void
+ni_objectmodel_subscriptions_route_handler(ni_netconfig_t *nc, ni_event_t event,
+				const ni_route_t *rp)
+{
+	ni_server_trace_route_events(nc, event, rp);
+	ni_state_snapshot_notify();
+
+	/* subscriptions are about the own network namespace */
+	if (nc != ni_global_state_handle(0))
+		return;
+	ni_objectmodel_subscriptions_route_event(__ni_objectmodel_server, event, rp);
+}
+
+/*
+ * The route tables of a router can be huge, so wickedd listens to
+ * route events only when configured or needed by a route subscriber.
+ * Routes discovered before were not tracked, so they are refreshed.
+ */
+ni_bool_t
+ni_objectmodel_track_routes(void)
+{
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+
+	if (ni_server_listens_route_events())
+		return TRUE;
+
+	if (ni_server_enable_route_events(ni_objectmodel_subscriptions_route_handler) < 0)
+		return FALSE;
+
+	if (ni_netconfig_devlist(nc) && __ni_system_refresh_routes(nc) < 0)
+		ni_warn("unable to refresh the routes");
+	ni_state_snapshot_track_routes(TRUE);
+	return TRUE;
+}
+
+/*
+ * The owner watch is not needed without any subscribers.
+ */
+static void
+ni_objectmodel_subscriptions_watch(ni_dbus_object_t *object)
+{
+	if (!ni_objectmodel_subscriptions.watching) {
+		ni_dbus_server_add_signal_handler(ni_dbus_object_get_server(object),
+				NI_DBUS_BUS_NAME, NI_DBUS_OBJECT_PATH, NI_DBUS_INTERFACE,
+				ni_objectmodel_subscriptions_name_owner_changed, NULL);
+		ni_objectmodel_subscriptions.watching = TRUE;
+	}
+
+	ni_objectmodel_subscriptions.object = object;
+}
+
+static ni_objectmodel_subscription_t *
+ni_objectmodel_subscription_add(unsigned int id, const char *owner,
+				const ni_objectmodel_subscription_filter_t *filter)
+{
+	ni_objectmodel_subscription_t *sub;
+
+	sub = xcalloc(1, sizeof(*sub));
+	sub->id = id;
+	ni_string_dup(&sub->owner, owner);
+	sub->filter = *filter;
+	sub->next = ni_objectmodel_subscriptions.list;
+	ni_objectmodel_subscriptions.list = sub;
+	ni_objectmodel_subscriptions.count++;
+	return sub;
+}
+
+/*
+ * InterfaceList.subscribe(dict filter) returns the subscription id
+ */
+dbus_bool_t
+ni_objectmodel_netif_list_subscribe(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_objectmodel_subscription_filter_t filter;
+	ni_objectmodel_subscription_t *sub;
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	const char *owner;
+	dbus_bool_t rv;
+
+	if (argc != 1)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	/* replies go back to the caller, so do the signals */
+	if (!(owner = dbus_message_get_destination(reply))) {
+		dbus_set_error(error, DBUS_ERROR_NOT_SUPPORTED,
+				"%s.%s: subscriptions require a bus connection",
+				object->path, method->name);
+		return FALSE;
+	}
+
+	if (!ni_objectmodel_subscription_filter_parse(&filter, &argv[0], error))
+		return FALSE;
+
+	if (ni_objectmodel_subscriptions.count >= NI_OBJECTMODEL_SUBSCRIPTIONS_MAX) {
+		dbus_set_error(error, DBUS_ERROR_LIMITS_EXCEEDED,
+				"%s.%s: too many subscriptions", object->path, method->name);
+		return FALSE;
+	}
+
+	if (filter.kind == NI_OBJECTMODEL_SUBSCRIBE_ROUTES && !ni_objectmodel_track_routes()) {
+		dbus_set_error(error, DBUS_ERROR_FAILED,
+				"%s.%s: unable to listen to route events",
+				object->path, method->name);
+		return FALSE;
+	}
+
+	ni_objectmodel_subscriptions_watch(object);
+
+	if (!++ni_objectmodel_subscriptions.last_id)
+		ni_objectmodel_subscriptions.last_id++;
+	sub = ni_objectmodel_subscription_add(ni_objectmodel_subscriptions.last_id,
+				owner, &filter);
+
+	ni_debug_dbus("%s subscribed to %s changes (subscription %u)", sub->owner,
+			ni_format_uint_mapped(filter.kind, ni_objectmodel_subscription_kinds),
+			sub->id);
+
+	ni_dbus_variant_set_uint32(&result, sub->id);
+	rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+	ni_dbus_variant_destroy(&result);
+	return rv;
+}
+
+/*
+ * InterfaceList.unsubscribe(uint32 id)
+ */
+dbus_bool_t
+ni_objectmodel_netif_list_unsubscribe(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	uint32_t id;
+
+	if (argc != 1 || !ni_dbus_variant_get_uint32(&argv[0], &id) || !id)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_objectmodel_subscriptions_drop(dbus_message_get_destination(reply), id);
+	return TRUE;
+}
+
+/*
+ * Send the change to the matching subscribers. The signal argument
+ * is built for the first match and only the id differs per signal.
+ */
+static void
+ni_objectmodel_subscriptions_send(ni_dbus_server_t *server, const char *signal_name,
+				ni_objectmodel_subscription_t *sub, ni_dbus_variant_t *arg)
+{
+	ni_dbus_variant_t *var;
+
+	if ((var = ni_dbus_dict_get(arg, "subscription")))
+		ni_dbus_variant_set_uint32(var, sub->id);
+
+	ni_dbus_server_send_signal_to(server, sub->owner,
+				ni_objectmodel_subscriptions.object,
+				NI_OBJECTMODEL_NETIFLIST_INTERFACE,
+				signal_name, 1, arg);
+}
+
+void
+ni_objectmodel_subscriptions_address_event(ni_dbus_server_t *server, const ni_netdev_t *dev,
+				ni_event_t event, const ni_address_t *ap)
+{
+	ni_dbus_variant_t arg = NI_DBUS_VARIANT_INIT;
+	ni_objectmodel_subscription_t *sub;
+	ni_dbus_variant_t *dict;
+
+	if (!server || !dev || !ap)
+		return;
+
+	for (sub = ni_objectmodel_subscriptions.list; sub; sub = sub->next) {
+		if (!ni_objectmodel_subscription_match_address(&sub->filter, dev, ap))
+			continue;
+
+		if (!ni_dbus_variant_is_dict(&arg)) {
+			ni_dbus_variant_init_dict(&arg);
+			ni_dbus_dict_add_uint32(&arg, "subscription", 0);
+			ni_dbus_dict_add_string(&arg, "event", ni_event_type_to_name(event));
+			ni_dbus_dict_add_uint32(&arg, "ifindex", dev->link.ifindex);
+			dict = ni_dbus_dict_add(&arg, "address");
+			ni_dbus_variant_init_dict(dict);
+			__ni_objectmodel_address_to_dict(ap, dict);
+		}
+		ni_objectmodel_subscriptions_send(server, "addressChange", sub, &arg);
+	}
+	ni_dbus_variant_destroy(&arg);
+}
+
+void
+ni_objectmodel_subscriptions_route_event(ni_dbus_server_t *server, ni_event_t event,
+				const ni_route_t *rp)
+{
+	ni_dbus_variant_t arg = NI_DBUS_VARIANT_INIT;
+	ni_objectmodel_subscription_t *sub;
+	ni_dbus_variant_t *dict;
+
+	if (!server || !rp)
+		return;
+
+	for (sub = ni_objectmodel_subscriptions.list; sub; sub = sub->next) {
+		if (!ni_objectmodel_subscription_match_route(&sub->filter, rp))
+			continue;
+
+		if (!ni_dbus_variant_is_dict(&arg)) {
+			ni_dbus_variant_init_dict(&arg);
+			ni_dbus_dict_add_uint32(&arg, "subscription", 0);
+			ni_dbus_dict_add_string(&arg, "event", ni_event_type_to_name(event));
+			dict = ni_dbus_dict_add(&arg, "route");
+			ni_dbus_variant_init_dict(dict);
+			__ni_objectmodel_route_to_dict(rp, dict);
+		}
+		ni_objectmodel_subscriptions_send(server, "routeChange", sub, &arg);
+	}
+	ni_dbus_variant_destroy(&arg);
+}
+
+/*
+ * Hand the subscriptions off to a new wickedd instance. The subscribers
+ * stay connected to the bus, so their names and ids remain valid.
+ */
+void
+ni_objectmodel_subscriptions_save(xml_node_t *parent)
+{
+	const ni_objectmodel_subscription_filter_t *filter;
+	ni_objectmodel_subscription_t *sub;
+	xml_node_t *list, *node;
+
+	list = xml_node_new("subscriptions", parent);
+	xml_node_add_attr_uint(list, "last-id", ni_objectmodel_subscriptions.last_id);
+
+	for (sub = ni_objectmodel_subscriptions.list; sub; sub = sub->next) {
+		filter = &sub->filter;
+
+		node = xml_node_new("subscription", list);
+		xml_node_add_attr_uint(node, "id", sub->id);
+		xml_node_add_attr(node, "owner", sub->owner);
+		xml_node_add_attr(node, "kind", ni_format_uint_mapped(filter->kind,
+					ni_objectmodel_subscription_kinds));
+		if (filter->family)
+			xml_node_add_attr_uint(node, "family", filter->family);
+		if (filter->ifindex)
+			xml_node_add_attr_uint(node, "ifindex", filter->ifindex);
+		if (filter->table)
+			xml_node_add_attr_uint(node, "table", filter->table);
+		if (filter->scope >= 0)
+			xml_node_add_attr_uint(node, "scope", filter->scope);
+		if (filter->prefix.ss_family)
+			xml_node_add_attr(node, "prefix", ni_sockaddr_prefix_print(&filter->prefix,
+						filter->prefixlen));
+	}
+}
+
+ni_bool_t
+ni_objectmodel_subscriptions_restore(ni_dbus_server_t *server, const xml_node_t *parent)
+{
+	ni_objectmodel_subscription_filter_t filter;
+	const xml_node_t *list, *node;
+	ni_dbus_object_t *object;
+	unsigned int id, scope;
+	const char *owner, *prefix;
+
+	if (!server || !(list = xml_node_get_child(parent, "subscriptions")))
+		return FALSE;
+
+	object = ni_dbus_object_lookup(ni_dbus_server_get_root_object(server),
+				NI_OBJECTMODEL_NETIF_LIST_PATH);
+	if (!object)
+		return FALSE;
+
+	xml_node_get_attr_uint(list, "last-id", &ni_objectmodel_subscriptions.last_id);
+	for (node = list->children; node; node = node->next) {
+		memset(&filter, 0, sizeof(filter));
+		filter.scope = -1;
+
+		owner = xml_node_get_attr(node, "owner");
+		prefix = xml_node_get_attr(node, "prefix");
+		if (!ni_string_eq(node->name, "subscription") || ni_string_empty(owner) ||
+		    !xml_node_get_attr_uint(node, "id", &id) ||
+		    ni_parse_uint_mapped(xml_node_get_attr(node, "kind"),
+				ni_objectmodel_subscription_kinds, &filter.kind) < 0 ||
+		    (prefix && !ni_sockaddr_prefix_parse(prefix, &filter.prefix, &filter.prefixlen)))
+			continue;
+
+		xml_node_get_attr_uint(node, "family", &filter.family);
+		xml_node_get_attr_uint(node, "ifindex", &filter.ifindex);
+		xml_node_get_attr_uint(node, "table", &filter.table);
+		if (xml_node_get_attr_uint(node, "scope", &scope))
+			filter.scope = scope;
+
+		if (ni_objectmodel_subscriptions.count >= NI_OBJECTMODEL_SUBSCRIPTIONS_MAX ||
+		    (filter.kind == NI_OBJECTMODEL_SUBSCRIBE_ROUTES && !ni_objectmodel_track_routes()))
+			return FALSE;
+
+		ni_objectmodel_subscriptions_watch(object);
+		ni_objectmodel_subscription_add(id, owner, &filter);
+	}
+	return TRUE;
+}
@@ -7,10 +7,13 @@
 #include "config.h"
 #endif
 
+#include <sys/time.h>
+
 #include <wicked/util.h>
 #include <wicked/logging.h>
 #include <wicked/dbus-service.h>
 #include <wicked/dbus-errors.h>
+#include <wicked/socket.h>
 #include "dbus-server.h"
 #include "dbus-object.h"
 #include "dbus-dict.h"
@@ -26,15 +29,30 @@ static const ni_dbus_class_t	dbus_root_object_class = {
 	.name = "<root>",
 };
 
+typedef struct ni_dbus_server_peer ni_dbus_server_peer_t;
+struct ni_dbus_server_peer {
+	ni_dbus_server_peer_t *	next;
+	ni_dbus_server_t *	server;			/* back pointer at server */
+	ni_dbus_connection_t *	connection;
+	ni_bool_t		closed;
+	ni_bool_t		stopped;		/* calls are resent via the bus */
+};
+
 struct ni_dbus_server {
 	ni_dbus_connection_t *	connection;
 	ni_dbus_object_t *	root_object;
+
+	ni_dbus_peer_server_t *	peer_server;
+	ni_dbus_server_peer_t *	peers;
+	const ni_timer_t *	peer_reaper;
+	ni_bool_t		peers_stopped;
 };
 
 static dbus_bool_t		ni_dbus_object_register_object_manager(ni_dbus_object_t *);
 static dbus_bool_t		ni_dbus_object_register_introspectable_interface(ni_dbus_object_t *);
 static const char *		__ni_dbus_server_root_path(const char *);
 static void			__ni_dbus_server_object_init(ni_dbus_object_t *object, ni_dbus_server_t *server);
+static void			__ni_dbus_server_peers_free(ni_dbus_server_t *, ni_bool_t);
 
 /*
  * Constructor for DBus server handle
@@ -71,6 +89,11 @@ ni_dbus_server_free(ni_dbus_server_t *server)
 {
 	NI_TRACE_ENTER();
 
+	if (server->peer_server)
+		ni_dbus_peer_server_free(server->peer_server);
+	server->peer_server = NULL;
+	__ni_dbus_server_peers_free(server, FALSE);
+
 	if (server->root_object)
 		__ni_dbus_object_free(server->root_object);
 	server->root_object = NULL;
@@ -122,6 +145,20 @@ dbus_bool_t
 ni_dbus_server_send_signal(ni_dbus_server_t *server, ni_dbus_object_t *object,
 				const char *interface, const char *signal_name,
 				unsigned int nargs, const ni_dbus_variant_t *args)
+{
+	return ni_dbus_server_send_signal_to(server, NULL, object, interface,
+						signal_name, nargs, args);
+}
+
+/*
+ * Send a signal to a single bus client only, e.g. a subscriber.
+ * Without destination, it is broadcast as usual.
+ */
+dbus_bool_t
+ni_dbus_server_send_signal_to(ni_dbus_server_t *server, const char *destination,
+				ni_dbus_object_t *object, const char *interface,
+				const char *signal_name, unsigned int nargs,
+				const ni_dbus_variant_t *args)
 {
 	const ni_dbus_service_t *svc = NULL;
 	const ni_dbus_method_t *method;
@@ -151,6 +188,9 @@ ni_dbus_server_send_signal(ni_dbus_server_t *server, ni_dbus_object_t *object,
 		return FALSE;
 	}
 
+	if (destination && !dbus_message_set_destination(msg, destination))
+		goto out;
+
 	if (nargs && !ni_dbus_message_serialize_variants(msg, nargs, args, &error))
 		goto out;
 
@@ -166,6 +206,18 @@ out:
 	return rv;
 }
 
+/*
+ * Receive signals from the bus on the server connection
+ */
+void
+ni_dbus_server_add_signal_handler(ni_dbus_server_t *server, const char *sender,
+				const char *object_path, const char *object_interface,
+				ni_dbus_signal_handler_t *callback, void *user_data)
+{
+	ni_dbus_add_signal_handler(server->connection, sender, object_path,
+				object_interface, callback, user_data);
+}
+
 /*
  * When creating an object as a child of a server side object, inherit
  * its server handle.
@@ -566,16 +618,14 @@ __ni_dbus_object_unregister(DBusConnection *conn, void *user_data)
 }
 
 static DBusHandlerResult
-__ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_data)
+__ni_dbus_object_dispatch(ni_dbus_connection_t *connection, ni_dbus_object_t *object, DBusMessage *call)
 {
 	const char *interface = dbus_message_get_interface(call);
 	const char *method_name = dbus_message_get_member(call);
-	ni_dbus_object_t *object = user_data;
 	const ni_dbus_method_t *method;
 	DBusError error = DBUS_ERROR_INIT;
 	DBusMessage *reply = NULL;
 	const ni_dbus_service_t *svc;
-	ni_dbus_server_t *server;
 	dbus_bool_t rv = FALSE;
 
 	/* Clean out deceased objects */
@@ -595,8 +645,6 @@ __ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_dat
 		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 	}
 
-	server = ni_dbus_object_get_server(object);
-
 	method = ni_dbus_service_get_method(svc, method_name);
 	if (method == NULL
 	 || (!method->handler && !method->handler_ex && !method->async_handler)) {
@@ -642,7 +690,8 @@ __ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_dat
 		if (method->handler_ex) {
 			int err;
 
-			err = ni_dbus_object_get_caller_uid(object, call, &caller_uid);
+			err = ni_dbus_connection_get_caller_uid(connection,
+					dbus_message_get_sender(call), &caller_uid);
 			if (err < 0) {
 				ni_dbus_set_error_from_code(&error, err, "unable to get caller's uid");
 				goto error_reply;
@@ -679,7 +728,7 @@ __ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_dat
 				ni_dbus_variant_destroy(&argv[argc]);
 		} else
 		if (method->async_handler) {
-			rv = method->async_handler(server->connection, object, method, call);
+			rv = method->async_handler(connection, object, method, call);
 		} else {
 			dbus_set_error(&error, DBUS_ERROR_FAILED, "No server side handler for method");
 			rv = FALSE;
@@ -696,7 +745,7 @@ error_reply:
 	}
 
 	/* send reply */
-	if (reply && ni_dbus_connection_send_message(server->connection, reply) < 0)
+	if (reply && ni_dbus_connection_send_message(connection, reply) < 0)
 		ni_error("unable to send reply (out of memory)");
 
 	dbus_error_free(&error);
@@ -704,8 +753,378 @@ error_reply:
 		dbus_message_unref(reply);
 
 	return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult
+__ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_data)
+{
+	ni_dbus_object_t *object = user_data;
+	ni_dbus_server_t *server;
+
+	if (!(server = ni_dbus_object_get_server(object)))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	return __ni_dbus_object_dispatch(server->connection, object, call);
+}
+
+/*
+ * Execute a single step of a compound call. The step is a dict
+ * with the "interface" and "method" names and an optional variant
+ * array of "arguments". The step outcome is recorded in the result
+ * dict, either as "result" variant array or as "error-name" and
+ * "error-message" strings.
+ */
+static dbus_bool_t
+__ni_dbus_server_call_step(ni_dbus_object_t *object, const ni_dbus_variant_t *step,
+				uid_t caller_uid, ni_dbus_variant_t *result)
+{
+	const char *interface = NULL, *name = NULL;
+	DBusError error = DBUS_ERROR_INIT;
+	const ni_dbus_service_t *svc = NULL;
+	const ni_dbus_method_t *method = NULL;
+	const ni_dbus_variant_t *args;
+	ni_dbus_message_t *reply = NULL;
+	ni_dbus_variant_t resv[16];
+	char signature[64];
+	unsigned int argc = 0, i;
+	int resc;
+	dbus_bool_t rv = FALSE;
+
+	ni_dbus_dict_get_string(step, "interface", &interface);
+	ni_dbus_dict_get_string(step, "method", &name);
+	ni_dbus_dict_add_string(result, "interface", interface ?: "");
+	ni_dbus_dict_add_string(result, "method", name ?: "");
+
+	if (interface && name && (svc = ni_dbus_object_get_service(object, interface)))
+		method = ni_dbus_service_get_method(svc, name);
+
+	if (method == NULL
+	 || method->handler_ex == ni_dbus_server_call_compound
+	 || (!method->handler && !method->handler_ex)) {
+		dbus_set_error(&error, DBUS_ERROR_UNKNOWN_METHOD,
+				"Unknown method in compound call to object %s, %s.%s",
+				object->path, interface, name);
+		goto done;
+	}
+
+	/* async methods and methods returning a callback to wait
+	 * for need their own reply and can't be used here */
+	if (method->async_handler || ni_dbus_xml_method_has_return(method)) {
+		dbus_set_error(&error, DBUS_ERROR_NOT_SUPPORTED,
+				"Method %s.%s can't be used in a compound call",
+				interface, name);
+		goto done;
+	}
+
+	signature[0] = '\0';
+	if ((args = ni_dbus_dict_get(step, "arguments")) != NULL) {
+		if (!ni_dbus_variant_is_variant_array(args))
+			goto invalid_args;
+
+		argc = args->array.len;
+		for (i = 0; i < argc; ++i) {
+			const char *sig = ni_dbus_variant_signature(&args->variant_array_value[i]);
+			unsigned int len = strlen(signature);
+
+			if (!sig || len + strlen(sig) >= sizeof(signature))
+				goto invalid_args;
+			strcat(signature + len, sig);
+		}
+	}
+
+	if (method->call_signature && strcmp(signature, method->call_signature)) {
+		ni_debug_dbus("Mismatched call signature; expect=%s; got=%s",
+				method->call_signature, signature);
+		dbus_set_error(&error, DBUS_ERROR_INVALID_SIGNATURE,
+				"Bad call signature in compound call to object %s, %s.%s",
+				object->path, svc->name, name);
+		goto done;
+	}
+
+	/* If the object has a refresh function, call it now */
+	if (object->class && object->class->refresh
+	 && !object->class->refresh(object)) {
+		dbus_set_error(&error, DBUS_ERROR_FAILED,
+				"Failed to refresh object %s", object->path);
+		goto done;
+	}
+
+	reply = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN);
+	if (method->handler_ex) {
+		rv = method->handler_ex(object, method, argc,
+				argc ? args->variant_array_value : NULL,
+				caller_uid, reply, &error);
+	} else {
+		rv = method->handler(object, method, argc,
+				argc ? args->variant_array_value : NULL,
+				reply, &error);
+	}
+
+	if (rv) {
+		ni_dbus_variant_t *res = ni_dbus_dict_add(result, "result");
+
+		memset(resv, 0, sizeof(resv));
+		ni_dbus_variant_init_variant_array(res);
+		if ((resc = ni_dbus_message_get_args_variants(reply, resv, 16)) > 0) {
+			for (i = 0; i < (unsigned int)resc; ++i)
+				*ni_dbus_variant_append_variant_element(res) = resv[i];
+		}
+	}
+	goto done;
+
+invalid_args:
+	dbus_set_error(&error, DBUS_ERROR_INVALID_ARGS,
+			"Bad arguments in compound call to object %s, %s.%s",
+			object->path, interface, name);
+done:
+	if (!rv) {
+		if (!dbus_error_is_set(&error))
+			dbus_set_error(&error, DBUS_ERROR_FAILED, "Unexpected error in method call");
+		ni_dbus_dict_add_string(result, "error-name", error.name);
+		ni_dbus_dict_add_string(result, "error-message", error.message);
+	}
+	dbus_error_free(&error);
+	if (reply)
+		dbus_message_unref(reply);
+	return rv;
+}
+
+/*
+ * Generic method handler, executing an ordered list of method calls
+ * on one object in a single message round trip. The steps are
+ * independent: a failing step does not stop the following ones.
+ * The reply contains one result dict per step; once the object has
+ * been deleted by a step, the remaining steps fail.
+ */
+dbus_bool_t
+ni_dbus_server_call_compound(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+				unsigned int argc, const ni_dbus_variant_t *argv,
+				uid_t caller_uid, ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t results = NI_DBUS_VARIANT_INIT;
+	const ni_dbus_variant_t *steps;
+	ni_bool_t deleted = FALSE;
+	unsigned int i;
+	dbus_bool_t rv;
+
+	if (argc != 1 || !ni_dbus_variant_is_dict_array(&argv[0]))
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
 
+	steps = &argv[0];
+	ni_dbus_dict_array_init(&results);
+	for (i = 0; i < steps->array.len; ++i) {
+		const ni_dbus_variant_t *step = &steps->variant_array_value[i];
+		ni_dbus_variant_t *result = ni_dbus_dict_array_add(&results);
+		const char *name = NULL;
+
+		if (!deleted) {
+			__ni_dbus_server_call_step(object, step, caller_uid, result);
+
+			/* object has been deleted by this step */
+			deleted = object->parent == NULL;
+			continue;
+		}
+
+		ni_dbus_dict_get_string(step, "interface", &name);
+		ni_dbus_dict_add_string(result, "interface", name ?: "");
+		name = NULL;
+		ni_dbus_dict_get_string(step, "method", &name);
+		ni_dbus_dict_add_string(result, "method", name ?: "");
+		ni_dbus_dict_add_string(result, "error-name", NI_DBUS_ERROR_DEVICE_NOT_KNOWN);
+		ni_dbus_dict_add_string(result, "error-message", "Device has been deleted");
+	}
+
+	rv = ni_dbus_message_serialize_variants(reply, 1, &results, error);
+	ni_dbus_variant_destroy(&results);
+	return rv;
+}
+
+/*
+ * Private peer-to-peer connections. The objects are served on peer
+ * connections using a fallback handler resolving the object path in
+ * the server's object tree; signals are still sent via the bus only.
+ */
+static DBusHandlerResult
+__ni_dbus_server_peer_message(DBusConnection *conn, DBusMessage *call, void *user_data)
+{
+	ni_dbus_server_peer_t *peer = user_data;
+	ni_dbus_object_t *root, *object = NULL;
+	const char *path;
+
+	if (peer->closed || !(root = peer->server->root_object))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (peer->stopped) {
+		DBusError error = DBUS_ERROR_INIT;
+
+		if (dbus_message_get_type(call) != DBUS_MESSAGE_TYPE_METHOD_CALL)
+			return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+		/* not executed, the client resends it via the bus */
+		dbus_set_error(&error, NI_DBUS_ERROR_PEER_CLOSED,
+				"Peer connection closed, call the service via the bus");
+		if (!dbus_message_get_no_reply(call))
+			ni_dbus_connection_send_error(peer->connection, call, &error);
+		dbus_error_free(&error);
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
+	path = dbus_message_get_path(call);
+	if (path && ni_dbus_object_get_relative_path(root, path))
+		object = ni_dbus_object_lookup(root, path);
+
+	if (object == NULL || object->server_object == NULL)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	return __ni_dbus_object_dispatch(peer->connection, object, call);
+}
+
+static const DBusObjectPathVTable	__ni_dbus_server_peer_vtable = {
+	.message_function = __ni_dbus_server_peer_message,
+};
+
+static void
+__ni_dbus_server_peers_free(ni_dbus_server_t *server, ni_bool_t closed_only)
+{
+	ni_dbus_server_peer_t **pos, *peer;
+
+	if (server->peer_reaper && !closed_only) {
+		ni_timer_cancel(server->peer_reaper);
+		server->peer_reaper = NULL;
+	}
+
+	for (pos = &server->peers; (peer = *pos) != NULL; ) {
+		if (closed_only && !peer->closed) {
+			pos = &peer->next;
+			continue;
+		}
+		*pos = peer->next;
+		ni_dbus_connection_free(peer->connection);
+		free(peer);
+	}
+}
+
+static void
+__ni_dbus_server_peer_reap(void *user_data, const ni_timer_t *timer)
+{
+	ni_dbus_server_t *server = user_data;
+
+	if (server->peer_reaper != timer)
+		return;
+
+	server->peer_reaper = NULL;
+	__ni_dbus_server_peers_free(server, TRUE);
+}
+
+static void
+__ni_dbus_server_peer_disconnect(ni_dbus_connection_t *connection, void *user_data)
+{
+	ni_dbus_server_peer_t *peer = user_data;
+	ni_dbus_server_t *server = peer->server;
+
+	/* we're called while dispatching on the connection, release it later */
+	peer->closed = TRUE;
+	if (!server->peer_reaper)
+		server->peer_reaper = ni_timer_register(0, __ni_dbus_server_peer_reap, server);
+}
+
+static void
+__ni_dbus_server_peer_accept(ni_dbus_connection_t *connection, void *user_data)
+{
+	ni_dbus_server_t *server = user_data;
+	ni_dbus_server_peer_t *peer;
+
+	peer = xcalloc(1, sizeof(*peer));
+	peer->server = server;
+	peer->connection = connection;
+	peer->stopped = server->peers_stopped;
+
+	ni_dbus_connection_set_disconnect_handler(connection, __ni_dbus_server_peer_disconnect, peer);
+	ni_dbus_connection_register_fallback(connection, "/", &__ni_dbus_server_peer_vtable, peer);
+
+	peer->next = server->peers;
+	server->peers = peer;
+}
+
+dbus_bool_t
+ni_dbus_server_listen_peer(ni_dbus_server_t *server, const char *path)
+{
+	if (!server || server->peer_server)
+		return FALSE;
+
+	server->peer_server = ni_dbus_peer_server_listen(path, __ni_dbus_server_peer_accept, server);
+	return server->peer_server != NULL;
+}
+
+/*
+ * Stop serving the peer connections, e.g. when handing off to a new
+ * instance listening on the socket now: the calls received already
+ * are processed, any later call is answered with a PeerClosed error,
+ * which makes the client resend it via the bus.
+ *
+ * The listener is kept: libdbus removes the socket path when it is
+ * disconnected, which is the socket of the new instance by now.
+ */
+void
+ni_dbus_server_stop_peers(ni_dbus_server_t *server)
+{
+	ni_dbus_server_peer_t *peer;
+
+	if (!server)
+		return;
+
+	server->peers_stopped = TRUE;
+	for (peer = server->peers; peer; peer = peer->next) {
+		if (!peer->closed && !peer->stopped &&
+		    !ni_dbus_connection_process(peer->connection, 0))
+			peer->closed = TRUE;
+		peer->stopped = TRUE;
+	}
+}
+
+/*
+ * Close the stopped peer connections, waiting up to timeout msec
+ * for the clients to close them, so no call sent meanwhile is lost.
+ */
+void
+ni_dbus_server_close_peers(ni_dbus_server_t *server, unsigned int timeout)
+{
+	ni_dbus_server_peer_t *peer;
+	struct timeval now, end, delta;
+	ni_bool_t open;
+
+	if (!server)
+		return;
+
+	ni_dbus_server_stop_peers(server);
+
+	ni_timer_get_time(&end);
+	delta.tv_sec = timeout / 1000;
+	delta.tv_usec = (timeout % 1000) * 1000;
+	timeradd(&end, &delta, &end);
+	do {
+		open = FALSE;
+		for (peer = server->peers; peer; peer = peer->next) {
+			if (peer->closed)
+				continue;
+			if (ni_dbus_connection_process(peer->connection, 10))
+				open = TRUE;
+			else
+				peer->closed = TRUE;
+		}
+		ni_timer_get_time(&now);
+	} while (open && timercmp(&now, &end, <));
+
+	__ni_dbus_server_peers_free(server, FALSE);
+}
+
+dbus_bool_t
+ni_dbus_server_allow_replacement(ni_dbus_server_t *server, const char *bus_name, ni_bool_t allow)
+{
+	if (!server)
+		return FALSE;
 
+	return ni_dbus_connection_allow_replacement(server->connection, bus_name, allow);
 }
 
 /*
@@ -46,6 +46,7 @@
 #include "appconfig.h"
 #include "util_priv.h"
 #include "buffer.h"
+#include "hashmap.h"
 #include "duid.h"
 
 #ifndef NI_MACHINE_ID_UUID_FILE
@@ -613,44 +614,81 @@ ni_duid_map_set_fallback_file(char **filename)
 			NI_CONFIG_DEFAULT_DUID_FILE) != NULL;
 }
 
-ni_duid_map_t *
-ni_duid_map_load(const char *filename)
+static ni_bool_t
+ni_duid_map_read(ni_duid_map_t *map, const char *type)
 {
-	ni_duid_map_t *map;
-	const char *type;
 	ni_buffer_t buff;
 	struct stat stb;
 	ssize_t len;
 
+	if (lseek(map->fd, 0, SEEK_SET) < 0)
+		return FALSE;
+
+	if (fstat(map->fd, &stb) < 0)
+		stb.st_size = BUFSIZ;
+
+	ni_buffer_init_dynamic(&buff, stb.st_size + 1);
+	do {
+		if (!ni_buffer_tailroom(&buff))
+			ni_buffer_ensure_tailroom(&buff, BUFSIZ);
+
+		do {
+			len = read(map->fd, ni_buffer_tail(&buff), ni_buffer_tailroom(&buff));
+			if (len > 0)
+				ni_buffer_push_tail(&buff, len);
+		} while (len < 0 && errno == EINTR);
+	} while (len > 0);
+
+	if (len < 0) {
+		ni_error("unable to read %s duid map file name (%s): %m", type, map->file);
+		ni_buffer_destroy(&buff);
+		return FALSE;
+	}
+
+	xml_document_free(map->doc);
+	map->doc = xml_document_from_buffer(&buff, map->file);
+	ni_buffer_destroy(&buff);
+	if (!map->doc) {
+		map->doc = xml_document_new();
+		ni_warn("unable to parse %s duid map file name (%s): %m", type, map->file);
+	}
+	return TRUE;
+}
+
+static ni_duid_map_t *
+ni_duid_map_open_file(const char *filename, const char **type)
+{
+	ni_duid_map_t *map;
+
 	if (!(map = ni_duid_map_new())) {
 		ni_error("unable to allocate memory for duid map: %m");
 		return NULL;
 	}
 
 	if (filename) {
-		type = "given";
+		*type = "given";
 		if (!ni_string_dup(&map->file, filename)) {
-			ni_error("unable to copy %s duid map file name (%s): %m", type, filename);
+			ni_error("unable to copy %s duid map file name (%s): %m", *type, filename);
 			goto failure;
 		}
 
 		if (!ni_duid_map_open(map)) {
-			ni_error("unable to open %s duid map file name (%s): %m", type, map->file);
+			ni_error("unable to open %s duid map file name (%s): %m", *type, map->file);
 			goto failure;
 		}
 	} else {
-		type = "default";
+		*type = "default";
 		if (!ni_duid_map_set_default_file(&map->file)) {
-			ni_error("unable to construct %s duid map file name: %m", type);
+			ni_error("unable to construct %s duid map file name: %m", *type);
 			goto failure;
 		}
 
 		if (!ni_duid_map_open(map)) {
 			ni_debug_readwrite("unable to open duid map file name (%s): %m", map->file);
 
-			type = "fallback";
+			*type = "fallback";
 			if (!ni_duid_map_set_fallback_file(&map->file)) {
-				ni_error("unable to construct %s duid map file name: %m", type);
+				ni_error("unable to construct %s duid map file name: %m", *type);
 				goto failure;
 			}
 
@@ -660,38 +698,29 @@ ni_duid_map_load(const char *filename)
 			}
 		}
 	}
+	return map;
+
+failure:
+	ni_duid_map_free(map);
+	return NULL;
+}
+
+ni_duid_map_t *
+ni_duid_map_load(const char *filename)
+{
+	ni_duid_map_t *map;
+	const char *type;
+
+	if (!(map = ni_duid_map_open_file(filename, &type)))
+		return NULL;
 
 	if (!ni_duid_map_lock(map)) {
 		ni_error("unable to lock %s duid map file name (%s): %m", type, map->file);
 		goto failure;
 	}
 
-	if (fstat(map->fd, &stb) < 0)
-		stb.st_size = BUFSIZ;
-
-	ni_buffer_init_dynamic(&buff, stb.st_size + 1);
-	do {
-		if (!ni_buffer_tailroom(&buff))
-			ni_buffer_ensure_tailroom(&buff, BUFSIZ);
-
-		do {
-			len = read(map->fd, ni_buffer_tail(&buff), ni_buffer_tailroom(&buff));
-			if (len > 0)
-				ni_buffer_push_tail(&buff, len);
-		} while (len < 0 && errno == EINTR);
-	} while (len > 0);
-
-	if (len < 0) {
-		ni_error("unable to read %s duid map file name (%s): %m", type, map->file);
-	} else {
-		map->doc = xml_document_from_buffer(&buff, map->file);
-		ni_buffer_destroy(&buff);
-		if (!map->doc) {
-			map->doc = xml_document_new();
-			ni_warn("unable to parse %s duid map file name (%s): %m", type, map->file);
-		}
+	if (ni_duid_map_read(map, type))
 		return map;
-	}
 
 failure:
 	ni_duid_map_free(map);
@@ -861,13 +890,140 @@ ni_duid_map_to_vars(ni_duid_map_t *map, ni_var_array_t *vars)
 	return TRUE;
 }
 
+/*
+ * Long-lived duid map of the dhcp supplicants, indexed by the scope
+ * (device) name. The file is parsed again only after another process
+ * changed it, detected by its inode, size and modification time, and
+ * is written under the same file lock the duid map users are taking.
+ */
+typedef struct ni_duid_registry {
+	ni_duid_map_t *		map;
+	const char *		type;
+	struct stat		stamp;
+	ni_hashmap_t *		names;
+} ni_duid_registry_t;
+
+static ni_duid_registry_t	ni_duid_registry;
+
+static ni_bool_t
+ni_duid_registry_stamp_equal(const struct stat *a, const struct stat *b)
+{
+	return	a->st_dev  == b->st_dev  &&
+		a->st_ino  == b->st_ino  &&
+		a->st_size == b->st_size &&
+		a->st_mtim.tv_sec  == b->st_mtim.tv_sec &&
+		a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+static void
+ni_duid_registry_index(ni_duid_registry_t *reg)
+{
+	xml_node_t *root, *node = NULL;
+
+	ni_hashmap_clear(reg->names);
+
+	if (!(root = ni_duid_map_root_node(reg->map)))
+		return;
+
+	/* the first usable node wins, as in ni_duid_map_get_duid */
+	while ((node = ni_duid_map_next_node(root, node))) {
+		if (ni_string_empty(node->cdata))
+			continue;
+
+		ni_hashmap_add(reg->names, xml_node_get_attr(node,
+				NI_CONFIG_DEFAULT_DUID_DEVICE), node);
+	}
+}
+
+static ni_duid_registry_t *
+ni_duid_registry_open(void)
+{
+	ni_duid_registry_t *reg = &ni_duid_registry;
+	struct stat stb, fstb;
+
+	/* reopen when the file has been removed or replaced */
+	if (reg->map && (stat(reg->map->file, &stb) < 0 || fstat(reg->map->fd, &fstb) < 0 ||
+			stb.st_dev != fstb.st_dev || stb.st_ino != fstb.st_ino)) {
+		ni_debug_readwrite("duid map file %s has been replaced, reopening", reg->map->file);
+		ni_duid_map_free(reg->map);
+		reg->map = NULL;
+	}
+
+	if (!reg->map) {
+		if (!(reg->map = ni_duid_map_open_file(NULL, &reg->type)))
+			return NULL;
+		memset(&reg->stamp, 0, sizeof(reg->stamp));
+	}
+	if (!reg->names)
+		reg->names = ni_hashmap_new();
+	return reg;
+}
+
+/*
+ * Refresh the map from file if needed; the caller holds the lock
+ */
+static ni_bool_t
+ni_duid_registry_sync(ni_duid_registry_t *reg)
+{
+	struct stat stb;
+
+	if (fstat(reg->map->fd, &stb) < 0)
+		return FALSE;
+
+	if (reg->map->doc && ni_duid_registry_stamp_equal(&reg->stamp, &stb))
+		return TRUE;
+
+	if (!ni_duid_map_read(reg->map, reg->type))
+		return FALSE;
+
+	reg->stamp = stb;
+	ni_duid_registry_index(reg);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_duid_registry_get_duid(ni_duid_registry_t *reg, const char *name, const char **hex, ni_opaque_t *raw)
+{
+	xml_node_t *node;
+
+	if (!(node = ni_hashmap_get(reg->names, name)))
+		return FALSE;
+
+	if (hex)
+		*hex = node->cdata;
+	if (raw && !ni_duid_parse_hex(raw, node->cdata))
+		return FALSE;
+	return TRUE;
+}
+
+static ni_bool_t
+ni_duid_registry_set(ni_duid_registry_t *reg, const char *name, const char *duid)
+{
+	if (!ni_duid_map_set(reg->map, name, duid))
+		return FALSE;
+
+	ni_duid_registry_index(reg);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_duid_registry_commit(ni_duid_registry_t *reg)
+{
+	if (!ni_duid_map_save(reg->map) || fstat(reg->map->fd, &reg->stamp) < 0) {
+		/* enforce a reload of what is in the file */
+		memset(&reg->stamp, 0, sizeof(reg->stamp));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 ni_bool_t
 ni_duid_acquire(ni_opaque_t *duid, const ni_netdev_t *dev, ni_netconfig_t *nc, const char *requested)
 {
 	const ni_config_dhcp6_t *conf;
 	const char *    scope = NULL;
 	const char *    hex = NULL;
-	ni_duid_map_t * map;
+	ni_duid_registry_t *reg;
 
 	if (!duid || !dev)
 		return FALSE;
@@ -875,9 +1031,17 @@ ni_duid_acquire(ni_opaque_t *duid, const ni_netdev_t *dev, ni_netconfig_t *nc, c
 	if (!(conf = ni_config_dhcp6_find_device(dev->name)))
 		return FALSE;
 
-	if (!(map = ni_duid_map_load(NULL)))
+	if (!(reg = ni_duid_registry_open()))
 		return FALSE;
 
+	if (!ni_duid_map_lock(reg->map)) {
+		ni_error("unable to lock %s duid map file name (%s): %m", reg->type, reg->map->file);
+		return FALSE;
+	}
+
+	if (!ni_duid_registry_sync(reg))
+		goto failure;
+
 	/*
 	 * The requested duid is always in per-device scope as it is
 	 * from a per device request to acquire a lease. Again, all
@@ -888,7 +1052,7 @@ ni_duid_acquire(ni_opaque_t *duid, const ni_netdev_t *dev, ni_netconfig_t *nc, c
 	if (requested && ni_duid_parse_hex(duid, requested)) {
 		scope = dev->name;
 
-		if (ni_duid_map_get_duid(map, scope, &hex, NULL) && ni_string_eq(hex, requested))
+		if (ni_duid_registry_get_duid(reg, scope, &hex, NULL) && ni_string_eq(hex, requested))
 			goto cleanup;
 
 		goto update;
@@ -901,12 +1065,12 @@ ni_duid_acquire(ni_opaque_t *duid, const ni_netdev_t *dev, ni_netconfig_t *nc, c
 	if (conf->device_duid)
 		scope = dev->name;
 
-	if (ni_duid_map_get_duid(map, scope, &hex, duid))
+	if (ni_duid_registry_get_duid(reg, scope, &hex, duid))
 		goto cleanup;
 
 	requested = conf->default_duid;
 	if (requested && ni_duid_parse_hex(duid, requested)) {
-		if (ni_duid_map_get_duid(map, scope, &hex, NULL) && ni_string_eq(hex, requested))
+		if (ni_duid_registry_get_duid(reg, scope, &hex, NULL) && ni_string_eq(hex, requested))
 			goto cleanup;
 
 		goto update;
@@ -919,18 +1083,17 @@ update:
 	if (!(hex = ni_duid_print_hex(duid)))
 		goto failure;
 
-	if (!ni_duid_map_set(map, scope, hex))
+	if (!ni_duid_registry_set(reg, scope, hex))
 		goto failure;
 
-	if (!ni_duid_map_save(map))
+	if (!ni_duid_registry_commit(reg))
 		goto failure;
 
 cleanup:
-	ni_duid_map_free(map);
+	ni_duid_map_unlock(reg->map);
 	return TRUE;
 
 failure:
-	ni_duid_map_free(map);
+	ni_duid_map_unlock(reg->map);
 	return FALSE;
 }
-
@@ -28,12 +28,15 @@
 #include <net/if_arp.h>
 #include <linux/ethtool.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <wicked/util.h>
 #include <wicked/ethtool.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
 #include "kernel.h"
+#include "workpool.h"
+#include "hashmap.h"
 
 /*
  * support mask to not repeat ioctl
@@ -3606,9 +3609,340 @@ ni_ethtool_set_pause(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool, const ni
 }
 
 
+/*
+ * setup categories to apply only the settings differing from
+ * the current (cached) state and to refresh what we've set.
+ */
+typedef enum {
+	NI_ETHTOOL_SETUP_PRIV_FLAGS,
+	NI_ETHTOOL_SETUP_LINK_SETTINGS,
+	NI_ETHTOOL_SETUP_WAKE_ON_LAN,
+	NI_ETHTOOL_SETUP_FEATURES,
+	NI_ETHTOOL_SETUP_EEE,
+	NI_ETHTOOL_SETUP_RING,
+	NI_ETHTOOL_SETUP_CHANNELS,
+	NI_ETHTOOL_SETUP_COALESCE,
+	NI_ETHTOOL_SETUP_PAUSE,
+} ni_ethtool_setup_t;
+
+static inline ni_bool_t
+ni_ethtool_uint_param_differs(unsigned int want, unsigned int have, unsigned int dflt)
+{
+	return want != dflt && want != have;
+}
+
+static inline ni_bool_t
+ni_ethtool_tristate_differs(ni_tristate_t want, ni_tristate_t have)
+{
+	return ni_tristate_is_set(want) && want != have;
+}
+
+static ni_bool_t
+ni_ethtool_priv_flags_differ(const ni_ethtool_priv_flags_t *have, const ni_ethtool_priv_flags_t *want)
+{
+	unsigned int i, bit;
+	const char *name;
+	ni_bool_t enabled;
+
+	if (!want || !want->names.count)
+		return FALSE;
+	if (!have || !have->names.count)
+		return TRUE;
+
+	for (i = 0; i < want->names.count; ++i) {
+		name = want->names.data[i];
+		if (ni_string_empty(name))
+			continue;
+
+		/* unknown flag: let the setter report it */
+		bit = ni_string_array_index(&have->names, name);
+		if (bit == -1U)
+			return TRUE;
+
+		enabled = !!(want->bitmap & NI_BIT(i));
+		if (enabled != !!(have->bitmap & NI_BIT(bit)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static ni_bool_t
+ni_ethtool_link_adv_modes_differ(const ni_bitfield_t *want, const ni_bitfield_t *have)
+{
+	ni_bitfield_t flg = NI_BITFIELD_INIT;
+	unsigned int bit, bits;
+	ni_bool_t differ = FALSE;
+
+	bits = max_t(unsigned int, ni_bitfield_bits(want), ni_bitfield_bits(have));
+	ni_ethtool_set_adv_flags_bitfield(&flg);
+	for (bit = 0; bit < bits && !differ; ++bit) {
+		if (ni_bitfield_testbit(&flg, bit))
+			continue;
+
+		differ = ni_bitfield_testbit(want, bit) != ni_bitfield_testbit(have, bit);
+	}
+	ni_bitfield_destroy(&flg);
+	return differ;
+}
+
+static ni_bool_t
+ni_ethtool_link_settings_differ(const ni_ethtool_link_settings_t *have, const ni_ethtool_link_settings_t *want)
+{
+	if (!want)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	if (ni_ethtool_tristate_differs(want->autoneg, have->autoneg))
+		return TRUE;
+	if (want->speed && ni_ethtool_uint_param_differs(want->speed, have->speed,
+				NI_ETHTOOL_SPEED_UNKNOWN))
+		return TRUE;
+	if (ni_ethtool_uint_param_differs(want->duplex, have->duplex,
+				NI_ETHTOOL_DUPLEX_UNKNOWN))
+		return TRUE;
+	if (ni_ethtool_uint_param_differs(want->port, have->port,
+				NI_ETHTOOL_PORT_DEFAULT))
+		return TRUE;
+	if (ni_ethtool_uint_param_differs(want->phy_address, have->phy_address,
+				NI_ETHTOOL_PHYAD_UNKNOWN))
+		return TRUE;
+	if (ni_ethtool_uint_param_differs(want->transceiver, have->transceiver,
+				NI_ETHTOOL_XCVR_UNKNOWN))
+		return TRUE;
+	if (ni_ethtool_uint_param_differs(want->tp_mdix, have->tp_mdix,
+				NI_ETHTOOL_MDI_INVALID))
+		return TRUE;
+
+	/*
+	 * advertising is (re)computed on enabled autoneg only:
+	 * either custom modes or all supported when not set.
+	 */
+	if (ni_tristate_is_enabled(want->autoneg) ||
+	    (!ni_tristate_is_set(want->autoneg) && ni_tristate_is_enabled(have->autoneg))) {
+		if (ni_bitfield_isset(&want->advertising))
+			return ni_ethtool_link_adv_modes_differ(&want->advertising,
+								&have->advertising);
+		if (!want->speed || want->speed == NI_ETHTOOL_SPEED_UNKNOWN)
+			return ni_ethtool_link_adv_modes_differ(&have->supported,
+								&have->advertising);
+	}
+	return FALSE;
+}
+
+static ni_bool_t
+ni_ethtool_wake_on_lan_differs(const ni_ethtool_wake_on_lan_t *have, const ni_ethtool_wake_on_lan_t *want)
+{
+	if (!want || want->options == NI_ETHTOOL_WOL_DEFAULT)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	if (want->options == NI_ETHTOOL_WOL_DISABLE)
+		return have->options != 0;
+
+	/* unsupported modes: let the setter report them */
+	if (want->options & ~have->support)
+		return TRUE;
+	if (want->options != have->options)
+		return TRUE;
+
+	if ((want->options & NI_BIT(NI_ETHTOOL_WOL_SECUREON)) && want->sopass.len)
+		return !ni_link_address_equal(&want->sopass, &have->sopass);
+
+	return FALSE;
+}
+
+static ni_bool_t
+ni_ethtool_features_differ(ni_ethtool_features_t *have, const ni_ethtool_features_t *want)
+{
+	const ni_ethtool_feature_t *wf, *hf;
+	unsigned int i;
+
+	if (!want || !want->count)
+		return FALSE;
+	if (!have || !have->count)
+		return TRUE;
+
+	for (i = 0; i < want->count; ++i) {
+		if (!(wf = want->data[i]))
+			continue;
+
+		/* unknown or legacy offload names: let the setter decide */
+		if (!(hf = ni_ethtool_features_get(have, wf->map.name)))
+			return TRUE;
+
+		if ((wf->value & NI_ETHTOOL_FEATURE_ON) != (hf->value & NI_ETHTOOL_FEATURE_ON))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static ni_bool_t
+ni_ethtool_eee_differs(const ni_ethtool_eee_t *have, const ni_ethtool_eee_t *want)
+{
+	if (!want)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	if (ni_ethtool_tristate_differs(want->status.enabled, have->status.enabled))
+		return TRUE;
+	if (ni_ethtool_tristate_differs(want->tx_lpi.enabled, have->tx_lpi.enabled))
+		return TRUE;
+	if (ni_ethtool_uint_param_differs(want->tx_lpi.timer, have->tx_lpi.timer,
+				NI_ETHTOOL_EEE_DEFAULT))
+		return TRUE;
+	if (ni_bitfield_isset(&want->speed.advertising) &&
+	    ni_bitfield_bytes(&want->speed.advertising) >= sizeof(unsigned int)) {
+		unsigned int wadv = 0, hadv = 0;
+
+		memcpy(&wadv, ni_bitfield_get_data(&want->speed.advertising), sizeof(wadv));
+		if (ni_bitfield_bytes(&have->speed.advertising) >= sizeof(hadv))
+			memcpy(&hadv, ni_bitfield_get_data(&have->speed.advertising), sizeof(hadv));
+		if (wadv != hadv)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static ni_bool_t
+ni_ethtool_ring_differs(const ni_ethtool_ring_t *have, const ni_ethtool_ring_t *want)
+{
+	if (!want)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	return	ni_ethtool_uint_param_differs(want->tx, have->tx, NI_ETHTOOL_RING_DEFAULT) ||
+		ni_ethtool_uint_param_differs(want->rx, have->rx, NI_ETHTOOL_RING_DEFAULT) ||
+		ni_ethtool_uint_param_differs(want->rx_jumbo, have->rx_jumbo, NI_ETHTOOL_RING_DEFAULT) ||
+		ni_ethtool_uint_param_differs(want->rx_mini, have->rx_mini, NI_ETHTOOL_RING_DEFAULT);
+}
+
+static ni_bool_t
+ni_ethtool_channels_differ(const ni_ethtool_channels_t *have, const ni_ethtool_channels_t *want)
+{
+	if (!want)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	return	ni_ethtool_uint_param_differs(want->tx, have->tx, NI_ETHTOOL_CHANNELS_DEFAULT) ||
+		ni_ethtool_uint_param_differs(want->rx, have->rx, NI_ETHTOOL_CHANNELS_DEFAULT) ||
+		ni_ethtool_uint_param_differs(want->other, have->other, NI_ETHTOOL_CHANNELS_DEFAULT) ||
+		ni_ethtool_uint_param_differs(want->combined, have->combined, NI_ETHTOOL_CHANNELS_DEFAULT);
+}
+
+static ni_bool_t
+ni_ethtool_coalesce_differs(const ni_ethtool_coalesce_t *have, const ni_ethtool_coalesce_t *want)
+{
+	const unsigned int dflt = NI_ETHTOOL_COALESCE_DEFAULT;
+
+	if (!want)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	return	ni_ethtool_tristate_differs(want->adaptive_tx, have->adaptive_tx) ||
+		ni_ethtool_tristate_differs(want->adaptive_rx, have->adaptive_rx) ||
+
+		ni_ethtool_uint_param_differs(want->pkt_rate_low,      have->pkt_rate_low,      dflt) ||
+		ni_ethtool_uint_param_differs(want->pkt_rate_high,     have->pkt_rate_high,     dflt) ||
+
+		ni_ethtool_uint_param_differs(want->sample_interval,   have->sample_interval,   dflt) ||
+		ni_ethtool_uint_param_differs(want->stats_block_usecs, have->stats_block_usecs, dflt) ||
+
+		ni_ethtool_uint_param_differs(want->tx_usecs,          have->tx_usecs,          dflt) ||
+		ni_ethtool_uint_param_differs(want->tx_usecs_irq,      have->tx_usecs_irq,      dflt) ||
+		ni_ethtool_uint_param_differs(want->tx_usecs_low,      have->tx_usecs_low,      dflt) ||
+		ni_ethtool_uint_param_differs(want->tx_usecs_high,     have->tx_usecs_high,     dflt) ||
+
+		ni_ethtool_uint_param_differs(want->tx_frames,         have->tx_frames,         dflt) ||
+		ni_ethtool_uint_param_differs(want->tx_frames_irq,     have->tx_frames_irq,     dflt) ||
+		ni_ethtool_uint_param_differs(want->tx_frames_low,     have->tx_frames_low,     dflt) ||
+		ni_ethtool_uint_param_differs(want->tx_frames_high,    have->tx_frames_high,    dflt) ||
+
+		ni_ethtool_uint_param_differs(want->rx_usecs,          have->rx_usecs,          dflt) ||
+		ni_ethtool_uint_param_differs(want->rx_usecs_irq,      have->rx_usecs_irq,      dflt) ||
+		ni_ethtool_uint_param_differs(want->rx_usecs_low,      have->rx_usecs_low,      dflt) ||
+		ni_ethtool_uint_param_differs(want->rx_usecs_high,     have->rx_usecs_high,     dflt) ||
+
+		ni_ethtool_uint_param_differs(want->rx_frames,         have->rx_frames,         dflt) ||
+		ni_ethtool_uint_param_differs(want->rx_frames_irq,     have->rx_frames_irq,     dflt) ||
+		ni_ethtool_uint_param_differs(want->rx_frames_low,     have->rx_frames_low,     dflt) ||
+		ni_ethtool_uint_param_differs(want->rx_frames_high,    have->rx_frames_high,    dflt);
+}
+
+static ni_bool_t
+ni_ethtool_pause_differs(const ni_ethtool_pause_t *have, const ni_ethtool_pause_t *want)
+{
+	if (!want)
+		return FALSE;
+	if (!have)
+		return TRUE;
+
+	return	ni_ethtool_tristate_differs(want->tx, have->tx) ||
+		ni_ethtool_tristate_differs(want->rx, have->rx) ||
+		ni_ethtool_tristate_differs(want->autoneg, have->autoneg);
+}
+
+static unsigned int
+ni_ethtool_setup_changes(ni_ethtool_t *have, const ni_ethtool_t *want)
+{
+	unsigned int changes = 0;
+
+	if (ni_ethtool_priv_flags_differ(have->priv_flags, want->priv_flags))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_PRIV_FLAGS);
+	if (ni_ethtool_link_settings_differ(have->link_settings, want->link_settings))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_LINK_SETTINGS);
+	if (ni_ethtool_wake_on_lan_differs(have->wake_on_lan, want->wake_on_lan))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_WAKE_ON_LAN);
+	if (ni_ethtool_features_differ(have->features, want->features))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_FEATURES);
+	if (ni_ethtool_eee_differs(have->eee, want->eee))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_EEE);
+	if (ni_ethtool_ring_differs(have->ring, want->ring))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_RING);
+	if (ni_ethtool_channels_differ(have->channels, want->channels))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_CHANNELS);
+	if (ni_ethtool_coalesce_differs(have->coalesce, want->coalesce))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_COALESCE);
+	if (ni_ethtool_pause_differs(have->pause, want->pause))
+		changes |= NI_BIT(NI_ETHTOOL_SETUP_PAUSE);
+
+	return changes;
+}
+
+
 /*
  * main system refresh and setup functions
  */
+static void
+ni_ethtool_refresh_changes(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool, unsigned int changes)
+{
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_PRIV_FLAGS))
+		ni_ethtool_get_priv_flags(ref, ethtool);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_LINK_SETTINGS)) {
+		ni_ethtool_get_link_detected(ref, ethtool);
+		ni_ethtool_get_link_settings(ref, ethtool);
+	}
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_WAKE_ON_LAN))
+		ni_ethtool_get_wake_on_lan(ref, ethtool);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_FEATURES))
+		ni_ethtool_get_features(ref, ethtool, FALSE);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_EEE))
+		ni_ethtool_get_eee(ref, ethtool);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_RING))
+		ni_ethtool_get_ring(ref, ethtool);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_CHANNELS))
+		ni_ethtool_get_channels(ref, ethtool);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_COALESCE))
+		ni_ethtool_get_coalesce(ref, ethtool);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_PAUSE))
+		ni_ethtool_get_pause(ref, ethtool);
+}
+
 static ni_bool_t
 ni_ethtool_refresh(ni_netdev_t *dev)
 {
@@ -3622,33 +3956,152 @@ ni_ethtool_refresh(ni_netdev_t *dev)
 	ref.index = dev->link.ifindex;
 	if (!ethtool->driver_info)
 		ni_ethtool_get_driver_info(&ref, ethtool);
-	ni_ethtool_get_priv_flags(&ref, ethtool);
-	ni_ethtool_get_link_detected(&ref, ethtool);
-	ni_ethtool_get_link_settings(&ref, ethtool);
-	ni_ethtool_get_wake_on_lan(&ref, ethtool);
-	ni_ethtool_get_features(&ref, ethtool, FALSE);
-	ni_ethtool_get_eee(&ref, ethtool);
-	ni_ethtool_get_ring(&ref, ethtool);
-	ni_ethtool_get_channels(&ref, ethtool);
-	ni_ethtool_get_coalesce(&ref, ethtool);
-	ni_ethtool_get_pause(&ref, ethtool);
+	ni_ethtool_refresh_changes(&ref, ethtool, -1U);
 
 	return TRUE;
 }
 
+/*
+ * Link events arrive often and the ethtool queries may block in the
+ * driver, e.g. while it reads the PHY. Once a device of the host has
+ * been refreshed, further refreshes run in a worker thread and their
+ * result replaces the device ethtool state in the main thread.
+ * While refreshes of a device are pending, it has an entry in the
+ * pending map; a result queried before an ethtool setup of the same
+ * device is dropped.
+ */
+typedef struct ni_ethtool_refresh_pending {
+	unsigned int		count;
+	unsigned int		setup_seq;
+} ni_ethtool_refresh_pending_t;
+
+typedef struct ni_ethtool_refresh_work {
+	ni_netdev_ref_t		ref;
+	int			iocfd;
+	unsigned int		setup_seq;
+	ni_ethtool_t *		ethtool;
+} ni_ethtool_refresh_work_t;
+
+static ni_hashmap_t *		ni_ethtool_refresh_pending_map;
+
+static const char *
+ni_ethtool_refresh_key(char *key, size_t size, unsigned int ifindex)
+{
+	snprintf(key, size, "ethtool:%u", ifindex);
+	return key;
+}
+
+static ni_ethtool_refresh_pending_t *
+ni_ethtool_refresh_pending(unsigned int ifindex)
+{
+	char key[64];
+
+	return ni_hashmap_get(ni_ethtool_refresh_pending_map,
+			ni_ethtool_refresh_key(key, sizeof(key), ifindex));
+}
+
+static void
+ni_ethtool_refresh_work_free(ni_ethtool_refresh_work_t *work)
+{
+	if (work->iocfd >= 0)
+		close(work->iocfd);
+	ni_ethtool_free(work->ethtool);
+	ni_netdev_ref_destroy(&work->ref);
+	free(work);
+}
+
+/* worker thread: uses only the work data and its own ioctl socket */
+static int
+ni_ethtool_refresh_work(void *user_data)
+{
+	ni_ethtool_refresh_work_t *work = user_data;
+
+	__ni_ioctl_socket_bind(work->iocfd);
+	ni_ethtool_refresh_changes(&work->ref, work->ethtool, -1U);
+	__ni_ioctl_socket_bind(-1);
+	return 0;
+}
+
+static void
+ni_ethtool_refresh_done(void *user_data, int result)
+{
+	ni_ethtool_refresh_work_t *work = user_data;
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+	ni_ethtool_refresh_pending_t *pending;
+	ni_bool_t current = FALSE;
+	ni_netdev_t *dev;
+	char key[64];
+
+	ni_ethtool_refresh_key(key, sizeof(key), work->ref.index);
+	if ((pending = ni_hashmap_get(ni_ethtool_refresh_pending_map, key))) {
+		current = work->setup_seq == pending->setup_seq;
+		if (--pending->count == 0)
+			free(ni_hashmap_remove(ni_ethtool_refresh_pending_map, key));
+	}
+
+	dev = ni_netdev_by_index(nc, work->ref.index);
+	if (current && dev && dev->ethtool && ni_string_eq(dev->name, work->ref.name)) {
+		work->ethtool->driver_info = dev->ethtool->driver_info;
+		dev->ethtool->driver_info = NULL;
+		ni_netdev_set_ethtool(dev, work->ethtool);
+		work->ethtool = NULL;
+	}
+	ni_ethtool_refresh_work_free(work);
+}
+
+static ni_bool_t
+ni_ethtool_refresh_async(ni_netdev_t *dev)
+{
+	ni_ethtool_refresh_pending_t *pending;
+	ni_ethtool_refresh_work_t *work;
+	ni_workpool_t *pool;
+	char key[64];
+
+	if (!(pool = ni_workpool_global()) || !dev->ethtool ||
+	    ni_netdev_by_index(ni_global_state_handle(0), dev->link.ifindex) != dev)
+		return FALSE;
+
+	work = xcalloc(1, sizeof(*work));
+	ni_netdev_ref_init(&work->ref, dev->name, dev->link.ifindex);
+	if ((work->iocfd = __ni_ioctl_socket_dup()) < 0 ||
+	    !(work->ethtool = ni_ethtool_new()) ||
+	    !ni_bitfield_set_data(&work->ethtool->supported,
+				ni_bitfield_get_data(&dev->ethtool->supported),
+				ni_bitfield_bytes(&dev->ethtool->supported))) {
+		ni_ethtool_refresh_work_free(work);
+		return FALSE;
+	}
+
+	ni_ethtool_refresh_key(key, sizeof(key), dev->link.ifindex);
+	if (!ni_ethtool_refresh_pending_map)
+		ni_ethtool_refresh_pending_map = ni_hashmap_new();
+	if (!(pending = ni_hashmap_get(ni_ethtool_refresh_pending_map, key))) {
+		pending = xcalloc(1, sizeof(*pending));
+		ni_hashmap_set(ni_ethtool_refresh_pending_map, key, pending);
+	}
+	work->setup_seq = pending->setup_seq;
+	pending->count++;
+
+	return ni_workpool_submit(pool, key, ni_ethtool_refresh_work,
+				ni_ethtool_refresh_done, work);
+}
+
 void
 ni_system_ethtool_refresh(ni_netdev_t *dev)
 {
 	if (!ni_netdev_device_is_ready(dev) || !dev->link.ifindex)
 		return;
 
-	ni_ethtool_refresh(dev);
+	if (!ni_ethtool_refresh_async(dev))
+		ni_ethtool_refresh(dev);
 }
 
 int
 ni_system_ethtool_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_netdev_t *cfg)
 {
+	ni_ethtool_refresh_pending_t *pending;
 	ni_netdev_ref_t ref;
+	unsigned int changes;
 
 	if (!ni_netdev_device_is_ready(dev) || !dev->link.ifindex)
 		return -1;
@@ -3656,20 +4109,53 @@ ni_system_ethtool_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_netdev_t
 	if (!dev->ethtool && !ni_ethtool_refresh(dev))
 		return -1;
 
+	/*
+	 * With a refresh pending, the device ethtool state is older than
+	 * the last link event: query it here and drop the pending results.
+	 */
+	if ((pending = ni_ethtool_refresh_pending(dev->link.ifindex))) {
+		pending->setup_seq++;
+		if (!ni_ethtool_refresh(dev))
+			return -1;
+	}
+
+	if (!cfg || !cfg->ethtool)
+		return 0;
+
+	/*
+	 * The device ethtool state is refreshed on every link event,
+	 * so we apply only the categories differing from it and
+	 * query back only what we've set.
+	 */
+	changes = ni_ethtool_setup_changes(dev->ethtool, cfg->ethtool);
+	if (!changes) {
+		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_IFCONFIG,
+				"%s: ethtool settings are up to date", dev->name);
+		return 0;
+	}
+
 	ref.name = dev->name;
 	ref.index = dev->link.ifindex;
-	if (cfg && cfg->ethtool) {
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_PRIV_FLAGS))
 		ni_ethtool_set_priv_flags(&ref, dev->ethtool, cfg->ethtool->priv_flags);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_LINK_SETTINGS))
 		ni_ethtool_set_link_settings(&ref, dev->ethtool, cfg->ethtool->link_settings);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_WAKE_ON_LAN))
 		ni_ethtool_set_wake_on_lan(&ref, dev->ethtool, cfg->ethtool->wake_on_lan);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_FEATURES))
 		ni_ethtool_set_features(&ref, dev->ethtool, cfg->ethtool->features);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_EEE))
 		ni_ethtool_set_eee(&ref, dev->ethtool, cfg->ethtool->eee);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_RING))
 		ni_ethtool_set_ring(&ref, dev->ethtool, cfg->ethtool->ring);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_CHANNELS))
 		ni_ethtool_set_channels(&ref, dev->ethtool, cfg->ethtool->channels);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_COALESCE))
 		ni_ethtool_set_coalesce(&ref, dev->ethtool, cfg->ethtool->coalesce);
+	if (changes & NI_BIT(NI_ETHTOOL_SETUP_PAUSE))
 		ni_ethtool_set_pause(&ref, dev->ethtool, cfg->ethtool->pause);
-		ni_ethtool_refresh(dev);
-	}
+
+	ni_ethtool_refresh_changes(&ref, dev->ethtool, changes);
 	return 0;
 }
 
@@ -108,6 +108,7 @@ struct ni_fsm_policy {
 	char *				name;
 	xml_node_t *			node;
 	unsigned int			weight;
+	ni_ifworker_priority_t		priority;
 
 	ni_ifcondition_t *		match;
 
@@ -239,6 +240,14 @@ __ni_fsm_policy_from_xml(ni_fsm_policy_t *policy, xml_node_t *node)
 		}
 	}
 
+	if ((attr = xml_node_get_attr(node, "priority")) != NULL) {
+		if (!ni_ifworker_priority_from_name(attr, &policy->priority)) {
+			ni_error("%s: cannot parse priority=\"%s\" attribute",
+						xml_node_location(node), attr);
+			return FALSE;
+		}
+	}
+
 	for (item = node->children; item; item = item->next) {
 		ni_fsm_policy_action_t *action = NULL;
 
@@ -354,6 +363,7 @@ ni_fsm_policy_update(ni_fsm_policy_t *policy, xml_node_t *node)
 	policy->type = temp.type;
 	policy->seq = temp.seq;
 	policy->weight = temp.weight;
+	policy->priority = temp.priority;
 	policy->create_action = temp.create_action;
 	policy->actions = temp.actions;
 	policy->match = temp.match;
@@ -505,6 +515,12 @@ ni_fsm_policy_get_origin(const ni_fsm_policy_t *policy)
 	return ni_string_empty(origin) ? "nanny" : origin;
 }
 
+ni_ifworker_priority_t
+ni_fsm_policy_priority(const ni_fsm_policy_t *policy)
+{
+	return policy ? policy->priority : NI_IFWORKER_PRIORITY_NORMAL;
+}
+
 /*
  * Compare the weight of two policies.
  * Returns < 0 if a's weight is smaller than that of b, etc.
@@ -622,6 +638,9 @@ ni_fsm_exists_applicable_policy(const ni_fsm_t *fsm, ni_fsm_policy_t *list, ni_i
  *   e)	Policies are applied in order of increasing weight, ie any
  *	policy with a greater "weight" attribute potentially overwrites
  *	changes made by a policy with lower weight.
+ *
+ *   f)	A "priority" attribute of a policy sets <control><priority>
+ *	of the resulting document.
  */
 xml_node_t *
 ni_fsm_policy_transform_document(xml_node_t *node, ni_fsm_policy_t * const *policies, unsigned int count)
@@ -650,6 +669,11 @@ ni_fsm_policy_transform_document(xml_node_t *node, ni_fsm_policy_t * const *poli
 				continue;
 			}
 		}
+
+		if (node && policy->priority != NI_IFWORKER_PRIORITY_NORMAL) {
+			xml_node_dict_set(xml_node_create(node, "control"), "priority",
+					ni_ifworker_priority_name(policy->priority));
+		}
 	}
 
 	return node;
@@ -64,11 +64,12 @@ static ni_bool_t		ni_ifworker_revert_state(ni_ifworker_t *, ni_event_t);
 static ni_bool_t		ni_ifworker_del_child_master(xml_node_t *);
 static void			ni_fsm_clear_hierarchy(ni_ifworker_t *);
 
-static void			ni_ifworker_update_client_state_control(ni_ifworker_t *w);
-static inline void		ni_ifworker_update_client_state_config(ni_ifworker_t *w);
-static void			ni_ifworker_update_client_state_scripts(ni_ifworker_t *w);
+static void			ni_ifworker_update_client_state_control(ni_ifworker_t *w, ni_call_compound_t *);
+static inline void		ni_ifworker_update_client_state_config(ni_ifworker_t *w, ni_call_compound_t *);
+static void			ni_ifworker_update_client_state_scripts(ni_ifworker_t *w, ni_call_compound_t *);
 static void			ni_fsm_events_destroy(ni_fsm_event_t **);
 static void			ni_fsm_process_event(ni_fsm_t *, ni_fsm_event_t *);
+static ni_bool_t		ni_fsm_state_feed_current(const ni_ifworker_t *);
 
 
 ni_fsm_t *
@@ -89,6 +90,7 @@ ni_fsm_free(ni_fsm_t *fsm)
 	ni_fsm_events_destroy(&fsm->events);
 	ni_ifworker_array_destroy(&fsm->pending);
 	ni_ifworker_array_destroy(&fsm->workers);
+	ni_state_feed_free(fsm->state_feed);
 	free(fsm);
 }
 
@@ -788,6 +790,32 @@ ni_ifworker_state_from_name(const char *name, unsigned int *state)
 	return TRUE;
 }
 
+static ni_intmap_t __priority_names[] = {
+	{ "normal",		NI_IFWORKER_PRIORITY_NORMAL	},
+	{ "high",		NI_IFWORKER_PRIORITY_HIGH	},
+	{ "critical",		NI_IFWORKER_PRIORITY_CRITICAL	},
+
+	{ NULL }
+};
+
+const char *
+ni_ifworker_priority_name(ni_ifworker_priority_t priority)
+{
+	return ni_format_uint_mapped(priority, __priority_names);
+}
+
+ni_bool_t
+ni_ifworker_priority_from_name(const char *name, ni_ifworker_priority_t *priority)
+{
+	unsigned int value;
+
+	if (ni_parse_uint_mapped(name, __priority_names, &value) < 0)
+		return FALSE;
+	if (priority)
+		*priority = value;
+	return TRUE;
+}
+
 ni_ifworker_array_t *
 ni_ifworker_array_new(void)
 {
@@ -1581,7 +1609,7 @@ ni_ifworker_waiting_for_event(ni_ifworker_t *w, const char *event_name)
 }
 
 static void
-ni_ifworker_update_client_state_control(ni_ifworker_t *w)
+ni_ifworker_update_client_state_control(ni_ifworker_t *w, ni_call_compound_t *compound)
 {
 	ni_client_state_control_t ctrl;
 
@@ -1589,32 +1617,53 @@ ni_ifworker_update_client_state_control(ni_ifworker_t *w)
 		ctrl.persistent = w->control.persistent;
 		ctrl.usercontrol = w->control.usercontrol;
 		ctrl.require_link = w->control.link_required;
-		ni_call_set_client_state_control(w->object, &ctrl);
+		ni_call_compound_set_client_state_control(compound, &ctrl);
 		ni_client_state_control_debug(w->name, &ctrl, "update");
 	}
 }
 
 static inline void
-ni_ifworker_update_client_state_config(ni_ifworker_t *w)
+ni_ifworker_update_client_state_config(ni_ifworker_t *w, ni_call_compound_t *compound)
 {
 	if (w && w->object && !w->readonly) {
-		ni_call_set_client_state_config(w->object, &w->config.meta);
+		ni_call_compound_set_client_state_config(compound, &w->config.meta);
 		ni_client_state_config_debug(w->name, &w->config.meta, "update");
 	}
 }
 
 static void
-ni_ifworker_update_client_state_scripts(ni_ifworker_t *w)
+ni_ifworker_update_client_state_scripts(ni_ifworker_t *w, ni_call_compound_t *compound)
 {
 	ni_client_state_scripts_t scripts = { .node = NULL };
 
 	if (w && w->object && !w->readonly && w->config.node) {
 		if ((scripts.node = xml_node_get_child(w->config.node, "scripts"))) {
-			ni_call_set_client_state_scripts(w->object, &scripts);
+			ni_call_compound_set_client_state_scripts(compound, &scripts);
 		}
 	}
 }
 
+/*
+ * Reset the event filters and record the client state of a ready
+ * device in a single compound call.
+ */
+static void
+ni_ifworker_update_client_state(ni_ifworker_t *w)
+{
+	ni_call_compound_t *compound;
+
+	if (!(compound = ni_call_compound_new(w->object)))
+		return;
+
+	ni_call_compound_clear_event_filters(compound);
+	ni_ifworker_update_client_state_control(w, compound);
+	ni_ifworker_update_client_state_scripts(w, compound);
+	ni_ifworker_update_client_state_config(w, compound);
+
+	ni_call_compound_execute(compound);
+	ni_call_compound_free(compound);
+}
+
 static inline ni_bool_t
 ni_ifworker_empty_config(ni_ifworker_t *w)
 {
@@ -1644,10 +1693,7 @@ ni_ifworker_set_state(ni_ifworker_t *w, unsigned int new_state)
 			w->fsm.wait_for = NULL;
 
 		if ((new_state == NI_FSM_STATE_DEVICE_READY) && w->object && !w->readonly) {
-			ni_call_clear_event_filters(w->object);
-			ni_ifworker_update_client_state_control(w);
-			ni_ifworker_update_client_state_scripts(w);
-			ni_ifworker_update_client_state_config(w);
+			ni_ifworker_update_client_state(w);
 		}
 
 		if (w->target_state == new_state)
@@ -1848,6 +1894,7 @@ ni_ifworker_control_init(ni_ifworker_control_t *control)
 	control->link_required = NI_TRISTATE_DEFAULT;
 	control->link_priority = 0;
 	control->link_timeout  = NI_IFWORKER_INFINITE_TIMEOUT;
+	control->priority      = NI_IFWORKER_PRIORITY_NORMAL;
 }
 
 static void
@@ -1880,6 +1927,7 @@ ni_ifworker_control_clone(const ni_ifworker_control_t *control)
 	_control->link_required = control->link_required;
 	_control->link_priority = control->link_priority;
 	_control->link_timeout  = control->link_timeout;
+	_control->priority      = control->priority;
 	return _control;
 }
 
@@ -2001,6 +2049,13 @@ ni_ifworker_control_from_xml(ni_ifworker_t *w, xml_node_t *ctrlnode)
 		ni_ifworker_control_set_usercontrol(w, val);
 	}
 
+	control->priority = NI_IFWORKER_PRIORITY_NORMAL;
+	if ((np = xml_node_get_child(ctrlnode, "priority")) &&
+	    !ni_ifworker_priority_from_name(np->cdata, &control->priority)) {
+		ni_warn("%s: ignoring unknown priority class \"%s\"",
+				w->name, np->cdata);
+	}
+
 	control->link_priority = 0;
 	control->link_required = NI_TRISTATE_DEFAULT;
 	control->link_timeout  = NI_IFWORKER_INFINITE_TIMEOUT;
@@ -3239,6 +3294,175 @@ ni_fsm_start_matching_workers(ni_fsm_t *fsm, ni_ifworker_array_t *marked)
 	return count;
 }
 
+/*
+ * Fast path for taking down many virtual devices: each worker still runs
+ * its down transitions (pre-down scripts, lease drop, lldp, firewall,
+ * shutdown), but instead of one deleteDevice call per worker, all workers
+ * waiting for it are deleted in one InterfaceList.deleteDevices call.
+ *
+ * Devices have to be deleted before the devices they are based on, so a
+ * device is planned only when all devices using it are planned already.
+ * Workers not deleted by the batch fall back to their own deleteDevice.
+ */
+static ni_bool_t
+ni_fsm_teardown_candidate(const ni_ifworker_t *w)
+{
+	const ni_netdev_t *dev = w->device;
+
+	if (w->type != NI_IFWORKER_TYPE_NETDEV || !dev || !w->ifindex)
+		return FALSE;
+	if (w->failed || w->done || w->dead || w->pending || w->readonly)
+		return FALSE;
+	if (w->target_state != NI_FSM_STATE_DEVICE_DOWN || w->control.persistent)
+		return FALSE;
+	if (!ni_ifworker_can_delete(w))
+		return FALSE;
+
+	switch (dev->link.type) {
+	case NI_IFTYPE_DUMMY:
+	case NI_IFTYPE_VLAN:
+	case NI_IFTYPE_MACVLAN:
+	case NI_IFTYPE_MACVTAP:
+	case NI_IFTYPE_VXLAN:
+	case NI_IFTYPE_TUN:
+	case NI_IFTYPE_TAP:
+	case NI_IFTYPE_BRIDGE:
+	case NI_IFTYPE_SIT:
+	case NI_IFTYPE_GRE:
+	case NI_IFTYPE_IPIP:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static ni_bool_t
+ni_fsm_teardown_users_planned(const ni_fsm_t *fsm, const ni_ifworker_t *w,
+				const ni_ifworker_array_t *plan)
+{
+	unsigned int i;
+
+	for (i = 0; i < fsm->workers.count; ++i) {
+		const ni_ifworker_t *user = fsm->workers.data[i];
+
+		if (user == w || !ni_ifworker_is_device_created(user) ||
+		    user->fsm.state <= NI_FSM_STATE_DEVICE_DOWN)
+			continue;
+
+		if (user->lowerdev != w && w->masterdev != user &&
+		    ni_ifworker_array_index(&user->children, w) < 0)
+			continue;
+
+		if (ni_ifworker_array_index(plan, user) < 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * A worker in the batch, which ran all its down transitions up to the
+ * deleteDevice call.
+ */
+static ni_bool_t
+ni_fsm_teardown_waiting(const ni_ifworker_t *w)
+{
+	const ni_fsm_transition_t *action = w->fsm.next_action;
+
+	if (!w->teardown || w->fsm.wait_for || ni_ifworker_complete(w))
+		return FALSE;
+
+	return action && action->next_state == NI_FSM_STATE_DEVICE_DOWN &&
+		w->fsm.state == NI_FSM_STATE_DEVICE_EXISTS;
+}
+
+unsigned int
+ni_fsm_teardown_fast(ni_fsm_t *fsm)
+{
+	unsigned int i, count = 0;
+	ni_ifworker_t *w;
+
+	if (!fsm)
+		return 0;
+
+	for (i = 0; i < fsm->workers.count; ++i) {
+		w = fsm->workers.data[i];
+		if (ni_fsm_teardown_candidate(w)) {
+			w->teardown = TRUE;
+			count++;
+		}
+	}
+	return count;
+}
+
+/*
+ * Delete the devices of the workers waiting for the batch; called when
+ * no worker can make progress otherwise. Returns TRUE when any of the
+ * waiting workers moved on, either deleted or to its own deleteDevice.
+ */
+static ni_bool_t
+ni_fsm_teardown_batch(ni_fsm_t *fsm)
+{
+	ni_ifworker_array_t waiting = NI_IFWORKER_ARRAY_INIT;
+	ni_ifworker_array_t plan = NI_IFWORKER_ARRAY_INIT;
+	ni_uint_array_t ifindexes = NI_UINT_ARRAY_INIT;
+	ni_uint_array_t deleted = NI_UINT_ARRAY_INIT;
+	ni_bool_t progress, batched = FALSE;
+	unsigned int i;
+	ni_ifworker_t *w;
+
+	for (i = 0; i < fsm->workers.count; ++i) {
+		w = fsm->workers.data[i];
+		if (ni_fsm_teardown_waiting(w))
+			ni_ifworker_array_append(&waiting, w);
+	}
+	if (!waiting.count)
+		return FALSE;
+
+	do {
+		progress = FALSE;
+		for (i = 0; i < waiting.count; ++i) {
+			w = waiting.data[i];
+			if (ni_ifworker_array_index(&plan, w) >= 0)
+				continue;
+			if (!ni_fsm_teardown_users_planned(fsm, w, &plan))
+				continue;
+
+			ni_ifworker_array_append(&plan, w);
+			ni_uint_array_append(&ifindexes, w->ifindex);
+			progress = TRUE;
+		}
+	} while (progress);
+
+	if (plan.count) {
+		ni_debug_application("deleting %u of %u waiting devices in one batch",
+				plan.count, waiting.count);
+
+		batched = ni_call_delete_devices(&ifindexes, &deleted) == 0 && deleted.count;
+		for (i = 0; i < deleted.count; ++i) {
+			if (!(w = ni_fsm_ifworker_by_ifindex(fsm, deleted.data[i])))
+				continue;
+
+			ni_debug_application("%s: device deleted", w->name);
+			w->teardown = FALSE;
+			ni_ifworker_set_state(w, NI_FSM_STATE_DEVICE_DOWN);
+		}
+	}
+
+	/* the others call deleteDevice themselves; unless a batch went
+	 * through, after which devices used by the deleted ones may follow */
+	for (i = 0; i < waiting.count; ++i) {
+		w = waiting.data[i];
+		if (w->teardown && (!batched || ni_ifworker_array_index(&plan, w) >= 0))
+			w->teardown = FALSE;
+	}
+
+	ni_uint_array_destroy(&deleted);
+	ni_uint_array_destroy(&ifindexes);
+	ni_ifworker_array_destroy(&plan);
+	ni_ifworker_array_destroy(&waiting);
+	return TRUE;
+}
+
 void
 ni_fsm_reset_matching_workers(ni_fsm_t *fsm, ni_ifworker_array_t *marked,
 			const ni_uint_range_t *target_range, ni_bool_t hard)
@@ -3925,6 +4149,7 @@ ni_fsm_refresh_state(ni_fsm_t *fsm)
 		/* Always clear the object - we don't know if it's still there
 		 * after we've called ni_dbus_object_refresh_children() */
 		w->object = NULL;
+		w->feed_synced = FALSE;
 		if (w->device) {
 			ni_netdev_put(w->device);
 			w->device = NULL;
@@ -3995,6 +4220,16 @@ ni_fsm_recv_new_netif(ni_fsm_t *fsm, ni_dbus_object_t *object, ni_bool_t refresh
 		return NULL;
 	}
 
+	/* too long to be sent as properties, fetch them page by page */
+	if (dev->addrs_paged &&
+	    ni_call_device_get_addresses(object, AF_UNSPEC, &dev->addrs) < 0)
+		ni_warn("%s: unable to retrieve the address list, keeping the previous one",
+				dev->name);
+	if (dev->routes_paged &&
+	    ni_call_device_get_routes(object, AF_UNSPEC, &dev->routes) < 0)
+		ni_warn("%s: unable to retrieve the route list, keeping the previous one",
+				dev->name);
+
 	if (ni_netdev_device_is_ready(dev)) {
 		/*
 		 * if tracked as pending worker, it's over now -- device is ready
@@ -4066,6 +4301,7 @@ ni_fsm_recv_new_netif(ni_fsm_t *fsm, ni_dbus_object_t *object, ni_bool_t refresh
 
 	found->ifindex = dev->link.ifindex;
 	found->object = object;
+	found->feed_synced = fsm->state_feed != NULL;
 
 	return found;
 }
@@ -5119,109 +5355,199 @@ ni_fsm_schedule_bind_methods(ni_fsm_t *fsm, ni_ifworker_t *w)
 	return 0;
 }
 
-unsigned int
-ni_fsm_schedule(ni_fsm_t *fsm)
+/*
+ * Raise the priority of a worker and of the devices it is built upon,
+ * so a priority device does not wait for a lower, port or master
+ * device in a lower class.
+ */
+static void
+ni_ifworker_raise_priority(ni_ifworker_t *w, ni_ifworker_priority_t priority)
 {
-	unsigned int i, waiting, nrequested;
+	unsigned int i;
 
-	while (1) {
-		int made_progress = 0;
+	if (!w || w->priority >= priority)
+		return;
 
-		for (i = 0; i < fsm->workers.count; ++i) {
-			ni_ifworker_t *w = fsm->workers.data[i];
-			ni_fsm_transition_t *action;
-			unsigned int prev_state;
-			int rv;
+	w->priority = priority;
+	ni_ifworker_raise_priority(w->lowerdev, priority);
+	ni_ifworker_raise_priority(w->masterdev, priority);
+	for (i = 0; i < w->children.count; ++i)
+		ni_ifworker_raise_priority(w->children.data[i], priority);
+}
 
-			ni_ifworker_get(w);
+static void
+ni_fsm_update_priorities(ni_fsm_t *fsm)
+{
+	unsigned int i;
 
-			if (w->pending)
-				goto release;
+	for (i = 0; i < fsm->workers.count; ++i)
+		fsm->workers.data[i]->priority = NI_IFWORKER_PRIORITY_NORMAL;
 
-			if (ni_ifworker_complete(w)) {
-				ni_ifworker_cancel_secondary_timeout(w);
-				ni_ifworker_cancel_timeout(w);
-				goto release;
-			}
+	for (i = 0; i < fsm->workers.count; ++i) {
+		ni_ifworker_t *w = fsm->workers.data[i];
 
-			if (!w->kickstarted)
-				w->kickstarted = TRUE;
-
-			/* We requested a change that takes time (such as acquiring
-			 * a DHCP lease). Wait for a notification from wickedd */
-			if (w->fsm.wait_for) {
-				ni_debug_application("%s: state=%s want=%s, wait-for=%s", w->name,
-					ni_ifworker_state_name(w->fsm.state),
-					ni_ifworker_state_name(w->target_state),
-					ni_ifworker_state_name(w->fsm.wait_for->next_state));
-				goto release;
-			}
+		ni_ifworker_raise_priority(w, w->control.priority);
+	}
+}
 
-			action = w->fsm.next_action;
-			if (action->next_state == NI_FSM_STATE_NONE)
-				w->fsm.state = w->target_state;
+/*
+ * Run the next transition of a worker, if it is ready for one.
+ * Returns TRUE if the worker made progress.
+ */
+static ni_bool_t
+ni_fsm_schedule_worker(ni_fsm_t *fsm, ni_ifworker_t *w)
+{
+	ni_fsm_transition_t *action;
+	unsigned int prev_state;
+	ni_bool_t made_progress = FALSE;
+	int rv;
 
-			if (w->fsm.state == w->target_state) {
-				ni_ifworker_success(w);
-				made_progress = 1;
-				goto release;
-			}
+	ni_ifworker_get(w);
 
-			ni_debug_application("%s: state=%s want=%s, next transition is %s -> %s", w->name,
-				ni_ifworker_state_name(w->fsm.state),
-				ni_ifworker_state_name(w->target_state),
-				ni_ifworker_state_name(w->fsm.next_action->from_state),
-				ni_ifworker_state_name(w->fsm.next_action->next_state));
-
-			if (!action->bound) {
-				ni_ifworker_fail(w, "failed to bind services and methods for %s()",
-						action->common.method_name);
-				goto release;
-			}
+	if (w->pending)
+		goto release;
 
-			if (!ni_ifworker_check_dependencies(fsm, w, action)) {
-				ni_debug_application("%s: defer action (pending dependencies)", w->name);
-				goto release;
-			}
+	if (ni_ifworker_complete(w)) {
+		ni_ifworker_cancel_secondary_timeout(w);
+		ni_ifworker_cancel_timeout(w);
+		goto release;
+	}
 
-			ni_ifworker_cancel_secondary_timeout(w);
+	if (!w->kickstarted)
+		w->kickstarted = TRUE;
 
-			prev_state = w->fsm.state;
-			ni_fsm_events_block(fsm);
+	/* We requested a change that takes time (such as acquiring
+	 * a DHCP lease). Wait for a notification from wickedd */
+	if (w->fsm.wait_for) {
+		ni_debug_application("%s: state=%s want=%s, wait-for=%s", w->name,
+			ni_ifworker_state_name(w->fsm.state),
+			ni_ifworker_state_name(w->target_state),
+			ni_ifworker_state_name(w->fsm.wait_for->next_state));
+		goto release;
+	}
 
-			rv = action->call_func(fsm, w, action);
-			if (w->fsm.next_action)
-				w->fsm.next_action++;
+	action = w->fsm.next_action;
+	if (action->next_state == NI_FSM_STATE_NONE)
+		w->fsm.state = w->target_state;
 
-			if (rv >= 0) {
-				made_progress = 1;
+	if (w->fsm.state == w->target_state) {
+		ni_ifworker_success(w);
+		made_progress = TRUE;
+		goto release;
+	}
 
-				if (w->fsm.wait_for) {
-					ni_debug_application("%s: waiting for event in state %s",
-						w->name, ni_ifworker_state_name(w->fsm.state));
-				} else {
-					ni_debug_application("%s: successfully transitioned from %s to %s",
-							w->name,
-							ni_ifworker_state_name(prev_state),
-							ni_ifworker_state_name(w->fsm.state));
-				}
-			} else
-			if (!w->failed) {
-				/* The fsm action should really have marked this
-				 * as a failure. shame on the lazy programmer. */
-				ni_ifworker_fail(w, "failed to transition from %s to %s",
-						ni_ifworker_state_name(prev_state),
-						ni_ifworker_state_name(action->next_state));
-			}
+	ni_debug_application("%s: state=%s want=%s, next transition is %s -> %s", w->name,
+		ni_ifworker_state_name(w->fsm.state),
+		ni_ifworker_state_name(w->target_state),
+		ni_ifworker_state_name(w->fsm.next_action->from_state),
+		ni_ifworker_state_name(w->fsm.next_action->next_state));
+
+	if (!action->bound) {
+		ni_ifworker_fail(w, "failed to bind services and methods for %s()",
+				action->common.method_name);
+		goto release;
+	}
+
+	if (!ni_ifworker_check_dependencies(fsm, w, action)) {
+		ni_debug_application("%s: defer action (pending dependencies)", w->name);
+		goto release;
+	}
 
-			ni_fsm_process_events(fsm);
-			ni_fsm_events_unblock(fsm);
+	if (w->teardown && action->next_state == NI_FSM_STATE_DEVICE_DOWN) {
+		ni_debug_application("%s: defer action (batched device delete)", w->name);
+		goto release;
+	}
+
+	ni_ifworker_cancel_secondary_timeout(w);
+
+	prev_state = w->fsm.state;
+	ni_fsm_events_block(fsm);
+
+	rv = action->call_func(fsm, w, action);
+	if (w->fsm.next_action)
+		w->fsm.next_action++;
+
+	if (rv >= 0) {
+		made_progress = TRUE;
+
+		if (w->fsm.wait_for) {
+			ni_debug_application("%s: waiting for event in state %s",
+				w->name, ni_ifworker_state_name(w->fsm.state));
+		} else {
+			ni_debug_application("%s: successfully transitioned from %s to %s",
+					w->name,
+					ni_ifworker_state_name(prev_state),
+					ni_ifworker_state_name(w->fsm.state));
+		}
+	} else
+	if (!w->failed) {
+		/* The fsm action should really have marked this
+		 * as a failure. shame on the lazy programmer. */
+		ni_ifworker_fail(w, "failed to transition from %s to %s",
+				ni_ifworker_state_name(prev_state),
+				ni_ifworker_state_name(action->next_state));
+	}
+
+	ni_fsm_process_events(fsm);
+	ni_fsm_events_unblock(fsm);
 release:
-			ni_ifworker_release(w);
+	ni_ifworker_release(w);
+
+	ni_dbus_objects_garbage_collect();
+
+	return made_progress;
+}
+
+/*
+ * Give the next worker of a priority class which can make progress its
+ * next call. The workers of a class take turns, starting after the one
+ * which made progress last.
+ */
+static ni_bool_t
+ni_fsm_schedule_class(ni_fsm_t *fsm, ni_ifworker_priority_t priority)
+{
+	unsigned int i, n, count = fsm->workers.count;
+
+	for (n = 0; n < count && n < fsm->workers.count; ++n) {
+		ni_ifworker_t *w;
+
+		i = (fsm->schedule_pos[priority] + n) % fsm->workers.count;
+		w = fsm->workers.data[i];
+		if (w->priority == priority && ni_fsm_schedule_worker(fsm, w)) {
+			fsm->schedule_pos[priority] = i + 1;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+unsigned int
+ni_fsm_schedule(ni_fsm_t *fsm)
+{
+	unsigned int i, waiting, nrequested;
+	ni_ifworker_priority_t priority;
 
-			ni_dbus_objects_garbage_collect();
+	while (1) {
+		int made_progress = 0;
+
+		/* A worker of a lower priority class gets its next call only
+		 * when no worker of a higher class can make progress; after
+		 * every call, which processes the events received meanwhile,
+		 * the highest class is checked again. So the dbus calls of
+		 * priority devices (e.g. to start dhcp) do not queue up behind
+		 * those of all other devices.
+		 */
+		ni_fsm_update_priorities(fsm);
+		for (priority = __NI_IFWORKER_PRIORITY_MAX; priority-- > 0; ) {
+			if (ni_fsm_schedule_class(fsm, priority)) {
+				priority = __NI_IFWORKER_PRIORITY_MAX;
+				made_progress = 1;
+			}
 		}
 
+		if (!made_progress && ni_fsm_teardown_batch(fsm))
+			made_progress = 1;
+
 		if (!made_progress)
 			break;
 
@@ -5674,6 +6000,7 @@ ni_fsm_process_event(ni_fsm_t *fsm, ni_fsm_event_t *ev)
 
 	fsm->event_seq += 1;
 
+	ni_fsm_sync_state_feed(fsm);
 	w = ni_fsm_ifworker_by_object_path(fsm, ev->object_path);
 
 	ni_debug_events("process event signal %s from %s; uuid=<%s>",
@@ -5712,7 +6039,10 @@ ni_fsm_process_event(ni_fsm_t *fsm, ni_fsm_event_t *ev)
 				return;
 		}
 
-		w = NULL; /* Force refresh (once) on device-ready event */
+		/* Force refresh (once) on device-ready event,
+		 * unless the state feed brought the device in */
+		if (!ni_fsm_state_feed_current(w) || !ni_netdev_device_is_ready(w->device))
+			w = NULL;
 		break;
 
 	case NI_EVENT_DEVICE_UP:
@@ -5721,11 +6051,13 @@ ni_fsm_process_event(ni_fsm_t *fsm, ni_fsm_event_t *ev)
 				return;
 		}
 
-		w = NULL; /* Force refresh (once) on device-up event */
+		/* Force refresh (once) on device-up event, see above */
+		if (!ni_fsm_state_feed_current(w) || !ni_netdev_device_is_up(w->device))
+			w = NULL;
 		break;
 
 	case NI_EVENT_LINK_UP:
-		if (w && !ni_netdev_link_is_up(w->device))
+		if (w && !ni_netdev_link_is_up(w->device) && !ni_fsm_state_feed_current(w))
 			w = NULL; /* refresh is needed */
 		break;
 
@@ -5830,6 +6162,116 @@ interface_state_change_signal(ni_dbus_connection_t *conn, ni_dbus_message_t *msg
 	}
 }
 
+/*
+ * Apply the device and lease changes of the wickedd state feed to the
+ * devices of the workers directly, so the events about them do not
+ * need a refresh of the device object via dbus.
+ */
+void
+ni_fsm_set_state_feed(ni_fsm_t *fsm, ni_state_feed_t *feed)
+{
+	unsigned int i;
+
+	if (fsm->state_feed != feed)
+		ni_state_feed_free(fsm->state_feed);
+	fsm->state_feed = feed;
+
+	/* the devices are current up to now */
+	for (i = 0; i < fsm->workers.count; ++i) {
+		ni_ifworker_t *w = fsm->workers.data[i];
+
+		w->feed_synced = feed && w->object && w->device;
+	}
+}
+
+static ni_bool_t
+ni_fsm_state_feed_current(const ni_ifworker_t *w)
+{
+	return w && w->feed_synced && w->object && w->device;
+}
+
+static ni_bool_t
+ni_fsm_state_feed_apply_leases(ni_netdev_t *dev, const ni_netdev_t *upd)
+{
+	const ni_addrconf_lease_t *ul;
+	ni_addrconf_lease_t *lease;
+	unsigned int count = 0;
+
+	for (ul = upd->leases; ul; ul = ul->next, count++) {
+		/* new leases need their addresses, routes, ... */
+		if (!(lease = ni_netdev_get_lease(dev, ul->family, ul->type)))
+			return FALSE;
+
+		lease->state = ul->state;
+		lease->flags = ul->flags;
+		lease->uuid = ul->uuid;
+		lease->acquired.tv_sec = ul->acquired.tv_sec;
+	}
+	for (lease = dev->leases; lease; lease = lease->next) {
+		if (!count--)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+ni_fsm_state_feed_apply(uint64_t generation, ni_event_t event, unsigned int ifindex,
+			const ni_netdev_t *upd, void *user_data)
+{
+	ni_fsm_t *fsm = user_data;
+	ni_ifworker_t *w;
+	ni_netdev_t *dev;
+
+	if (!(w = ni_fsm_ifworker_by_ifindex(fsm, ifindex)) || !ni_fsm_state_feed_current(w))
+		return;
+
+	dev = w->device;
+	if (!upd || !ni_string_eq(dev->name, upd->name)) {
+		/* delete and rename events refresh the worker */
+		w->feed_synced = FALSE;
+		return;
+	}
+
+	dev->link.ifflags = upd->link.ifflags;
+	dev->link.mtu = upd->link.mtu;
+	dev->link.oper_state = upd->link.oper_state;
+	dev->link.hwaddr = upd->link.hwaddr;
+	ni_string_dup(&dev->link.alias, upd->link.alias);
+	if (upd->link.masterdev.index)
+		ni_netdev_ref_set(&dev->link.masterdev, upd->link.masterdev.name,
+					upd->link.masterdev.index);
+	else
+		ni_netdev_ref_destroy(&dev->link.masterdev);
+	if (upd->link.lowerdev.index)
+		ni_netdev_ref_set(&dev->link.lowerdev, upd->link.lowerdev.name,
+					upd->link.lowerdev.index);
+	else
+		ni_netdev_ref_destroy(&dev->link.lowerdev);
+
+	if (!ni_fsm_state_feed_apply_leases(dev, upd))
+		w->feed_synced = FALSE;
+	w->feed_generation = generation;
+
+	ni_debug_events("%s: applied state feed generation %llu (%s)%s", w->name,
+			(unsigned long long)generation, ni_event_type_to_name(event),
+			w->feed_synced ? "" : ", refresh needed");
+}
+
+void
+ni_fsm_sync_state_feed(ni_fsm_t *fsm)
+{
+	unsigned int i;
+
+	if (!fsm->state_feed)
+		return;
+
+	if (ni_state_feed_read(fsm->state_feed, ni_fsm_state_feed_apply, fsm) < 0) {
+		/* changes lost, refresh all workers on their next event */
+		for (i = 0; i < fsm->workers.count; ++i)
+			fsm->workers.data[i]->feed_synced = FALSE;
+	}
+}
+
 ni_dbus_client_t *
 ni_fsm_create_client(ni_fsm_t *fsm)
 {
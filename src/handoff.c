@@ -0,0 +1,629 @@
+/*
+ *	Runtime state handoff between two wickedd instances
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/poll.h>
+#include <sys/un.h>
+#include <limits.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include <wicked/socket.h>
+#include <wicked/logging.h>
+#include <wicked/xml.h>
+#include "netinfo_priv.h"
+#include "socket_priv.h"
+#include "util_priv.h"
+#include "handoff.h"
+
+#define NI_HANDOFF_REQUEST		"HANDOFF"
+#define NI_HANDOFF_READY		"READY"
+#define NI_HANDOFF_REFUSED		"REFUSED"
+#define NI_HANDOFF_REQUEST_TIMEOUT	1000	/* msec */
+
+struct ni_handoff {
+	char *				path;
+	int				fd;		/* connection of the new instance */
+
+	ni_socket_t *			listener;
+	ni_socket_t *			peer;		/* granted request */
+	ni_handoff_request_fn_t *	request;
+	ni_handoff_cancel_fn_t *	cancel;
+	void *				user_data;
+};
+
+const char *
+ni_handoff_default_path(void)
+{
+	static char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", ni_config_statedir(), NI_HANDOFF_SOCKET);
+	return path;
+}
+
+static ni_handoff_t *
+__ni_handoff_new(const char *path)
+{
+	ni_handoff_t *ho;
+
+	ho = xcalloc(1, sizeof(*ho));
+	ni_string_dup(&ho->path, path);
+	ho->fd = -1;
+	return ho;
+}
+
+static int
+__ni_handoff_address(const char *path, struct sockaddr_un *sun)
+{
+	memset(sun, 0, sizeof(*sun));
+	sun->sun_family = AF_UNIX;
+	if (ni_string_len(path) >= sizeof(sun->sun_path)) {
+		ni_error("handoff socket path %s is too long", path);
+		return -1;
+	}
+	strcpy(sun->sun_path, path);
+	return 0;
+}
+
+static int
+__ni_handoff_poll(int fd, short events, unsigned int timeout)
+{
+	struct pollfd pfd = { .fd = fd, .events = events };
+	int ret;
+
+	do {
+		ret = poll(&pfd, 1, timeout);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret == 0)
+		errno = ETIMEDOUT;
+	return ret > 0 ? 0 : -1;
+}
+
+static int
+__ni_handoff_write(int fd, const char *data, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		if ((ret = send(fd, data, len, MSG_NOSIGNAL)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		data += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+/*
+ * The request and its reply are short lines
+ */
+static int
+__ni_handoff_read_line(int fd, char *buf, size_t size, unsigned int timeout)
+{
+	size_t len = 0;
+	ssize_t ret;
+
+	while (len + 1 < size) {
+		if (__ni_handoff_poll(fd, POLLIN, timeout) < 0)
+			return -1;
+
+		if ((ret = read(fd, buf + len, 1)) < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			return -1;
+		}
+		if (ret == 0) {
+			errno = ECONNRESET;
+			return -1;
+		}
+		if (buf[len] == '\n') {
+			buf[len] = '\0';
+			return 0;
+		}
+		len++;
+	}
+	errno = EPROTO;
+	return -1;
+}
+
+static void
+__ni_handoff_reply(int fd, const char *reply)
+{
+	char line[64];
+
+	snprintf(line, sizeof(line), "%s\n", reply);
+	if (__ni_handoff_write(fd, line, strlen(line)) < 0)
+		ni_debug_wicked("handoff: cannot send reply: %m");
+}
+
+/*
+ * The old instance: the granted new instance went away before it
+ * took over the bus name, or sent something unexpected.
+ */
+static void
+__ni_handoff_peer_receive(ni_socket_t *sock)
+{
+	ni_handoff_t *ho = sock->user_data;
+	char buf[64];
+	ssize_t ret;
+
+	ret = recv(sock->__fd, buf, sizeof(buf), MSG_DONTWAIT);
+	if (ret < 0 && (errno == EINTR || errno == EAGAIN))
+		return;
+
+	ni_warn("handoff: new instance went away before taking over");
+	ni_socket_close(ho->peer);
+	ho->peer = NULL;
+	if (ho->cancel)
+		ho->cancel(ho->user_data);
+}
+
+static void
+__ni_handoff_accept(ni_socket_t *sock)
+{
+	ni_handoff_t *ho = sock->user_data;
+	char line[64], expect[64];
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	int fd;
+
+	if ((fd = accept4(sock->__fd, NULL, NULL, SOCK_CLOEXEC)) < 0) {
+		if (errno != EINTR && errno != EAGAIN)
+			ni_error("handoff: cannot accept connection: %m");
+		return;
+	}
+
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0 ||
+	    cred.uid != geteuid()) {
+		ni_warn("handoff: request from uid %u rejected", (unsigned int)cred.uid);
+		close(fd);
+		return;
+	}
+
+	snprintf(expect, sizeof(expect), "%s %u", NI_HANDOFF_REQUEST, NI_HANDOFF_VERSION);
+	if (__ni_handoff_read_line(fd, line, sizeof(line), NI_HANDOFF_REQUEST_TIMEOUT) < 0 ||
+	    !ni_string_eq(line, expect)) {
+		ni_warn("handoff: invalid request from pid %d", (int)cred.pid);
+		__ni_handoff_reply(fd, NI_HANDOFF_REFUSED);
+		close(fd);
+		return;
+	}
+
+	if (ho->peer || !ho->request || !ho->request(ho->user_data)) {
+		ni_note("handoff: request from pid %d refused", (int)cred.pid);
+		__ni_handoff_reply(fd, NI_HANDOFF_REFUSED);
+		close(fd);
+		return;
+	}
+
+	if (!(ho->peer = ni_socket_wrap(fd, SOCK_STREAM))) {
+		close(fd);
+		if (ho->cancel)
+			ho->cancel(ho->user_data);
+		return;
+	}
+	ho->peer->user_data = ho;
+	ho->peer->receive = __ni_handoff_peer_receive;
+	ni_socket_activate(ho->peer);
+
+	ni_note("handoff: handing over to pid %d", (int)cred.pid);
+	__ni_handoff_reply(fd, NI_HANDOFF_READY);
+}
+
+/*
+ * A socket left over by a previous instance is replaced, so only
+ * call this when that instance is gone, i.e. after the handoff.
+ */
+ni_handoff_t *
+ni_handoff_listen(const char *path, ni_handoff_request_fn_t *request,
+			ni_handoff_cancel_fn_t *cancel, void *user_data)
+{
+	struct sockaddr_un sun;
+	ni_handoff_t *ho;
+	struct stat stb;
+	int fd;
+
+	if (ni_string_empty(path))
+		path = ni_handoff_default_path();
+	if (__ni_handoff_address(path, &sun) < 0)
+		return NULL;
+
+	if (lstat(path, &stb) == 0 && S_ISSOCK(stb.st_mode))
+		unlink(path);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0)) < 0) {
+		ni_error("handoff: cannot create socket: %m");
+		return NULL;
+	}
+	if (bind(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0 ||
+	    chmod(path, S_IRUSR | S_IWUSR) < 0 || listen(fd, 1) < 0) {
+		ni_error("handoff: cannot listen on %s: %m", path);
+		close(fd);
+		return NULL;
+	}
+
+	ho = __ni_handoff_new(path);
+	ho->request = request;
+	ho->cancel = cancel;
+	ho->user_data = user_data;
+	if (!(ho->listener = ni_socket_wrap(fd, SOCK_STREAM))) {
+		close(fd);
+		ni_handoff_free(ho);
+		return NULL;
+	}
+	ho->listener->user_data = ho;
+	ho->listener->receive = __ni_handoff_accept;
+	ni_socket_activate(ho->listener);
+
+	ni_debug_wicked("Listening for handoff requests on %s", path);
+	return ho;
+}
+
+ni_bool_t
+ni_handoff_pending(const ni_handoff_t *ho)
+{
+	return ho && ho->peer;
+}
+
+/*
+ * Send the state to the granted instance and close the connection
+ */
+int
+ni_handoff_send(ni_handoff_t *ho, const xml_node_t *state)
+{
+	char *data;
+	int fd, ret;
+
+	if (!ho || !ho->peer || !state)
+		return -1;
+
+	if (!(data = xml_node_sprint(state)))
+		return -1;
+
+	fd = ho->peer->__fd;
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+	if ((ret = __ni_handoff_write(fd, data, strlen(data))) < 0)
+		ni_error("handoff: cannot send state: %m");
+	free(data);
+
+	ni_socket_close(ho->peer);
+	ho->peer = NULL;
+	return ret;
+}
+
+/*
+ * The new instance: request the handoff and wait until it's granted
+ */
+ni_handoff_t *
+ni_handoff_connect(const char *path, unsigned int timeout)
+{
+	struct sockaddr_un sun;
+	char line[64];
+	ni_handoff_t *ho;
+	int fd;
+
+	if (ni_string_empty(path))
+		path = ni_handoff_default_path();
+	if (__ni_handoff_address(path, &sun) < 0)
+		return NULL;
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+		ni_error("handoff: cannot create socket: %m");
+		return NULL;
+	}
+	if (connect(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0) {
+		ni_error("handoff: cannot connect to %s: %m", path);
+		close(fd);
+		return NULL;
+	}
+
+	snprintf(line, sizeof(line), "%s %u\n", NI_HANDOFF_REQUEST, NI_HANDOFF_VERSION);
+	if (__ni_handoff_write(fd, line, strlen(line)) < 0 ||
+	    __ni_handoff_read_line(fd, line, sizeof(line), timeout) < 0) {
+		ni_error("handoff: request to %s failed: %m", path);
+		close(fd);
+		return NULL;
+	}
+	if (!ni_string_eq(line, NI_HANDOFF_READY)) {
+		ni_error("handoff: request refused by the running instance");
+		close(fd);
+		return NULL;
+	}
+
+	ho = __ni_handoff_new(path);
+	ho->fd = fd;
+	return ho;
+}
+
+/*
+ * Wait for the state; the timeout applies to each read
+ */
+xml_node_t *
+ni_handoff_receive(ni_handoff_t *ho, unsigned int timeout)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	xml_node_t *root = NULL, *node;
+	xml_document_t *doc = NULL;
+	char chunk[8192];
+	ssize_t ret;
+
+	if (!ho || ho->fd < 0)
+		return NULL;
+
+	for (;;) {
+		if (__ni_handoff_poll(ho->fd, POLLIN, timeout) < 0) {
+			ni_error("handoff: no state received: %m");
+			goto done;
+		}
+		if ((ret = read(ho->fd, chunk, sizeof(chunk))) < 0) {
+			if (errno == EINTR)
+				continue;
+			ni_error("handoff: cannot receive state: %m");
+			goto done;
+		}
+		if (ret == 0)
+			break;
+		ni_stringbuf_put(&buf, chunk, ret);
+	}
+
+	if (ni_string_empty(buf.string) ||
+	    !(doc = xml_document_from_string(buf.string, "handoff")) ||
+	    !(node = xml_node_get_child(xml_document_root(doc), "handoff"))) {
+		ni_error("handoff: cannot parse the received state");
+		goto done;
+	}
+	xml_node_detach(node);
+	root = node;
+
+done:
+	xml_document_free(doc);
+	ni_stringbuf_destroy(&buf);
+	close(ho->fd);
+	ho->fd = -1;
+	return root;
+}
+
+void
+ni_handoff_free(ni_handoff_t *ho)
+{
+	if (!ho)
+		return;
+
+	if (ho->peer)
+		ni_socket_close(ho->peer);
+	if (ho->listener)
+		ni_socket_close(ho->listener);
+	if (ho->fd >= 0)
+		close(ho->fd);
+	ni_string_free(&ho->path);
+	free(ho);
+}
+
+/*
+ * The leases with the update in progress, if any.
+ */
+static void
+__ni_handoff_lease_save(const ni_addrconf_lease_t *lease, xml_node_t *parent, const char *ifname)
+{
+	xml_node_t *node, *data;
+
+	if (ni_addrconf_lease_to_xml(lease, &data, ifname) < 0) {
+		ni_warn("%s: unable to hand off %s:%s lease", ifname,
+				ni_addrfamily_type_to_name(lease->family),
+				ni_addrconf_type_to_name(lease->type));
+		return;
+	}
+
+	node = xml_node_new("addrconf", parent);
+	xml_node_add_attr_uint(node, "flags", lease->flags);
+	if (lease->updater)
+		xml_node_add_attr(node, "update", ni_event_type_to_name(lease->updater->event));
+	xml_node_add_child(node, data);
+
+	if (lease->old && ni_addrconf_lease_to_xml(lease->old, &data, ifname) == 0)
+		xml_node_add_child(xml_node_new("old", node), data);
+}
+
+static int
+__ni_handoff_lease_restore(ni_netdev_t *dev, const xml_node_t *node)
+{
+	ni_addrconf_lease_t *lease = NULL, *old = NULL;
+	const xml_node_t *child;
+	const char *update;
+	int event;
+
+	if (ni_addrconf_lease_from_xml(&lease, node, dev->name) < 0)
+		return -1;
+
+	xml_node_get_attr_uint(node, "flags", &lease->flags);
+	if ((child = xml_node_get_child(node, "old")) &&
+	    ni_addrconf_lease_from_xml(&old, child, dev->name) == 0)
+		lease->old = old;
+	ni_netdev_set_lease(dev, lease);
+
+	if (!(update = xml_node_get_attr(node, "update")))
+		return 0;
+
+	/* an update in progress is restarted from its first action */
+	if ((event = ni_event_name_to_type(update)) < 0)
+		event = NI_EVENT_ADDRESS_ACQUIRED;
+	if (lease->state == NI_ADDRCONF_STATE_RELEASING ||
+	    lease->state == NI_ADDRCONF_STATE_RELEASED)
+		ni_addrconf_updater_new_removing(lease, dev, event);
+	else
+		ni_addrconf_updater_new_applying(lease, dev, event);
+
+	if (!ni_addrconf_updater_background(lease->updater, 0)) {
+		ni_error("%s: unable to resume %s:%s lease update", dev->name,
+				ni_addrfamily_type_to_name(lease->family),
+				ni_addrconf_type_to_name(lease->type));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * The event filters of calls waiting for a device event, e.g. linkUp;
+ * the new instance emits the event with the uuid the caller waits for.
+ */
+static void
+__ni_handoff_event_filters_save(const ni_netdev_t *dev, xml_node_t *parent)
+{
+	const ni_event_filter_t *efp;
+	xml_node_t *node;
+
+	for (efp = dev->event_filter; efp; efp = efp->next) {
+		node = xml_node_new("event-filter", parent);
+		xml_node_add_attr_uint(node, "mask", efp->event_mask);
+		xml_node_add_attr(node, "uuid", ni_uuid_print(&efp->uuid));
+	}
+}
+
+static void
+__ni_handoff_event_filters_restore(ni_netdev_t *dev, const xml_node_t *parent)
+{
+	ni_event_filter_t *efp, **tail;
+	const xml_node_t *node;
+	unsigned int mask;
+	ni_uuid_t uuid;
+
+	for (tail = &dev->event_filter; *tail; tail = &(*tail)->next)
+		;
+
+	for (node = parent->children; node; node = node->next) {
+		if (!ni_string_eq(node->name, "event-filter"))
+			continue;
+
+		if (!xml_node_get_attr_uint(node, "mask", &mask) ||
+		    ni_uuid_parse(&uuid, xml_node_get_attr(node, "uuid")) < 0) {
+			ni_warn("%s: unable to restore an event filter", dev->name);
+			continue;
+		}
+
+		efp = xcalloc(1, sizeof(*efp));
+		efp->event_mask = mask;
+		efp->uuid = uuid;
+		*tail = efp;
+		tail = &efp->next;
+	}
+}
+
+xml_node_t *
+ni_handoff_state_save(ni_netconfig_t *nc)
+{
+	const ni_addrconf_lease_t *lease;
+	xml_node_t *root, *ifnode, *node;
+	ni_netdev_t *dev;
+
+	root = xml_node_new("handoff", NULL);
+	xml_node_add_attr_uint(root, "version", NI_HANDOFF_VERSION);
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		ifnode = xml_node_new("interface", root);
+		xml_node_new_element_uint("index", ifnode, dev->link.ifindex);
+		xml_node_new_element("name", ifnode, dev->name);
+		if (ni_netdev_device_is_ready(dev))
+			xml_node_new_element("ready", ifnode, "true");
+
+		if (dev->client_state) {
+			node = xml_node_new(NI_CLIENT_STATE_XML_NODE, ifnode);
+			ni_client_state_print_xml(dev->client_state, node);
+		}
+
+		for (lease = dev->leases; lease; lease = lease->next)
+			__ni_handoff_lease_save(lease, ifnode, dev->name);
+
+		__ni_handoff_event_filters_save(dev, ifnode);
+	}
+	return root;
+}
+
+/*
+ * Apply the state to the devices discovered by the new instance.
+ * Devices gone or renamed meanwhile are skipped; the index of each
+ * device with restored state is added to the restored array.
+ */
+int
+ni_handoff_state_restore(ni_netconfig_t *nc, const xml_node_t *root, ni_uint_array_t *restored)
+{
+	const xml_node_t *ifnode, *node;
+	ni_client_state_t cs;
+	unsigned int version, ifindex;
+	ni_bool_t ready;
+	ni_netdev_t *dev;
+
+	if (!nc || !root || !ni_string_eq(root->name, "handoff"))
+		return -1;
+
+	if (!xml_node_get_attr_uint(root, "version", &version) || version != NI_HANDOFF_VERSION) {
+		ni_error("handoff: unsupported state version");
+		return -1;
+	}
+
+	for (ifnode = root->children; ifnode; ifnode = ifnode->next) {
+		if (!ni_string_eq(ifnode->name, "interface"))
+			continue;
+
+		if (!(node = xml_node_get_child(ifnode, "index")) ||
+		    ni_parse_uint(node->cdata, &ifindex, 10) < 0)
+			continue;
+
+		node = xml_node_get_child(ifnode, "name");
+		dev = ni_netdev_by_index(nc, ifindex);
+		if (!dev || !node || !ni_string_eq(dev->name, node->cdata)) {
+			ni_debug_wicked("handoff: device %s#%u gone, state ignored",
+					node ? node->cdata : "", ifindex);
+			continue;
+		}
+
+		if ((node = xml_node_get_child(ifnode, "ready")) &&
+		    ni_parse_boolean(node->cdata, &ready) == 0 && ready)
+			dev->link.ifflags |= NI_IFF_DEVICE_READY;
+
+		if ((node = xml_node_get_child(ifnode, NI_CLIENT_STATE_XML_NODE))) {
+			ni_client_state_init(&cs);
+			if (ni_client_state_parse_xml(node, &cs))
+				ni_netdev_set_client_state(dev, ni_client_state_clone(&cs));
+			ni_client_state_reset(&cs);
+		}
+
+		for (node = ifnode->children; node; node = node->next) {
+			if (ni_string_eq(node->name, "addrconf") &&
+			    __ni_handoff_lease_restore(dev, node) < 0)
+				ni_warn("%s: unable to restore a lease", dev->name);
+		}
+
+		__ni_handoff_event_filters_restore(dev, ifnode);
+
+		if (restored)
+			ni_uint_array_append(restored, ifindex);
+	}
+	return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ *	Runtime state handoff between two wickedd instances
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_HANDOFF_H__
+#define __WICKED_HANDOFF_H__
+
+#include <wicked/types.h>
+#include <wicked/xml.h>
+
+/*
+ * A running wickedd listens on a unix socket in the state directory.
+ * A new instance started to replace it connects and requests the
+ * handoff; once the old one granted it, the new one takes over the
+ * bus name and the old one sends its state as xml when it lost the
+ * name, i.e. after it processed the last call routed to it, and exits.
+ */
+#define NI_HANDOFF_SOCKET		"wickedd-handoff.socket"
+#define NI_HANDOFF_VERSION		1U
+
+typedef struct ni_handoff		ni_handoff_t;
+
+/* the old instance: grant a request or forget about a granted one */
+typedef ni_bool_t			ni_handoff_request_fn_t(void *user_data);
+typedef void				ni_handoff_cancel_fn_t(void *user_data);
+
+extern const char *		ni_handoff_default_path(void);
+
+extern ni_handoff_t *		ni_handoff_listen(const char *path,
+						ni_handoff_request_fn_t *,
+						ni_handoff_cancel_fn_t *, void *);
+extern ni_bool_t		ni_handoff_pending(const ni_handoff_t *);
+extern int			ni_handoff_send(ni_handoff_t *, const xml_node_t *);
+
+/* the new instance */
+extern ni_handoff_t *		ni_handoff_connect(const char *path, unsigned int timeout);
+extern xml_node_t *		ni_handoff_receive(ni_handoff_t *, unsigned int timeout);
+
+extern void			ni_handoff_free(ni_handoff_t *);
+
+/*
+ * Interface state which is not in the kernel: the device ready flag,
+ * the client state, the leases including pending lease updates and the
+ * event filters of calls waiting for a device event.
+ */
+extern xml_node_t *		ni_handoff_state_save(ni_netconfig_t *);
+extern int			ni_handoff_state_restore(ni_netconfig_t *, const xml_node_t *,
+						ni_uint_array_t *);
+
+#endif /* __WICKED_HANDOFF_H__ */
@@ -0,0 +1,231 @@
+/*
+ *	Simple string keyed hash map
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <wicked/util.h>
+#include "util_priv.h"
+#include "hashmap.h"
+
+#define NI_HASHMAP_MIN_SIZE	32
+
+typedef struct ni_hashmap_entry	ni_hashmap_entry_t;
+struct ni_hashmap_entry {
+	ni_hashmap_entry_t *	next;
+	unsigned int		hash;
+	char *			key;
+	void *			value;
+};
+
+struct ni_hashmap {
+	unsigned int		size;
+	unsigned int		count;
+	ni_hashmap_entry_t **	buckets;
+};
+
+/*
+ * FNV-1a; the NULL key hashes differently than the empty string
+ */
+unsigned int
+ni_hashmap_hash(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	if (!key)
+		return 0;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+ni_hashmap_t *
+ni_hashmap_new(void)
+{
+	return xcalloc(1, sizeof(ni_hashmap_t));
+}
+
+void
+ni_hashmap_clear(ni_hashmap_t *map)
+{
+	ni_hashmap_entry_t *entry;
+	unsigned int i;
+
+	if (!map)
+		return;
+
+	for (i = 0; i < map->size; ++i) {
+		while ((entry = map->buckets[i]) != NULL) {
+			map->buckets[i] = entry->next;
+			free(entry->key);
+			free(entry);
+		}
+	}
+	free(map->buckets);
+	map->buckets = NULL;
+	map->size = 0;
+	map->count = 0;
+}
+
+void
+ni_hashmap_free(ni_hashmap_t *map)
+{
+	if (map) {
+		ni_hashmap_clear(map);
+		free(map);
+	}
+}
+
+unsigned int
+ni_hashmap_count(const ni_hashmap_t *map)
+{
+	return map ? map->count : 0;
+}
+
+static void
+ni_hashmap_resize(ni_hashmap_t *map, unsigned int size)
+{
+	ni_hashmap_entry_t **buckets, *entry;
+	unsigned int i, pos;
+
+	buckets = xcalloc(size, sizeof(buckets[0]));
+	for (i = 0; i < map->size; ++i) {
+		while ((entry = map->buckets[i]) != NULL) {
+			map->buckets[i] = entry->next;
+			pos = entry->hash & (size - 1);
+			entry->next = buckets[pos];
+			buckets[pos] = entry;
+		}
+	}
+	free(map->buckets);
+	map->buckets = buckets;
+	map->size = size;
+}
+
+static ni_hashmap_entry_t **
+ni_hashmap_lookup(const ni_hashmap_t *map, const char *key, unsigned int hash)
+{
+	ni_hashmap_entry_t **pos;
+
+	if (!map->size)
+		return NULL;
+
+	pos = &map->buckets[hash & (map->size - 1)];
+	for (; *pos; pos = &(*pos)->next) {
+		if ((*pos)->hash == hash && ni_string_eq((*pos)->key, key))
+			return pos;
+	}
+	return NULL;
+}
+
+void *
+ni_hashmap_get(const ni_hashmap_t *map, const char *key)
+{
+	ni_hashmap_entry_t **pos;
+
+	if (!map || !(pos = ni_hashmap_lookup(map, key, ni_hashmap_hash(key))))
+		return NULL;
+	return (*pos)->value;
+}
+
+static void
+ni_hashmap_insert(ni_hashmap_t *map, const char *key, unsigned int hash, void *value)
+{
+	ni_hashmap_entry_t *entry;
+	unsigned int pos;
+
+	if (!map->size)
+		ni_hashmap_resize(map, NI_HASHMAP_MIN_SIZE);
+	else
+	if (map->count >= map->size)
+		ni_hashmap_resize(map, map->size << 1);
+
+	entry = xcalloc(1, sizeof(*entry));
+	entry->hash = hash;
+	entry->key = key ? xstrdup(key) : NULL;
+	entry->value = value;
+
+	pos = hash & (map->size - 1);
+	entry->next = map->buckets[pos];
+	map->buckets[pos] = entry;
+	map->count++;
+}
+
+/*
+ * Set the value of a key, replacing any previous value
+ */
+ni_bool_t
+ni_hashmap_set(ni_hashmap_t *map, const char *key, void *value)
+{
+	ni_hashmap_entry_t **pos;
+	unsigned int hash;
+
+	if (!map)
+		return FALSE;
+
+	hash = ni_hashmap_hash(key);
+	if ((pos = ni_hashmap_lookup(map, key, hash)))
+		(*pos)->value = value;
+	else
+		ni_hashmap_insert(map, key, hash, value);
+	return TRUE;
+}
+
+/*
+ * Add a key only when not yet present, keeping the first value
+ */
+ni_bool_t
+ni_hashmap_add(ni_hashmap_t *map, const char *key, void *value)
+{
+	unsigned int hash;
+
+	if (!map)
+		return FALSE;
+
+	hash = ni_hashmap_hash(key);
+	if (ni_hashmap_lookup(map, key, hash))
+		return FALSE;
+
+	ni_hashmap_insert(map, key, hash, value);
+	return TRUE;
+}
+
+void *
+ni_hashmap_remove(ni_hashmap_t *map, const char *key)
+{
+	ni_hashmap_entry_t **pos, *entry;
+	void *value;
+
+	if (!map || !(pos = ni_hashmap_lookup(map, key, ni_hashmap_hash(key))))
+		return NULL;
+
+	entry = *pos;
+	*pos = entry->next;
+	value = entry->value;
+	free(entry->key);
+	free(entry);
+	map->count--;
+	return value;
+}
@@ -0,0 +1,42 @@
+/*
+ *	Simple string keyed hash map
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_HASHMAP_H__
+#define __WICKED_HASHMAP_H__
+
+#include <wicked/types.h>
+
+/*
+ * Maps a copy of the key string to a value pointer the map does not
+ * own; a NULL key is a valid key distinct from the empty string.
+ */
+typedef struct ni_hashmap	ni_hashmap_t;
+
+extern ni_hashmap_t *		ni_hashmap_new(void);
+extern void			ni_hashmap_free(ni_hashmap_t *);
+extern void			ni_hashmap_clear(ni_hashmap_t *);
+extern unsigned int		ni_hashmap_count(const ni_hashmap_t *);
+
+extern void *			ni_hashmap_get(const ni_hashmap_t *, const char *);
+extern ni_bool_t		ni_hashmap_set(ni_hashmap_t *, const char *, void *);
+extern ni_bool_t		ni_hashmap_add(ni_hashmap_t *, const char *, void *);
+extern void *			ni_hashmap_remove(ni_hashmap_t *, const char *);
+
+extern unsigned int		ni_hashmap_hash(const char *);
+
+#endif /* __WICKED_HASHMAP_H__ */
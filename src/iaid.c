@@ -42,6 +42,7 @@
 
 #include "iaid.h"
 #include "buffer.h"
+#include "hashmap.h"
 
 
 #define NI_CONFIG_DEFAULT_IAID_NODE	"iaid"
@@ -150,85 +151,113 @@ ni_iaid_map_set_fallback_file(char **filename)
 			NI_CONFIG_DEFAULT_IAID_FILE) != NULL;
 }
 
-ni_iaid_map_t *
-ni_iaid_map_load(const char *filename)
+static ni_bool_t
+ni_iaid_map_read(ni_iaid_map_t *map, const char *type)
 {
-	ni_iaid_map_t *map;
-	const char *type;
 	ni_buffer_t buff;
 	struct stat stb;
 	ssize_t len;
 
+	if (lseek(map->fd, 0, SEEK_SET) < 0)
+		return FALSE;
+
+	if (fstat(map->fd, &stb) < 0)
+		stb.st_size = BUFSIZ;
+
+	ni_buffer_init_dynamic(&buff, stb.st_size + 1);
+	do {
+		if (!ni_buffer_tailroom(&buff))
+			ni_buffer_ensure_tailroom(&buff, BUFSIZ);
+
+		do {
+			 len = read(map->fd, ni_buffer_tail(&buff), ni_buffer_tailroom(&buff));
+			 if (len > 0)
+				 ni_buffer_push_tail(&buff, len);
+		} while (len < 0 && errno == EINTR);
+	} while (len > 0);
+
+	if (len < 0) {
+		ni_error("unable to read %s iaid map file name (%s): %m", type, map->file);
+		ni_buffer_destroy(&buff);
+		return FALSE;
+	}
+
+	xml_document_free(map->doc);
+	map->doc = xml_document_from_buffer(&buff, map->file);
+	ni_buffer_destroy(&buff);
+	if (!map->doc) {
+		map->doc = xml_document_new();
+		ni_warn("unable to parse %s iaid map file name (%s): %m", type, map->file);
+	}
+	return TRUE;
+}
+
+static ni_iaid_map_t *
+ni_iaid_map_open_file(const char *filename, const char **type)
+{
+	ni_iaid_map_t *map;
+
 	if (!(map = ni_iaid_map_new())) {
 		ni_error("unable to allocate memory for iaid map: %m");
 		return NULL;
 	}
 
 	if (filename) {
-		type = "given";
+		*type = "given";
 		if (!ni_string_dup(&map->file, filename)) {
-			ni_error("unable to copy %s iaid map file name (%s): %m", type, filename);
+			ni_error("unable to copy %s iaid map file name (%s): %m", *type, filename);
 			goto failure;
 		}
 
 		if (!ni_iaid_map_open(map)) {
-			ni_error("unable to open %s iaid map file name (%s): %m", type, map->file);
+			ni_error("unable to open %s iaid map file name (%s): %m", *type, map->file);
 			goto failure;
 		}
 	} else {
-		type = "default";
+		*type = "default";
 		if (!ni_iaid_map_set_default_file(&map->file)) {
-			ni_error("unable to construct %s iaid map file name: %m", type);
+			ni_error("unable to construct %s iaid map file name: %m", *type);
 			goto failure;
 		}
 
 		if (!ni_iaid_map_open(map)) {
-			ni_debug_readwrite("unable to open %s iaid map file name (%s): %m", type, map->file);
+			ni_debug_readwrite("unable to open %s iaid map file name (%s): %m", *type, map->file);
 
-			type = "fallback";
+			*type = "fallback";
 			if (!ni_iaid_map_set_fallback_file(&map->file)) {
-				ni_error("unable to construct %s iaid map file name: %m", type);
+				ni_error("unable to construct %s iaid map file name: %m", *type);
 				goto failure;
 			}
-			
+
 			if (!ni_iaid_map_open(map)) {
 				ni_error("unable to open iaid map file name (%s): %m", map->file);
 				goto failure;
 			}
 		}
 	}
+	return map;
+
+failure:
+	ni_iaid_map_free(map);
+	return NULL;
+}
+
+ni_iaid_map_t *
+ni_iaid_map_load(const char *filename)
+{
+	ni_iaid_map_t *map;
+	const char *type;
+
+	if (!(map = ni_iaid_map_open_file(filename, &type)))
+		return NULL;
 
 	if (!ni_iaid_map_lock(map)) {
 		ni_error("unable to lock %s iaid map file name (%s): %m", type, map->file);
 		goto failure;
 	}
 
-	if (fstat(map->fd, &stb) < 0)
-		stb.st_size = BUFSIZ;
-
-	ni_buffer_init_dynamic(&buff, stb.st_size + 1);
-	do {
-		if (!ni_buffer_tailroom(&buff))
-			ni_buffer_ensure_tailroom(&buff, BUFSIZ);
-
-		do {
-			 len = read(map->fd, ni_buffer_tail(&buff), ni_buffer_tailroom(&buff));
-			 if (len > 0)
-				 ni_buffer_push_tail(&buff, len);
-		} while (len < 0 && errno == EINTR);
-	} while (len > 0);
-
-	if (len < 0) {
-		ni_error("unable to read %s iaid map file name (%s): %m", type, map->file);
-	} else {
-		map->doc = xml_document_from_buffer(&buff, map->file);
-		ni_buffer_destroy(&buff);
-		if (!map->doc) {
-			map->doc = xml_document_new();
-			ni_warn("unable to parse %s iaid map file name (%s): %m", type, map->file);
-		}
+	if (ni_iaid_map_read(map, type))
 		return map;
-	}
 
 failure:
 	ni_iaid_map_free(map);
@@ -487,38 +516,259 @@ ni_iaid_create(unsigned int *iaid, const ni_netdev_t *dev, const ni_iaid_map_t *
 	return FALSE;
 }
 
+/*
+ * Long-lived iaid map of the dhcp supplicants, indexed by device name
+ * and by iaid. The file is parsed again only after another process
+ * changed it, detected by its inode, size and modification time, and
+ * is written under the same file lock the iaid map users are taking.
+ */
+typedef struct ni_iaid_registry {
+	ni_iaid_map_t *		map;
+	const char *		type;
+	struct stat		stamp;
+	ni_hashmap_t *		names;
+	ni_hashmap_t *		iaids;
+	unsigned int		free_hint;
+	xml_node_t *		added;
+} ni_iaid_registry_t;
+
+static ni_iaid_registry_t	ni_iaid_registry;
+
+static ni_bool_t
+ni_iaid_registry_stamp_equal(const struct stat *a, const struct stat *b)
+{
+	return	a->st_dev  == b->st_dev  &&
+		a->st_ino  == b->st_ino  &&
+		a->st_size == b->st_size &&
+		a->st_mtim.tv_sec  == b->st_mtim.tv_sec &&
+		a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+static const char *
+ni_iaid_registry_key(char *buf, size_t len, unsigned int iaid)
+{
+	snprintf(buf, len, "%u", iaid);
+	return buf;
+}
+
+static void
+ni_iaid_registry_index(ni_iaid_registry_t *reg)
+{
+	xml_node_t *root, *node = NULL;
+	unsigned int iaid;
+	const char *name;
+	char key[16];
+
+	ni_hashmap_clear(reg->names);
+	ni_hashmap_clear(reg->iaids);
+	reg->free_hint = 1;
+
+	if (!(root = ni_iaid_map_root_node(reg->map)))
+		return;
+
+	/* the first node wins, as in the linear map lookups */
+	while ((node = ni_iaid_map_next_node(root, node))) {
+		if (ni_iaid_map_node_to_name(node, &name))
+			ni_hashmap_add(reg->names, name, node);
+
+		if (ni_iaid_map_node_to_iaid(node, &iaid))
+			ni_hashmap_add(reg->iaids, ni_iaid_registry_key(key,
+					sizeof(key), iaid), node);
+	}
+}
+
+static ni_iaid_registry_t *
+ni_iaid_registry_open(void)
+{
+	ni_iaid_registry_t *reg = &ni_iaid_registry;
+	struct stat stb, fstb;
+
+	/* reopen when the file has been removed or replaced */
+	if (reg->map && (stat(reg->map->file, &stb) < 0 || fstat(reg->map->fd, &fstb) < 0 ||
+			stb.st_dev != fstb.st_dev || stb.st_ino != fstb.st_ino)) {
+		ni_debug_readwrite("iaid map file %s has been replaced, reopening", reg->map->file);
+		ni_iaid_map_free(reg->map);
+		reg->map = NULL;
+	}
+
+	if (!reg->map) {
+		if (!(reg->map = ni_iaid_map_open_file(NULL, &reg->type)))
+			return NULL;
+		memset(&reg->stamp, 0, sizeof(reg->stamp));
+	}
+	if (!reg->names)
+		reg->names = ni_hashmap_new();
+	if (!reg->iaids)
+		reg->iaids = ni_hashmap_new();
+	return reg;
+}
+
+/*
+ * Refresh the map from file if needed; the caller holds the lock
+ */
+static ni_bool_t
+ni_iaid_registry_sync(ni_iaid_registry_t *reg)
+{
+	struct stat stb;
+
+	if (fstat(reg->map->fd, &stb) < 0)
+		return FALSE;
+
+	if (reg->map->doc && ni_iaid_registry_stamp_equal(&reg->stamp, &stb))
+		return TRUE;
+
+	if (!ni_iaid_map_read(reg->map, reg->type))
+		return FALSE;
+
+	reg->stamp = stb;
+	ni_iaid_registry_index(reg);
+	return TRUE;
+}
+
+/*
+ * The file contains the sequence of the map nodes, so a new node is
+ * appended to it, while changes of existing nodes rewrite the file.
+ */
+static ni_bool_t
+ni_iaid_registry_append(ni_iaid_registry_t *reg, const xml_node_t *node)
+{
+	char *data;
+	size_t off, len;
+	ssize_t ret = 0;
+
+	if (lseek(reg->map->fd, 0, SEEK_END) < 0)
+		return FALSE;
+
+	if (!(data = xml_node_sprint(node)))
+		return FALSE;
+
+	len = ni_string_len(data);
+	for (off = 0; len > off; ) {
+		ret = write(reg->map->fd, data + off, len - off);
+		if (ret < 0 && errno != EINTR)
+			break;
+		else
+		if (ret > 0)
+			off += ret;
+	}
+	free(data);
+	return ret < 0 ? FALSE : TRUE;
+}
+
+static ni_bool_t
+ni_iaid_registry_commit(ni_iaid_registry_t *reg)
+{
+	xml_node_t *added = reg->added;
+	ni_bool_t ret;
+
+	reg->added = NULL;
+	if (added)
+		ret = ni_iaid_registry_append(reg, added);
+	else
+		ret = ni_iaid_map_save(reg->map);
+
+	if (!ret || fstat(reg->map->fd, &reg->stamp) < 0) {
+		/* enforce a reload of what is in the file */
+		memset(&reg->stamp, 0, sizeof(reg->stamp));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static ni_bool_t
+ni_iaid_registry_set(ni_iaid_registry_t *reg, const char *name, unsigned int iaid)
+{
+	xml_node_t *root, *node;
+	unsigned int curr;
+	char key[16];
+
+	if (!(root = ni_iaid_map_root_node(reg->map)) || ni_string_empty(name))
+		return FALSE;
+
+	if ((node = ni_hashmap_get(reg->names, name))) {
+		if (ni_iaid_map_node_to_iaid(node, &curr)) {
+			ni_iaid_registry_key(key, sizeof(key), curr);
+			if (ni_hashmap_get(reg->iaids, key) == node)
+				ni_hashmap_remove(reg->iaids, key);
+		}
+	} else {
+		if (!(node = xml_node_new(NI_CONFIG_DEFAULT_IAID_NODE, root)))
+			return FALSE;
+		xml_node_add_attr(node, NI_CONFIG_DEFAULT_IAID_DEVICE, name);
+		ni_hashmap_add(reg->names, name, node);
+		reg->added = node;
+	}
+
+	xml_node_set_uint(node, iaid);
+	ni_hashmap_add(reg->iaids, ni_iaid_registry_key(key, sizeof(key), iaid), node);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_iaid_registry_create(ni_iaid_registry_t *reg, unsigned int *iaid, const ni_netdev_t *dev)
+{
+	const char *name;
+	xml_node_t *node;
+	char key[16];
+	unsigned int i;
+
+	if (ni_iaid_create_hwaddr(iaid, &dev->link.hwaddr))
+		return TRUE;
+
+	/* iaids are not released while indexed, skip the ones in use */
+	for (i = reg->free_hint; i && i < -1U; ++i) {
+		node = ni_hashmap_get(reg->iaids, ni_iaid_registry_key(key, sizeof(key), i));
+		if (node && ni_iaid_map_node_to_name(node, &name))
+			continue;
+
+		*iaid = reg->free_hint = i;
+		return TRUE;
+	}
+	return FALSE;
+}
+
 ni_bool_t
 ni_iaid_acquire(unsigned int *iaid, const ni_netdev_t *dev, unsigned int requested)
 {
-	ni_iaid_map_t * map = NULL;
+	ni_iaid_registry_t *reg;
+	xml_node_t *node;
 
 	if (!iaid || !dev)
 		return FALSE;
 
-	if (!(map = ni_iaid_map_load(NULL)))
+	if (!(reg = ni_iaid_registry_open()))
 		goto failure;
 
-	if (ni_iaid_map_get_iaid(map, dev->name, iaid))
+	if (!ni_iaid_map_lock(reg->map)) {
+		ni_error("unable to lock %s iaid map file name (%s): %m", reg->type, reg->map->file);
+		goto failure;
+	}
+
+	if (!ni_iaid_registry_sync(reg))
+		goto failure;
+
+	if ((node = ni_hashmap_get(reg->names, dev->name)) &&
+	    ni_iaid_map_node_to_iaid(node, iaid))
 		goto cleanup;
 
-	if (!requested && !ni_iaid_create(&requested, dev, map))
+	if (!requested && !ni_iaid_registry_create(reg, &requested, dev))
 		goto failure;
 
 	*iaid = requested;
 
-	if (!ni_iaid_map_set(map, dev->name, requested))
+	if (!ni_iaid_registry_set(reg, dev->name, requested))
 		goto failure;
 
-	if (!ni_iaid_map_save(map))
+	if (!ni_iaid_registry_commit(reg))
 		goto failure;
 
 cleanup:
-	ni_iaid_map_free(map);
+	ni_iaid_map_unlock(reg->map);
 	return TRUE;
 
 failure:
 	*iaid = 0;
-	ni_iaid_map_free(map);
+	if (reg)
+		ni_iaid_map_unlock(reg->map);
 	return FALSE;
 }
-
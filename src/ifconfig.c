@@ -140,8 +140,9 @@ static int	__ni_rtnl_link_add_port_up(const ni_netdev_t *, const char *, unsigne
 static int	__ni_rtnl_link_add_slave_down(const ni_netdev_t *, const char *, unsigned int);
 
 static int	__ni_rtnl_send_deladdr(ni_netdev_t *, const ni_address_t *);
+static int	__ni_rtnl_send_deladdrs(ni_netdev_t *, const ni_address_array_t *);
 static int	__ni_rtnl_send_newaddr(ni_netdev_t *, const ni_address_t *, int);
-static int	__ni_rtnl_send_delroute(ni_netdev_t *, ni_route_t *);
+static int	__ni_rtnl_send_delroutes(ni_netdev_t *, const ni_route_array_t *);
 static int	__ni_rtnl_send_newroute(ni_netdev_t *, ni_route_t *, int);
 static int	__ni_rtnl_send_newrule(const ni_rule_t *, int);
 static int	__ni_rtnl_send_delrule(const ni_rule_t *);
@@ -466,6 +467,7 @@ ni_system_interface_link_change(ni_netdev_t *dev, const ni_netdev_req_t *req)
 int
 __ni_system_interface_flush_addrs(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
+	ni_address_array_t addrs = NI_ADDRESS_ARRAY_INIT;
 	ni_address_t *ap;
 
 	 if (!dev || (!nc && !(nc = ni_global_state_handle(0))))
@@ -473,9 +475,10 @@ __ni_system_interface_flush_addrs(ni_netconfig_t *nc, ni_netdev_t *dev)
 
 	 /* TODO: ni_rtnl_query_addr_info + del without to parse */
 	__ni_system_refresh_interface_addrs(nc, dev);
-	for (ap = dev->addrs; ap; ap = ap->next) {
-		__ni_rtnl_send_deladdr(dev, ap);
-	}
+	for (ap = dev->addrs; ap; ap = ap->next)
+		ni_address_array_append(&addrs, ni_address_ref(ap));
+	__ni_rtnl_send_deladdrs(dev, &addrs);
+	ni_address_array_destroy(&addrs);
 	__ni_system_refresh_interface_addrs(nc, dev);
 	return dev->addrs == NULL ? 0 : 1;
 }
@@ -483,22 +486,15 @@ __ni_system_interface_flush_addrs(ni_netconfig_t *nc, ni_netdev_t *dev)
 int
 __ni_system_interface_flush_routes(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
-	ni_route_table_t *tab;
-	ni_route_t *rp;
-	 unsigned int i;
+	ni_route_array_t routes = NI_ROUTE_ARRAY_INIT;
 
 	 if (!dev || (!nc && !(nc = ni_global_state_handle(0))))
 		 return -1;
 
-	 /* TODO: ni_rtnl_query_route_info + del without to parse */
-	 __ni_system_refresh_interface_routes(nc, dev);
-	 for (tab = dev->routes; tab; tab = tab->next) {
-		 for (i = 0; i < tab->routes.count; ++i) {
-			if (!(rp = tab->routes.data[i]))
-				continue;
-			__ni_rtnl_send_delroute(dev, rp);
-		}
-	 }
+	 /* query without merging into the device route tables */
+	 __ni_system_query_interface_routes(nc, dev, &routes);
+	 __ni_rtnl_send_delroutes(dev, &routes);
+	 ni_route_array_destroy(&routes);
 	 __ni_system_refresh_interface_routes(nc, dev);
 	 return dev->routes == NULL ? 0 : 1;
 }
@@ -1398,6 +1394,182 @@ ni_system_interface_delete(ni_netconfig_t *nc, const char *ifname)
 	return 0;
 }
 
+/*
+ * Delete several devices at once, e.g. on shutdown. Only devices the
+ * kernel removes on a plain RTM_DELLINK (with their addresses and
+ * routes) are handled; the ifindexes of the deleted devices are
+ * appended to deleted.
+ *
+ * The devices are moved into an unused link group first, which is
+ * then deleted using a single RTM_DELLINK, so the kernel unregisters
+ * them all at once instead of waiting for each device separately.
+ */
+#define NI_SYSTEM_DELETE_GROUP		0x7fffffffU
+
+static ni_bool_t
+__ni_system_interface_bulk_deletable(const ni_netdev_t *dev)
+{
+	switch (dev->link.type) {
+	case NI_IFTYPE_DUMMY:
+	case NI_IFTYPE_VLAN:
+	case NI_IFTYPE_MACVLAN:
+	case NI_IFTYPE_MACVTAP:
+	case NI_IFTYPE_VXLAN:
+	case NI_IFTYPE_TUN:
+	case NI_IFTYPE_TAP:
+	case NI_IFTYPE_BRIDGE:
+	case NI_IFTYPE_SIT:
+	case NI_IFTYPE_GRE:
+	case NI_IFTYPE_IPIP:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static unsigned int
+__ni_system_interfaces_delete_group(ni_netconfig_t *nc)
+{
+	unsigned int group = NI_SYSTEM_DELETE_GROUP;
+	ni_netdev_t *dev;
+
+	for (dev = ni_netconfig_devlist(nc); dev; ) {
+		if (dev->link.group == group) {
+			group--;
+			dev = ni_netconfig_devlist(nc);
+		} else {
+			dev = dev->next;
+		}
+	}
+	return group;
+}
+
+static struct nl_msg *
+__ni_system_interfaces_delete_msg(int type, unsigned int ifindex, unsigned int group)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = ifindex;
+
+	msg = nlmsg_alloc_simple(type, 0);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+	if (type == RTM_SETLINK || group)
+		NLA_PUT_U32(msg, IFLA_GROUP, group);
+	return msg;
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return NULL;
+}
+
+int
+ni_system_interfaces_delete(ni_netconfig_t *nc, const ni_uint_array_t *ifindexes,
+				ni_uint_array_t *deleted)
+{
+	struct nl_msg **msgs, *msg;
+	ni_netdev_t **devs;
+	unsigned int i, n, count = 0, ndeleted = 0, group;
+	unsigned int *groups;
+	int *errors, rv = -1;
+
+	if (!nc || !ifindexes || !deleted)
+		return -1;
+	if (!ifindexes->count)
+		return 0;
+
+	msgs = xcalloc(ifindexes->count, sizeof(msgs[0]));
+	devs = xcalloc(ifindexes->count, sizeof(devs[0]));
+	errors = xcalloc(ifindexes->count, sizeof(errors[0]));
+	groups = xcalloc(ifindexes->count, sizeof(groups[0]));
+
+	group = __ni_system_interfaces_delete_group(nc);
+	for (i = 0; i < ifindexes->count; ++i) {
+		ni_netdev_t *dev = ni_netdev_by_index(nc, ifindexes->data[i]);
+
+		if (!dev || !__ni_system_interface_bulk_deletable(dev)) {
+			ni_debug_ifconfig("%s: skipping device with index %u",
+					__func__, ifindexes->data[i]);
+			continue;
+		}
+		if (!(msg = __ni_system_interfaces_delete_msg(RTM_SETLINK,
+						dev->link.ifindex, group)))
+			continue;
+
+		groups[count] = dev->link.group;
+		devs[count] = dev;
+		msgs[count++] = msg;
+	}
+
+	ni_debug_ifconfig("%s: deleting %u devices in link group %u",
+			__func__, count, group);
+	if (ni_nl_talk_batch(msgs, count, errors) >= 0 &&
+	    (msg = __ni_system_interfaces_delete_msg(RTM_DELLINK, 0, group))) {
+		rv = ni_nl_talk(msg, NULL);
+		nlmsg_free(msg);
+	}
+
+	for (i = 0; i < count; ++i)
+		nlmsg_free(msgs[i]);
+
+	/* fall back to delete the devices one by one, pipelined */
+	if (rv < 0) {
+		ni_debug_ifconfig("%s: link group delete failed, deleting one by one",
+				__func__);
+		for (i = 0, n = 0; i < count; ++i) {
+			msgs[n] = __ni_system_interfaces_delete_msg(RTM_DELLINK,
+						devs[i]->link.ifindex, 0);
+			if (msgs[n]) {
+				groups[n] = groups[i];
+				devs[n++] = devs[i];
+			}
+		}
+		count = n;
+		memset(errors, 0, count * sizeof(errors[0]));
+		ni_nl_talk_batch(msgs, count, errors);
+		for (i = 0; i < count; ++i)
+			nlmsg_free(msgs[i]);
+
+		/* move the devices still there back to their link group */
+		for (i = 0, n = 0; i < count; ++i) {
+			if (!errors[i] || errors[i] == ENODEV)
+				continue;
+			msgs[n] = __ni_system_interfaces_delete_msg(RTM_SETLINK,
+						devs[i]->link.ifindex, groups[i]);
+			if (msgs[n])
+				n++;
+		}
+		if (n && ni_nl_talk_batch(msgs, n, NULL) != 0)
+			ni_warn("%s: unable to restore the link group of some devices",
+					__func__);
+		for (i = 0; i < n; ++i)
+			nlmsg_free(msgs[i]);
+	}
+
+	for (i = 0; i < count; ++i) {
+
+		if (errors[i] && errors[i] != ENODEV) {
+			ni_error("could not destroy %s interface %s: %s",
+					ni_linktype_type_to_name(devs[i]->link.type),
+					devs[i]->name, strerror(errors[i]));
+			continue;
+		}
+
+		ni_client_state_drop(devs[i]->link.ifindex);
+		ni_uint_array_append(deleted, devs[i]->link.ifindex);
+		ndeleted++;
+	}
+
+	free(groups);
+	free(errors);
+	free(devs);
+	free(msgs);
+	return ndeleted;
+}
+
 /*
  * Create a VLAN interface
  */
@@ -4646,14 +4818,11 @@ failed:
 	return -1;
 }
 
-static int
-__ni_rtnl_send_deladdr(ni_netdev_t *dev, const ni_address_t *ap)
+static struct nl_msg *
+__ni_rtnl_deladdr_msg(const ni_netdev_t *dev, const ni_address_t *ap)
 {
 	struct ifaddrmsg ifa;
 	struct nl_msg *msg;
-	int err;
-
-	ni_debug_ifconfig("%s(%s/%u)", __FUNCTION__, ni_sockaddr_print(&ap->local_addr), ap->prefixlen);
 
 	memset(&ifa, 0, sizeof(ifa));
 	ifa.ifa_index = dev->link.ifindex;
@@ -4674,22 +4843,84 @@ __ni_rtnl_send_deladdr(ni_netdev_t *dev, const ni_address_t *ap)
 		if (addattr_sockaddr(msg, IFA_ADDRESS, &ap->local_addr))
 			goto nla_put_failure;
 	}
+	return msg;
+
+nla_put_failure:
+	ni_error("failed to encode netlink attr");
+	nlmsg_free(msg);
+	return NULL;
+}
+
+static int
+__ni_rtnl_send_deladdr(ni_netdev_t *dev, const ni_address_t *ap)
+{
+	struct nl_msg *msg;
+	int err;
+
+	ni_debug_ifconfig("%s(%s/%u)", __FUNCTION__, ni_sockaddr_print(&ap->local_addr), ap->prefixlen);
+
+	if (!(msg = __ni_rtnl_deladdr_msg(dev, ap)))
+		return -1;
 
 	if ((err = ni_nl_talk(msg, NULL)) < 0) {
 		ni_error("%s(%s/%u): rtnl_talk failed: %s", __func__,
 				ni_sockaddr_print(&ap->local_addr),
 				ap->prefixlen,  nl_geterror(err));
-		goto failed;
+		nlmsg_free(msg);
+		return -1;
 	}
 
 	nlmsg_free(msg);
 	return 0;
+}
 
-nla_put_failure:
-	ni_error("failed to encode netlink attr");
-failed:
-	nlmsg_free(msg);
-	return -1;
+/*
+ * Delete a set of addresses, sending the requests in one pipelined
+ * batch instead of waiting for the kernel to ack each one of them.
+ * Returns the number of addresses which could not be deleted.
+ */
+static int
+__ni_rtnl_send_deladdrs(ni_netdev_t *dev, const ni_address_array_t *addrs)
+{
+	struct nl_msg **msgs;
+	const ni_address_t **sent;
+	unsigned int i, count = 0;
+	int *errors, failed = 0;
+
+	if (!addrs->count)
+		return 0;
+
+	ni_debug_ifconfig("%s(%s): deleting %u addresses", __func__,
+			dev->name, addrs->count);
+
+	msgs = xcalloc(addrs->count, sizeof(msgs[0]));
+	sent = xcalloc(addrs->count, sizeof(sent[0]));
+	errors = xcalloc(addrs->count, sizeof(errors[0]));
+
+	for (i = 0; i < addrs->count; ++i) {
+		if (!(msgs[count] = __ni_rtnl_deladdr_msg(dev, addrs->data[i]))) {
+			failed++;
+			continue;
+		}
+		sent[count++] = addrs->data[i];
+	}
+
+	ni_nl_talk_batch(msgs, count, errors);
+	for (i = 0; i < count; ++i) {
+		nlmsg_free(msgs[i]);
+		if (!errors[i])
+			continue;
+
+		ni_error("%s: unable to delete address %s/%u: %s", dev->name,
+				ni_sockaddr_print(&sent[i]->local_addr),
+				sent[i]->prefixlen, strerror(errors[i]));
+		failed++;
+	}
+
+	free(errors);
+	free(sent);
+	free(msgs);
+	return failed;
 }
 
 /*
@@ -4905,16 +5136,11 @@ failed:
 	return -NI_ERROR_CANNOT_CONFIGURE_ROUTE;
 }
 
-static int
-__ni_rtnl_send_delroute(ni_netdev_t *dev, ni_route_t *rp)
+static struct nl_msg *
+__ni_rtnl_delroute_msg(const ni_netdev_t *dev, const ni_route_t *rp)
 {
-	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
 	struct rtmsg rt;
 	struct nl_msg *msg;
-	int err;
-
-	ni_debug_ifconfig("%s(%s)", __FUNCTION__, ni_route_print(&buf, rp));
-	ni_stringbuf_destroy(&buf);
 
 	memset(&rt, 0, sizeof(rt));
 	rt.rtm_family = rp->family;
@@ -4940,23 +5166,61 @@ __ni_rtnl_send_delroute(ni_netdev_t *dev, ni_route_t *rp)
 		goto nla_put_failure;
 
 	NLA_PUT_U32(msg, RTA_OIF, dev->link.ifindex);
-
-	if ((err = ni_nl_talk(msg, NULL)) < 0) {
-		ni_error("%s(%s): rtnl_talk failed[%d]: %s", __func__,
-				ni_route_print(&buf, rp),
-				err, nl_geterror(err));
-		ni_stringbuf_destroy(&buf);
-		goto failed;
-	}
-
-	nlmsg_free(msg);
-	return 0;
+	return msg;
 
 nla_put_failure:
 	ni_error("failed to encode netlink attr");
-failed:
 	nlmsg_free(msg);
-	return -1;
+	return NULL;
+}
+
+/*
+ * Delete a set of routes in one pipelined batch, like the addresses.
+ * Returns the number of routes which could not be deleted.
+ */
+static int
+__ni_rtnl_send_delroutes(ni_netdev_t *dev, const ni_route_array_t *routes)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	struct nl_msg **msgs;
+	const ni_route_t **sent;
+	unsigned int i, count = 0;
+	int *errors, failed = 0;
+
+	if (!routes->count)
+		return 0;
+
+	ni_debug_ifconfig("%s(%s): deleting %u routes", __func__,
+			dev->name, routes->count);
+
+	msgs = xcalloc(routes->count, sizeof(msgs[0]));
+	sent = xcalloc(routes->count, sizeof(sent[0]));
+	errors = xcalloc(routes->count, sizeof(errors[0]));
+
+	for (i = 0; i < routes->count; ++i) {
+		if (!(msgs[count] = __ni_rtnl_delroute_msg(dev, routes->data[i]))) {
+			failed++;
+			continue;
+		}
+		sent[count++] = routes->data[i];
+	}
+
+	ni_nl_talk_batch(msgs, count, errors);
+	for (i = 0; i < count; ++i) {
+		nlmsg_free(msgs[i]);
+		if (!errors[i])
+			continue;
+
+		ni_error("%s: unable to delete route %s: %s", dev->name,
+				ni_route_print(&buf, sent[i]), strerror(errors[i]));
+		ni_stringbuf_destroy(&buf);
+		failed++;
+	}
+
+	free(errors);
+	free(sent);
+	free(msgs);
+	return failed;
 }
 
 static int
@@ -5424,6 +5688,7 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 				ni_addrconf_updater_t     *updater)
 {
 	unsigned int max_changes = NI_ADDRCONF_UPDATER_MAX_ADDR_CHANGES;
+	ni_address_array_t deletes = NI_ADDRESS_ARRAY_INIT;
 	ni_addrconf_mode_t owner = NI_ADDRCONF_NONE;
 	ni_address_updater_t *au;
 	unsigned int family = AF_UNSPEC;
@@ -5544,11 +5809,14 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 				break;
 			else max_changes--;
 
-			if ((rv = __ni_rtnl_send_deladdr(dev, ap)) < 0)
-				continue;
+			/* deleted in one batch below */
+			ni_address_array_append(&deletes, ni_address_ref(ap));
 		}
 	}
 
+	__ni_rtnl_send_deladdrs(dev, &deletes);
+	ni_address_array_destroy(&deletes);
+
 	if (max_changes == 0)
 		return 1;
 
@@ -5669,6 +5937,7 @@ __ni_netdev_update_routes(ni_netconfig_t *nc, ni_netdev_t *dev,
 				ni_addrconf_lease_t       *new_lease)
 {
 	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_route_array_t deletes = NI_ROUTE_ARRAY_INIT;
 	ni_addrconf_mode_t old_type = NI_ADDRCONF_NONE;
 	unsigned int family = AF_UNSPEC;
 	ni_route_table_t *tab, *cfg_tab;
@@ -5767,12 +6036,14 @@ __ni_netdev_update_routes(ni_netconfig_t *nc, ni_netdev_t *dev,
 					dev->name, ni_route_print(&buf, rp));
 			ni_stringbuf_destroy(&buf);
 
-			if ((__ni_rtnl_send_delroute(dev, rp)) < 0) {
-				continue;
-			}
+			/* deleted in one batch below */
+			ni_route_array_append(&deletes, ni_route_ref(rp));
 		}
 	}
 
+	__ni_rtnl_send_delroutes(dev, &deletes);
+	ni_route_array_destroy(&deletes);
+
 	/* Loop over all tables and routes in the configuration
 	 * and create those that don't exist yet.
 	 */
@@ -8,11 +8,15 @@
 #include "config.h"
 #endif
 
+#include <sys/eventfd.h>
+#include <sys/poll.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 #include <netlink/msg.h>
 #include <netinet/icmp6.h>
+#include <linux/netlink.h>
 
 #include <wicked/types.h>
 #include <wicked/netinfo.h>
@@ -20,6 +24,7 @@
 #include <wicked/socket.h>
 #include <wicked/route.h>
 #include <wicked/ipv6.h>
+#include <wicked/netns.h>
 
 #include "netinfo_priv.h"
 #include "socket_priv.h"
@@ -55,16 +60,65 @@ struct ni_nd_opt_dnssl_info_p
 	unsigned char	nd_opt_dnssl_list[];
 };
 
+/*
+ * Optional ingestion thread draining the rtnetlink socket into a
+ * single producer, single consumer ring, which the main loop applies
+ * in batches -- so event bursts do not overflow the socket buffer
+ * while the main loop is busy with dbus or fsm work.
+ */
+#define NI_RTEVENT_INGEST_BATCH		128
+#define NI_RTEVENT_INGEST_RECV_LEN	65536
+
+typedef struct ni_rtevent_ingest_slot {
+	struct sockaddr_nl	sender;
+	int			nsid;
+	size_t			len;
+	unsigned char *		data;
+} ni_rtevent_ingest_slot_t;
+
+typedef struct ni_rtevent_ingest {
+	int			nlfd;
+	int			evfd;
+	int			stopfd;
+
+	pthread_t		thread;
+	ni_bool_t		running;
+
+	unsigned int		mask;
+	ni_rtevent_ingest_slot_t *ring;
+	unsigned int		head;		/* written by the thread only */
+	unsigned int		tail;		/* written by the main loop only */
+
+	int			overflow;	/* ENOBUFS seen, set by the thread */
+	int			failure;	/* errno the thread exited with */
+
+	struct {
+		unsigned long	received;
+		unsigned long	overflows;
+		unsigned long	truncated;
+		unsigned long	full_waits;
+		unsigned int	high_water;
+	} stats;
+} ni_rtevent_ingest_t;
+
 typedef struct ni_rtevent_handle
 {
+	ni_config_rtnl_event_class_t class;
 	struct nl_sock *nlsock;
 	ni_uint_array_t	groups;
+	ni_rtevent_ingest_t *ingest;
+	ni_bool_t	all_nsid;	/* events of the opened namespaces too */
+	unsigned char *	nsid_buf;
 } ni_rtevent_handle_t;
 
 /*
- * TODO: Move the socket somewhere else & add cleanup...
+ * The events are received on one socket per class, so a burst of route
+ * events can not overflow the buffer of the link and address events;
+ * before a batch of events of one class is processed, the pending events
+ * of all higher priority classes are (links, addresses, rules, routes).
  */
-static ni_socket_t *	__ni_rtevent_sock;
+static ni_socket_t *	__ni_rtevent_socks[NI_CONFIG_RTNL_EVENT_CLASS_MAX];
+static ni_bool_t	__ni_rtevent_all_nsid;
 
 static int	__ni_rtevent_process(ni_netconfig_t *, const struct sockaddr_nl *, struct nlmsghdr *);
 static int	__ni_rtevent_newlink(ni_netconfig_t *, const struct sockaddr_nl *, struct nlmsghdr *);
@@ -519,8 +573,10 @@ __ni_rtevent_deladdr(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 	}
 
 	/* Remove the address when we track it */
-	if ((ap = ni_address_list_find(dev->addrs, &tmp.local_addr)) != NULL)
+	if ((ap = ni_address_list_find(dev->addrs, &tmp.local_addr)) != NULL) {
 		__ni_address_list_remove(&dev->addrs, ap);
+		ni_netdev_addrs_changed(dev);
+	}
 
 	/* Tentative IPv6 addresses are not exposed via NEWADDR events,
 	 * but in manuall address lookup / dump only.
@@ -900,16 +956,25 @@ __ni_rtevent_nduseropt(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, str
 
 /*
  * Receive events from netlink socket and generate events.
+ *
+ * Events of other namespaces carry the id the own namespace uses for
+ * them; they are applied to the netconfig of the opened namespace and
+ * processed inside of it, so ioctls and sysctls reach the right device.
  */
 static int
-__ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
+__ni_rtevent_dispatch(const struct sockaddr_nl *sender, int nsid, struct nlmsghdr *nlh)
 {
-	const struct sockaddr_nl *sender = nlmsg_get_src(msg);
-	struct nlmsghdr *nlh;
+	ni_netns_t *ns = NULL;
 	ni_netconfig_t *nc;
+	int rv = NL_OK;
 
-	if ((nc = ni_global_state_handle(0)) == NULL)
-		return NL_SKIP;
+	if (nsid == NI_NETNS_ID_NONE || nsid == ni_netns_own_id()) {
+		if ((nc = ni_global_state_handle(0)) == NULL)
+			return NL_SKIP;
+	} else {
+		if (!(ns = ni_netns_by_id(nsid)) || !(nc = ni_netns_state_handle(ns, 0)))
+			return NL_SKIP;
+	}
 
 	if (sender->nl_pid != 0) {
 		ni_error("ignoring rtnetlink event message from PID %u",
@@ -917,48 +982,478 @@ __ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
 		return NL_SKIP;
 	}
 
-	nlh = nlmsg_hdr(msg);
-	if (__ni_rtevent_process(nc, sender, nlh) < 0) {
-		ni_debug_events("ignoring %s rtnetlink event",
-			ni_rtnl_msg_type_to_name(nlh->nlmsg_type, "unknown"));
+	if (ns && ni_netns_enter(ns) < 0)
 		return NL_SKIP;
+
+	if (__ni_rtevent_process(nc, sender, nlh) < 0) {
+		ni_debug_events("ignoring %s rtnetlink event%s%s",
+			ni_rtnl_msg_type_to_name(nlh->nlmsg_type, "unknown"),
+			ns ? " of netns " : "", ns ? ni_netns_name(ns) : "");
+		rv = NL_SKIP;
+	}
+
+	if (ns)
+		ni_netns_leave();
+	return rv;
+}
+
+static int
+__ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
+{
+	return __ni_rtevent_dispatch(nlmsg_get_src(msg), NI_NETNS_ID_NONE, nlmsg_hdr(msg));
+}
+
+/*
+ * Read one datagram, with the id of the namespace it originates from
+ * when the socket listens to all namespaces.
+ */
+static ssize_t
+__ni_rtevent_recvmsg(int fd, unsigned char *buf, size_t size,
+			struct sockaddr_nl *sender, int *nsid)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = { .iov_base = buf, .iov_len = size };
+	struct msghdr msg = {
+		.msg_name	= sender,
+		.msg_namelen	= sizeof(*sender),
+		.msg_iov	= &iov,
+		.msg_iovlen	= 1,
+		.msg_control	= cbuf,
+		.msg_controllen	= sizeof(cbuf),
+	};
+	struct cmsghdr *cmsg;
+	ssize_t len;
+
+	*nsid = NI_NETNS_ID_NONE;
+	if ((len = recvmsg(fd, &msg, MSG_DONTWAIT | MSG_TRUNC)) < 0)
+		return len;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_NETLINK &&
+		    cmsg->cmsg_type == NETLINK_LISTEN_ALL_NSID &&
+		    cmsg->cmsg_len >= CMSG_LEN(sizeof(int)))
+			memcpy(nsid, CMSG_DATA(cmsg), sizeof(int));
 	}
+	return len;
+}
+
+static void
+__ni_rtevent_apply(const struct sockaddr_nl *sender, int nsid,
+			unsigned char *data, size_t len)
+{
+	struct nlmsghdr *nlh;
+	int rem = len;
 
-	return NL_OK;
+	for (nlh = (struct nlmsghdr *)data; nlmsg_ok(nlh, rem);
+			nlh = nlmsg_next(nlh, &rem)) {
+		if (nlh->nlmsg_type < NLMSG_MIN_TYPE)
+			continue;
+		__ni_rtevent_dispatch(sender, nsid, nlh);
+	}
 }
 
 static ni_bool_t	__ni_rtevent_restart(ni_socket_t *sock);
+static void		__ni_rtevent_drain_higher(ni_config_rtnl_event_class_t);
 
+static const char *
+__ni_rtevent_class_name(const ni_socket_t *sock)
+{
+	const ni_rtevent_handle_t *handle = sock->user_data;
+
+	return handle ? ni_config_rtnl_event_class_to_name(handle->class) : "";
+}
+
+static void
+__ni_rtevent_recover(ni_socket_t *sock)
+{
+	if (__ni_rtevent_restart(sock)) {
+		ni_note("restarted rtnetlink event listener");
+	} else {
+		ni_error("unable to restart rtnetlink event listener");
+	}
+}
 
 /*
- * Receive netlink message and trigger processing by callback
+ * libnl does not pass on the namespace id of a message, so a socket
+ * listening to all namespaces is read directly.
+ */
+static int
+__ni_rtevent_read_all_nsid(ni_socket_t *sock, unsigned int batch)
+{
+	ni_rtevent_handle_t *handle = sock->user_data;
+	struct sockaddr_nl sender;
+	ssize_t len;
+	int nsid;
+
+	while (batch) {
+		len = __ni_rtevent_recvmsg(nl_socket_get_fd(handle->nlsock),
+				handle->nsid_buf, NI_RTEVENT_INGEST_RECV_LEN,
+				&sender, &nsid);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+
+			ni_error("rtnetlink %s event receive error: %m",
+					__ni_rtevent_class_name(sock));
+			__ni_rtevent_recover(sock);
+			return -1;
+		}
+		batch--;
+		if (len > NI_RTEVENT_INGEST_RECV_LEN) {
+			ni_warn("rtnetlink event message truncated, ignored");
+			continue;
+		}
+		__ni_rtevent_apply(&sender, nsid, handle->nsid_buf, len);
+	}
+	return 1;
+}
+
+/*
+ * Read up to batch datagrams and trigger processing by callback.
+ * Returns 1 when there may be more, 0 when the socket is drained
+ * and -1 on error, after the socket has been restarted.
+ */
+static int
+__ni_rtevent_read(ni_socket_t *sock, unsigned int batch)
+{
+	ni_rtevent_handle_t *handle = sock->user_data;
+	int ret;
+
+	if (!handle || !handle->nlsock)
+		return 0;
+
+	if (handle->all_nsid)
+		return __ni_rtevent_read_all_nsid(sock, batch);
+
+	while (batch) {
+		ret = nl_recvmsgs_default(handle->nlsock);
+		if (ret == -NLE_INTR)
+			continue;
+		if (ret == -NLE_AGAIN)
+			return 0;
+		if (ret < 0) {
+			ni_error("rtnetlink %s event receive error: %s (%m)",
+					__ni_rtevent_class_name(sock),
+					nl_geterror(ret));
+			__ni_rtevent_recover(sock);
+			return -1;
+		}
+		batch--;
+	}
+	return 1;
+}
+
+/*
+ * Receive netlink messages until the socket is drained
  */
 static void
 __ni_rtevent_receive(ni_socket_t *sock)
 {
 	ni_rtevent_handle_t *handle = sock->user_data;
-	int ret;
+	ni_config_rtnl_event_class_t class;
+
+	if (!handle)
+		return;
+
+	class = handle->class;
+	do {
+		__ni_rtevent_drain_higher(class);
+	} while (__ni_rtevent_read(sock, NI_RTEVENT_INGEST_BATCH) > 0);
+}
+
+/*
+ * rtnetlink event ingestion thread
+ */
+static void
+__ni_rtevent_ingest_wakeup(int fd)
+{
+	uint64_t one = 1;
+
+	/* a failing write means the counter is pending anyway */
+	if (write(fd, &one, sizeof(one)) < 0)
+		return;
+}
+
+static ni_bool_t
+__ni_rtevent_ingest_push(ni_rtevent_ingest_t *ingest, const struct sockaddr_nl *sender,
+			int nsid, const unsigned char *data, size_t len)
+{
+	ni_rtevent_ingest_slot_t *slot;
+	unsigned int head, tail, depth;
+
+	head = ingest->head;
+	tail = __atomic_load_n(&ingest->tail, __ATOMIC_ACQUIRE);
+	if (head - tail > ingest->mask)
+		return FALSE;
+
+	slot = &ingest->ring[head & ingest->mask];
+	if (!(slot->data = malloc(len)))
+		return FALSE;
+	memcpy(slot->data, data, len);
+	slot->len = len;
+	slot->sender = *sender;
+	slot->nsid = nsid;
+
+	__atomic_store_n(&ingest->head, head + 1, __ATOMIC_SEQ_CST);
+
+	depth = head + 1 - __atomic_load_n(&ingest->tail, __ATOMIC_SEQ_CST);
+	if (depth > ingest->stats.high_water)
+		ingest->stats.high_water = depth;
+
+	/* the main loop drains until empty, wake it up on the first entry only */
+	if (depth == 1)
+		__ni_rtevent_ingest_wakeup(ingest->evfd);
+	return TRUE;
+}
+
+static ni_bool_t
+__ni_rtevent_ingest_stopped(ni_rtevent_ingest_t *ingest, int timeout)
+{
+	struct pollfd pfd = { .fd = ingest->stopfd, .events = POLLIN };
+
+	return poll(&pfd, 1, timeout) > 0;
+}
+
+static void *
+__ni_rtevent_ingest_thread(void *user_data)
+{
+	ni_rtevent_ingest_t *ingest = user_data;
+	struct sockaddr_nl sender;
+	struct pollfd pfd[2];
+	unsigned char *buf;
+	ssize_t len;
+	int nsid;
+
+	if (!(buf = malloc(NI_RTEVENT_INGEST_RECV_LEN))) {
+		__atomic_store_n(&ingest->failure, ENOMEM, __ATOMIC_SEQ_CST);
+		__ni_rtevent_ingest_wakeup(ingest->evfd);
+		return NULL;
+	}
 
-	if (handle && handle->nlsock) {
-		do {
-			ret = nl_recvmsgs_default(handle->nlsock);
-		} while (ret == NLE_SUCCESS || ret == -NLE_INTR);
+	for (;;) {
+		pfd[0].fd = ingest->nlfd;
+		pfd[0].events = POLLIN;
+		pfd[0].revents = 0;
+		pfd[1].fd = ingest->stopfd;
+		pfd[1].events = POLLIN;
+		pfd[1].revents = 0;
 
-		switch (ret) {
-		case NLE_SUCCESS:
-		case -NLE_AGAIN:
+		if (poll(pfd, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
 			break;
+		}
+		if (pfd[1].revents)
+			goto done;
+		if (!pfd[0].revents)
+			continue;
 
-		default:
-			ni_error("rtnetlink event receive error: %s (%m)",
-					nl_geterror(ret));
-			if (__ni_rtevent_restart(sock)) {
-				ni_note("restarted rtnetlink event listener");
-			} else {
-				ni_error("unable to restart rtnetlink event listener");
+		for (;;) {
+			len = __ni_rtevent_recvmsg(ingest->nlfd, buf,
+					NI_RTEVENT_INGEST_RECV_LEN, &sender, &nsid);
+			if (len < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					break;
+				if (errno != ENOBUFS)
+					goto failed;
+
+				ingest->stats.overflows++;
+				__atomic_store_n(&ingest->overflow, 1, __ATOMIC_SEQ_CST);
+				__ni_rtevent_ingest_wakeup(ingest->evfd);
+				continue;
+			}
+			if (len > NI_RTEVENT_INGEST_RECV_LEN) {
+				ingest->stats.truncated++;
+				continue;
 			}
+
+			ingest->stats.received++;
+			while (!__ni_rtevent_ingest_push(ingest, &sender, nsid, buf, len)) {
+				/* back-pressure: the main loop is behind */
+				ingest->stats.full_waits++;
+				if (__ni_rtevent_ingest_stopped(ingest, 1))
+					goto done;
+			}
+		}
+	}
+
+failed:
+	__atomic_store_n(&ingest->failure, errno ? errno : EIO, __ATOMIC_SEQ_CST);
+	__ni_rtevent_ingest_wakeup(ingest->evfd);
+done:
+	free(buf);
+	return NULL;
+}
+
+static ni_rtevent_ingest_t *
+__ni_rtevent_ingest_new(int nlfd, unsigned int length)
+{
+	ni_rtevent_ingest_t *ingest;
+	unsigned int size;
+
+	for (size = 2; size < length && size < (1U << 30); size <<= 1)
+		;
+
+	if (!(ingest = calloc(1, sizeof(*ingest))))
+		return NULL;
+
+	ingest->nlfd = nlfd;
+	ingest->mask = size - 1;
+	ingest->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	ingest->stopfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	ingest->ring = calloc(size, sizeof(ingest->ring[0]));
+	if (ingest->evfd < 0 || ingest->stopfd < 0 || !ingest->ring) {
+		if (ingest->evfd >= 0)
+			close(ingest->evfd);
+		if (ingest->stopfd >= 0)
+			close(ingest->stopfd);
+		free(ingest->ring);
+		free(ingest);
+		return NULL;
+	}
+	return ingest;
+}
+
+static ni_bool_t
+__ni_rtevent_ingest_start(ni_rtevent_ingest_t *ingest)
+{
+	int err;
+
+	if ((err = pthread_create(&ingest->thread, NULL,
+				__ni_rtevent_ingest_thread, ingest)) != 0) {
+		ni_error("Cannot start rtnetlink event ingest thread: %s", strerror(err));
+		return FALSE;
+	}
+	ingest->running = TRUE;
+	ni_debug_events("started rtnetlink event ingest thread, queue length %u",
+			ingest->mask + 1);
+	return TRUE;
+}
+
+static void
+__ni_rtevent_ingest_stop(ni_rtevent_ingest_t *ingest)
+{
+	if (!ingest || !ingest->running)
+		return;
+
+	__ni_rtevent_ingest_wakeup(ingest->stopfd);
+	pthread_join(ingest->thread, NULL);
+	ingest->running = FALSE;
+
+	ni_debug_events("rtnetlink event ingest: %lu received, %lu overflows, "
+			"%lu truncated, %lu queue full waits, %u high water",
+			ingest->stats.received, ingest->stats.overflows,
+			ingest->stats.truncated, ingest->stats.full_waits,
+			ingest->stats.high_water);
+}
+
+static void
+__ni_rtevent_ingest_free(ni_rtevent_ingest_t *ingest)
+{
+	if (!ingest)
+		return;
+
+	__ni_rtevent_ingest_stop(ingest);
+	for (; ingest->tail != ingest->head; ingest->tail++)
+		free(ingest->ring[ingest->tail & ingest->mask].data);
+
+	close(ingest->evfd);
+	close(ingest->stopfd);
+	free(ingest->ring);
+	free(ingest);
+}
+
+/*
+ * Apply a batch of queued events in the main loop. Returns 1 when
+ * there are more, 0 when the queue is empty and -1 on error, after
+ * the socket has been restarted.
+ */
+static int
+__ni_rtevent_ingest_apply(ni_socket_t *sock, unsigned int batch)
+{
+	ni_rtevent_handle_t *handle = sock->user_data;
+	ni_rtevent_ingest_t *ingest = handle ? handle->ingest : NULL;
+	ni_rtevent_ingest_slot_t *slot;
+	unsigned int tail, n;
+	int err;
+
+	if (!ingest)
+		return 0;
+
+	tail = ingest->tail;
+	for (n = 0; n < batch; ++n) {
+		if (tail == __atomic_load_n(&ingest->head, __ATOMIC_ACQUIRE))
 			break;
+
+		slot = &ingest->ring[tail & ingest->mask];
+		__ni_rtevent_apply(&slot->sender, slot->nsid, slot->data, slot->len);
+		free(slot->data);
+		slot->data = NULL;
+
+		__atomic_store_n(&ingest->tail, ++tail, __ATOMIC_SEQ_CST);
+	}
+
+	err = __atomic_load_n(&ingest->failure, __ATOMIC_SEQ_CST);
+	if (err || __atomic_load_n(&ingest->overflow, __ATOMIC_SEQ_CST)) {
+		__ni_rtevent_ingest_stop(ingest);
+		ni_error("rtnetlink %s event receive error: %s",
+				__ni_rtevent_class_name(sock),
+				err ? strerror(err) : strerror(ENOBUFS));
+		__ni_rtevent_recover(sock);
+		return -1;
+	}
+	return tail != __atomic_load_n(&ingest->head, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Re-arm the eventfd when there are more queued events than a batch,
+ * so other sockets get their turn.
+ */
+static void
+__ni_rtevent_ingest_receive(ni_socket_t *sock)
+{
+	ni_rtevent_handle_t *handle = sock->user_data;
+	uint64_t count;
+
+	if (!handle || !handle->ingest)
+		return;
+
+	if (read(sock->__fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		ni_error("unable to read rtnetlink event ingest counter: %m");
+
+	__ni_rtevent_drain_higher(handle->class);
+	if (__ni_rtevent_ingest_apply(sock, NI_RTEVENT_INGEST_BATCH) > 0)
+		__ni_rtevent_ingest_wakeup(sock->__fd);
+}
+
+/*
+ * Process the pending events of the classes with a higher priority;
+ * after each batch of a class, the ones before it are checked again.
+ */
+static void
+__ni_rtevent_drain_higher(ni_config_rtnl_event_class_t class)
+{
+	ni_rtevent_handle_t *handle;
+	ni_socket_t *sock;
+	unsigned int c;
+	int ret;
+
+	for (c = 0; c < class; ) {
+		if (!(sock = __ni_rtevent_socks[c]) || !(handle = sock->user_data)) {
+			c++;
+			continue;
 		}
+
+		if (handle->ingest)
+			ret = __ni_rtevent_ingest_apply(sock, NI_RTEVENT_INGEST_BATCH);
+		else
+			ret = __ni_rtevent_read(sock, NI_RTEVENT_INGEST_BATCH);
+
+		c = ret > 0 ? 0 : c + 1;
 	}
 }
 
@@ -971,6 +1466,8 @@ __ni_rtevent_close(ni_socket_t *sock)
 	ni_rtevent_handle_t *handle = sock->user_data;
 
 	if (handle) {
+		__ni_rtevent_ingest_free(handle->ingest);
+		handle->ingest = NULL;
 		if (handle->nlsock) {
 			nl_socket_free(handle->nlsock);
 			handle->nlsock = NULL;
@@ -979,20 +1476,27 @@ __ni_rtevent_close(ni_socket_t *sock)
 }
 
 static inline ni_rtevent_handle_t *
-__ni_rtevent_handle_new(void)
+__ni_rtevent_handle_new(ni_config_rtnl_event_class_t class)
 {
-	return calloc(1, sizeof(ni_rtevent_handle_t));
+	ni_rtevent_handle_t *handle;
+
+	if ((handle = calloc(1, sizeof(ni_rtevent_handle_t))))
+		handle->class = class;
+	return handle;
 }
 
 static void
 __ni_rtevent_handle_free(ni_rtevent_handle_t *handle)
 {
 	if (handle) {
+		__ni_rtevent_ingest_free(handle->ingest);
+		handle->ingest = NULL;
 		if (handle->nlsock) {
 			nl_socket_free(handle->nlsock);
 			handle->nlsock = NULL;
 		}
 		ni_uint_array_destroy(&handle->groups);
+		free(handle->nsid_buf);
 		free(handle);
 	}
 }
@@ -1021,6 +1525,31 @@ __ni_rtevent_join_group(ni_rtevent_handle_t *handle, unsigned int group)
 	return TRUE;
 }
 
+static ni_bool_t
+__ni_rtevent_listen_all_nsid(ni_rtevent_handle_t *handle)
+{
+	int on = 1;
+
+	if (!handle || !handle->nlsock)
+		return FALSE;
+
+	if (handle->all_nsid)
+		return TRUE;
+
+	if (!handle->nsid_buf && !(handle->nsid_buf = malloc(NI_RTEVENT_INGEST_RECV_LEN))) {
+		ni_error("Unable to allocate rtnetlink event buffer: %m");
+		return FALSE;
+	}
+
+	if (setsockopt(nl_socket_get_fd(handle->nlsock), SOL_NETLINK,
+				NETLINK_LISTEN_ALL_NSID, &on, sizeof(on)) < 0) {
+		ni_error("Cannot listen to rtnetlink events of all namespaces: %m");
+		return FALSE;
+	}
+	handle->all_nsid = TRUE;
+	return TRUE;
+}
+
 static void
 __ni_rtevent_sock_error_handler(ni_socket_t *sock)
 {
@@ -1039,9 +1568,15 @@ __ni_rtevent_sock_release_data(void *user_data)
 }
 
 static unsigned int
-__ni_rtevent_config_recv_buff_len(void)
+__ni_rtevent_config_recv_buff_len(ni_config_rtnl_event_class_t class)
 {
-	return ni_global.config ? ni_global.config->rtnl_event.recv_buff_length : 0;
+	const ni_config_rtnl_event_t *conf;
+
+	if (!ni_global.config)
+		return 0;
+
+	conf = &ni_global.config->rtnl_event;
+	return conf->class_recv_buff_length[class] ?: conf->recv_buff_length;
 }
 
 static unsigned int
@@ -1050,16 +1585,23 @@ __ni_rtevent_config_mesg_buff_len(void)
 	return ni_global.config ? ni_global.config->rtnl_event.mesg_buff_length : 0;
 }
 
+static unsigned int
+__ni_rtevent_config_ingest_queue_len(void)
+{
+	return ni_global.config ? ni_global.config->rtnl_event.ingest_queue_length : 0;
+}
+
 static ni_socket_t *
-__ni_rtevent_sock_open(void)
+__ni_rtevent_sock_open(ni_config_rtnl_event_class_t class)
 {
-	unsigned int recv_buff_len = __ni_rtevent_config_recv_buff_len();
+	unsigned int recv_buff_len = __ni_rtevent_config_recv_buff_len(class);
 	unsigned int mesg_buff_len = __ni_rtevent_config_mesg_buff_len();
+	unsigned int ingest_len = __ni_rtevent_config_ingest_queue_len();
 	ni_rtevent_handle_t *handle;
 	ni_socket_t *sock;
 	int fd, ret;
 
-	if (!(handle = __ni_rtevent_handle_new())) {
+	if (!(handle = __ni_rtevent_handle_new(class))) {
 		ni_error("Unable to allocate rtnetlink event handle: %m");
 		return NULL;
 	}
@@ -1090,7 +1632,17 @@ __ni_rtevent_sock_open(void)
 	nl_socket_set_nonblocking(handle->nlsock);
 
 	fd = nl_socket_get_fd(handle->nlsock);
-	if (!(sock = ni_socket_wrap(fd, SOCK_DGRAM))) {
+	if (ingest_len && (handle->ingest = __ni_rtevent_ingest_new(fd, ingest_len))) {
+		if (!__ni_rtevent_ingest_start(handle->ingest)) {
+			__ni_rtevent_ingest_free(handle->ingest);
+			handle->ingest = NULL;
+		}
+	}
+	if (ingest_len && !handle->ingest)
+		ni_warn("Cannot start rtnetlink event ingest thread, reading events inline");
+
+	/* with an ingest thread, the main loop waits on its queue eventfd */
+	if (!(sock = ni_socket_wrap(handle->ingest ? handle->ingest->evfd : fd, SOCK_DGRAM))) {
 		ni_error("Cannot wrap rtnetlink event socket: %m");
 		__ni_rtevent_handle_free(handle);
 		return NULL;
@@ -1101,11 +1653,11 @@ __ni_rtevent_sock_open(void)
 				(char *)&recv_buff_len, sizeof(recv_buff_len)) &&
 		    setsockopt(fd, SOL_SOCKET, SO_RCVBUF,
 				(char *)&recv_buff_len, sizeof(recv_buff_len))) {
-			ni_warn("Unable to set netlink event receive buffer to %u bytes: %m",
-					recv_buff_len);
+			ni_warn("Unable to set netlink %s event receive buffer to %u bytes: %m",
+					ni_config_rtnl_event_class_to_name(class), recv_buff_len);
 		} else {
-			ni_info("Using netlink event receive buffer of %u bytes",
-					recv_buff_len);
+			ni_info("Using netlink %s event receive buffer of %u bytes",
+					ni_config_rtnl_event_class_to_name(class), recv_buff_len);
 		}
 	}
 	if (mesg_buff_len) {
@@ -1123,59 +1675,157 @@ __ni_rtevent_sock_open(void)
 	sock->close	= __ni_rtevent_close;
 	sock->handle_error  = __ni_rtevent_sock_error_handler;
 	sock->release_user_data = __ni_rtevent_sock_release_data;
+	if (handle->ingest)
+		sock->receive = __ni_rtevent_ingest_receive;
 	return sock;
 }
 
+/*
+ * Replace the socket by a new one of the same event class; the old one
+ * is released either way.
+ */
 static ni_bool_t
 __ni_rtevent_restart(ni_socket_t *sock)
 {
 	ni_rtevent_handle_t *handle = sock->user_data;
-	if (handle) {
-		if ((__ni_rtevent_sock = __ni_rtevent_sock_open())) {
-			const ni_uint_array_t *groups = &handle->groups;
-			unsigned int i;
+	ni_config_rtnl_event_class_t class;
+	ni_socket_t *nsock;
+	unsigned int i;
 
-			handle = __ni_rtevent_sock->user_data;
-			for (i = 0; i < groups->count; ++i) {
-				__ni_rtevent_join_group(handle, groups->data[i]);
-			}
-			ni_socket_activate(__ni_rtevent_sock);
-			return TRUE;
+	if (!handle || __ni_rtevent_socks[handle->class] != sock)
+		return FALSE;
+
+	class = handle->class;
+	if ((nsock = __ni_rtevent_sock_open(class))) {
+		for (i = 0; i < handle->groups.count; ++i)
+			__ni_rtevent_join_group(nsock->user_data, handle->groups.data[i]);
+		if (handle->all_nsid)
+			__ni_rtevent_listen_all_nsid(nsock->user_data);
+		ni_socket_activate(nsock);
+	}
+
+	__ni_rtevent_socks[class] = nsock;
+	ni_socket_deactivate(sock);
+	ni_socket_release(sock);
+	return nsock != NULL;
+}
+
+static ni_config_rtnl_event_class_t
+__ni_rtevent_group_class(unsigned int group)
+{
+	switch (group) {
+	case RTNLGRP_LINK:
+	case RTNLGRP_IPV6_IFINFO:
+		return NI_CONFIG_RTNL_EVENT_LINK;
+
+	case RTNLGRP_IPV4_IFADDR:
+	case RTNLGRP_IPV6_IFADDR:
+	case RTNLGRP_IPV6_PREFIX:
+	case RTNLGRP_ND_USEROPT:
+		return NI_CONFIG_RTNL_EVENT_ADDR;
+
+	case RTNLGRP_IPV4_RULE:
+	case RTNLGRP_IPV6_RULE:
+		return NI_CONFIG_RTNL_EVENT_RULE;
+
+	default:
+		return NI_CONFIG_RTNL_EVENT_ROUTE;
+	}
+}
+
+/*
+ * Join the group on the socket of its event class, opened on demand
+ */
+static ni_bool_t
+__ni_rtevent_join(unsigned int group)
+{
+	ni_config_rtnl_event_class_t class = __ni_rtevent_group_class(group);
+	ni_socket_t *sock;
+
+	if (!(sock = __ni_rtevent_socks[class])) {
+		if (!(sock = __ni_rtevent_sock_open(class)))
+			return FALSE;
+
+		if (__ni_rtevent_all_nsid && !__ni_rtevent_listen_all_nsid(sock->user_data)) {
+			ni_socket_release(sock);
+			return FALSE;
 		}
+		__ni_rtevent_socks[class] = sock;
+		ni_socket_activate(sock);
+	}
+	return __ni_rtevent_join_group(sock->user_data, group);
+}
+
+static void
+__ni_rtevent_close_all(void)
+{
+	unsigned int class;
+	ni_socket_t *sock;
+
+	for (class = 0; class < NI_CONFIG_RTNL_EVENT_CLASS_MAX; ++class) {
+		if (!(sock = __ni_rtevent_socks[class]))
+			continue;
+
+		__ni_rtevent_socks[class] = NULL;
+		ni_socket_deactivate(sock);
 		ni_socket_release(sock);
 	}
-	return FALSE;
+	__ni_rtevent_all_nsid = FALSE;
+}
+
+static inline ni_bool_t
+__ni_rtevent_enabled(void)
+{
+	return __ni_rtevent_socks[NI_CONFIG_RTNL_EVENT_LINK] != NULL;
 }
 
 /*
- * Embed rtnetlink socket into ni_socket_t and set ifevent handler
+ * Embed rtnetlink sockets into ni_socket_t and set ifevent handler
  */
 int
 ni_server_listen_interface_events(void (*ifevent_handler)(ni_netdev_t *, ni_event_t))
 {
-	ni_rtevent_handle_t *handle;
 	unsigned int family;
 
-	if (__ni_rtevent_sock || ni_global.interface_event) {
+	if (__ni_rtevent_enabled() || ni_global.interface_event) {
 		ni_error("Interface event handler is already set");
 		return -1;
 	}
 
-	if (!(__ni_rtevent_sock = __ni_rtevent_sock_open()))
-		return -1;
-
 	family = ni_netconfig_get_family_filter(ni_global_state_handle(0));
-	handle = __ni_rtevent_sock->user_data;
 	/* TODO: Move IPv6 info to separate function, dhcp4 does not need it */
-	if (!__ni_rtevent_join_group(handle, RTNLGRP_LINK) ||
+	if (!__ni_rtevent_join(RTNLGRP_LINK) ||
 	    (family != AF_INET &&
-	     !__ni_rtevent_join_group(handle, RTNLGRP_IPV6_IFINFO))) {
-		ni_socket_release(__ni_rtevent_sock);
-		__ni_rtevent_sock = NULL;
+	     !__ni_rtevent_join(RTNLGRP_IPV6_IFINFO))) {
+		__ni_rtevent_close_all();
 		return -1;
 	}
 	ni_global.interface_event = ifevent_handler;
-	ni_socket_activate(__ni_rtevent_sock);
+	return 0;
+}
+
+/*
+ * Receive the events of the opened network namespaces on the event
+ * sockets as well. The kernel sends them only for namespaces, which
+ * have an id in the own namespace -- ni_netns_open assigns one.
+ */
+int
+ni_server_enable_netns_events(void)
+{
+	unsigned int class;
+	ni_socket_t *sock;
+
+	if (!__ni_rtevent_enabled()) {
+		ni_error("Event monitor not enabled");
+		return -1;
+	}
+
+	__ni_rtevent_all_nsid = TRUE;
+	for (class = 0; class < NI_CONFIG_RTNL_EVENT_CLASS_MAX; ++class) {
+		if ((sock = __ni_rtevent_socks[class]) &&
+		    !__ni_rtevent_listen_all_nsid(sock->user_data))
+			return -1;
+	}
 	return 0;
 }
 
@@ -1196,20 +1846,18 @@ ni_server_trace_interface_addr_events(ni_netdev_t *dev, ni_event_t event, const
 int
 ni_server_enable_interface_addr_events(void (*ifaddr_handler)(ni_netdev_t *, ni_event_t, const ni_address_t *))
 {
-	ni_rtevent_handle_t *handle;
 	unsigned int family;
 
-	if (!__ni_rtevent_sock || ni_global.interface_addr_event) {
+	if (!__ni_rtevent_enabled() || ni_global.interface_addr_event) {
 		ni_error("Interface address event handler already set");
 		return -1;
 	}
 
 	family = ni_netconfig_get_family_filter(ni_global_state_handle(0));
-	handle = __ni_rtevent_sock->user_data;
 	if ((family != AF_INET6 &&
-	     !__ni_rtevent_join_group(handle, RTNLGRP_IPV4_IFADDR)) ||
+	     !__ni_rtevent_join(RTNLGRP_IPV4_IFADDR)) ||
 	    (family != AF_INET  &&
-	     !__ni_rtevent_join_group(handle, RTNLGRP_IPV6_IFADDR))) {
+	     !__ni_rtevent_join(RTNLGRP_IPV6_IFADDR))) {
 		ni_error("Cannot add rtnetlink address event membership: %m");
 		return -1;
 	}
@@ -1242,15 +1890,12 @@ ni_server_trace_interface_prefix_events(ni_netdev_t *dev, ni_event_t event, cons
 int
 ni_server_enable_interface_prefix_events(void (*ifprefix_handler)(ni_netdev_t *, ni_event_t, const ni_ipv6_ra_pinfo_t *))
 {
-	ni_rtevent_handle_t *handle;
-
-	if (!__ni_rtevent_sock || ni_global.interface_prefix_event) {
+	if (!__ni_rtevent_enabled() || ni_global.interface_prefix_event) {
 		ni_error("Interface prefix event handler already set");
 		return -1;
 	}
 
-	handle = __ni_rtevent_sock->user_data;
-	if (!__ni_rtevent_join_group(handle, RTNLGRP_IPV6_PREFIX)) {
+	if (!__ni_rtevent_join(RTNLGRP_IPV6_PREFIX)) {
 		ni_error("Cannot add rtnetlink prefix event membership: %m");
 		return -1;
 	}
@@ -1318,15 +1963,12 @@ ni_server_trace_interface_nduseropt_events(ni_netdev_t *dev, ni_event_t event)
 int
 ni_server_enable_interface_nduseropt_events(void (*ifnduseropt_handler)(ni_netdev_t *, ni_event_t))
 {
-	ni_rtevent_handle_t *handle;
-
-	if (!__ni_rtevent_sock || ni_global.interface_nduseropt_event) {
+	if (!__ni_rtevent_enabled() || ni_global.interface_nduseropt_event) {
 		ni_error("Interface ND user opt event handler already set");
 		return -1;
 	}
 
-	handle = __ni_rtevent_sock->user_data;
-	if (!__ni_rtevent_join_group(handle, RTNLGRP_ND_USEROPT)) {
+	if (!__ni_rtevent_join(RTNLGRP_ND_USEROPT)) {
 		ni_error("Cannot add rtnetlink nd user opt event membership: %m");
 		return -1;
 	}
@@ -1360,9 +2002,7 @@ ni_server_trace_route_events(ni_netconfig_t *nc, ni_event_t event, const ni_rout
 int
 ni_server_enable_route_events(void (*route_handler)(ni_netconfig_t *, ni_event_t, const ni_route_t *))
 {
-	ni_rtevent_handle_t *handle;
-
-	if (!__ni_rtevent_sock) {
+	if (!__ni_rtevent_enabled()) {
 		ni_error("Event monitor not enabled");
 		return -1;
 	}
@@ -1371,9 +2011,8 @@ ni_server_enable_route_events(void (*route_handler)(ni_netconfig_t *, ni_event_t
 		return 1;
 	}
 
-	handle = __ni_rtevent_sock->user_data;
-	if (!__ni_rtevent_join_group(handle, RTNLGRP_IPV4_ROUTE) ||
-	    !__ni_rtevent_join_group(handle, RTNLGRP_IPV6_ROUTE)) {
+	if (!__ni_rtevent_join(RTNLGRP_IPV4_ROUTE) ||
+	    !__ni_rtevent_join(RTNLGRP_IPV6_ROUTE)) {
 		ni_error("Cannot add rtnetlink route event membership: %m");
 		return -1;
 	}
@@ -1381,6 +2020,12 @@ ni_server_enable_route_events(void (*route_handler)(ni_netconfig_t *, ni_event_t
 	return 0;
 }
 
+ni_bool_t
+ni_server_listens_route_events(void)
+{
+	return ni_global.route_event != NULL;
+}
+
 void
 ni_server_trace_rule_events(ni_netconfig_t *nc, ni_event_t event, const ni_rule_t *rule)
 {
@@ -1407,9 +2052,7 @@ ni_server_trace_rule_events(ni_netconfig_t *nc, ni_event_t event, const ni_rule_
 int
 ni_server_enable_rule_events(void (*rule_handler)(ni_netconfig_t *, ni_event_t, const ni_rule_t *))
 {
-	ni_rtevent_handle_t *handle;
-
-	if (!__ni_rtevent_sock) {
+	if (!__ni_rtevent_enabled()) {
 		ni_error("Event monitor not enabled");
 		return -1;
 	}
@@ -1418,9 +2061,8 @@ ni_server_enable_rule_events(void (*rule_handler)(ni_netconfig_t *, ni_event_t,
 		return 1;
 	}
 
-	handle = __ni_rtevent_sock->user_data;
-	if (!__ni_rtevent_join_group(handle, RTNLGRP_IPV4_RULE) ||
-	    !__ni_rtevent_join_group(handle, RTNLGRP_IPV6_RULE)) {
+	if (!__ni_rtevent_join(RTNLGRP_IPV4_RULE) ||
+	    !__ni_rtevent_join(RTNLGRP_IPV6_RULE)) {
 		ni_error("Cannot add rtnetlink rule event membership: %m");
 		return -1;
 	}
@@ -1433,13 +2075,7 @@ ni_server_deactivate_interface_events(void)
 {
 	ni_server_deactivate_interface_uevents();
 
-	if (__ni_rtevent_sock) {
-		ni_socket_t *sock = __ni_rtevent_sock;
-		__ni_rtevent_sock = NULL;
-
-		ni_socket_deactivate(sock);
-		ni_socket_release(sock);
-	}
+	__ni_rtevent_close_all();
 	ni_global.rule_event = NULL;
 	ni_global.route_event = NULL;
 	ni_global.interface_event = NULL;
@@ -330,19 +330,22 @@ ni_address_list_reset_seq(ni_address_t *addrs)
 		ap->seq = 0;
 }
 
-static void
+static ni_bool_t
 ni_address_list_drop_by_seq(ni_address_t **tail, unsigned int seq)
 {
+	ni_bool_t dropped = FALSE;
 	ni_address_t *ap;
 
 	while ((ap = *tail)) {
 		if (ap->seq != seq) {
 			*tail = ap->next;
 			ni_address_free(ap);
+			dropped = TRUE;
 		} else {
 			tail = &ap->next;
 		}
 	}
+	return dropped;
 }
 
 static void
@@ -364,9 +367,10 @@ ni_route_tables_reset_seq(ni_route_table_t *tab)
 		ni_route_array_reset_seq(&tab->routes);
 }
 
-static void
+static ni_bool_t
 ni_route_array_drop_by_seq(ni_netconfig_t *nc, ni_route_array_t *routes, unsigned int seq)
 {
+	ni_bool_t dropped = FALSE;
 	unsigned int i;
 	ni_route_t *rp;
 
@@ -376,18 +380,25 @@ ni_route_array_drop_by_seq(ni_netconfig_t *nc, ni_route_array_t *routes, unsigne
 			if (ni_route_array_remove(routes, i) == rp) {
 				ni_netconfig_route_del(nc, rp, NULL);
 				ni_route_free(rp);
+				dropped = TRUE;
 				continue;
 			}
 		}
 		i++;
 	}
+	return dropped;
 }
 
-static void
+static ni_bool_t
 ni_route_tables_drop_by_seq(ni_netconfig_t *nc, ni_route_table_t *tab, unsigned int seq)
 {
-	for ( ; tab; tab = tab->next)
-		ni_route_array_drop_by_seq(nc, &tab->routes, seq);
+	ni_bool_t dropped = FALSE;
+
+	for ( ; tab; tab = tab->next) {
+		if (ni_route_array_drop_by_seq(nc, &tab->routes, seq))
+			dropped = TRUE;
+	}
+	return dropped;
 }
 
 static void
@@ -636,8 +647,10 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 	/* Cull any interfaces that went away */
 	tail = ni_netconfig_device_list_head(nc);
 	while ((dev = *tail) != NULL) {
-		ni_address_list_drop_by_seq(&dev->addrs, seqno);
-		ni_route_tables_drop_by_seq(nc, dev->routes, seqno);
+		if (ni_address_list_drop_by_seq(&dev->addrs, seqno))
+			ni_netdev_addrs_changed(dev);
+		if (ni_route_tables_drop_by_seq(nc, dev->routes, seqno))
+			ni_netdev_routes_changed(dev);
 		if (dev->seq != seqno) {
 			*tail = dev->next;
 			if (del_list == NULL) {
@@ -724,7 +737,8 @@ __ni_system_refresh_interface(ni_netconfig_t *nc, ni_netdev_t *dev)
 		if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
 			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
 	}
-	ni_address_list_drop_by_seq(&dev->addrs, dev->seq);
+	if (ni_address_list_drop_by_seq(&dev->addrs, dev->seq))
+		ni_netdev_addrs_changed(dev);
 
 	while (1) {
 		struct rtmsg *rtm;
@@ -735,7 +749,8 @@ __ni_system_refresh_interface(ni_netconfig_t *nc, ni_netdev_t *dev)
 		if (__ni_netdev_process_newroute(dev, h, rtm, nc) < 0)
 			ni_error("Problem parsing RTM_NEWROUTE message");
 	}
-	ni_route_tables_drop_by_seq(nc, dev->routes, dev->seq);
+	if (ni_route_tables_drop_by_seq(nc, dev->routes, dev->seq))
+		ni_netdev_routes_changed(dev);
 
 	res = 0;
 
@@ -786,8 +801,10 @@ __ni_system_refresh_addrs(ni_netconfig_t *nc, unsigned int family)
 			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
 	}
 
-	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
-		ni_address_list_drop_by_seq(&dev->addrs, seqno);
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (ni_address_list_drop_by_seq(&dev->addrs, seqno))
+			ni_netdev_addrs_changed(dev);
+	}
 
 	res = 0;
 
@@ -824,7 +841,8 @@ __ni_system_refresh_interface_addrs(ni_netconfig_t *nc, ni_netdev_t *dev)
 		if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
 			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
 	}
-	ni_address_list_drop_by_seq(&dev->addrs, dev->seq);
+	if (ni_address_list_drop_by_seq(&dev->addrs, dev->seq))
+		ni_netdev_addrs_changed(dev);
 
 	res = 0;
 
@@ -906,8 +924,10 @@ __ni_system_refresh_routes(ni_netconfig_t *nc)
 			ni_error("Problem parsing RTM_NEWROUTE message");
 	}
 
-	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
-		ni_route_tables_drop_by_seq(nc, dev->routes, seqno);
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (ni_route_tables_drop_by_seq(nc, dev->routes, seqno))
+			ni_netdev_routes_changed(dev);
+	}
 
 	res = 0;
 
@@ -944,7 +964,8 @@ __ni_system_refresh_interface_routes(ni_netconfig_t *nc, ni_netdev_t *dev)
 		if (__ni_netdev_process_newroute(dev, h, rtm, nc) < 0)
 			ni_error("Problem parsing RTM_NEWROUTE message");
 	}
-	ni_route_tables_drop_by_seq(nc, dev->routes, dev->seq);
+	if (ni_route_tables_drop_by_seq(nc, dev->routes, dev->seq))
+		ni_netdev_routes_changed(dev);
 
 	res = 0;
 
@@ -954,6 +975,39 @@ failed:
 }
 
 
+/*
+ * Retrieve the routes of an interface without merging them into its
+ * route tables, e.g. to flush them.
+ */
+int
+__ni_system_query_interface_routes(ni_netconfig_t *nc, ni_netdev_t *dev, ni_route_array_t *routes)
+{
+	struct ni_rtnl_query query;
+	struct nlmsghdr *h;
+	struct rtmsg *rtm;
+	ni_route_t *rp;
+
+	if (ni_rtnl_query_route_info(&query, ni_netconfig_get_family_filter(nc)) < 0) {
+		ni_rtnl_query_destroy(&query);
+		return -1;
+	}
+
+	while ((rtm = ni_rtnl_query_next_route_info(&query, &h))) {
+		if (ni_rtnl_route_filter_msg(rtm))
+			continue;
+
+		rp = ni_route_new();
+		if (ni_rtnl_route_parse_msg(h, rtm, rp) == 0 &&
+		    ni_route_nexthop_find_by_ifindex(&rp->nh, dev->link.ifindex))
+			ni_route_array_append(routes, rp);
+		else
+			ni_route_free(rp);
+	}
+
+	ni_rtnl_query_destroy(&query);
+	return 0;
+}
+
 /*
  * Refresh the link info of one interface
  */
@@ -1488,6 +1542,8 @@ __ni_process_ifinfomsg_linkinfo(ni_linkinfo_t *link, const char *ifname,
 		link->mtu = nla_get_u32(tb[IFLA_MTU]);
 	if (tb[IFLA_TXQLEN])
 		link->txqlen = nla_get_u32(tb[IFLA_TXQLEN]);
+	if (tb[IFLA_GROUP])
+		link->group = nla_get_u32(tb[IFLA_GROUP]);
 	if (tb[IFLA_COST])
 		link->metric = nla_get_u32(tb[IFLA_COST]);
 	if (tb[IFLA_QDISC])
@@ -1865,6 +1921,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		ni_string_dup(&dev->name, nla_get_string(tb[IFLA_IFNAME]));
 	}
 
+	dev->link.netnsid = ni_netconfig_get_netnsid(nc);
 	rv = __ni_process_ifinfomsg_linkinfo(&dev->link, dev->name, tb, h, ifi, nc);
 	if (rv < 0)
 		return rv;
@@ -2905,6 +2962,7 @@ __ni_netdev_process_newaddr_event(ni_netdev_t *dev, struct nlmsghdr *h, struct i
 			ni_string_free(&tmp.label);
 			return -1;
 		}
+		ni_netdev_addrs_changed(dev);
 	}
 	ap->seq = dev->seq;
 	ap->scope = tmp.scope;
@@ -49,11 +49,18 @@
 ni_netlink_t *		__ni_global_netlink;
 int			__ni_global_iocfd = -1;
 
+/*
+ * A worker thread must not use the global ioctl socket, which is
+ * replaced when entering another network namespace. It uses its
+ * own duplicate of the socket, bound to the thread while it runs.
+ */
+static __thread int	__ni_thread_iocfd = -1;
+
 /*
  * Helpers for SIOC* ioctls
  */
 static int
-__ni_ioctl(int ioc, void *arg)
+__ni_ioctl_socket(void)
 {
 	if (__ni_global_iocfd < 0) {
 		__ni_global_iocfd = socket(PF_INET, SOCK_DGRAM, 0);
@@ -62,10 +69,36 @@ __ni_ioctl(int ioc, void *arg)
 			return -1;
 		}
 	}
+	return __ni_global_iocfd;
+}
+
+static int
+__ni_ioctl(int ioc, void *arg)
+{
+	if (__ni_thread_iocfd >= 0)
+		return ioctl(__ni_thread_iocfd, ioc, arg);
+
+	if (__ni_ioctl_socket() < 0)
+		return -1;
 
 	return ioctl(__ni_global_iocfd, ioc, arg);
 }
 
+int
+__ni_ioctl_socket_dup(void)
+{
+	if (__ni_ioctl_socket() < 0)
+		return -1;
+
+	return fcntl(__ni_global_iocfd, F_DUPFD_CLOEXEC, 0);
+}
+
+void
+__ni_ioctl_socket_bind(int fd)
+{
+	__ni_thread_iocfd = fd;
+}
+
 /*
  * Rename a network interface
  */
@@ -452,6 +485,107 @@ __ni_nl_talk(ni_netlink_t *nl, struct nl_msg *msg,
 	return err;
 }
 
+/*
+ * Send a batch of requests, keeping up to NI_NL_BATCH_WINDOW of them
+ * in flight instead of waiting for the ack of each one. The kernel
+ * processes them in order; the result of every request (0 or the
+ * positive errno reported by the kernel) is stored in errors.
+ * Returns the number of failed requests or a negative libnl error.
+ */
+#define NI_NL_BATCH_WINDOW	64U
+
+struct __ni_nl_batch_state {
+	unsigned int		first_seq;
+	unsigned int		count;
+	unsigned int		done;
+	unsigned int		failed;
+	int *			errors;
+};
+
+static void
+__ni_nl_batch_result(struct __ni_nl_batch_state *state, unsigned int seq, int error)
+{
+	unsigned int index = seq - state->first_seq;
+
+	if (index >= state->count)
+		return;
+
+	if (state->errors)
+		state->errors[index] = error;
+	if (error)
+		state->failed++;
+	state->done++;
+}
+
+static int
+__ni_nl_batch_ack_handler(struct nl_msg *msg, void *arg)
+{
+	__ni_nl_batch_result(arg, nlmsg_hdr(msg)->nlmsg_seq, 0);
+	return NL_OK;
+}
+
+static int
+__ni_nl_batch_error_handler(struct sockaddr_nl *sender, struct nlmsgerr *err, void *arg)
+{
+	__ni_nl_batch_result(arg, err->msg.nlmsg_seq, -err->error);
+	return NL_SKIP;
+}
+
+int
+ni_nl_talk_batch(struct nl_msg **msgs, unsigned int count, int *errors)
+{
+	struct __ni_nl_batch_state state;
+	struct nl_sock *nl_sock;
+	struct nl_cb *cb;
+	unsigned int sent = 0;
+	int err = 0;
+
+	if (!__ni_global_netlink || !(nl_sock = __ni_global_netlink->nl_sock)) {
+		ni_error("%s: no netlink socket", __func__);
+		return -NLE_BAD_SOCK;
+	}
+	if (!count)
+		return 0;
+
+	memset(&state, 0, sizeof(state));
+	state.count = count;
+	state.errors = errors;
+
+	if (!(cb = __ni_nl_cb_clone(__ni_global_netlink)))
+		return -NLE_NOMEM;
+	nl_cb_err(cb, NL_CB_CUSTOM, __ni_nl_batch_error_handler, &state);
+	nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, __ni_nl_batch_ack_handler, &state);
+
+	while (state.done < count) {
+		if (sent < count && sent - state.done < NI_NL_BATCH_WINDOW) {
+			if ((err = nl_send_auto(nl_sock, msgs[sent])) < 0) {
+				ni_error("%s: unable to send: %s", __func__, nl_geterror(err));
+				break;
+			}
+			if (sent++ == 0)
+				state.first_seq = nlmsg_hdr(msgs[0])->nlmsg_seq;
+			continue;
+		}
+
+		if ((err = nl_recvmsgs(nl_sock, cb)) < 0) {
+			ni_debug_socket("%s: recv failed: %s", __func__, nl_geterror(err));
+			break;
+		}
+	}
+	nl_cb_put(cb);
+
+	if (err < 0) {
+		/* requests without a result are unknown, count them as failed */
+		for (; state.done < count; state.done++) {
+			state.failed++;
+			if (errors)
+				errors[state.done] = EIO;
+		}
+		return err;
+	}
+	return state.failed;
+}
+
 /*
  * Helper functions for storing all netlink responses in a list
  */
@@ -39,6 +39,8 @@ __ni_rta_get_uint16(uint16_t *val, struct rtattr *rta)
 	return 0;
 }
 
+extern int		__ni_ioctl_socket_dup(void);
+extern void		__ni_ioctl_socket_bind(int);
 extern int		__ni_ethtool(const char *, int, void *);
 extern int		__ni_wireless_ext(const ni_netdev_t *dev, int cmd,
 				void *data, size_t data_len, unsigned int flags);
@@ -73,6 +75,7 @@ struct ni_nlmsg_list {
 };
 
 extern int	ni_nl_talk(struct nl_msg *, struct ni_nlmsg_list *);
+extern int	ni_nl_talk_batch(struct nl_msg **, unsigned int, int *errors);
 extern int	ni_nl_dump_store(int af, int type, struct ni_nlmsg_list *list);
 
 extern void	ni_nlmsg_list_init(struct ni_nlmsg_list *);
@@ -34,6 +34,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <fcntl.h>
 
 #include <wicked/netinfo.h>
 #include <wicked/addrconf.h>
@@ -50,6 +51,8 @@
 #include "dhcp4/lease.h"
 #include "dhcp6/lease.h"
 #include "netinfo_priv.h"
+#include "util_priv.h"
+#include "workpool.h"
 
 /*
  * utility returning a family + type specific node / name
@@ -726,7 +729,7 @@ __ni_addrconf_lease_addr_from_xml(ni_address_t **ap_list, unsigned int family, c
 	if (!(child = xml_node_get_child(node, "local")))
 		return 1;
 
-	if (ni_sockaddr_prefix_parse(child->cdata, &addr, &plen))
+	if (!ni_sockaddr_prefix_parse(child->cdata, &addr, &plen))
 		return -1;
 
 	if (family != addr.ss_family ||
@@ -1247,101 +1250,193 @@ ni_addrconf_lease_from_xml(ni_addrconf_lease_t **leasep, const xml_node_t *root,
  */
 static const char *		__ni_addrconf_lease_file_path(char **,
 				const char *, const char *, int, int);
-static void			__ni_addrconf_lease_file_remove(
-				const char *, const char *, int, int);
 
 /*
  * Write a lease to a file
+ *
+ * The lease is serialized in the calling (main) thread; the file
+ * I/O is offloaded to the global worker pool when there is one.
+ * Requests for the same file are executed in order.
  */
-int
-ni_addrconf_lease_file_write(const char *ifname, ni_addrconf_lease_t *lease)
+typedef struct ni_addrconf_lease_file_io {
+	char *			storefile;
+	char *			statefile;
+	char *			data;		/* NULL to remove the lease */
+	const char *		written;
+	int			error;
+} ni_addrconf_lease_file_io_t;
+
+static void
+ni_addrconf_lease_file_io_free(ni_addrconf_lease_file_io_t *io)
 {
-	char tempname[PATH_MAX] = {'\0'};
-	ni_bool_t fallback = FALSE;
-	char *filename = NULL;
-	xml_node_t *xml = NULL;
-	FILE *fp = NULL;
-	int ret = -1;
-	int fd;
+	ni_string_free(&io->storefile);
+	ni_string_free(&io->statefile);
+	ni_string_free(&io->data);
+	free(io);
+}
 
-	if (lease->state == NI_ADDRCONF_STATE_RELEASED) {
-		ni_addrconf_lease_file_remove(ifname, lease->type, lease->family);
-		return 0;
-	}
+static int
+__ni_addrconf_lease_file_store(const char *filename, const char *data)
+{
+	char tempname[PATH_MAX];
+	size_t len = strlen(data);
+	ssize_t ret;
+	int fd, err;
 
-	if (!__ni_addrconf_lease_file_path(&filename, ni_config_storedir(),
-					ifname, lease->type, lease->family)) {
-		ni_error("Cannot construct lease file name: %m");
+	snprintf(tempname, sizeof(tempname), "%s.XXXXXX", filename);
+	if ((fd = mkostemp(tempname, O_CLOEXEC)) < 0)
 		return -1;
-	}
 
-	ni_debug_dhcp("Preparing xml lease data for '%s'", filename);
-	if ((ret = ni_addrconf_lease_to_xml(lease, &xml, ifname)) != 0) {
-		if (ret > 0) {
-			ni_debug_dhcp("Skipped, %s:%s leases are disabled",
-		                        ni_addrfamily_type_to_name(lease->family),
-					ni_addrconf_type_to_name(lease->type));
-		} else {
-			ni_error("Unable to represent %s:%s lease as XML",
-					ni_addrfamily_type_to_name(lease->family),
-					ni_addrconf_type_to_name(lease->type));
+	while (len) {
+		if ((ret = write(fd, data, len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			goto failed;
 		}
+		data += ret;
+		len -= ret;
+	}
+	if (close(fd) < 0) {
+		fd = -1;
 		goto failed;
 	}
+	fd = -1;
 
-	snprintf(tempname, sizeof(tempname), "%s.XXXXXX", filename);
-	if ((fd = mkstemp(tempname)) < 0) {
-		if (errno == EROFS && __ni_addrconf_lease_file_path(&filename,
-						ni_config_statedir(), ifname,
-						lease->type, lease->family)) {
-			ni_debug_dhcp("Read-only filesystem, try fallback to %s",
-					filename);
-			snprintf(tempname, sizeof(tempname), "%s.XXXXXX", filename);
-			fd = mkstemp(tempname);
-			fallback = TRUE;
-		}
-		if (fd < 0) {
-			ni_error("Cannot create temporary lease file '%s': %m",
-					tempname);
-			tempname[0] = '\0';
-			ret = -1;
-			goto failed;
-		}
-	}
-	if ((fp = fdopen(fd, "we")) == NULL) {
-		ret = -1;
-		close(fd);
-		ni_error("Cannot reopen temporary lease file '%s': %m", tempname);
+	if (rename(tempname, filename) < 0)
 		goto failed;
+	return 0;
+
+failed:
+	err = errno;
+	if (fd >= 0)
+		close(fd);
+	unlink(tempname);
+	errno = err;
+	return -1;
+}
+
+/* worker thread: must not touch any global state */
+static int
+__ni_addrconf_lease_file_io(void *user_data)
+{
+	ni_addrconf_lease_file_io_t *io = user_data;
+
+	if (!io->data) {
+		if (unlink(io->statefile) < 0 && errno != ENOENT)
+			io->error = errno;
+		if (unlink(io->storefile) < 0 && errno != ENOENT)
+			io->error = errno;
+		return io->error ? -1 : 0;
 	}
 
-	ni_debug_dhcp("Writing lease to temporary file for '%s'", filename);
-	xml_node_print(xml, fp);
-	fclose(fp);
-	xml_node_free(xml);
+	if (__ni_addrconf_lease_file_store(io->storefile, io->data) == 0) {
+		io->written = io->storefile;
+		unlink(io->statefile);
+		return 0;
+	}
+	if (errno == EROFS &&
+	    __ni_addrconf_lease_file_store(io->statefile, io->data) == 0) {
+		io->written = io->statefile;
+		return 0;
+	}
+	io->error = errno;
+	return -1;
+}
 
-	if ((ret = rename(tempname, filename)) != 0) {
-		ni_error("Unable to rename temporary lease file '%s' to '%s': %m",
-				tempname, filename);
-		goto failed;
-	} else if (!fallback) {
-		__ni_addrconf_lease_file_remove(ni_config_statedir(),
-				ifname, lease->type, lease->family);
+static void
+__ni_addrconf_lease_file_io_done(void *user_data, int result)
+{
+	ni_addrconf_lease_file_io_t *io = user_data;
+
+	if (!io->data) {
+		if (result < 0)
+			ni_error("Unable to remove lease file '%s': %s",
+					io->storefile, strerror(io->error));
+		else
+			ni_debug_dhcp("removed lease file '%s'", io->storefile);
+	} else {
+		if (result < 0)
+			ni_error("Unable to write lease file '%s': %s",
+					io->storefile, strerror(io->error));
+		else
+			ni_debug_dhcp("Lease written to file '%s'", io->written);
 	}
+	ni_addrconf_lease_file_io_free(io);
+}
 
-	ni_debug_dhcp("Lease written to file '%s'", filename);
-	ni_string_free(&filename);
-	return 0;
+static ni_addrconf_lease_file_io_t *
+__ni_addrconf_lease_file_io_new(const char *ifname, int type, int family)
+{
+	ni_addrconf_lease_file_io_t *io;
 
-failed:
-	if (fp)
-		fclose(fp);
-	if (xml)
+	io = xcalloc(1, sizeof(*io));
+	if (!__ni_addrconf_lease_file_path(&io->storefile, ni_config_storedir(),
+					ifname, type, family) ||
+	    !__ni_addrconf_lease_file_path(&io->statefile, ni_config_statedir(),
+					ifname, type, family)) {
+		ni_error("Cannot construct lease file name: %m");
+		ni_addrconf_lease_file_io_free(io);
+		return NULL;
+	}
+	return io;
+}
+
+/*
+ * Writes and removals of the same file are queued in order,
+ * keyed by the file name.
+ */
+static int
+__ni_addrconf_lease_file_io_submit(ni_addrconf_lease_file_io_t *io)
+{
+	ni_workpool_t *pool;
+	int ret;
+
+	if ((pool = ni_workpool_global()) != NULL) {
+		ni_workpool_submit(pool, io->storefile, __ni_addrconf_lease_file_io,
+				__ni_addrconf_lease_file_io_done, io);
+		return 0;
+	}
+
+	ret = __ni_addrconf_lease_file_io(io);
+	__ni_addrconf_lease_file_io_done(io, ret);
+	return ret;
+}
+
+int
+ni_addrconf_lease_file_write(const char *ifname, ni_addrconf_lease_t *lease)
+{
+	ni_addrconf_lease_file_io_t *io;
+	xml_node_t *xml = NULL;
+	int ret;
+
+	if (!(io = __ni_addrconf_lease_file_io_new(ifname, lease->type, lease->family)))
+		return -1;
+
+	if (lease->state != NI_ADDRCONF_STATE_RELEASED) {
+		ni_debug_dhcp("Preparing xml lease data for '%s'", io->storefile);
+		if ((ret = ni_addrconf_lease_to_xml(lease, &xml, ifname)) != 0) {
+			if (ret > 0) {
+				ni_debug_dhcp("Skipped, %s:%s leases are disabled",
+						ni_addrfamily_type_to_name(lease->family),
+						ni_addrconf_type_to_name(lease->type));
+			} else {
+				ni_error("Unable to represent %s:%s lease as XML",
+						ni_addrfamily_type_to_name(lease->family),
+						ni_addrconf_type_to_name(lease->type));
+			}
+			ni_addrconf_lease_file_io_free(io);
+			return -1;
+		}
+
+		io->data = xml_node_sprint(xml);
 		xml_node_free(xml);
-	if (tempname[0])
-		unlink(tempname);
-	ni_string_free(&filename);
-	return -1;
+		if (!io->data) {
+			ni_addrconf_lease_file_io_free(io);
+			return -1;
+		}
+	}
+
+	return __ni_addrconf_lease_file_io_submit(io);
 }
 
 /*
@@ -1416,25 +1511,13 @@ ni_addrconf_lease_file_read(const char *ifname, int type, int family)
 /*
  * Remove a lease file
  */
-static void
-__ni_addrconf_lease_file_remove(const char *dir, const char *ifname,
-				int type, int family)
-{
-	char *filename = NULL;
-
-	if (!__ni_addrconf_lease_file_path(&filename, dir, ifname, type, family))
-		return;
-
-	if (ni_file_exists(filename) && unlink(filename) == 0)
-		ni_debug_dhcp("removed %s", filename);
-	ni_string_free(&filename);
-}
-
 void
 ni_addrconf_lease_file_remove(const char *ifname, int type, int family)
 {
-	__ni_addrconf_lease_file_remove(ni_config_statedir(), ifname, type, family);
-	__ni_addrconf_lease_file_remove(ni_config_storedir(), ifname, type, family);
+	ni_addrconf_lease_file_io_t *io;
+
+	if ((io = __ni_addrconf_lease_file_io_new(ifname, type, family)))
+		__ni_addrconf_lease_file_io_submit(io);
 }
 
 static const char *
@@ -29,6 +29,10 @@
 
 #include <stdlib.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <ctype.h>
@@ -50,6 +54,7 @@
 #include "util_priv.h"
 #include "dhcp6/options.h"
 #include "dhcp.h"
+#include "hashmap.h"
 
 static const char *	__ni_keyword_format(char **, const char *,
 					const char *, unsigned int);
@@ -802,44 +807,54 @@ ni_leaseinfo_path(const char *ifname, const ni_addrconf_mode_t type,
 	return filename;
 }
 
-void
-ni_leaseinfo_dump(FILE *out, const ni_addrconf_lease_t *lease,
-		const char *ifname, const char *prefix)
-{
-
-	char *filename = NULL;
-	ni_bool_t close_out_fp = TRUE; /* Used to prevent unwanted closure of
-					* things like stdout.
-					*/
-
-	if (!lease) {
-		ni_error("Cannot dump info from NULL lease.");
-		return;
-	}
+/*
+ * The lease info files are rendered in memory first; a file is only
+ * rewritten when the hash of its content changed or the file on disk
+ * is not the one we wrote last. With the addrconf leaseinfo-index
+ * option, all current leases are also written to one index file,
+ * each lease as a section with a LEASEINFO_<slot>_ variable prefix.
+ */
+#define NI_LEASEINFO_INDEX_NAME		"leaseinfo-index"
+
+typedef struct ni_leaseinfo_file {
+	unsigned int		slot;
+	uint64_t		hash;
+	size_t			size;
+	dev_t			dev;
+	ino_t			ino;
+	struct timespec		mtim;
+	char *			section;
+} ni_leaseinfo_file_t;
+
+static struct {
+	ni_hashmap_t *		files;
+	ni_leaseinfo_file_t **	slots;
+	unsigned int		nslots;
+	ni_bool_t		dirty;
+} ni_leaseinfo_files;
 
-	if (lease->state == NI_ADDRCONF_STATE_RELEASED) {
-		ni_debug_dhcp("Lease to dump has been released.");
-		ni_leaseinfo_remove(ifname, lease->type, lease->family);
-	}
+static ni_bool_t
+__ni_leaseinfo_index_enabled(void)
+{
+	return ni_global.config && ni_global.config->addrconf.leaseinfo_index;
+}
 
-	/* If we're supplied a FILE pointer, use it. Otherwise, open a file based
-	 * on lease info (ifname, type, family).
-	 */
-	if (!out) {
-		if ((filename = ni_leaseinfo_path(ifname, lease->type, lease->family)) == NULL) {
-			ni_error("Unable to set leaseinfo file path for creation.");
-			return;
-		}
+static uint64_t
+__ni_leaseinfo_hash(const char *data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
 
-		if ((out = fopen(filename, "w")) == NULL) {
-			ni_error("Cannot open %s", filename);
-			return;
-		}
-	} else {
-		/* A fp passed to us, don't close it! */
-		close_out_fp = FALSE;
+	while (size--) {
+		hash ^= (unsigned char)*data++;
+		hash *= 1099511628211ULL;
 	}
+	return hash;
+}
 
+static void
+__ni_leaseinfo_print(FILE *out, const ni_addrconf_lease_t *lease,
+		const char *ifname, const char *prefix)
+{
 	__ni_leaseinfo_dump(out, lease, ifname, prefix);
 
 	switch (lease->type) {
@@ -863,9 +878,254 @@ ni_leaseinfo_dump(FILE *out, const ni_addrconf_lease_t *lease,
 		 * information. */
 		break;
 	}
+}
+
+static char *
+__ni_leaseinfo_render(size_t *size, const ni_addrconf_lease_t *lease,
+		const char *ifname, const char *prefix)
+{
+	char *data = NULL;
+	FILE *out;
+
+	*size = 0;
+	if ((out = open_memstream(&data, size)) == NULL)
+		return NULL;
+
+	__ni_leaseinfo_print(out, lease, ifname, prefix);
+	if (fclose(out) != 0) {
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+static int
+__ni_leaseinfo_store(const char *filename, const char *data, size_t len,
+		struct stat *stb)
+{
+	char tempname[PATH_MAX];
+	ssize_t ret;
+	int fd, err;
+
+	snprintf(tempname, sizeof(tempname), "%s.XXXXXX", filename);
+	if ((fd = mkostemp(tempname, O_CLOEXEC)) < 0)
+		return -1;
+
+	if (fchmod(fd, 0644) < 0)
+		goto failed;
+
+	while (len) {
+		if ((ret = write(fd, data, len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			goto failed;
+		}
+		data += ret;
+		len -= ret;
+	}
+	if (stb && fstat(fd, stb) < 0)
+		goto failed;
+	if (close(fd) < 0) {
+		fd = -1;
+		goto failed;
+	}
+	fd = -1;
+
+	if (rename(tempname, filename) < 0)
+		goto failed;
+	return 0;
+
+failed:
+	err = errno;
+	if (fd >= 0)
+		close(fd);
+	unlink(tempname);
+	errno = err;
+	return -1;
+}
+
+static ni_bool_t
+__ni_leaseinfo_file_unchanged(const ni_leaseinfo_file_t *file, const char *filename,
+		uint64_t hash, size_t size)
+{
+	struct stat stb;
+
+	if (file->hash != hash || file->size != size)
+		return FALSE;
+
+	if (stat(filename, &stb) < 0)
+		return FALSE;
+
+	return	stb.st_dev == file->dev && stb.st_ino == file->ino &&
+		(size_t)stb.st_size == file->size &&
+		stb.st_mtim.tv_sec == file->mtim.tv_sec &&
+		stb.st_mtim.tv_nsec == file->mtim.tv_nsec;
+}
+
+static ni_leaseinfo_file_t *
+__ni_leaseinfo_file_get(const char *filename)
+{
+	ni_leaseinfo_file_t *file;
+	unsigned int slot;
+
+	if (!ni_leaseinfo_files.files)
+		ni_leaseinfo_files.files = ni_hashmap_new();
+	else
+	if ((file = ni_hashmap_get(ni_leaseinfo_files.files, filename)))
+		return file;
+
+	for (slot = 0; slot < ni_leaseinfo_files.nslots; ++slot) {
+		if (!ni_leaseinfo_files.slots[slot])
+			break;
+	}
+	if (slot == ni_leaseinfo_files.nslots) {
+		ni_leaseinfo_files.slots = xrealloc(ni_leaseinfo_files.slots,
+				(slot + 1) * sizeof(ni_leaseinfo_file_t *));
+		ni_leaseinfo_files.nslots++;
+	}
 
-	if (close_out_fp)
-		fclose(out);
+	file = xcalloc(1, sizeof(*file));
+	file->slot = slot;
+	ni_leaseinfo_files.slots[slot] = file;
+	ni_hashmap_set(ni_leaseinfo_files.files, filename, file);
+	return file;
+}
+
+static void
+__ni_leaseinfo_file_forget(const char *filename)
+{
+	ni_leaseinfo_file_t *file;
+
+	if (!(file = ni_hashmap_remove(ni_leaseinfo_files.files, filename)))
+		return;
+
+	ni_leaseinfo_files.slots[file->slot] = NULL;
+	if (file->section)
+		ni_leaseinfo_files.dirty = TRUE;
+	ni_string_free(&file->section);
+	free(file);
+}
+
+/*
+ * Replace the index file with the sections of all current leases
+ */
+static void
+__ni_leaseinfo_index_write(void)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_leaseinfo_file_t *file;
+	const char *sep = "";
+	char *filename = NULL;
+	unsigned int slot;
+
+	ni_stringbuf_puts(&buf, "LEASEINFO_SLOTS='");
+	for (slot = 0; slot < ni_leaseinfo_files.nslots; ++slot) {
+		file = ni_leaseinfo_files.slots[slot];
+		if (file && file->section) {
+			ni_stringbuf_printf(&buf, "%s%u", sep, slot);
+			sep = " ";
+		}
+	}
+	ni_stringbuf_puts(&buf, "'\n");
+	for (slot = 0; slot < ni_leaseinfo_files.nslots; ++slot) {
+		file = ni_leaseinfo_files.slots[slot];
+		if (file && file->section)
+			ni_stringbuf_puts(&buf, file->section);
+	}
+
+	ni_string_printf(&filename, "%s/%s", ni_config_statedir(), NI_LEASEINFO_INDEX_NAME);
+	if (__ni_leaseinfo_store(filename, buf.string, buf.len, NULL) < 0) {
+		ni_error("Cannot write %s: %m", filename);
+	} else {
+		ni_debug_dhcp("Updated leaseinfo index: %s", filename);
+		ni_leaseinfo_files.dirty = FALSE;
+	}
+	ni_string_free(&filename);
+	ni_stringbuf_destroy(&buf);
+}
+
+static void
+__ni_leaseinfo_file_update(const char *filename, const ni_addrconf_lease_t *lease,
+		const char *ifname, const char *prefix)
+{
+	ni_leaseinfo_file_t *file;
+	char *data, *section = NULL;
+	struct stat stb;
+	uint64_t hash;
+	size_t size;
+
+	if (!(data = __ni_leaseinfo_render(&size, lease, ifname, prefix))) {
+		ni_error("Cannot format lease info for %s", filename);
+		return;
+	}
+	hash = __ni_leaseinfo_hash(data, size);
+	file = __ni_leaseinfo_file_get(filename);
+
+	if (__ni_leaseinfo_file_unchanged(file, filename, hash, size)) {
+		ni_debug_dhcp("Leaseinfo file unchanged: %s", filename);
+		free(data);
+	} else {
+		if (__ni_leaseinfo_store(filename, data, size, &stb) < 0) {
+			ni_error("Cannot write %s: %m", filename);
+			file->hash = 0;
+			file->size = 0;
+		} else {
+			file->hash = hash;
+			file->size = size;
+			file->dev = stb.st_dev;
+			file->ino = stb.st_ino;
+			file->mtim = stb.st_mtim;
+		}
+		free(data);
+
+		/* the index section has to follow the file content */
+		ni_string_free(&file->section);
+	}
+
+	if (!__ni_leaseinfo_index_enabled())
+		return;
+
+	if (!file->section) {
+		ni_string_printf(&section, "LEASEINFO_%u_%s", file->slot, prefix ? prefix : "");
+		file->section = __ni_leaseinfo_render(&size, lease, ifname, section);
+		ni_string_free(&section);
+		ni_leaseinfo_files.dirty = TRUE;
+	}
+	if (ni_leaseinfo_files.dirty)
+		__ni_leaseinfo_index_write();
+}
+
+void
+ni_leaseinfo_dump(FILE *out, const ni_addrconf_lease_t *lease,
+		const char *ifname, const char *prefix)
+{
+	char *filename = NULL;
+
+	if (!lease) {
+		ni_error("Cannot dump info from NULL lease.");
+		return;
+	}
+
+	if (lease->state == NI_ADDRCONF_STATE_RELEASED) {
+		ni_debug_dhcp("Lease to dump has been released.");
+		ni_leaseinfo_remove(ifname, lease->type, lease->family);
+	}
+
+	/* If we're supplied a FILE pointer, use it (and don't close it,
+	 * it may be e.g. stdout). Otherwise, update the file based on
+	 * the lease info (ifname, type, family).
+	 */
+	if (out) {
+		__ni_leaseinfo_print(out, lease, ifname, prefix);
+		return;
+	}
+
+	if ((filename = ni_leaseinfo_path(ifname, lease->type, lease->family)) == NULL) {
+		ni_error("Unable to set leaseinfo file path for creation.");
+		return;
+	}
+
+	__ni_leaseinfo_file_update(filename, lease, ifname, prefix);
 	ni_string_free(&filename);
 }
 
@@ -882,5 +1142,10 @@ ni_leaseinfo_remove(const char *ifname, const ni_addrconf_mode_t type,
 
 	ni_debug_dhcp("Removing leaseinfo file: %s", filename);
 	unlink(filename);
+
+	__ni_leaseinfo_file_forget(filename);
+	if (ni_leaseinfo_files.dirty && __ni_leaseinfo_index_enabled())
+		__ni_leaseinfo_index_write();
+
 	ni_string_free(&filename);
 }
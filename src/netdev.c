@@ -19,6 +19,7 @@
 #include <wicked/ovs.h>
 #include <wicked/ethernet.h>
 #include <wicked/infiniband.h>
+#include <wicked/netns.h>
 #include <wicked/wireless.h>
 #include <wicked/vlan.h>
 #include <wicked/vxlan.h>
@@ -58,6 +59,7 @@ ni_netdev_new(const char *name, unsigned int index)
 	dev->link.hwaddr.type = ARPHRD_VOID;
 	dev->link.hwpeer.type = ARPHRD_VOID;
 	dev->link.ifindex = index;
+	dev->link.netnsid = NI_NETNS_ID_NONE;
 
 	if (name)
 		dev->name = xstrdup(name);
@@ -683,6 +685,35 @@ ni_netdev_set_lldp(ni_netdev_t *dev, ni_lldp_t *lldp)
 	dev->lldp = lldp;
 }
 
+/*
+ * Record a change of the address or of the route list of a device.
+ * The generations are unique across devices and lists; paged list
+ * walks use them to detect changes between two pages.
+ */
+static unsigned int
+ni_netdev_list_gen_next(void)
+{
+	static unsigned int list_gen;
+
+	if (!++list_gen)
+		++list_gen;
+	return list_gen;
+}
+
+void
+ni_netdev_addrs_changed(ni_netdev_t *dev)
+{
+	if (dev)
+		dev->addr_gen = ni_netdev_list_gen_next();
+}
+
+void
+ni_netdev_routes_changed(ni_netdev_t *dev)
+{
+	if (dev)
+		dev->route_gen = ni_netdev_list_gen_next();
+}
+
 /*
  * Handle event filters
  */
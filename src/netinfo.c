@@ -10,6 +10,7 @@
 #include <signal.h>
 #include <limits.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <wicked/netinfo.h>
 #include <wicked/route.h>
@@ -24,6 +25,7 @@
 #include <wicked/socket.h>
 #include <wicked/resolver.h>
 #include <wicked/nis.h>
+#include <wicked/netns.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
 #include "dbus-server.h"
@@ -44,6 +46,7 @@ typedef struct ni_netconfig_filter {
 
 struct ni_netconfig {
 	ni_netconfig_filter_t	filter;
+	int			netnsid;
 
 	ni_netdev_t *		interfaces;
 	ni_modem_t *		modems;
@@ -413,9 +416,39 @@ ni_server_listen_dbus(const char *dbus_name)
 	return ni_dbus_server_open(ni_global.config->dbus_type, dbus_name, NULL);
 }
 
+/*
+ * Private peer-to-peer dbus socket of a service in the state directory
+ */
+static const char *
+ni_server_dbus_peer_path(const char *dbus_name, char *path, size_t size)
+{
+	snprintf(path, size, "%s/%s.socket", ni_config_statedir(), dbus_name);
+	return path;
+}
+
+ni_bool_t
+ni_server_listen_dbus_peer(ni_dbus_server_t *server, const char *dbus_name)
+{
+	char path[PATH_MAX];
+
+	ni_global_assert_initialized();
+	if (!server || !ni_global.config->dbus_peer)
+		return FALSE;
+	if (dbus_name == NULL)
+		dbus_name = ni_global.config->dbus_name;
+	if (dbus_name == NULL)
+		return FALSE;
+
+	ni_server_dbus_peer_path(dbus_name, path, sizeof(path));
+	return ni_dbus_server_listen_peer(server, path);
+}
+
 ni_dbus_client_t *
 ni_create_dbus_client(const char *dbus_name)
 {
+	ni_dbus_client_t *client;
+	char path[PATH_MAX];
+
 	ni_global_assert_initialized();
 	if (dbus_name == NULL)
 		dbus_name = ni_global.config->dbus_name;
@@ -424,7 +457,13 @@ ni_create_dbus_client(const char *dbus_name)
 		return NULL;
 	}
 
-	return ni_dbus_client_open(ni_global.config->dbus_type, dbus_name);
+	client = ni_dbus_client_open(ni_global.config->dbus_type, dbus_name);
+	if (client && ni_global.config->dbus_peer && geteuid() == 0) {
+		ni_server_dbus_peer_path(dbus_name, path, sizeof(path));
+		if (ni_file_exists(path))
+			ni_dbus_client_connect_peer(client, path);
+	}
+	return client;
 }
 
 ni_xs_scope_t *
@@ -500,6 +539,7 @@ ni_netconfig_new(void)
 	ni_netconfig_t *nc;
 
 	nc = xcalloc(1, sizeof(*nc));
+	nc->netnsid = NI_NETNS_ID_NONE;
 	return nc;
 }
 
@@ -514,6 +554,7 @@ void
 ni_netconfig_init(ni_netconfig_t *nc)
 {
 	memset(nc, 0, sizeof(*nc));
+	nc->netnsid = NI_NETNS_ID_NONE;
 }
 
 void
@@ -559,6 +600,23 @@ ni_netconfig_get_family_filter(ni_netconfig_t *nc)
 	return nc ? nc->filter.family : AF_UNSPEC;
 }
 
+/*
+ * The id of the network namespace the devices live in,
+ * NI_NETNS_ID_NONE for the own namespace
+ */
+void
+ni_netconfig_set_netnsid(ni_netconfig_t *nc, int netnsid)
+{
+	if (nc)
+		nc->netnsid = netnsid;
+}
+
+int
+ni_netconfig_get_netnsid(const ni_netconfig_t *nc)
+{
+	return nc ? nc->netnsid : NI_NETNS_ID_NONE;
+}
+
 /*
  * Get the list of all discovered interfaces, given a
  * netinfo handle.
@@ -673,6 +731,7 @@ ni_netconfig_route_add(ni_netconfig_t *nc, ni_route_t *rp, ni_netdev_t *dev)
 			ret = -1;
 		} else {
 			ni_string_dup(&nh->device.name, dev->name);
+			ni_netdev_routes_changed(dev);
 			ret = 0;
 
 			if (ni_log_level_at(NI_LOG_DEBUG2)) {
@@ -704,8 +763,10 @@ ni_netconfig_route_del(ni_netconfig_t *nc, ni_route_t *rp, ni_netdev_t *dev)
 	if (!nc || !ni_route_ref(rp))
 		return -1;
 
-	if (dev && ni_route_tables_del_route(dev->routes, rp))
+	if (dev && ni_route_tables_del_route(dev->routes, rp)) {
+		ni_netdev_routes_changed(dev);
 		ret = 0;
+	}
 
 	for (nh = &rp->nh; nh; nh = nh->next) {
 		if (!nh->device.index)
@@ -717,8 +778,10 @@ ni_netconfig_route_del(ni_netconfig_t *nc, ni_route_t *rp, ni_netdev_t *dev)
 		if (!(dev = ni_netdev_by_index(nc, nh->device.index)))
 			continue;
 
-		if (ni_route_tables_del_route(dev->routes, rp))
+		if (ni_route_tables_del_route(dev->routes, rp)) {
+			ni_netdev_routes_changed(dev);
 			ret = 0;
+		}
 	}
 
 	ni_route_free(rp);
@@ -13,6 +13,7 @@
 #include <wicked/types.h>
 #include <wicked/netinfo.h>
 #include <wicked/addrconf.h>
+#include <wicked/route.h>
 #include <wicked/logging.h>
 #include <wicked/team.h>
 #include <wicked/ovs.h>
@@ -59,9 +60,13 @@ extern ni_bool_t	ni_netconfig_set_discover_filter(ni_netconfig_t *, unsigned int
 extern ni_bool_t	ni_netconfig_discover_filtered(ni_netconfig_t *, unsigned int);
 extern ni_bool_t	ni_netconfig_set_family_filter(ni_netconfig_t *, unsigned int);
 extern unsigned int	ni_netconfig_get_family_filter(ni_netconfig_t *);
+extern void		ni_netconfig_set_netnsid(ni_netconfig_t *, int);
+extern int		ni_netconfig_get_netnsid(const ni_netconfig_t *);
 
 extern ni_bool_t	__ni_linkinfo_kind_to_type(const char *, ni_iftype_t *);
 
+extern void		ni_netdev_addrs_changed(ni_netdev_t *);
+extern void		ni_netdev_routes_changed(ni_netdev_t *);
 extern void		__ni_netdev_list_append(ni_netdev_t **, ni_netdev_t *);
 extern void		__ni_netdev_list_destroy(ni_netdev_t **);
 extern ni_addrconf_lease_t *__ni_netdev_find_lease(ni_netdev_t *, unsigned int, ni_addrconf_mode_t, int);
@@ -84,6 +89,8 @@ extern int		__ni_system_refresh_interfaces(ni_netconfig_t *nc);
 extern int		__ni_system_refresh_interface(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_refresh_interface_addrs(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_refresh_interface_routes(ni_netconfig_t *, ni_netdev_t *);
+extern int		__ni_system_query_interface_routes(ni_netconfig_t *, ni_netdev_t *,
+						ni_route_array_t *);
 extern int		__ni_system_refresh_addrs(ni_netconfig_t *, unsigned int);
 extern int		__ni_system_refresh_routes(ni_netconfig_t *);
 extern int		__ni_system_refresh_rules(ni_netconfig_t *);
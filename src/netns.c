@@ -0,0 +1,447 @@
+/*
+ *	Network namespaces managed next to the daemon's own one
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <errno.h>
+#include <netlink/msg.h>
+#include <linux/rtnetlink.h>
+#include <linux/net_namespace.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/netns.h>
+#include "netinfo_priv.h"
+#include "util_priv.h"
+#include "kernel.h"
+
+struct ni_netns {
+	ni_netns_t *		next;
+
+	char *			name;
+	int			fd;
+	int			nsid;
+
+	ni_netlink_t *		netlink;
+	int			iocfd;
+
+	ni_netconfig_t *	nc;
+};
+
+static ni_netns_t *		ni_netns_list_head;
+
+/* the daemon's own namespace and its handles while switched */
+static struct {
+	int			fd;
+	ino_t			ino;
+	int			nsid;
+	ni_netlink_t *		netlink;
+	int			iocfd;
+	const ni_netns_t *	current;
+} ni_netns_host = {
+	.fd		= -1,
+	.nsid		= NI_NETNS_ID_NONE,
+	.iocfd		= -1,
+};
+
+static int	ni_netns_get_nsid(int, int *);
+
+static int
+ni_netns_host_init(void)
+{
+	struct stat stb;
+
+	if (ni_netns_host.fd >= 0)
+		return 0;
+
+	if ((ni_netns_host.fd = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC)) < 0) {
+		ni_error("unable to open own network namespace: %m");
+		return -1;
+	}
+	if (fstat(ni_netns_host.fd, &stb) < 0) {
+		ni_error("unable to stat own network namespace: %m");
+		close(ni_netns_host.fd);
+		ni_netns_host.fd = -1;
+		return -1;
+	}
+	ni_netns_host.ino = stb.st_ino;
+
+	/* an id for itself, e.g. by "ip netns set", marks own events too */
+	if (ni_netns_get_nsid(ni_netns_host.fd, &ni_netns_host.nsid) < 0)
+		ni_netns_host.nsid = NI_NETNS_ID_NONE;
+	return 0;
+}
+
+/*
+ * RTM_GETNSID returns the id the own namespace uses for a peer,
+ * RTM_NEWNSID with NETNSA_NSID -1 lets the kernel assign one.
+ */
+static struct nl_msg *
+ni_netns_nsid_msg(int type, int fd, ni_bool_t assign)
+{
+	struct rtgenmsg rtg = { .rtgen_family = AF_UNSPEC };
+	struct nl_msg *msg;
+
+	if (!(msg = nlmsg_alloc_simple(type, NLM_F_REQUEST)))
+		return NULL;
+
+	if (nlmsg_append(msg, &rtg, sizeof(rtg), NLMSG_ALIGNTO) < 0 ||
+	    nla_put_u32(msg, NETNSA_FD, fd) < 0 ||
+	    (assign && nla_put_s32(msg, NETNSA_NSID, NETNSA_NSID_NOT_ASSIGNED) < 0)) {
+		nlmsg_free(msg);
+		return NULL;
+	}
+	return msg;
+}
+
+static int
+ni_netns_get_nsid(int fd, int *nsid)
+{
+	struct ni_nlmsg_list list;
+	struct nlattr *tb[NETNSA_MAX + 1];
+	struct ni_nlmsg *entry;
+	struct nl_msg *msg;
+	int rv;
+
+	if (!(msg = ni_netns_nsid_msg(RTM_GETNSID, fd, FALSE)))
+		return -1;
+
+	ni_nlmsg_list_init(&list);
+	rv = ni_nl_talk(msg, &list);
+	nlmsg_free(msg);
+
+	*nsid = NETNSA_NSID_NOT_ASSIGNED;
+	for (entry = list.head; rv >= 0 && entry; entry = entry->next) {
+		if (entry->h.nlmsg_type != RTM_NEWNSID)
+			continue;
+		if (nlmsg_parse(&entry->h, sizeof(struct rtgenmsg), tb, NETNSA_MAX, NULL) < 0)
+			continue;
+		if (tb[NETNSA_NSID])
+			*nsid = nla_get_s32(tb[NETNSA_NSID]);
+	}
+	ni_nlmsg_list_destroy(&list);
+	return rv < 0 ? -1 : 0;
+}
+
+static int
+ni_netns_assign_nsid(ni_netns_t *ns)
+{
+	struct nl_msg *msg;
+	int rv;
+
+	if (ni_netns_get_nsid(ns->fd, &ns->nsid) < 0)
+		return -1;
+	if (ns->nsid >= 0)
+		return 0;
+
+	if (!(msg = ni_netns_nsid_msg(RTM_NEWNSID, ns->fd, TRUE)))
+		return -1;
+	rv = ni_nl_talk(msg, NULL);
+	nlmsg_free(msg);
+
+	/* EEXIST: someone else was faster, fine */
+	if (rv < 0 && rv != -NLE_EXIST) {
+		ni_error("netns %s: unable to assign a namespace id: %s",
+				ns->name, nl_geterror(rv));
+		return -1;
+	}
+	if (ni_netns_get_nsid(ns->fd, &ns->nsid) < 0 || ns->nsid < 0) {
+		ni_error("netns %s: no namespace id assigned", ns->name);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Sockets belong to the namespace they are created in, so create the
+ * handles of the namespace inside of it.
+ */
+static int
+ni_netns_open_handles(ni_netns_t *ns)
+{
+	int rv = 0;
+
+	if (setns(ns->fd, CLONE_NEWNET) < 0) {
+		ni_error("netns %s: unable to enter namespace: %m", ns->name);
+		return -1;
+	}
+
+	if (!(ns->netlink = __ni_netlink_open(0)))
+		rv = -1;
+	else
+	if ((ns->iocfd = socket(PF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0) {
+		ni_error("netns %s: cannot create UDP socket: %m", ns->name);
+		rv = -1;
+	}
+
+	if (setns(ni_netns_host.fd, CLONE_NEWNET) < 0)
+		ni_fatal("unable to return to own network namespace: %m");
+	return rv;
+}
+
+static void
+ni_netns_free(ni_netns_t *ns)
+{
+	if (ns->nc)
+		ni_netconfig_free(ns->nc);
+	if (ns->netlink)
+		__ni_netlink_close(ns->netlink);
+	if (ns->iocfd >= 0)
+		close(ns->iocfd);
+	if (ns->fd >= 0)
+		close(ns->fd);
+	ni_string_free(&ns->name);
+	free(ns);
+}
+
+ni_netns_t *
+ni_netns_open(const char *name)
+{
+	char path[PATH_MAX];
+	struct stat stb;
+	ni_netns_t *ns;
+
+	if (ni_string_empty(name))
+		return NULL;
+
+	if ((ns = ni_netns_by_name(name)))
+		return ns;
+
+	/* the nsid and the handles are relative to the own namespace */
+	ni_netns_leave();
+	if (ni_netns_host_init() < 0 || !ni_global_state_handle(0))
+		return NULL;
+
+	if (name[0] == '/')
+		snprintf(path, sizeof(path), "%s", name);
+	else
+	if (strchr(name, '/') || ni_string_eq(name, ".") || ni_string_eq(name, "..")) {
+		ni_error("netns %s: invalid namespace name", name);
+		return NULL;
+	} else
+		snprintf(path, sizeof(path), "%s/%s", NI_NETNS_RUN_DIR, name);
+
+	ns = xcalloc(1, sizeof(*ns));
+	ns->name = xstrdup(name);
+	ns->nsid = NETNSA_NSID_NOT_ASSIGNED;
+	ns->iocfd = -1;
+
+	if ((ns->fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+		ni_error("netns %s: unable to open %s: %m", name, path);
+		goto failed;
+	}
+	if (fstat(ns->fd, &stb) < 0 || stb.st_ino == ni_netns_host.ino) {
+		ni_error("netns %s: not a namespace other than the own one", name);
+		goto failed;
+	}
+
+	if (ni_netns_assign_nsid(ns) < 0 || ni_netns_open_handles(ns) < 0)
+		goto failed;
+
+	ns->nc = ni_netconfig_new();
+	ni_netconfig_set_netnsid(ns->nc, ns->nsid);
+
+	ns->next = ni_netns_list_head;
+	ni_netns_list_head = ns;
+
+	ni_debug_ifconfig("netns %s: opened with namespace id %d", ns->name, ns->nsid);
+	return ns;
+
+failed:
+	ni_netns_free(ns);
+	return NULL;
+}
+
+void
+ni_netns_close(ni_netns_t *ns)
+{
+	ni_netns_t **pos, *cur;
+
+	if (!ns)
+		return;
+
+	if (ni_netns_host.current == ns)
+		ni_netns_leave();
+
+	for (pos = &ni_netns_list_head; (cur = *pos); pos = &cur->next) {
+		if (cur == ns) {
+			*pos = cur->next;
+			break;
+		}
+	}
+	ni_netns_free(ns);
+}
+
+void
+ni_netns_close_all(void)
+{
+	while (ni_netns_list_head)
+		ni_netns_close(ni_netns_list_head);
+}
+
+ni_netns_t *
+ni_netns_list(void)
+{
+	return ni_netns_list_head;
+}
+
+ni_netns_t *
+ni_netns_next(const ni_netns_t *ns)
+{
+	return ns ? ns->next : NULL;
+}
+
+unsigned int
+ni_netns_count(void)
+{
+	unsigned int count = 0;
+	ni_netns_t *ns;
+
+	for (ns = ni_netns_list_head; ns; ns = ns->next)
+		count++;
+	return count;
+}
+
+ni_netns_t *
+ni_netns_by_name(const char *name)
+{
+	ni_netns_t *ns;
+
+	for (ns = ni_netns_list_head; ns; ns = ns->next) {
+		if (ni_string_eq(ns->name, name))
+			return ns;
+	}
+	return NULL;
+}
+
+ni_netns_t *
+ni_netns_by_id(int nsid)
+{
+	ni_netns_t *ns;
+
+	if (nsid < 0)
+		return NULL;
+
+	for (ns = ni_netns_list_head; ns; ns = ns->next) {
+		if (ns->nsid == nsid)
+			return ns;
+	}
+	return NULL;
+}
+
+const char *
+ni_netns_name(const ni_netns_t *ns)
+{
+	return ns ? ns->name : NULL;
+}
+
+int
+ni_netns_id(const ni_netns_t *ns)
+{
+	return ns ? ns->nsid : NI_NETNS_ID_NONE;
+}
+
+ni_netconfig_t *
+ni_netns_state_handle(ni_netns_t *ns, int refresh)
+{
+	const ni_netns_t *prev;
+	int rv;
+
+	if (!ns)
+		return NULL;
+
+	if (refresh) {
+		prev = ni_netns_host.current;
+		if (ni_netns_enter(ns) < 0)
+			return NULL;
+
+		rv = __ni_system_refresh_all(ns->nc, NULL);
+
+		if (prev)
+			ni_netns_enter(prev);
+		else
+			ni_netns_leave();
+
+		if (rv < 0) {
+			ni_error("netns %s: failed to refresh interface list", ns->name);
+			return NULL;
+		}
+	}
+	return ns->nc;
+}
+
+int
+ni_netns_enter(const ni_netns_t *ns)
+{
+	if (!ns) {
+		ni_netns_leave();
+		return 0;
+	}
+	if (ni_netns_host.current == ns)
+		return 0;
+
+	if (setns(ns->fd, CLONE_NEWNET) < 0) {
+		ni_error("netns %s: unable to enter namespace: %m", ns->name);
+		return -1;
+	}
+
+	if (!ni_netns_host.current) {
+		ni_netns_host.netlink = __ni_global_netlink;
+		ni_netns_host.iocfd = __ni_global_iocfd;
+	}
+	__ni_global_netlink = ns->netlink;
+	__ni_global_iocfd = ns->iocfd;
+	ni_netns_host.current = ns;
+	return 0;
+}
+
+void
+ni_netns_leave(void)
+{
+	if (!ni_netns_host.current)
+		return;
+
+	if (setns(ni_netns_host.fd, CLONE_NEWNET) < 0)
+		ni_fatal("unable to return to own network namespace: %m");
+
+	__ni_global_netlink = ni_netns_host.netlink;
+	__ni_global_iocfd = ni_netns_host.iocfd;
+	ni_netns_host.netlink = NULL;
+	ni_netns_host.iocfd = -1;
+	ni_netns_host.current = NULL;
+}
+
+int
+ni_netns_own_id(void)
+{
+	return ni_netns_host.nsid;
+}
+
+const ni_netns_t *
+ni_netns_current(void)
+{
+	return ni_netns_host.current;
+}
@@ -0,0 +1,1320 @@
+/*
+ *	Read-only shared memory snapshot of the network state
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <errno.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include <wicked/address.h>
+#include <wicked/route.h>
+#include <wicked/socket.h>
+#include <wicked/logging.h>
+#include <wicked/snapshot.h>
+#include <wicked/netns.h>
+#include "netinfo_priv.h"
+#include "util_priv.h"
+#include "buffer.h"
+
+#define NI_STATE_SNAPSHOT_MAGIC		0x574b5353U	/* "WKSS" */
+#define NI_STATE_SNAPSHOT_CAPACITY	65536U
+#define NI_STATE_SNAPSHOT_DELAY		100		/* msec, coalesces event bursts */
+#define NI_STATE_SNAPSHOT_RETRIES	1000
+
+#define ni_state_snapshot_barrier()	__sync_synchronize()
+
+/*
+ * The snapshot file consists of a header followed by the payload area.
+ * The header is in host byte order (it's for local readers only), the
+ * payload is a sequence of type-length-value records in network order.
+ *
+ * The writer makes the sequence number odd while it is modifying the
+ * payload. Readers copy the payload and retry when the sequence number
+ * was odd or has changed meanwhile. The file is rewritten in place and
+ * never shrinks, so existing reader mappings remain valid.
+ */
+typedef struct ni_state_snapshot_header {
+	uint32_t		magic;
+	uint32_t		version;
+	uint32_t		seq;
+	uint32_t		size;		/* payload length	*/
+	uint32_t		capacity;	/* payload area size	*/
+	uint32_t		flags;
+	uint64_t		generation;
+} ni_state_snapshot_header_t;
+
+/* the payload contains the routes, they are tracked by the writer */
+#define NI_STATE_SNAPSHOT_F_ROUTES	0x1U
+
+enum {
+	NI_STATE_SNAPSHOT_RECORD_DEVICE = 1,
+	NI_STATE_SNAPSHOT_RECORD_ADDRESS,
+	NI_STATE_SNAPSHOT_RECORD_ROUTE,
+	NI_STATE_SNAPSHOT_RECORD_LEASE,
+};
+
+struct ni_state_snapshot {
+	char *			path;
+	int			fd;
+	ni_bool_t		writer;
+
+	void *			map;
+	size_t			map_size;
+
+	uint64_t		generation;	/* last published/read	*/
+	ni_bool_t		routes;		/* published/read with routes */
+	const ni_timer_t *	timer;
+	ni_buffer_t		buffer;
+};
+
+static ni_state_snapshot_t *	ni_state_snapshot_publisher;
+
+const char *
+ni_state_snapshot_default_path(void)
+{
+	static char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", ni_config_statedir(), NI_STATE_SNAPSHOT_FILE);
+	return path;
+}
+
+/*
+ * Payload encoding
+ */
+static inline void
+__ni_snapshot_put(ni_buffer_t *bp, const void *data, size_t len)
+{
+	if (ni_buffer_tailroom(bp) < len)
+		ni_buffer_ensure_tailroom(bp, len + 4096);
+	ni_buffer_put(bp, data, len);
+}
+
+static inline void
+__ni_snapshot_put_u8(ni_buffer_t *bp, unsigned int value)
+{
+	uint8_t v = value;
+
+	__ni_snapshot_put(bp, &v, sizeof(v));
+}
+
+static inline void
+__ni_snapshot_put_u16(ni_buffer_t *bp, unsigned int value)
+{
+	uint16_t v = htons(value);
+
+	__ni_snapshot_put(bp, &v, sizeof(v));
+}
+
+static inline void
+__ni_snapshot_put_u32(ni_buffer_t *bp, unsigned int value)
+{
+	uint32_t v = htonl(value);
+
+	__ni_snapshot_put(bp, &v, sizeof(v));
+}
+
+static void
+__ni_snapshot_put_string(ni_buffer_t *bp, const char *str)
+{
+	size_t len = ni_string_len(str);
+
+	if (len > 255)
+		len = 255;
+	__ni_snapshot_put_u8(bp, len);
+	__ni_snapshot_put(bp, str, len);
+}
+
+static void
+__ni_snapshot_put_sockaddr(ni_buffer_t *bp, const ni_sockaddr_t *sap)
+{
+	ni_opaque_t pack = NI_OPAQUE_INIT;
+
+	if (!ni_sockaddr_pack(sap, &pack))
+		pack.len = 0;
+	__ni_snapshot_put_u8(bp, pack.len);
+	__ni_snapshot_put(bp, pack.data, pack.len);
+}
+
+static size_t
+__ni_snapshot_record_begin(ni_buffer_t *bp, unsigned int type)
+{
+	__ni_snapshot_put_u16(bp, type);
+	__ni_snapshot_put_u16(bp, 0);
+	return bp->tail;
+}
+
+static void
+__ni_snapshot_record_end(ni_buffer_t *bp, size_t start)
+{
+	size_t len = bp->tail - start;
+	uint16_t v;
+
+	if (len > 0xffff) {
+		/* drop it, e.g. a route with an insane amount of hops */
+		bp->tail = start - 2 * sizeof(v);
+		return;
+	}
+	v = htons(len);
+	memcpy(bp->base + start - sizeof(v), &v, sizeof(v));
+}
+
+static void
+__ni_snapshot_put_device(ni_buffer_t *bp, const ni_netdev_t *dev)
+{
+	size_t rec = __ni_snapshot_record_begin(bp, NI_STATE_SNAPSHOT_RECORD_DEVICE);
+
+	__ni_snapshot_put_u32(bp, dev->link.ifindex);
+	__ni_snapshot_put_u32(bp, dev->link.type);
+	__ni_snapshot_put_u32(bp, dev->link.ifflags);
+	__ni_snapshot_put_u32(bp, dev->link.mtu);
+	__ni_snapshot_put_u32(bp, dev->link.oper_state);
+	__ni_snapshot_put_u32(bp, dev->link.masterdev.index);
+	__ni_snapshot_put_string(bp, dev->link.masterdev.name);
+	__ni_snapshot_put_u32(bp, dev->link.lowerdev.index);
+	__ni_snapshot_put_string(bp, dev->link.lowerdev.name);
+	__ni_snapshot_put_u16(bp, dev->link.hwaddr.type);
+	__ni_snapshot_put_u8(bp, dev->link.hwaddr.len);
+	__ni_snapshot_put(bp, dev->link.hwaddr.data, dev->link.hwaddr.len);
+	__ni_snapshot_put_string(bp, dev->name);
+	__ni_snapshot_put_string(bp, dev->link.alias);
+
+	__ni_snapshot_record_end(bp, rec);
+}
+
+static void
+__ni_snapshot_put_address(ni_buffer_t *bp, const ni_netdev_t *dev, const ni_address_t *ap)
+{
+	size_t rec = __ni_snapshot_record_begin(bp, NI_STATE_SNAPSHOT_RECORD_ADDRESS);
+
+	__ni_snapshot_put_u32(bp, dev->link.ifindex);
+	__ni_snapshot_put_u8(bp, ap->family);
+	__ni_snapshot_put_u8(bp, ap->prefixlen);
+	__ni_snapshot_put_u8(bp, ap->owner);
+	__ni_snapshot_put_u32(bp, ap->flags);
+	__ni_snapshot_put_u32(bp, ap->scope);
+	__ni_snapshot_put_sockaddr(bp, &ap->local_addr);
+	__ni_snapshot_put_sockaddr(bp, &ap->peer_addr);
+
+	__ni_snapshot_record_end(bp, rec);
+}
+
+static void
+__ni_snapshot_put_route(ni_buffer_t *bp, const ni_route_t *rp)
+{
+	size_t rec = __ni_snapshot_record_begin(bp, NI_STATE_SNAPSHOT_RECORD_ROUTE);
+	const ni_route_nexthop_t *nh;
+	unsigned int count = 0;
+
+	for (nh = &rp->nh; nh && count < 255; nh = nh->next)
+		count++;
+
+	__ni_snapshot_put_u8(bp, rp->family);
+	__ni_snapshot_put_u8(bp, rp->prefixlen);
+	__ni_snapshot_put_u8(bp, rp->type);
+	__ni_snapshot_put_u8(bp, rp->scope);
+	__ni_snapshot_put_u8(bp, rp->protocol);
+	__ni_snapshot_put_u8(bp, rp->owner);
+	__ni_snapshot_put_u32(bp, rp->table);
+	__ni_snapshot_put_u32(bp, rp->priority);
+	__ni_snapshot_put_u32(bp, rp->flags);
+	__ni_snapshot_put_sockaddr(bp, &rp->destination);
+	__ni_snapshot_put_sockaddr(bp, &rp->pref_src);
+	__ni_snapshot_put_u8(bp, count);
+	for (nh = &rp->nh; nh && count; nh = nh->next, count--) {
+		__ni_snapshot_put_u32(bp, nh->device.index);
+		__ni_snapshot_put_u32(bp, nh->weight);
+		__ni_snapshot_put_u32(bp, nh->flags);
+		__ni_snapshot_put_sockaddr(bp, &nh->gateway);
+	}
+
+	__ni_snapshot_record_end(bp, rec);
+}
+
+static void
+__ni_snapshot_put_lease(ni_buffer_t *bp, const ni_netdev_t *dev, const ni_addrconf_lease_t *lease)
+{
+	size_t rec = __ni_snapshot_record_begin(bp, NI_STATE_SNAPSHOT_RECORD_LEASE);
+
+	__ni_snapshot_put_u32(bp, dev->link.ifindex);
+	__ni_snapshot_put_u8(bp, lease->family);
+	__ni_snapshot_put_u8(bp, lease->type);
+	__ni_snapshot_put_u8(bp, lease->state);
+	__ni_snapshot_put_u32(bp, lease->flags);
+	__ni_snapshot_put(bp, lease->uuid.octets, sizeof(lease->uuid.octets));
+	__ni_snapshot_put_u32(bp, lease->acquired.tv_sec);
+
+	__ni_snapshot_record_end(bp, rec);
+}
+
+static int
+__ni_state_snapshot_encode(ni_buffer_t *bp, ni_netconfig_t *nc, ni_bool_t routes)
+{
+	const ni_addrconf_lease_t *lease;
+	const ni_route_table_t *tab;
+	const ni_address_t *ap;
+	ni_netdev_t *dev;
+	unsigned int i;
+
+	if (!bp || !nc)
+		return -1;
+
+	/* devices first, the other records refer to them by index */
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
+		__ni_snapshot_put_device(bp, dev);
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		for (ap = dev->addrs; ap; ap = ap->next)
+			__ni_snapshot_put_address(bp, dev, ap);
+
+		for (tab = routes ? dev->routes : NULL; tab; tab = tab->next) {
+			for (i = 0; i < tab->routes.count; ++i) {
+				const ni_route_t *rp = tab->routes.data[i];
+
+				/* multipath routes are referenced by each hop device */
+				if (rp && rp->nh.device.index == dev->link.ifindex)
+					__ni_snapshot_put_route(bp, rp);
+			}
+		}
+
+		for (lease = dev->leases; lease; lease = lease->next)
+			__ni_snapshot_put_lease(bp, dev, lease);
+	}
+
+	return bp->overflow ? -1 : 0;
+}
+
+int
+ni_state_snapshot_encode(ni_buffer_t *bp, ni_netconfig_t *nc)
+{
+	return __ni_state_snapshot_encode(bp, nc, TRUE);
+}
+
+/*
+ * Payload decoding
+ */
+static inline ni_bool_t
+__ni_snapshot_get_u8(ni_buffer_t *bp, unsigned int *var)
+{
+	int cc;
+
+	if ((cc = ni_buffer_getc(bp)) == EOF)
+		return FALSE;
+	*var = cc;
+	return TRUE;
+}
+
+static inline ni_bool_t
+__ni_snapshot_get_u16(ni_buffer_t *bp, unsigned int *var)
+{
+	uint16_t v;
+
+	if (ni_buffer_get_uint16(bp, &v) < 0)
+		return FALSE;
+	*var = v;
+	return TRUE;
+}
+
+static inline ni_bool_t
+__ni_snapshot_get_u32(ni_buffer_t *bp, unsigned int *var)
+{
+	uint32_t v;
+
+	if (ni_buffer_get_uint32(bp, &v) < 0)
+		return FALSE;
+	*var = v;
+	return TRUE;
+}
+
+static ni_bool_t
+__ni_snapshot_get_string(ni_buffer_t *bp, char **str)
+{
+	const char *data;
+	unsigned int len;
+
+	if (!__ni_snapshot_get_u8(bp, &len))
+		return FALSE;
+	if (!(data = ni_buffer_pull_head(bp, len)))
+		return FALSE;
+	if (len)
+		return ni_string_set(str, data, len);
+	ni_string_free(str);
+	return TRUE;
+}
+
+static ni_bool_t
+__ni_snapshot_get_sockaddr(ni_buffer_t *bp, ni_sockaddr_t *sap)
+{
+	ni_opaque_t pack = NI_OPAQUE_INIT;
+	const void *data;
+	unsigned int len;
+
+	memset(sap, 0, sizeof(*sap));
+	if (!__ni_snapshot_get_u8(bp, &len) || len > sizeof(pack.data))
+		return FALSE;
+	if (!(data = ni_buffer_pull_head(bp, len)))
+		return FALSE;
+	if (len) {
+		memcpy(pack.data, data, len);
+		pack.len = len;
+		return ni_sockaddr_unpack(sap, &pack) != NULL;
+	}
+	return TRUE;
+}
+
+static ni_bool_t
+__ni_snapshot_get_device(ni_buffer_t *bp, ni_netconfig_t *nc)
+{
+	unsigned int ifindex, type, ifflags, mtu, oper_state, index, hwtype, hwlen;
+	char *master = NULL, *lower = NULL;
+	const void *hwdata;
+	ni_netdev_t *dev;
+
+	if (!__ni_snapshot_get_u32(bp, &ifindex) ||
+	    !__ni_snapshot_get_u32(bp, &type) ||
+	    !__ni_snapshot_get_u32(bp, &ifflags) ||
+	    !__ni_snapshot_get_u32(bp, &mtu) ||
+	    !__ni_snapshot_get_u32(bp, &oper_state))
+		return FALSE;
+
+	dev = ni_netdev_new(NULL, ifindex);
+	dev->link.type = type;
+	dev->link.ifflags = ifflags;
+	dev->link.mtu = mtu;
+	dev->link.oper_state = oper_state;
+
+	if (!__ni_snapshot_get_u32(bp, &index) ||
+	    !__ni_snapshot_get_string(bp, &master))
+		goto failure;
+	if (index)
+		ni_netdev_ref_set(&dev->link.masterdev, master, index);
+
+	if (!__ni_snapshot_get_u32(bp, &index) ||
+	    !__ni_snapshot_get_string(bp, &lower))
+		goto failure;
+	if (index)
+		ni_netdev_ref_set(&dev->link.lowerdev, lower, index);
+
+	if (!__ni_snapshot_get_u16(bp, &hwtype) ||
+	    !__ni_snapshot_get_u8(bp, &hwlen) || hwlen > NI_MAXHWADDRLEN ||
+	    !(hwdata = ni_buffer_pull_head(bp, hwlen)))
+		goto failure;
+	dev->link.hwaddr.type = hwtype;
+	dev->link.hwaddr.len = hwlen;
+	memcpy(dev->link.hwaddr.data, hwdata, hwlen);
+
+	if (!__ni_snapshot_get_string(bp, &dev->name) ||
+	    !__ni_snapshot_get_string(bp, &dev->link.alias))
+		goto failure;
+
+	ni_string_free(&master);
+	ni_string_free(&lower);
+	ni_netconfig_device_append(nc, dev);
+	return TRUE;
+
+failure:
+	ni_string_free(&master);
+	ni_string_free(&lower);
+	ni_netdev_put(dev);
+	return FALSE;
+}
+
+static ni_bool_t
+__ni_snapshot_get_address(ni_buffer_t *bp, ni_netconfig_t *nc)
+{
+	unsigned int ifindex, family, prefixlen, owner, flags, scope;
+	ni_sockaddr_t local, peer;
+	ni_address_t *ap;
+	ni_netdev_t *dev;
+
+	if (!__ni_snapshot_get_u32(bp, &ifindex) ||
+	    !__ni_snapshot_get_u8(bp, &family) ||
+	    !__ni_snapshot_get_u8(bp, &prefixlen) ||
+	    !__ni_snapshot_get_u8(bp, &owner) ||
+	    !__ni_snapshot_get_u32(bp, &flags) ||
+	    !__ni_snapshot_get_u32(bp, &scope) ||
+	    !__ni_snapshot_get_sockaddr(bp, &local) ||
+	    !__ni_snapshot_get_sockaddr(bp, &peer))
+		return FALSE;
+
+	if (!(dev = ni_netdev_by_index(nc, ifindex)))
+		return TRUE;
+
+	if (!(ap = ni_address_new(family, prefixlen, &local, &dev->addrs)))
+		return FALSE;
+	ap->owner = owner;
+	ap->flags = flags;
+	ap->scope = (int)scope;
+	ap->peer_addr = peer;
+	return TRUE;
+}
+
+static ni_bool_t
+__ni_snapshot_get_route(ni_buffer_t *bp, ni_netconfig_t *nc)
+{
+	unsigned int family, prefixlen, type, scope, protocol, owner, count, i;
+	ni_route_nexthop_t *nh;
+	ni_route_t *rp;
+
+	if (!__ni_snapshot_get_u8(bp, &family) ||
+	    !__ni_snapshot_get_u8(bp, &prefixlen) ||
+	    !__ni_snapshot_get_u8(bp, &type) ||
+	    !__ni_snapshot_get_u8(bp, &scope) ||
+	    !__ni_snapshot_get_u8(bp, &protocol) ||
+	    !__ni_snapshot_get_u8(bp, &owner))
+		return FALSE;
+
+	rp = ni_route_new();
+	rp->family = family;
+	rp->prefixlen = prefixlen;
+	rp->type = type;
+	rp->scope = scope;
+	rp->protocol = protocol;
+	rp->owner = owner;
+
+	if (!__ni_snapshot_get_u32(bp, &rp->table) ||
+	    !__ni_snapshot_get_u32(bp, &rp->priority) ||
+	    !__ni_snapshot_get_u32(bp, &rp->flags) ||
+	    !__ni_snapshot_get_sockaddr(bp, &rp->destination) ||
+	    !__ni_snapshot_get_sockaddr(bp, &rp->pref_src) ||
+	    !__ni_snapshot_get_u8(bp, &count) || !count)
+		goto failure;
+
+	for (i = 0, nh = &rp->nh; i < count; ++i) {
+		if (i) {
+			nh = ni_route_nexthop_new();
+			ni_route_nexthop_list_append(&rp->nh.next, nh);
+		}
+		if (!__ni_snapshot_get_u32(bp, &nh->device.index) ||
+		    !__ni_snapshot_get_u32(bp, &nh->weight) ||
+		    !__ni_snapshot_get_u32(bp, &nh->flags) ||
+		    !__ni_snapshot_get_sockaddr(bp, &nh->gateway))
+			goto failure;
+	}
+
+	/* records the route in the route tables of the hop devices */
+	ni_netconfig_route_add(nc, rp, NULL);
+	ni_route_free(rp);
+	return TRUE;
+
+failure:
+	ni_route_free(rp);
+	return FALSE;
+}
+
+static ni_bool_t
+__ni_snapshot_get_lease(ni_buffer_t *bp, ni_netconfig_t *nc)
+{
+	unsigned int ifindex, family, type, state, flags, acquired;
+	ni_addrconf_lease_t *lease;
+	const void *uuid;
+	ni_netdev_t *dev;
+
+	if (!__ni_snapshot_get_u32(bp, &ifindex) ||
+	    !__ni_snapshot_get_u8(bp, &family) ||
+	    !__ni_snapshot_get_u8(bp, &type) ||
+	    !__ni_snapshot_get_u8(bp, &state) ||
+	    !__ni_snapshot_get_u32(bp, &flags) ||
+	    !(uuid = ni_buffer_pull_head(bp, sizeof(lease->uuid.octets))) ||
+	    !__ni_snapshot_get_u32(bp, &acquired))
+		return FALSE;
+
+	if (!(dev = ni_netdev_by_index(nc, ifindex)))
+		return TRUE;
+
+	if (!(lease = ni_addrconf_lease_new(type, family)))
+		return FALSE;
+	lease->state = state;
+	lease->flags = flags;
+	memcpy(lease->uuid.octets, uuid, sizeof(lease->uuid.octets));
+	lease->acquired.tv_sec = acquired;
+	ni_netdev_set_lease(dev, lease);
+	return TRUE;
+}
+
+ni_netconfig_t *
+ni_state_snapshot_decode(const void *data, size_t size)
+{
+	ni_buffer_t buf, rec;
+	unsigned int type, len;
+	ni_netconfig_t *nc;
+	void *body;
+	ni_bool_t ok;
+
+	if (!(nc = ni_netconfig_new()))
+		return NULL;
+
+	ni_buffer_init_reader(&buf, (void *)data, size);
+	while (ni_buffer_count(&buf)) {
+		if (!__ni_snapshot_get_u16(&buf, &type) ||
+		    !__ni_snapshot_get_u16(&buf, &len) ||
+		    !(body = ni_buffer_pull_head(&buf, len)))
+			goto failure;
+
+		ni_buffer_init_reader(&rec, body, len);
+		switch (type) {
+		case NI_STATE_SNAPSHOT_RECORD_DEVICE:
+			ok = __ni_snapshot_get_device(&rec, nc);
+			break;
+		case NI_STATE_SNAPSHOT_RECORD_ADDRESS:
+			ok = __ni_snapshot_get_address(&rec, nc);
+			break;
+		case NI_STATE_SNAPSHOT_RECORD_ROUTE:
+			ok = __ni_snapshot_get_route(&rec, nc);
+			break;
+		case NI_STATE_SNAPSHOT_RECORD_LEASE:
+			ok = __ni_snapshot_get_lease(&rec, nc);
+			break;
+		default:
+			/* added in a later revision of the format */
+			ok = TRUE;
+			break;
+		}
+		if (!ok)
+			goto failure;
+	}
+	return nc;
+
+failure:
+	ni_error("state snapshot: malformed record at offset %zu", buf.head);
+	ni_netconfig_free(nc);
+	return NULL;
+}
+
+/*
+ * Snapshot file handling
+ */
+static ni_state_snapshot_t *
+__ni_state_snapshot_new(const char *path, ni_bool_t writer)
+{
+	ni_state_snapshot_t *snap;
+
+	snap = xcalloc(1, sizeof(*snap));
+	ni_string_dup(&snap->path, path ? path : ni_state_snapshot_default_path());
+	snap->writer = writer;
+	snap->fd = -1;
+	ni_buffer_init_dynamic(&snap->buffer, NI_STATE_SNAPSHOT_CAPACITY);
+	return snap;
+}
+
+static int
+__ni_state_snapshot_map(ni_state_snapshot_t *snap, size_t size)
+{
+	void *map;
+
+	if (snap->map && snap->map_size >= size)
+		return 0;
+
+	if (snap->writer && ftruncate(snap->fd, size) < 0) {
+		ni_error("state snapshot %s: cannot resize to %zu bytes: %m", snap->path, size);
+		return -1;
+	}
+
+	map = mmap(NULL, size, snap->writer ? PROT_READ | PROT_WRITE : PROT_READ,
+			MAP_SHARED, snap->fd, 0);
+	if (map == MAP_FAILED) {
+		ni_error("state snapshot %s: cannot map %zu bytes: %m", snap->path, size);
+		return -1;
+	}
+
+	if (snap->map)
+		munmap(snap->map, snap->map_size);
+	snap->map = map;
+	snap->map_size = size;
+	return 0;
+}
+
+static size_t
+__ni_state_snapshot_map_size(size_t payload)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t size = sizeof(ni_state_snapshot_header_t) + payload;
+
+	return (size + page - 1) / page * page;
+}
+
+ni_state_snapshot_t *
+ni_state_snapshot_create(const char *path)
+{
+	ni_state_snapshot_header_t *hdr;
+	ni_state_snapshot_t *snap;
+	struct stat stb;
+	size_t size;
+
+	snap = __ni_state_snapshot_new(path, TRUE);
+	if ((snap->fd = open(snap->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0) {
+		ni_error("state snapshot %s: cannot open: %m", snap->path);
+		goto failure;
+	}
+	if (fstat(snap->fd, &stb) < 0 || !S_ISREG(stb.st_mode)) {
+		ni_error("state snapshot %s: not a regular file", snap->path);
+		goto failure;
+	}
+
+	/* reuse the file of a previous instance, readers keep their mapping */
+	size = __ni_state_snapshot_map_size(NI_STATE_SNAPSHOT_CAPACITY);
+	if ((size_t)stb.st_size > size)
+		size = stb.st_size;
+	if (__ni_state_snapshot_map(snap, size) < 0)
+		goto failure;
+
+	hdr = snap->map;
+	if (hdr->magic != NI_STATE_SNAPSHOT_MAGIC || hdr->version != NI_STATE_SNAPSHOT_VERSION) {
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->version = NI_STATE_SNAPSHOT_VERSION;
+		ni_state_snapshot_barrier();
+		hdr->magic = NI_STATE_SNAPSHOT_MAGIC;
+	} else if (hdr->seq & 1) {
+		/* previous writer died while updating */
+		hdr->seq++;
+	}
+	hdr->capacity = snap->map_size - sizeof(*hdr);
+	snap->generation = hdr->generation;
+	snap->routes = ni_server_listens_route_events();
+
+	ni_state_snapshot_publisher = snap;
+	return snap;
+
+failure:
+	ni_state_snapshot_free(snap);
+	return NULL;
+}
+
+int
+ni_state_snapshot_publish(ni_state_snapshot_t *snap, ni_netconfig_t *nc)
+{
+	volatile ni_state_snapshot_header_t *hdr;
+	size_t len;
+
+	if (!snap || !snap->writer || !nc)
+		return -1;
+
+	ni_buffer_reset(&snap->buffer);
+	if (__ni_state_snapshot_encode(&snap->buffer, nc, snap->routes) < 0) {
+		ni_error("state snapshot %s: cannot encode network state", snap->path);
+		return -1;
+	}
+
+	len = ni_buffer_count(&snap->buffer);
+	if (sizeof(*hdr) + len > snap->map_size &&
+	    __ni_state_snapshot_map(snap, __ni_state_snapshot_map_size(2 * len)) < 0)
+		return -1;
+
+	hdr = snap->map;
+	hdr->capacity = snap->map_size - sizeof(*hdr);
+
+	hdr->seq++;
+	ni_state_snapshot_barrier();
+	memcpy((unsigned char *)snap->map + sizeof(*hdr), ni_buffer_head(&snap->buffer), len);
+	hdr->size = len;
+	hdr->flags = snap->routes ? NI_STATE_SNAPSHOT_F_ROUTES : 0;
+	hdr->generation = ++snap->generation;
+	ni_state_snapshot_barrier();
+	hdr->seq++;
+
+	ni_debug_ifconfig("state snapshot %s: published generation %llu (%zu bytes)",
+			snap->path, (unsigned long long)snap->generation, len);
+	return 0;
+}
+
+static void
+__ni_state_snapshot_timeout(void *user_data, const ni_timer_t *timer)
+{
+	ni_state_snapshot_t *snap = user_data;
+
+	if (snap->timer != timer)
+		return;
+
+	snap->timer = NULL;
+	ni_state_snapshot_publish(snap, ni_global_state_handle(0));
+}
+
+/*
+ * Routes are published only while they are tracked, otherwise the
+ * snapshot would contain the routes of the last refresh.
+ */
+void
+ni_state_snapshot_track_routes(ni_bool_t routes)
+{
+	ni_state_snapshot_t *snap = ni_state_snapshot_publisher;
+
+	if (!snap || snap->routes == routes)
+		return;
+
+	snap->routes = routes;
+	ni_state_snapshot_notify();
+}
+
+/*
+ * Called on state changes; publishes the global state after a short
+ * delay, so a burst of events results in one snapshot update only.
+ */
+void
+ni_state_snapshot_notify(void)
+{
+	ni_state_snapshot_t *snap = ni_state_snapshot_publisher;
+
+	if (!snap || snap->timer)
+		return;
+
+	snap->timer = ni_timer_register(NI_STATE_SNAPSHOT_DELAY,
+					__ni_state_snapshot_timeout, snap);
+}
+
+ni_state_snapshot_t *
+ni_state_snapshot_open(const char *path)
+{
+	ni_state_snapshot_t *snap;
+	struct stat stb;
+
+	snap = __ni_state_snapshot_new(path, FALSE);
+	if ((snap->fd = open(snap->path, O_RDONLY | O_CLOEXEC)) < 0) {
+		ni_debug_ifconfig("state snapshot %s: cannot open: %m", snap->path);
+		goto failure;
+	}
+	if (fstat(snap->fd, &stb) < 0 || (size_t)stb.st_size < sizeof(ni_state_snapshot_header_t)) {
+		ni_debug_ifconfig("state snapshot %s: not published yet", snap->path);
+		goto failure;
+	}
+	if (__ni_state_snapshot_map(snap, stb.st_size) < 0)
+		goto failure;
+
+	return snap;
+
+failure:
+	ni_state_snapshot_free(snap);
+	return NULL;
+}
+
+/*
+ * Decode a consistent copy of the current snapshot into *ncp.
+ * Returns 1 when updated, 0 when unchanged since the last read.
+ */
+int
+ni_state_snapshot_read(ni_state_snapshot_t *snap, ni_netconfig_t **ncp)
+{
+	const volatile ni_state_snapshot_header_t *hdr;
+	uint32_t seq, size, capacity, flags;
+	unsigned int retries;
+	uint64_t generation;
+	ni_netconfig_t *nc;
+
+	if (!snap || !snap->map || !ncp)
+		return -1;
+
+	for (retries = 0; retries < NI_STATE_SNAPSHOT_RETRIES; ++retries) {
+		hdr = snap->map;
+		if (hdr->magic != NI_STATE_SNAPSHOT_MAGIC ||
+		    hdr->version != NI_STATE_SNAPSHOT_VERSION) {
+			ni_error("state snapshot %s: unsupported format", snap->path);
+			return -1;
+		}
+
+		seq = hdr->seq;
+		if (seq & 1) {
+			sched_yield();
+			continue;
+		}
+		ni_state_snapshot_barrier();
+
+		generation = hdr->generation;
+		if (*ncp && generation == snap->generation)
+			return 0;
+
+		size = hdr->size;
+		capacity = hdr->capacity;
+		flags = hdr->flags;
+		if (sizeof(*hdr) + capacity > snap->map_size) {
+			/* grown by the writer */
+			if (__ni_state_snapshot_map(snap, sizeof(*hdr) + capacity) < 0)
+				return -1;
+			continue;
+		}
+		if (size > capacity)
+			continue;
+
+		ni_buffer_reset(&snap->buffer);
+		__ni_snapshot_put(&snap->buffer, (const unsigned char *)snap->map + sizeof(*hdr), size);
+
+		ni_state_snapshot_barrier();
+		if (hdr->seq != seq)
+			continue;
+
+		if (!(nc = ni_state_snapshot_decode(ni_buffer_head(&snap->buffer), size)))
+			return -1;
+
+		if (*ncp)
+			ni_netconfig_free(*ncp);
+		*ncp = nc;
+		snap->generation = generation;
+		snap->routes = !!(flags & NI_STATE_SNAPSHOT_F_ROUTES);
+		return 1;
+	}
+
+	ni_debug_ifconfig("state snapshot %s: writer busy, giving up", snap->path);
+	return -1;
+}
+
+uint64_t
+ni_state_snapshot_generation(const ni_state_snapshot_t *snap)
+{
+	return snap ? snap->generation : 0;
+}
+
+ni_bool_t
+ni_state_snapshot_has_routes(const ni_state_snapshot_t *snap)
+{
+	return snap ? snap->routes : FALSE;
+}
+
+void
+ni_state_snapshot_free(ni_state_snapshot_t *snap)
+{
+	if (!snap)
+		return;
+
+	if (ni_state_snapshot_publisher == snap)
+		ni_state_snapshot_publisher = NULL;
+	if (snap->timer)
+		ni_timer_cancel(snap->timer);
+	if (snap->map)
+		munmap(snap->map, snap->map_size);
+	if (snap->fd >= 0)
+		close(snap->fd);
+	ni_buffer_destroy(&snap->buffer);
+	ni_string_free(&snap->path);
+	free(snap);
+}
+
+/*
+ * State feed
+ *
+ * The feed file consists of a header followed by a ring of entries,
+ * each an entry header and a payload of snapshot records describing
+ * the device and its leases. Entries are 8 byte aligned and may wrap
+ * around the end of the ring.
+ *
+ * The writer first advances the limit over the area it is going to
+ * overwrite, then writes the entry and finally advances the head.
+ * Readers copy the entries between their position and the head and
+ * check afterwards, that the limit did not run over their position.
+ * A reader which fell behind by more than the ring size has lost
+ * entries and has to resync from the full state.
+ */
+#define NI_STATE_FEED_MAGIC		0x574b5346U	/* "WKSF" */
+#define NI_STATE_FEED_CAPACITY		262144U
+#define NI_STATE_FEED_ALIGN		8U
+
+typedef struct ni_state_feed_header {
+	uint32_t		magic;
+	uint32_t		version;
+	uint32_t		capacity;	/* ring size		*/
+	uint32_t		reserved;
+	uint64_t		epoch;		/* writer instance	*/
+	uint64_t		generation;	/* of the last entry	*/
+	uint64_t		head;		/* end of last entry	*/
+	uint64_t		limit;		/* end of written area	*/
+} ni_state_feed_header_t;
+
+typedef struct ni_state_feed_entry {
+	uint32_t		length;		/* of the payload	*/
+	uint16_t		event;
+	uint16_t		deleted;
+	uint32_t		ifindex;
+	uint32_t		reserved;
+	uint64_t		generation;
+} ni_state_feed_entry_t;
+
+struct ni_state_feed {
+	char *			path;
+	int			fd;
+	ni_bool_t		writer;
+
+	void *			map;
+	size_t			map_size;
+
+	uint64_t		epoch;
+	uint64_t		position;	/* reader: next entry	*/
+	uint64_t		generation;	/* last written/read	*/
+	ni_buffer_t		buffer;
+};
+
+static ni_state_feed_t *	ni_state_feed_publisher;
+
+const char *
+ni_state_feed_default_path(void)
+{
+	static char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", ni_config_statedir(), NI_STATE_FEED_FILE);
+	return path;
+}
+
+static inline size_t
+__ni_state_feed_align(size_t len)
+{
+	return (len + NI_STATE_FEED_ALIGN - 1) & ~(size_t)(NI_STATE_FEED_ALIGN - 1);
+}
+
+static ni_state_feed_t *
+__ni_state_feed_new(const char *path, ni_bool_t writer)
+{
+	ni_state_feed_t *feed;
+
+	feed = xcalloc(1, sizeof(*feed));
+	ni_string_dup(&feed->path, path ? path : ni_state_feed_default_path());
+	feed->writer = writer;
+	feed->fd = -1;
+	ni_buffer_init_dynamic(&feed->buffer, 4096);
+	return feed;
+}
+
+static int
+__ni_state_feed_map(ni_state_feed_t *feed, size_t size)
+{
+	void *map;
+
+	if (feed->writer && ftruncate(feed->fd, size) < 0) {
+		ni_error("state feed %s: cannot resize to %zu bytes: %m", feed->path, size);
+		return -1;
+	}
+
+	map = mmap(NULL, size, feed->writer ? PROT_READ | PROT_WRITE : PROT_READ,
+			MAP_SHARED, feed->fd, 0);
+	if (map == MAP_FAILED) {
+		ni_error("state feed %s: cannot map %zu bytes: %m", feed->path, size);
+		return -1;
+	}
+	if (feed->map)
+		munmap(feed->map, feed->map_size);
+	feed->map = map;
+	feed->map_size = size;
+	return 0;
+}
+
+static inline unsigned char *
+__ni_state_feed_ring(const ni_state_feed_t *feed)
+{
+	return (unsigned char *)feed->map + sizeof(ni_state_feed_header_t);
+}
+
+/*
+ * Copy to and from the ring at a feed position, wrapping around
+ */
+static void
+__ni_state_feed_ring_put(ni_state_feed_t *feed, uint64_t pos, const void *data, size_t len)
+{
+	const ni_state_feed_header_t *hdr = feed->map;
+	size_t off = pos % hdr->capacity;
+	size_t part = hdr->capacity - off;
+
+	if (part > len)
+		part = len;
+	memcpy(__ni_state_feed_ring(feed) + off, data, part);
+	memcpy(__ni_state_feed_ring(feed), (const unsigned char *)data + part, len - part);
+}
+
+static void
+__ni_state_feed_ring_get(const ni_state_feed_t *feed, uint32_t capacity, uint64_t pos,
+		void *data, size_t len)
+{
+	size_t off = pos % capacity;
+	size_t part = capacity - off;
+
+	if (part > len)
+		part = len;
+	memcpy(data, __ni_state_feed_ring(feed) + off, part);
+	memcpy((unsigned char *)data + part, __ni_state_feed_ring(feed), len - part);
+}
+
+ni_state_feed_t *
+ni_state_feed_create(const char *path, unsigned int capacity)
+{
+	ni_state_feed_header_t *hdr;
+	ni_state_feed_t *feed;
+	struct stat stb;
+
+	if (!capacity)
+		capacity = NI_STATE_FEED_CAPACITY;
+	capacity = __ni_state_feed_align(capacity);
+
+	feed = __ni_state_feed_new(path, TRUE);
+	if ((feed->fd = open(feed->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0) {
+		ni_error("state feed %s: cannot open: %m", feed->path);
+		goto failure;
+	}
+	if (fstat(feed->fd, &stb) < 0 || !S_ISREG(stb.st_mode)) {
+		ni_error("state feed %s: not a regular file", feed->path);
+		goto failure;
+	}
+
+	/* keep the header of a previous instance, readers notice the new epoch */
+	if ((size_t)stb.st_size > sizeof(*hdr) + capacity)
+		capacity = stb.st_size - sizeof(*hdr);
+	if (__ni_state_feed_map(feed, sizeof(*hdr) + capacity) < 0)
+		goto failure;
+
+	hdr = feed->map;
+	if (hdr->magic != NI_STATE_FEED_MAGIC || hdr->version != NI_STATE_FEED_VERSION) {
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->version = NI_STATE_FEED_VERSION;
+		ni_state_snapshot_barrier();
+		hdr->magic = NI_STATE_FEED_MAGIC;
+	}
+
+	/* readers of a previous instance notice the new epoch and resync */
+	hdr->capacity = capacity;
+	hdr->limit = hdr->head;
+	ni_state_snapshot_barrier();
+	hdr->epoch++;
+
+	feed->epoch = hdr->epoch;
+	feed->generation = hdr->generation;
+	ni_state_feed_publisher = feed;
+	return feed;
+
+failure:
+	ni_state_feed_free(feed);
+	return NULL;
+}
+
+/*
+ * Append the state of a device after an event
+ */
+int
+ni_state_feed_append(ni_state_feed_t *feed, const ni_netdev_t *dev, ni_event_t event)
+{
+	volatile ni_state_feed_header_t *hdr;
+	const ni_addrconf_lease_t *lease;
+	ni_state_feed_entry_t entry;
+	size_t len, total;
+	uint64_t head;
+
+	if (!feed || !feed->writer || !dev)
+		return -1;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.event = event;
+	entry.ifindex = dev->link.ifindex;
+	entry.deleted = event == NI_EVENT_DEVICE_DELETE;
+
+	ni_buffer_reset(&feed->buffer);
+	if (!entry.deleted) {
+		__ni_snapshot_put_device(&feed->buffer, dev);
+		for (lease = dev->leases; lease; lease = lease->next)
+			__ni_snapshot_put_lease(&feed->buffer, dev, lease);
+	}
+	len = ni_buffer_count(&feed->buffer);
+	entry.length = len;
+
+	hdr = feed->map;
+	total = __ni_state_feed_align(sizeof(entry) + len);
+	if (feed->buffer.overflow || total > hdr->capacity / 4) {
+		ni_error("state feed %s: %s state too large for the feed",
+				feed->path, dev->name);
+		return -1;
+	}
+
+	head = hdr->head;
+	entry.generation = ++feed->generation;
+
+	hdr->limit = head + total;
+	ni_state_snapshot_barrier();
+	__ni_state_feed_ring_put(feed, head, &entry, sizeof(entry));
+	__ni_state_feed_ring_put(feed, head + sizeof(entry), ni_buffer_head(&feed->buffer), len);
+	ni_state_snapshot_barrier();
+	hdr->generation = entry.generation;
+	hdr->head = head + total;
+	return 0;
+}
+
+/*
+ * Called before event signals of a device are sent
+ */
+void
+ni_state_feed_notify(const ni_netdev_t *dev, ni_event_t event)
+{
+	/* the feed describes the own namespace, as the snapshot does */
+	if (dev && dev->link.netnsid != NI_NETNS_ID_NONE)
+		return;
+
+	if (ni_state_feed_publisher)
+		ni_state_feed_append(ni_state_feed_publisher, dev, event);
+}
+
+ni_state_feed_t *
+ni_state_feed_open(const char *path)
+{
+	const volatile ni_state_feed_header_t *hdr;
+	ni_state_feed_t *feed;
+	struct stat stb;
+
+	feed = __ni_state_feed_new(path, FALSE);
+	if ((feed->fd = open(feed->path, O_RDONLY | O_CLOEXEC)) < 0) {
+		ni_debug_ifconfig("state feed %s: cannot open: %m", feed->path);
+		goto failure;
+	}
+	if (fstat(feed->fd, &stb) < 0 || (size_t)stb.st_size <= sizeof(ni_state_feed_header_t)) {
+		ni_debug_ifconfig("state feed %s: not published yet", feed->path);
+		goto failure;
+	}
+	if (__ni_state_feed_map(feed, stb.st_size) < 0)
+		goto failure;
+
+	hdr = feed->map;
+	if (hdr->magic != NI_STATE_FEED_MAGIC || hdr->version != NI_STATE_FEED_VERSION ||
+	    sizeof(*hdr) + hdr->capacity > feed->map_size) {
+		ni_error("state feed %s: unsupported format", feed->path);
+		goto failure;
+	}
+
+	/* start with the entries written from now on */
+	feed->epoch = hdr->epoch;
+	ni_state_snapshot_barrier();
+	feed->generation = hdr->generation;
+	feed->position = hdr->head;
+	return feed;
+
+failure:
+	ni_state_feed_free(feed);
+	return NULL;
+}
+
+static ni_bool_t
+__ni_state_feed_deliver(const ni_state_feed_entry_t *entry, const void *payload,
+		ni_state_feed_fn_t *func, void *user_data)
+{
+	ni_netconfig_t *nc;
+
+	if (entry->deleted) {
+		func(entry->generation, entry->event, entry->ifindex, NULL, user_data);
+		return TRUE;
+	}
+
+	if (!(nc = ni_state_snapshot_decode(payload, entry->length)))
+		return FALSE;
+	func(entry->generation, entry->event, entry->ifindex,
+			ni_netdev_by_index(nc, entry->ifindex), user_data);
+	ni_netconfig_free(nc);
+	return TRUE;
+}
+
+/*
+ * Pass the entries written since the last call to func.
+ * Returns the number of entries, or -1 when entries were lost
+ * (the reader continues with the current head then).
+ */
+int
+ni_state_feed_read(ni_state_feed_t *feed, ni_state_feed_fn_t *func, void *user_data)
+{
+	const volatile ni_state_feed_header_t *hdr;
+	ni_state_feed_entry_t entry;
+	uint64_t head, limit, pos;
+	uint32_t capacity;
+	unsigned char *data;
+	size_t len, off;
+	int count = 0;
+
+	if (!feed || feed->writer || !feed->map || !func)
+		return -1;
+
+	hdr = feed->map;
+	capacity = hdr->capacity;
+	head = hdr->head;
+	ni_state_snapshot_barrier();
+
+	if (hdr->epoch != feed->epoch || sizeof(*hdr) + capacity > feed->map_size ||
+	    head < feed->position || head - feed->position > capacity)
+		goto lost;
+	if (head == feed->position)
+		return 0;
+
+	/* copy all pending entries at once, then verify them */
+	len = head - feed->position;
+	ni_buffer_reset(&feed->buffer);
+	if (ni_buffer_tailroom(&feed->buffer) < len)
+		ni_buffer_ensure_tailroom(&feed->buffer, len);
+	data = ni_buffer_tail(&feed->buffer);
+	__ni_state_feed_ring_get(feed, capacity, feed->position, data, len);
+
+	ni_state_snapshot_barrier();
+	limit = hdr->limit;
+	if (hdr->epoch != feed->epoch || limit - feed->position > capacity)
+		goto lost;
+
+	for (off = 0, pos = feed->position; off + sizeof(entry) <= len; ) {
+		memcpy(&entry, data + off, sizeof(entry));
+		if (off + sizeof(entry) + entry.length > len) {
+			ni_error("state feed %s: malformed entry", feed->path);
+			goto lost;
+		}
+
+		if (!__ni_state_feed_deliver(&entry, data + off + sizeof(entry),
+					func, user_data))
+			goto lost;
+
+		feed->generation = entry.generation;
+		off += __ni_state_feed_align(sizeof(entry) + entry.length);
+		count++;
+	}
+	feed->position = pos + len;
+	return count;
+
+lost:
+	ni_debug_ifconfig("state feed %s: lost entries after generation %llu",
+			feed->path, (unsigned long long)feed->generation);
+	if (sizeof(*hdr) + hdr->capacity > feed->map_size &&
+	    __ni_state_feed_map(feed, sizeof(*hdr) + hdr->capacity) == 0)
+		hdr = feed->map;
+	feed->epoch = hdr->epoch;
+	ni_state_snapshot_barrier();
+	feed->generation = hdr->generation;
+	feed->position = hdr->head;
+	return -1;
+}
+
+uint64_t
+ni_state_feed_generation(const ni_state_feed_t *feed)
+{
+	return feed ? feed->generation : 0;
+}
+
+void
+ni_state_feed_free(ni_state_feed_t *feed)
+{
+	if (!feed)
+		return;
+
+	if (ni_state_feed_publisher == feed)
+		ni_state_feed_publisher = NULL;
+	if (feed->map)
+		munmap(feed->map, feed->map_size);
+	if (feed->fd >= 0)
+		close(feed->fd);
+	ni_buffer_destroy(&feed->buffer);
+	ni_string_free(&feed->path);
+	free(feed);
+}
@@ -109,6 +109,51 @@ __ni_default_hangup_handler(ni_socket_t *sock)
 {
 }
 
+/*
+ * Main loop stall accounting: the time spent in the socket callbacks
+ * after a wakeup, which is the delay any other pending event sees.
+ */
+static const unsigned int	ni_socket_stall_limits[] = {
+	1, 5, 10, 50, 100, 500, 1000
+};
+#define NI_SOCKET_STALL_LIMITS		(sizeof(ni_socket_stall_limits)/sizeof(ni_socket_stall_limits[0]))
+static unsigned long		ni_socket_stall_hist[NI_SOCKET_STALL_LIMITS + 1];
+
+static void
+ni_socket_stall_account(const struct timeval *begin)
+{
+	struct timeval now, delta;
+	unsigned long msec;
+	unsigned int i;
+
+	ni_timer_get_time(&now);
+	timersub(&now, begin, &delta);
+	msec = delta.tv_sec * 1000 + delta.tv_usec / 1000;
+
+	for (i = 0; i < NI_SOCKET_STALL_LIMITS; ++i) {
+		if (msec < ni_socket_stall_limits[i])
+			break;
+	}
+	ni_socket_stall_hist[i]++;
+}
+
+void
+ni_socket_stall_report(void)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	unsigned int i;
+
+	for (i = 0; i < NI_SOCKET_STALL_LIMITS + 1; ++i) {
+		if (i < NI_SOCKET_STALL_LIMITS)
+			ni_stringbuf_printf(&buf, "%s<%ums: %lu", i ? ", " : "",
+					ni_socket_stall_limits[i], ni_socket_stall_hist[i]);
+		else
+			ni_stringbuf_printf(&buf, ", >=%ums: %lu",
+					ni_socket_stall_limits[i - 1], ni_socket_stall_hist[i]);
+	}
+	ni_debug_socket("main loop stalls: %s", buf.string);
+	ni_stringbuf_destroy(&buf);
+}
 
 /*
  * Wait for incoming data on any of the sockets.
@@ -117,7 +162,7 @@ int
 ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 {
 	struct pollfd pfd[array->count];
-	struct timeval now, expires;
+	struct timeval now, expires, begin;
 	unsigned int i, socket_count;
 
 	/* First step - cleanup empty socket slots from the array. */
@@ -170,6 +215,7 @@ ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 		ni_error("poll returns error: %m");
 		return -1;
 	}
+	ni_timer_get_time(&begin);
 
 	for (i = 0; i < socket_count; ++i) {
 		ni_socket_t *sock = array->data[i];
@@ -231,6 +277,9 @@ done_with_this_socket:
 			sock->check_timeout(sock, &now);
 	}
 
+	if (array == &__ni_sockets)
+		ni_socket_stall_account(&begin);
+
 	/* Finally cleanup deactivated/released sockets */
 	ni_socket_array_cleanup(array);
 
@@ -9,6 +9,8 @@
 
 #include <unistd.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <net/if_arp.h>
 
 #include <wicked/netinfo.h>
@@ -784,18 +786,28 @@ static int
 __ni_sysfs_read_string(const char *pathname, char **result)
 {
 	char buffer[256];
-	FILE *fp;
-
-	if (!(fp = fopen(pathname, "r")))
+	ssize_t len;
+	int fd;
+
+	/*
+	 * Attributes are read one by one in large numbers, so use plain
+	 * syscalls -- stdio would add a stat and a buffer allocation.
+	 */
+	if ((fd = open(pathname, O_RDONLY | O_CLOEXEC)) < 0)
 		return -1;
 
 	ni_string_free(result);
 
-	if (fgets(buffer, sizeof(buffer), fp) != NULL) {
+	do {
+		len = read(fd, buffer, sizeof(buffer) - 1);
+	} while (len < 0 && errno == EINTR);
+	close(fd);
+
+	if (len > 0) {
+		buffer[len] = '\0';
 		buffer[strcspn(buffer, "\n")] = '\0';
 		ni_string_dup(result, buffer);
 	}
-	fclose(fp);
 	return 0;
 }
 
@@ -0,0 +1,341 @@
+/*
+ *	Worker thread pool for blocking operations
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/socket.h>
+#include "socket_priv.h"
+#include "util_priv.h"
+#include "workpool.h"
+
+typedef struct ni_work		ni_work_t;
+struct ni_work {
+	ni_work_t *		next;
+	char *			key;
+
+	ni_work_fn_t *		func;
+	ni_work_done_fn_t *	done;
+	void *			data;
+	int			result;
+};
+
+/*
+ * Work is queued under the pool lock, picked up by the worker threads
+ * and moved into the completed list, which is processed by the main
+ * thread when the eventfd wakes up the socket loop.
+ */
+struct ni_workpool {
+	char *			name;
+
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	ni_bool_t		stopping;
+
+	unsigned int		nthreads;
+	pthread_t *		threads;
+
+	ni_work_t *		queue;
+	ni_work_t *		running;
+	ni_work_t *		completed;
+
+	ni_socket_t *		sock;
+};
+
+static ni_workpool_t *		ni_workpool_global_pool;
+
+static void
+ni_work_free(ni_work_t *work)
+{
+	ni_string_free(&work->key);
+	free(work);
+}
+
+static void
+__ni_work_list_append(ni_work_t **list, ni_work_t *work)
+{
+	while (*list)
+		list = &(*list)->next;
+	work->next = NULL;
+	*list = work;
+}
+
+static void
+__ni_work_list_unlink(ni_work_t **list, ni_work_t *work)
+{
+	for (; *list; list = &(*list)->next) {
+		if (*list == work) {
+			*list = work->next;
+			work->next = NULL;
+			return;
+		}
+	}
+}
+
+static ni_bool_t
+__ni_work_list_has_key(const ni_work_t *list, const char *key)
+{
+	for (; key && list; list = list->next) {
+		if (ni_string_eq(list->key, key))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Take the first queued work item whose key is not busy; caller holds the lock
+ */
+static ni_work_t *
+__ni_workpool_dequeue(ni_workpool_t *pool)
+{
+	ni_work_t **pos, *work;
+
+	for (pos = &pool->queue; (work = *pos) != NULL; pos = &work->next) {
+		if (__ni_work_list_has_key(pool->running, work->key))
+			continue;
+
+		*pos = work->next;
+		work->next = pool->running;
+		pool->running = work;
+		return work;
+	}
+	return NULL;
+}
+
+static void
+__ni_workpool_wakeup(ni_workpool_t *pool)
+{
+	uint64_t one = 1;
+
+	/* a failing write means the counter is pending anyway */
+	if (write(pool->sock->__fd, &one, sizeof(one)) < 0)
+		return;
+}
+
+static void *
+__ni_workpool_thread(void *user_data)
+{
+	ni_workpool_t *pool = user_data;
+	ni_work_t *work;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		if (!(work = __ni_workpool_dequeue(pool))) {
+			if (pool->stopping && !pool->queue)
+				break;
+			pthread_cond_wait(&pool->cond, &pool->lock);
+			continue;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+		work->result = work->func(work->data);
+		pthread_mutex_lock(&pool->lock);
+
+		__ni_work_list_unlink(&pool->running, work);
+		__ni_work_list_append(&pool->completed, work);
+
+		/* another item with this key may be runnable now */
+		pthread_cond_broadcast(&pool->cond);
+		__ni_workpool_wakeup(pool);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/*
+ * Run the done callbacks of completed work in the main thread
+ */
+static void
+__ni_workpool_complete(ni_workpool_t *pool)
+{
+	ni_work_t *list, *work;
+
+	pthread_mutex_lock(&pool->lock);
+	list = pool->completed;
+	pool->completed = NULL;
+	pthread_mutex_unlock(&pool->lock);
+
+	while ((work = list) != NULL) {
+		list = work->next;
+		if (work->done)
+			work->done(work->data, work->result);
+		ni_work_free(work);
+	}
+}
+
+static void
+__ni_workpool_receive(ni_socket_t *sock)
+{
+	ni_workpool_t *pool = sock->user_data;
+	uint64_t count;
+
+	if (read(sock->__fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		ni_error("%s: unable to read work completion event: %m", pool->name);
+
+	__ni_workpool_complete(pool);
+}
+
+ni_workpool_t *
+ni_workpool_new(const char *name, unsigned int threads)
+{
+	ni_workpool_t *pool;
+	int efd, err;
+
+	if (!threads)
+		return NULL;
+
+	if ((efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+		ni_error("%s: unable to create eventfd: %m", name);
+		return NULL;
+	}
+
+	pool = xcalloc(1, sizeof(*pool));
+	ni_string_dup(&pool->name, name);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	if (!(pool->sock = ni_socket_wrap(efd, SOCK_DGRAM))) {
+		close(efd);
+		ni_workpool_free(pool);
+		return NULL;
+	}
+	pool->sock->user_data = pool;
+	pool->sock->receive = __ni_workpool_receive;
+	pool->sock->poll_flags = POLLIN;
+	ni_socket_activate(pool->sock);
+
+	pool->threads = xcalloc(threads, sizeof(pthread_t));
+	for (pool->nthreads = 0; pool->nthreads < threads; pool->nthreads++) {
+		if ((err = pthread_create(&pool->threads[pool->nthreads], NULL,
+					__ni_workpool_thread, pool)) != 0) {
+			ni_error("%s: unable to start worker thread: %s", name, strerror(err));
+			break;
+		}
+	}
+	if (!pool->nthreads) {
+		ni_workpool_free(pool);
+		return NULL;
+	}
+
+	ni_debug_socket("%s: started %u worker threads", pool->name, pool->nthreads);
+	return pool;
+}
+
+/*
+ * Finish all queued work, run the pending done callbacks and
+ * release the pool.
+ */
+void
+ni_workpool_free(ni_workpool_t *pool)
+{
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = TRUE;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->nthreads; ++i)
+		pthread_join(pool->threads[i], NULL);
+	free(pool->threads);
+
+	if (pool->sock) {
+		__ni_workpool_complete(pool);
+		ni_socket_close(pool->sock);
+	}
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+	ni_string_free(&pool->name);
+	free(pool);
+}
+
+/*
+ * Queue work for a worker thread. Without a pool, the work is
+ * executed synchronously and the done callback is called directly.
+ */
+ni_bool_t
+ni_workpool_submit(ni_workpool_t *pool, const char *key,
+		ni_work_fn_t *func, ni_work_done_fn_t *done, void *data)
+{
+	ni_work_t *work;
+
+	if (!func)
+		return FALSE;
+
+	if (!pool) {
+		int result = func(data);
+
+		if (done)
+			done(data, result);
+		return TRUE;
+	}
+
+	work = xcalloc(1, sizeof(*work));
+	ni_string_dup(&work->key, key);
+	work->func = func;
+	work->done = done;
+	work->data = data;
+
+	pthread_mutex_lock(&pool->lock);
+	__ni_work_list_append(&pool->queue, work);
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+	return TRUE;
+}
+
+/*
+ * The global pool is used by library functions offloading blocking
+ * calls; it is started by daemons running the socket loop only.
+ */
+ni_bool_t
+ni_workpool_global_init(unsigned int threads)
+{
+	if (!ni_workpool_global_pool)
+		ni_workpool_global_pool = ni_workpool_new("workpool", threads);
+	return ni_workpool_global_pool != NULL;
+}
+
+ni_workpool_t *
+ni_workpool_global(void)
+{
+	return ni_workpool_global_pool;
+}
+
+void
+ni_workpool_global_free(void)
+{
+	ni_workpool_t *pool = ni_workpool_global_pool;
+
+	ni_workpool_global_pool = NULL;
+	ni_workpool_free(pool);
+}
@@ -0,0 +1,47 @@
+/*
+ *	Worker thread pool for blocking operations
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_WORKPOOL_H__
+#define __WICKED_WORKPOOL_H__
+
+#include <wicked/types.h>
+
+/*
+ * The work function runs in a worker thread. It must only use the
+ * data passed to it -- no global state, no object model; logging is
+ * fine.
+ * Its result is passed to the done function, which runs in the main
+ * thread via the socket loop and may update state as usual.
+ *
+ * Work items with the same key are executed in submission order and
+ * never concurrently, e.g. to serialize writes to the same file.
+ */
+typedef struct ni_workpool	ni_workpool_t;
+typedef int			ni_work_fn_t(void *);
+typedef void			ni_work_done_fn_t(void *, int);
+
+extern ni_workpool_t *		ni_workpool_new(const char *name, unsigned int threads);
+extern void			ni_workpool_free(ni_workpool_t *);
+extern ni_bool_t		ni_workpool_submit(ni_workpool_t *, const char *key,
+						ni_work_fn_t *, ni_work_done_fn_t *, void *);
+
+extern ni_bool_t		ni_workpool_global_init(unsigned int threads);
+extern ni_workpool_t *		ni_workpool_global(void);
+extern void			ni_workpool_global_free(void);
+
+#endif /* __WICKED_WORKPOOL_H__ */
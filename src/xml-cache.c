@@ -0,0 +1,493 @@
+/*
+ *	Cache of parsed XML documents
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/xml.h>
+#include "util_priv.h"
+#include "hashmap.h"
+#include "xml-cache.h"
+
+/*
+ * The image of a document is the header, followed by the nodes in
+ * document order, the attributes of all nodes in the same order and
+ * the string table. Strings are referenced by their offset + 1, so
+ * that 0 means NULL. The header records the stat data of the source
+ * file; the image is used only while it still matches.
+ */
+#define XML_CACHE_MAGIC		"NIXMLC01"
+#define XML_CACHE_DIR		WICKED_STATEDIR "/xml-cache"
+
+typedef struct xml_cache_header {
+	char			magic[8];
+	uint32_t		nnodes;
+	uint32_t		nattrs;
+	uint32_t		strsize;
+	uint32_t		filename;
+
+	uint64_t		dev;
+	uint64_t		ino;
+	uint64_t		size;
+	int64_t			mtime_sec;
+	int64_t			mtime_nsec;
+	int64_t			ctime_sec;
+	int64_t			ctime_nsec;
+} xml_cache_header_t;
+
+typedef struct xml_cache_node {
+	uint32_t		name;
+	uint32_t		cdata;
+	uint32_t		line;
+	uint32_t		nattrs;
+	uint32_t		nchildren;
+} xml_cache_node_t;
+
+typedef struct xml_cache_attr {
+	uint32_t		name;
+	uint32_t		value;
+} xml_cache_attr_t;
+
+typedef struct xml_cache_writer {
+	xml_cache_header_t	header;
+
+	xml_cache_node_t *	nodes;
+	unsigned int		nodes_size;
+	xml_cache_attr_t *	attrs;
+	unsigned int		attrs_size;
+
+	ni_stringbuf_t		strings;
+	ni_hashmap_t *		offsets;
+} xml_cache_writer_t;
+
+static char *			xml_cache_dirname;
+static ni_bool_t		xml_cache_dirname_set;
+
+void
+xml_document_cache_set_dir(const char *dirname)
+{
+	ni_string_dup(&xml_cache_dirname, dirname);
+	xml_cache_dirname_set = TRUE;
+}
+
+const char *
+xml_document_cache_dir(void)
+{
+	return xml_cache_dirname_set ? xml_cache_dirname : XML_CACHE_DIR;
+}
+
+static const char *
+xml_cache_path(char *path, size_t size, const char *filename)
+{
+	const char *dirname = xml_document_cache_dir();
+	unsigned int len;
+
+	if (ni_string_empty(dirname) || !filename || filename[0] != '/')
+		return NULL;
+
+	len = snprintf(path, size, "%s/%08x-%08x.xmlc", dirname,
+			ni_hashmap_hash(filename), (unsigned int)strlen(filename));
+	return len < size ? path : NULL;
+}
+
+static ni_bool_t
+xml_cache_stamp_match(const xml_cache_header_t *header, const struct stat *stb)
+{
+	return	header->dev == (uint64_t)stb->st_dev &&
+		header->ino == (uint64_t)stb->st_ino &&
+		header->size == (uint64_t)stb->st_size &&
+		header->mtime_sec == (int64_t)stb->st_mtim.tv_sec &&
+		header->mtime_nsec == (int64_t)stb->st_mtim.tv_nsec &&
+		header->ctime_sec == (int64_t)stb->st_ctim.tv_sec &&
+		header->ctime_nsec == (int64_t)stb->st_ctim.tv_nsec;
+}
+
+static void
+xml_cache_stamp_set(xml_cache_header_t *header, const struct stat *stb)
+{
+	header->dev = stb->st_dev;
+	header->ino = stb->st_ino;
+	header->size = stb->st_size;
+	header->mtime_sec = stb->st_mtim.tv_sec;
+	header->mtime_nsec = stb->st_mtim.tv_nsec;
+	header->ctime_sec = stb->st_ctim.tv_sec;
+	header->ctime_nsec = stb->st_ctim.tv_nsec;
+}
+
+/*
+ * Loading an image
+ */
+static inline ni_bool_t
+xml_cache_string(const char *strings, uint32_t strsize, uint32_t ref, const char **str)
+{
+	if (ref == 0) {
+		*str = NULL;
+		return TRUE;
+	}
+	if (ref > strsize)
+		return FALSE;
+
+	/* the string table is NUL terminated, see xml_cache_image_check */
+	*str = strings + ref - 1;
+	return TRUE;
+}
+
+static const char *
+xml_cache_image_check(const void *image, size_t size)
+{
+	const xml_cache_header_t *header = image;
+	const char *strings;
+	size_t expect;
+
+	if (size < sizeof(*header) || memcmp(header->magic, XML_CACHE_MAGIC, sizeof(header->magic)))
+		return NULL;
+
+	if (header->nnodes == 0 || header->strsize == 0 ||
+	    header->nnodes > size / sizeof(xml_cache_node_t) ||
+	    header->nattrs > size / sizeof(xml_cache_attr_t))
+		return NULL;
+
+	expect = sizeof(*header) +
+		(size_t)header->nnodes * sizeof(xml_cache_node_t) +
+		(size_t)header->nattrs * sizeof(xml_cache_attr_t) +
+		header->strsize;
+	if (expect != size)
+		return NULL;
+
+	strings = (const char *)image + size - header->strsize;
+	if (strings[header->strsize - 1] != '\0')
+		return NULL;
+
+	return strings;
+}
+
+typedef struct xml_cache_frame {
+	xml_node_t *		node;
+	xml_node_t *		last;
+	unsigned int		remaining;
+} xml_cache_frame_t;
+
+static ni_bool_t
+xml_cache_node_fill(xml_node_t *node, const xml_cache_node_t *cn, const xml_cache_attr_t *attrs,
+		const char *strings, uint32_t strsize, const xml_location_t *location)
+{
+	const char *cdata, *name, *value;
+	unsigned int n;
+
+	if (!xml_cache_string(strings, strsize, cn->cdata, &cdata))
+		return FALSE;
+	if (cdata)
+		xml_node_set_cdata(node, cdata);
+
+	for (n = 0; n < cn->nattrs; ++n) {
+		if (!xml_cache_string(strings, strsize, attrs[n].name, &name) ||
+		    !xml_cache_string(strings, strsize, attrs[n].value, &value))
+			return FALSE;
+		ni_var_array_append(&node->attrs, name, value);
+	}
+
+	if (location) {
+		node->location = xml_location_clone(location);
+		node->location->line = cn->line;
+	}
+	return TRUE;
+}
+
+static xml_document_t *
+xml_cache_image_load(const void *image, size_t size, const char *filename)
+{
+	const xml_cache_header_t *header = image;
+	const xml_cache_node_t *nodes;
+	const xml_cache_attr_t *attrs;
+	const char *strings, *name;
+	xml_cache_frame_t *stack, *frame;
+	unsigned int depth, i, a;
+	xml_location_t *location;
+	xml_document_t *doc;
+	xml_node_t *node;
+
+	if (!(strings = xml_cache_image_check(image, size)))
+		return NULL;
+
+	nodes = (const xml_cache_node_t *)(header + 1);
+	attrs = (const xml_cache_attr_t *)(nodes + header->nnodes);
+
+	if (!xml_cache_string(strings, header->strsize, header->filename, &name) ||
+	    !ni_string_eq(name, filename))
+		return NULL;
+
+	doc = xml_document_new();
+	location = xml_location_create(filename, 0);
+	stack = xcalloc(header->nnodes, sizeof(stack[0]));
+
+	node = xml_document_root(doc);
+	if (nodes[0].nattrs > header->nattrs ||
+	    !xml_cache_node_fill(node, &nodes[0], attrs, strings, header->strsize, location))
+		goto failed;
+	a = nodes[0].nattrs;
+
+	depth = 0;
+	stack[depth].node = node;
+	stack[depth].remaining = nodes[0].nchildren;
+	depth++;
+
+	for (i = 1; i < header->nnodes; ++i) {
+		/* return to the closest ancestor still expecting children */
+		while (depth && !stack[depth - 1].remaining)
+			depth--;
+		if (!depth)
+			goto failed;
+		frame = &stack[depth - 1];
+
+		if (!xml_cache_string(strings, header->strsize, nodes[i].name, &name))
+			goto failed;
+		node = xml_node_new(name, NULL);
+
+		/* append without walking the list of siblings */
+		node->parent = frame->node;
+		if (frame->last)
+			frame->last->next = node;
+		else
+			frame->node->children = node;
+		frame->last = node;
+		frame->remaining--;
+
+		if (nodes[i].nattrs > header->nattrs - a ||
+		    !xml_cache_node_fill(node, &nodes[i], attrs + a, strings, header->strsize, location))
+			goto failed;
+		a += nodes[i].nattrs;
+
+		if (nodes[i].nchildren) {
+			stack[depth].node = node;
+			stack[depth].last = NULL;
+			stack[depth].remaining = nodes[i].nchildren;
+			depth++;
+		}
+	}
+
+	while (depth && !stack[depth - 1].remaining)
+		depth--;
+	if (depth || a != header->nattrs)
+		goto failed;
+
+	free(stack);
+	xml_location_free(location);
+	return doc;
+
+failed:
+	free(stack);
+	xml_location_free(location);
+	xml_document_free(doc);
+	return NULL;
+}
+
+static xml_document_t *
+xml_cache_load(const char *path, const char *filename, const struct stat *source)
+{
+	xml_document_t *doc = NULL;
+	struct stat stb;
+	void *image;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return NULL;
+
+	/* trust images written by us or root only */
+	if (fstat(fd, &stb) < 0 || !S_ISREG(stb.st_mode) ||
+	    (stb.st_uid != 0 && stb.st_uid != geteuid()) ||
+	    (stb.st_mode & (S_IWGRP | S_IWOTH)) ||
+	    (size_t)stb.st_size < sizeof(xml_cache_header_t)) {
+		close(fd);
+		return NULL;
+	}
+
+	image = mmap(NULL, stb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED)
+		return NULL;
+
+	if (xml_cache_stamp_match(image, source))
+		doc = xml_cache_image_load(image, stb.st_size, filename);
+
+	munmap(image, stb.st_size);
+	return doc;
+}
+
+/*
+ * Writing an image
+ */
+static uint32_t
+xml_cache_writer_string(xml_cache_writer_t *w, const char *str)
+{
+	void *ref;
+
+	if (!str)
+		return 0;
+
+	if ((ref = ni_hashmap_get(w->offsets, str)))
+		return (uintptr_t)ref;
+
+	ni_stringbuf_put(&w->strings, str, strlen(str) + 1);
+	ref = (void *)(uintptr_t)(w->strings.len - strlen(str));
+	ni_hashmap_add(w->offsets, str, ref);
+	return (uintptr_t)ref;
+}
+
+static void
+xml_cache_writer_node(xml_cache_writer_t *w, const xml_node_t *node)
+{
+	xml_cache_node_t *cn;
+	const xml_node_t *child;
+	unsigned int i, pos;
+
+	if (w->header.nnodes == w->nodes_size) {
+		w->nodes_size = w->nodes_size ? w->nodes_size * 2 : 64;
+		w->nodes = xrealloc(w->nodes, w->nodes_size * sizeof(w->nodes[0]));
+	}
+	pos = w->header.nnodes++;
+
+	cn = &w->nodes[pos];
+	memset(cn, 0, sizeof(*cn));
+	cn->name = xml_cache_writer_string(w, node->name);
+	cn->cdata = xml_cache_writer_string(w, node->cdata);
+	cn->line = node->location ? node->location->line : 0;
+	cn->nattrs = node->attrs.count;
+
+	for (i = 0; i < node->attrs.count; ++i) {
+		if (w->header.nattrs == w->attrs_size) {
+			w->attrs_size = w->attrs_size ? w->attrs_size * 2 : 64;
+			w->attrs = xrealloc(w->attrs, w->attrs_size * sizeof(w->attrs[0]));
+		}
+		w->attrs[w->header.nattrs].name = xml_cache_writer_string(w, node->attrs.data[i].name);
+		w->attrs[w->header.nattrs].value = xml_cache_writer_string(w, node->attrs.data[i].value);
+		w->header.nattrs++;
+	}
+
+	for (child = node->children; child; child = child->next) {
+		xml_cache_writer_node(w, child);
+		/* the nodes array may have been reallocated */
+		w->nodes[pos].nchildren++;
+	}
+}
+
+static int
+xml_cache_write_all(int fd, const void *data, size_t len)
+{
+	const char *ptr = data;
+	ssize_t ret;
+
+	while (len) {
+		if ((ret = write(fd, ptr, len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		ptr += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+static int
+xml_cache_store(const char *path, const char *filename, const struct stat *source,
+		const xml_document_t *doc)
+{
+	char tempname[PATH_MAX];
+	xml_cache_writer_t w;
+	int fd, ret = -1;
+
+	memset(&w, 0, sizeof(w));
+	memcpy(w.header.magic, XML_CACHE_MAGIC, sizeof(w.header.magic));
+	xml_cache_stamp_set(&w.header, source);
+	ni_stringbuf_init(&w.strings);
+	w.offsets = ni_hashmap_new();
+
+	w.header.filename = xml_cache_writer_string(&w, filename);
+	xml_cache_writer_node(&w, doc->root);
+	w.header.strsize = w.strings.len;
+
+	if ((size_t)snprintf(tempname, sizeof(tempname), "%s.XXXXXX", path) >= sizeof(tempname))
+		goto cleanup;
+	if ((fd = mkostemp(tempname, O_CLOEXEC)) < 0)
+		goto cleanup;
+
+	if (fchmod(fd, 0644) < 0 ||
+	    xml_cache_write_all(fd, &w.header, sizeof(w.header)) < 0 ||
+	    xml_cache_write_all(fd, w.nodes, w.header.nnodes * sizeof(w.nodes[0])) < 0 ||
+	    xml_cache_write_all(fd, w.attrs, w.header.nattrs * sizeof(w.attrs[0])) < 0 ||
+	    xml_cache_write_all(fd, w.strings.string, w.strings.len) < 0) {
+		close(fd);
+		unlink(tempname);
+		goto cleanup;
+	}
+	if (close(fd) < 0 || rename(tempname, path) < 0) {
+		unlink(tempname);
+		goto cleanup;
+	}
+	ret = 0;
+
+cleanup:
+	ni_hashmap_free(w.offsets);
+	ni_stringbuf_destroy(&w.strings);
+	free(w.nodes);
+	free(w.attrs);
+	return ret;
+}
+
+xml_document_t *
+xml_document_read_cached(const char *filename)
+{
+	char path[PATH_MAX];
+	xml_document_t *doc;
+	struct stat stb;
+
+	if (!filename || !xml_cache_path(path, sizeof(path), filename) ||
+	    stat(filename, &stb) < 0 || !S_ISREG(stb.st_mode))
+		return xml_document_read(filename);
+
+	if ((doc = xml_cache_load(path, filename, &stb))) {
+		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_XML,
+				"%s: using cached document %s", filename, path);
+		return doc;
+	}
+
+	if (!(doc = xml_document_read(filename)))
+		return NULL;
+
+	/* the cache is an optimization only, failures are not fatal */
+	if (ni_mkdir_maybe(xml_document_cache_dir(), 0755) < 0 ||
+	    xml_cache_store(path, filename, &stb, doc) < 0) {
+		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_XML,
+				"%s: unable to write cached document %s: %m",
+				filename, path);
+	}
+	return doc;
+}
@@ -0,0 +1,33 @@
+/*
+ *	Cache of parsed XML documents
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_XML_CACHE_H__
+#define __WICKED_XML_CACHE_H__
+
+#include <wicked/xml.h>
+
+/*
+ * Reads a document like xml_document_read, but from a compiled image
+ * of it in the cache directory, as long as the file has not changed
+ * since the image was written. A NULL directory disables the cache.
+ */
+extern xml_document_t *		xml_document_read_cached(const char *);
+extern void			xml_document_cache_set_dir(const char *);
+extern const char *		xml_document_cache_dir(void);
+
+#endif /* __WICKED_XML_CACHE_H__ */
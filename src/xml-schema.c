@@ -13,6 +13,7 @@
 #include <wicked/xml.h>
 #include <wicked/logging.h>
 #include "xml-schema.h"
+#include "xml-cache.h"
 #include "util_priv.h"
 
 static int		ni_xs_process_include(xml_node_t *, ni_xs_scope_t *);
@@ -622,7 +623,7 @@ ni_xs_process_schema_file(const char *filename, ni_xs_scope_t *scope)
 		return -1;
 	}
 
-	doc = xml_document_read(filename);
+	doc = xml_document_read_cached(filename);
 	if (doc == NULL) {
 		ni_error("cannot parse schema file \"%s\"", filename);
 		return -1;
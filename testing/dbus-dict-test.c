@@ -0,0 +1,106 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <wicked/util.h>
+#include <wicked/dbus.h>
+
+#include "test-util.h"
+
+/*
+ * Decode dicts of increasing size the way the property setters do,
+ * looking up every expected key once, and check the results.
+ */
+static const unsigned int	sizes[] = { 10, 100, 1000, 10000 };
+static char **			keys;
+
+static int
+decode(const ni_dbus_variant_t *dict, unsigned int count)
+{
+	uint32_t value;
+	unsigned int i;
+
+	for (i = 0; i < count; ++i) {
+		if (!ni_dbus_dict_get_uint32(dict, keys[i], &value) || value != i) {
+			fprintf(stderr, "%s: lookup mismatch in dict of %u\n", keys[i], count);
+			return -1;
+		}
+	}
+	if (ni_dbus_dict_get(dict, "missing") != NULL) {
+		fprintf(stderr, "found missing key in dict of %u\n", count);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+run(unsigned int count)
+{
+	ni_dbus_variant_t dict = NI_DBUS_VARIANT_INIT;
+	ni_test_timer_t timer;
+	unsigned int i, rounds;
+	uint32_t value;
+
+	ni_dbus_variant_init_dict(&dict);
+	for (i = 0; i < count; ++i)
+		ni_dbus_dict_add_uint32(&dict, keys[i], i);
+
+	/* a duplicate key must not shadow the first entry */
+	ni_dbus_dict_add_uint32(&dict, keys[0], count);
+
+	if (decode(&dict, count) < 0)
+		return -1;
+
+	if (ni_test_verbose()) {
+		rounds = 100000 / count + 1;
+		ni_test_timer_start(&timer);
+		for (i = 0; i < rounds; ++i)
+			decode(&dict, count);
+		ni_test_report("%5u entries: %8.3f usec per dict\n", count,
+				ni_test_timer_elapsed(&timer) * 1e6 / rounds);
+	}
+
+	/* appending and deleting entries must keep lookups correct */
+	ni_dbus_dict_add_uint32(&dict, "appended", count);
+	if (!ni_dbus_dict_get_uint32(&dict, "appended", &value) || value != count) {
+		fprintf(stderr, "appended key not found in dict of %u\n", count);
+		return -1;
+	}
+	ni_dbus_dict_delete_entry(&dict, keys[0]);
+	if (!ni_dbus_dict_get_uint32(&dict, keys[0], &value) || value != count) {
+		fprintf(stderr, "duplicate key not found after delete in dict of %u\n", count);
+		return -1;
+	}
+	if (count > 1 && (!ni_dbus_dict_get_uint32(&dict, keys[1], &value) || value != 1)) {
+		fprintf(stderr, "lookup mismatch after delete in dict of %u\n", count);
+		return -1;
+	}
+
+	ni_dbus_variant_destroy(&dict);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned int i, max = sizes[sizeof(sizes)/sizeof(sizes[0]) - 1];
+	char name[32];
+	int rv = 0;
+
+	keys = calloc(max, sizeof(char *));
+	for (i = 0; i < max; ++i) {
+		snprintf(name, sizeof(name), "member-%u", i);
+		keys[i] = strdup(name);
+	}
+
+	for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]) && rv == 0; ++i)
+		rv = run(sizes[i]);
+
+	for (i = 0; i < max; ++i)
+		free(keys[i]);
+	free(keys);
+	return rv ? 1 : 0;
+}
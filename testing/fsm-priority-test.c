@@ -0,0 +1,181 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <wicked/util.h>
+#include <wicked/xml.h>
+#include <wicked/fsm.h>
+
+#include "test-util.h"
+
+/*
+ * Simulate the bring-up of a few priority interfaces next to a lot of
+ * tenant VLANs. Each fsm transition stands for a dbus call to wickedd
+ * taking a fixed time. Compare when the priority interfaces are ready
+ * with and without the priority classes.
+ */
+#define NTENANTS	500
+#define NCRITICAL	4
+#define CALL_USEC	20
+
+static ni_test_timer_t		timer;
+static double			last_ready;	/* of the mgmt interfaces */
+
+/* a critical interface waiting for an event, sent by a tenant call */
+static ni_ifworker_t *		late;
+static int			late_calls;	/* tenant calls until it is ready */
+
+/* a dbus call to wickedd */
+static int
+sim_call(ni_fsm_t *fsm, ni_ifworker_t *w, ni_fsm_transition_t *action)
+{
+	ni_test_timer_t call;
+
+	ni_test_timer_start(&call);
+	while (ni_test_timer_elapsed(&call) * 1e6 < CALL_USEC)
+		;
+
+	w->fsm.state = action->next_state;
+	if (w->fsm.state == w->target_state && !strncmp(w->name, "mgmt", 4))
+		last_ready = ni_test_timer_elapsed(&timer);
+
+	if (late && !strncmp(w->name, "vlan", 4)) {
+		if (late->pending && !strcmp(w->name, "vlan100"))
+			late->pending = FALSE;
+		else if (!late->pending && late->fsm.state != late->target_state)
+			late_calls++;
+	}
+	return 0;
+}
+
+static const ni_fsm_transition_t	sim_actions[] = {
+	{ NI_FSM_STATE_DEVICE_EXISTS,	NI_FSM_STATE_DEVICE_READY,	.call_func = sim_call, .bound = TRUE },
+	{ NI_FSM_STATE_DEVICE_READY,	NI_FSM_STATE_DEVICE_SETUP,	.call_func = sim_call, .bound = TRUE },
+	{ NI_FSM_STATE_DEVICE_SETUP,	NI_FSM_STATE_DEVICE_UP,		.call_func = sim_call, .bound = TRUE },
+	{ NI_FSM_STATE_DEVICE_UP,	NI_FSM_STATE_LINK_UP,		.call_func = sim_call, .bound = TRUE },
+	/* the dhcp start */
+	{ NI_FSM_STATE_LINK_UP,		NI_FSM_STATE_ADDRCONF_UP,	.call_func = sim_call, .bound = TRUE },
+	{ NI_FSM_STATE_ADDRCONF_UP,	NI_FSM_STATE_NETWORK_UP,	.call_func = sim_call, .bound = TRUE },
+
+	{ .from_state = NI_FSM_STATE_NONE, .next_state = NI_FSM_STATE_NONE }
+};
+
+static ni_ifworker_t *
+add_worker(ni_fsm_t *fsm, const char *name, const char *priority)
+{
+	xml_node_t *ifnode, *ctrl;
+	ni_ifworker_t *w;
+
+	ifnode = xml_node_new("interface", NULL);
+	xml_node_new_element("name", ifnode, name);
+	if (priority) {
+		ctrl = xml_node_new("control", ifnode);
+		xml_node_new_element("priority", ctrl, priority);
+	}
+	if (!ni_fsm_workers_from_xml(fsm, ifnode, "sim") ||
+	    !(w = ni_fsm_ifworker_by_name(fsm, NI_IFWORKER_TYPE_NETDEV, name))) {
+		xml_node_free(ifnode);
+		return NULL;
+	}
+	xml_node_free(ifnode);
+
+	w->fsm.action_table = calloc(1, sizeof(sim_actions));
+	memcpy(w->fsm.action_table, sim_actions, sizeof(sim_actions));
+	w->fsm.next_action = w->fsm.action_table;
+	w->fsm.state = NI_FSM_STATE_DEVICE_EXISTS;
+	w->target_state = NI_FSM_STATE_NETWORK_UP;
+	return w;
+}
+
+/*
+ * Returns the time until the critical interfaces are ready, or < 0
+ */
+static double
+simulate(ni_bool_t use_priority, double *all_ready)
+{
+	ni_ifworker_t *w, *lower = NULL;
+	char name[32];
+	unsigned int i;
+	double ready;
+	ni_fsm_t *fsm;
+
+	fsm = ni_fsm_new();
+	for (i = 0; i < NTENANTS; ++i) {
+		snprintf(name, sizeof(name), "vlan%u", i);
+		if (!add_worker(fsm, name, NULL))
+			return -1;
+	}
+
+	/* the priority interfaces come last in the worker list */
+	for (i = 0; i < NCRITICAL; ++i) {
+		snprintf(name, sizeof(name), "mgmt%u", i);
+		if (!(w = add_worker(fsm, name, use_priority ? "critical" : "normal")))
+			return -1;
+		if (i == 0) {
+			if (!(lower = add_worker(fsm, "eth0", NULL)))
+				return -1;
+			ni_ifworker_set_ref(&w->lowerdev, lower);
+		}
+	}
+
+	if (!(late = add_worker(fsm, "late0", use_priority ? "critical" : "normal")))
+		return -1;
+	late->pending = TRUE;
+	late_calls = 0;
+
+	last_ready = 0;
+	ni_test_timer_start(&timer);
+	if (ni_fsm_schedule(fsm) != 0)
+		return -1;
+	*all_ready = ni_test_timer_elapsed(&timer);
+	ready = last_ready;
+
+	if (use_priority && lower->priority != NI_IFWORKER_PRIORITY_CRITICAL) {
+		fprintf(stderr, "%s: priority not inherited from upper device\n", lower->name);
+		return -1;
+	}
+	for (i = 0; i < fsm->workers.count; ++i) {
+		w = fsm->workers.data[i];
+		if (w->fsm.state != NI_FSM_STATE_NETWORK_UP) {
+			fprintf(stderr, "%s: not ready\n", w->name);
+			return -1;
+		}
+	}
+
+	late = NULL;
+	ni_fsm_free(fsm);
+	return ready;
+}
+
+int
+main(int argc, char **argv)
+{
+	double t_plain, t_prio, t_all;
+	int plain_calls;
+
+	if ((t_plain = simulate(FALSE, &t_all)) < 0)
+		return 1;
+	plain_calls = late_calls;
+	if ((t_prio = simulate(TRUE, &t_all)) < 0)
+		return 1;
+
+	ni_test_report("%u priority of %u interfaces ready: %.4f sec in order, "
+		"%.4f sec with priority classes (all ready %.4f sec)\n",
+		NCRITICAL, NTENANTS + NCRITICAL + 1, t_plain, t_prio, t_all);
+
+	ni_test_report("event for a priority interface: ready after %d other calls "
+		"in order, %d with priority classes\n", plain_calls, late_calls);
+
+	if (t_prio * 10 > t_plain) {
+		fprintf(stderr, "priority interfaces not started first\n");
+		return 1;
+	}
+	if (late_calls != 0) {
+		fprintf(stderr, "priority interface waited for other interfaces after its event\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,205 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include <wicked/address.h>
+#include <wicked/socket.h>
+#include <wicked/xml.h>
+
+#include "netinfo_priv.h"
+#include "appconfig.h"
+#include "handoff.h"
+#include "test-util.h"
+
+extern ni_global_t ni_global;
+
+/*
+ * Hand the state of a few thousand devices from one process to a
+ * forked one over the handoff socket and check what it restored.
+ * The first device has a lease update and a linkUp call in progress,
+ * the second one was renamed in the new process.
+ */
+#define NDEVICES	2000
+
+static ni_netconfig_t *
+build_state(ni_bool_t old)
+{
+	ni_netconfig_t *nc = ni_netconfig_new();
+	ni_addrconf_lease_t *lease;
+	ni_client_state_t *cs;
+	ni_sockaddr_t addr;
+	ni_netdev_t *dev;
+	char name[32];
+	unsigned int i;
+
+	for (i = 0; i < NDEVICES; ++i) {
+		snprintf(name, sizeof(name), old || i != 1 ? "eth%u" : "eth%ux", i);
+		dev = ni_test_netdev_new(nc, name, i + 2);
+		if (!old)
+			continue;
+
+		dev->link.ifflags |= NI_IFF_DEVICE_READY;
+		cs = ni_netdev_get_client_state(dev);
+		cs->control.persistent = i % 2;
+		ni_uuid_generate(&cs->config.uuid);
+		ni_string_dup(&cs->config.origin, "compat:suse:/etc/sysconfig/network/ifcfg-eth");
+
+		ni_sockaddr_parse(&addr, "192.168.1.2", AF_INET);
+		addr.sin.sin_addr.s_addr = htonl(0x0a000001 + i);
+		lease = ni_test_lease_new(dev, NI_ADDRCONF_STATIC, AF_INET, &addr, 8);
+		lease->flags = 1U << NI_ADDRCONF_FLAGS_PRIMARY;
+
+		if (i == 0) {
+			ni_netdev_add_event_filter(dev, 1 << NI_EVENT_LINK_UP);
+			lease->state = NI_ADDRCONF_STATE_APPLYING;
+			lease->old = ni_addrconf_lease_new(NI_ADDRCONF_STATIC, AF_INET);
+			lease->old->state = NI_ADDRCONF_STATE_GRANTED;
+			lease->old->acquired = lease->acquired;
+			ni_addrconf_updater_new_applying(lease, dev, NI_EVENT_ADDRESS_ACQUIRED);
+		}
+	}
+	return nc;
+}
+
+static int
+check_state(ni_netconfig_t *old, ni_netconfig_t *nc, const ni_uint_array_t *restored)
+{
+	const ni_addrconf_lease_t *lease, *orig;
+	ni_netdev_t *dev, *odev;
+
+	if (restored->count != NDEVICES - 1) {
+		fprintf(stderr, "restored %u of %u devices\n", restored->count, NDEVICES - 1);
+		return -1;
+	}
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		odev = ni_netdev_by_index(old, dev->link.ifindex);
+		if (!ni_string_eq(odev->name, dev->name)) {
+			if (dev->leases || dev->client_state) {
+				fprintf(stderr, "%s: state of renamed device restored\n", dev->name);
+				return -1;
+			}
+			continue;
+		}
+
+		lease = dev->leases;
+		orig = odev->leases;
+		if (!ni_netdev_device_is_ready(dev) || !dev->client_state ||
+		    dev->client_state->control.persistent != odev->client_state->control.persistent ||
+		    !ni_uuid_equal(&dev->client_state->config.uuid, &odev->client_state->config.uuid)) {
+			fprintf(stderr, "%s: device state not restored\n", dev->name);
+			return -1;
+		}
+		if (!lease || lease->next || !ni_uuid_equal(&lease->uuid, &orig->uuid) ||
+		    lease->state != orig->state || lease->flags != orig->flags ||
+		    !lease->addrs || !ni_sockaddr_equal(&lease->addrs->local_addr, &orig->addrs->local_addr) ||
+		    !lease->old != !orig->old || !lease->updater != !orig->updater) {
+			fprintf(stderr, "%s: lease not restored\n", dev->name);
+			return -1;
+		}
+		if (!dev->event_filter != !odev->event_filter || (dev->event_filter &&
+		    !ni_uuid_equal(&dev->event_filter->uuid, &odev->event_filter->uuid))) {
+			fprintf(stderr, "%s: event filter not restored\n", dev->name);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* the new instance */
+static int
+take_over(const char *path, ni_netconfig_t *old)
+{
+	ni_uint_array_t restored = NI_UINT_ARRAY_INIT;
+	ni_test_timer_t timer;
+	ni_handoff_t *ho;
+	double elapsed;
+	xml_node_t *state;
+	ni_netconfig_t *nc;
+
+	if (!(ho = ni_handoff_connect(path, 2000)))
+		return 1;
+
+	ni_test_timer_start(&timer);
+	state = ni_handoff_receive(ho, 2000);
+	nc = build_state(FALSE);
+	if (!state || ni_handoff_state_restore(nc, state, &restored) < 0)
+		return 1;
+	elapsed = ni_test_timer_elapsed(&timer);
+
+	if (check_state(old, nc, &restored) < 0)
+		return 1;
+
+	ni_test_report("state of %u devices received and restored in %.4f sec\n",
+			NDEVICES, elapsed);
+
+	xml_node_free(state);
+	ni_handoff_free(ho);
+	ni_uint_array_destroy(&restored);
+	ni_netconfig_free(nc);
+	return 0;
+}
+
+static ni_bool_t
+grant(void *user_data)
+{
+	return TRUE;
+}
+
+int
+main(int argc, char **argv)
+{
+	char dir[] = "/tmp/handoff-test.XXXXXX", path[64];
+	ni_test_timer_t timer;
+	ni_netconfig_t *old;
+	unsigned int loops;
+	xml_node_t *state;
+	ni_handoff_t *ho;
+	int status;
+	pid_t pid;
+
+	ni_global.config = ni_config_new();
+	if (!mkdtemp(dir))
+		return 1;
+	snprintf(path, sizeof(path), "%s/%s", dir, NI_HANDOFF_SOCKET);
+
+	old = build_state(TRUE);
+	if (!(ho = ni_handoff_listen(path, grant, NULL, NULL)))
+		return 1;
+
+	if ((pid = fork()) < 0)
+		return 1;
+	if (pid == 0)
+		exit(take_over(path, old));
+
+	for (loops = 0; !ni_handoff_pending(ho) && loops < 20; ++loops)
+		ni_socket_wait(100);
+	if (!ni_handoff_pending(ho)) {
+		fprintf(stderr, "handoff request not granted\n");
+		return 1;
+	}
+
+	ni_test_timer_start(&timer);
+	state = ni_handoff_state_save(old);
+	if (ni_handoff_send(ho, state) < 0)
+		return 1;
+	ni_test_report("state of %u devices saved and sent in %.4f sec\n",
+			NDEVICES, ni_test_timer_elapsed(&timer));
+
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+		return 1;
+
+	xml_node_free(state);
+	ni_handoff_free(ho);
+	ni_netconfig_free(old);
+	unlink(path);
+	rmdir(dir);
+	return 0;
+}
@@ -0,0 +1,136 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include <wicked/util.h>
+
+#include "client/suse/ifsysctl.h"
+
+/*
+ * Load a generated sysctl file into the hashed ifsysctl store and
+ * check the lookups against the var array based functions.
+ */
+#define NIFACES		2000
+
+static int
+check_value(const ni_var_t *var, const char *expected, const char *what)
+{
+	const char *value = var ? var->value : NULL;
+
+	if (!ni_string_eq(value, expected)) {
+		fprintf(stderr, "%s: got '%s', expected '%s'\n", what,
+				value ? value : "(null)",
+				expected ? expected : "(null)");
+		return -1;
+	}
+	return 0;
+}
+
+static const ni_var_t *
+array_lookup(const ni_var_array_t *vars, const char *path, const char *ifname, const char *attr)
+{
+	const char *names[] = { "all", "default", ifname, NULL };
+	const ni_var_t *ret = NULL, *var;
+	const char **name;
+
+	for (name = names; *name; name++) {
+		var = ni_ifsysctl_vars_get(vars, "%s/%s/%s", path, *name, attr);
+		if (var && !ni_string_empty(var->value))
+			ret = var;
+	}
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_var_array_t vars = NI_VAR_ARRAY_INIT;
+	char filename[] = "/tmp/ifsysctl-test.XXXXXX";
+	char ifname[32], override[] = "/tmp/ifsysctl-test.XXXXXX";
+	struct timespec start, end;
+	double t_array, t_store;
+	ni_ifsysctl_t *store, *local;
+	unsigned int i;
+	FILE *fp;
+	int fd;
+
+	if ((fd = mkstemp(filename)) < 0 || !(fp = fdopen(fd, "w")))
+		return 1;
+	fprintf(fp, "# generated\n");
+	fprintf(fp, "net.ipv4.ip_forward = 1\n");
+	fprintf(fp, "net.ipv6.conf.all.forwarding = 0\n");
+	fprintf(fp, "net.ipv6.conf.$INTERFACE.accept_ra = 2\n");
+	fprintf(fp, "net.ipv6.conf.eth0/42.accept_ra = 0\n");
+	fprintf(fp, "net/ipv6/conf/eth1.7/autoconf = 0\n");
+	fprintf(fp, "kernel.sysrq = 1\n");
+	for (i = 0; i < NIFACES; ++i)
+		fprintf(fp, "net.ipv6.conf.eth%u.use_tempaddr = %u\n", i, i % 3);
+	fclose(fp);
+
+	if ((fd = mkstemp(override)) < 0 || !(fp = fdopen(fd, "w")))
+		return 1;
+	fprintf(fp, "net.ipv6.conf.eth5.use_tempaddr = 7\n");
+	fclose(fp);
+
+	store = ni_ifsysctl_new(NULL);
+	if (!ni_ifsysctl_load(store, filename) || !ni_ifsysctl_file_load(&vars, filename))
+		return 1;
+
+	if (check_value(ni_ifsysctl_lookup(store, AF_INET, "eth3", "forwarding"), "1", "ip_forward") ||
+	    check_value(ni_ifsysctl_lookup(store, AF_INET6, "eth3", "forwarding"), "0", "forwarding") ||
+	    check_value(ni_ifsysctl_lookup(store, AF_INET6, "eth3", "accept_ra"), "2", "default") ||
+	    check_value(ni_ifsysctl_lookup(store, AF_INET6, "eth0.42", "accept_ra"), "0", "dot name") ||
+	    check_value(ni_ifsysctl_get(store, AF_INET6, "eth1.7", "autoconf"), "0", "slash key") ||
+	    check_value(ni_ifsysctl_get(store, AF_INET6, "eth1", "autoconf"), NULL, "no match") ||
+	    check_value(ni_ifsysctl_get(store, AF_INET, "eth0", "use_tempaddr"), NULL, "family"))
+		return 1;
+
+	local = ni_ifsysctl_new(store);
+	if (!ni_ifsysctl_load(local, override) ||
+	    check_value(ni_ifsysctl_lookup(local, AF_INET6, "eth5", "use_tempaddr"), "7", "override") ||
+	    check_value(ni_ifsysctl_lookup(local, AF_INET6, "eth6", "use_tempaddr"), "0", "parent") ||
+	    check_value(ni_ifsysctl_lookup(store, AF_INET6, "eth5", "use_tempaddr"), "2", "unchanged"))
+		return 1;
+	ni_ifsysctl_free(local);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NIFACES; ++i) {
+		snprintf(ifname, sizeof(ifname), "eth%u", i);
+		if (!array_lookup(&vars, "net/ipv6/conf", ifname, "use_tempaddr"))
+			return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t_array = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	for (i = 0; i < NIFACES; ++i) {
+		snprintf(ifname, sizeof(ifname), "eth%u", i);
+		if (check_value(ni_ifsysctl_lookup(store, AF_INET6, ifname, "use_tempaddr"),
+				array_lookup(&vars, "net/ipv6/conf", ifname,
+					"use_tempaddr")->value, ifname))
+			return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NIFACES; ++i) {
+		snprintf(ifname, sizeof(ifname), "eth%u", i);
+		if (!ni_ifsysctl_lookup(store, AF_INET6, ifname, "use_tempaddr"))
+			return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t_store = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("%u interface lookups: %.4f sec var array, %.4f sec store\n",
+			NIFACES, t_array, t_store);
+
+	ni_ifsysctl_free(store);
+	ni_var_array_destroy(&vars);
+	unlink(override);
+	unlink(filename);
+	return 0;
+}
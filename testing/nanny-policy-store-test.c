@@ -0,0 +1,211 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <wicked/util.h>
+#include <wicked/socket.h>
+#include <wicked/xml.h>
+
+#include "util_priv.h"
+#include "nanny/nanny.h"
+
+/*
+ * Save and drop policies through the nanny policy store and check
+ * the journal, the debounced compaction, the replay of the journal
+ * on load and the recovery from a store which fails to load.
+ */
+static char			dir[] = "/tmp/policy-store-test.XXXXXX";
+static xml_node_t *		policies;
+
+static ni_bool_t
+write_policies(FILE *fp, void *user_data)
+{
+	const xml_node_t *pnode;
+
+	for (pnode = policies->children; pnode; pnode = pnode->next) {
+		if (xml_node_print(pnode, fp) < 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static xml_node_t *
+policy_find(const char *name)
+{
+	xml_node_t *pnode;
+
+	for (pnode = policies->children; pnode; pnode = pnode->next) {
+		if (ni_string_eq(xml_node_get_attr(pnode, "name"), name))
+			return pnode;
+	}
+	return NULL;
+}
+
+static ni_bool_t
+policy_save(ni_nanny_policy_store_t *store, const char *name, const char *origin)
+{
+	xml_node_t *pnode;
+
+	if ((pnode = policy_find(name)))
+		xml_node_delete_child_node(policies, pnode);
+
+	pnode = xml_node_new("policy", policies);
+	xml_node_add_attr(pnode, "name", name);
+	xml_node_add_attr(pnode, "origin", origin);
+	xml_node_new_element("device", xml_node_new("match", pnode), name);
+	return ni_nanny_policy_store_save(store, pnode);
+}
+
+static ni_bool_t
+policy_drop(ni_nanny_policy_store_t *store, const char *name)
+{
+	xml_node_t *pnode;
+
+	if ((pnode = policy_find(name)))
+		xml_node_delete_child_node(policies, pnode);
+	return ni_nanny_policy_store_drop(store, name);
+}
+
+/*
+ * Compare a loaded list with the policies the test saved
+ */
+static int
+check_loaded(const char *what, xml_node_t *list)
+{
+	xml_node_t *a, *b;
+
+	if (!list) {
+		fprintf(stderr, "%s: load failed\n", what);
+		return -1;
+	}
+
+	for (a = list->children, b = policies->children; a && b; a = a->next, b = b->next) {
+		if (!ni_string_eq(xml_node_get_attr(a, "name"), xml_node_get_attr(b, "name")) ||
+		    !ni_string_eq(xml_node_get_attr(a, "origin"), xml_node_get_attr(b, "origin")))
+			break;
+	}
+	xml_node_free(list);
+
+	if (a || b) {
+		fprintf(stderr, "%s: loaded policies differ from the saved ones\n", what);
+		return -1;
+	}
+	return 0;
+}
+
+static void
+run_timers(ni_nanny_policy_store_t *store, unsigned int msec)
+{
+	long timeout;
+
+	while (store->dirty && msec) {
+		timeout = ni_timer_next_timeout();
+		if (timeout > 10)
+			timeout = 10;
+		ni_socket_wait(timeout);
+		msec = msec > 10 ? msec - 10 : 0;
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_nanny_policy_store_t *store;
+	char path[256];
+	FILE *fp;
+	int rv = 1;
+
+	if (!mkdtemp(dir)) {
+		perror("mkdtemp");
+		return 1;
+	}
+	policies = xml_node_new(NULL, NULL);
+
+	/* an empty directory loads no policies */
+	store = ni_nanny_policy_store_new(dir, write_policies, NULL);
+	if (check_loaded("empty", ni_nanny_policy_store_load(store)) < 0)
+		goto out;
+
+	/* saved policies go into the journal first */
+	if (!policy_save(store, "policy1", "one") ||
+	    !policy_save(store, "policy2", "two") ||
+	    !policy_save(store, "policy3", "three")) {
+		fprintf(stderr, "save failed\n");
+		goto out;
+	}
+	if (!ni_file_exists(store->journal) || ni_file_exists(store->path)) {
+		fprintf(stderr, "save: expected the journal only\n");
+		goto out;
+	}
+
+	/* the timer compacts the whole burst into the store */
+	store->delay = 20;
+	run_timers(store, 2000);
+	if (store->dirty || ni_file_exists(store->journal) || !ni_file_exists(store->path)) {
+		fprintf(stderr, "debounce: journal not compacted into the store\n");
+		goto out;
+	}
+
+	/* a new instance replays the journal on top of the store */
+	if (!policy_save(store, "policy1", "changed") || !policy_drop(store, "policy2")) {
+		fprintf(stderr, "update failed\n");
+		goto out;
+	}
+	ni_nanny_policy_store_free(store);
+	store = NULL;
+
+	store = ni_nanny_policy_store_new(dir, write_policies, NULL);
+	if (check_loaded("replay", ni_nanny_policy_store_load(store)) < 0)
+		goto out;
+	if (!store->dirty || !ni_nanny_policy_store_flush(store) ||
+	    ni_file_exists(store->journal)) {
+		fprintf(stderr, "replay: journal not compacted after load\n");
+		goto out;
+	}
+	ni_nanny_policy_store_free(store);
+	store = NULL;
+
+	/* a broken store is moved aside and persistence continues */
+	snprintf(path, sizeof(path), "%s/policies.xml", dir);
+	if (!(fp = fopen(path, "w"))) {
+		perror(path);
+		goto out;
+	}
+	fprintf(fp, "<policies version=\"1\"><policy name=\"broken\"");
+	fclose(fp);
+
+	store = ni_nanny_policy_store_new(dir, write_policies, NULL);
+	xml_node_free(policies);
+	policies = xml_node_new(NULL, NULL);
+	if (check_loaded("broken", ni_nanny_policy_store_load(store)) < 0)
+		goto out;
+	snprintf(path, sizeof(path), "%s/policies.xml.broken", dir);
+	if (!ni_file_exists(path) || store->broken) {
+		fprintf(stderr, "broken: store not moved aside\n");
+		goto out;
+	}
+	if (!policy_save(store, "policy4", "four") || !ni_nanny_policy_store_flush(store)) {
+		fprintf(stderr, "broken: save failed\n");
+		goto out;
+	}
+	ni_nanny_policy_store_free(store);
+	store = NULL;
+
+	store = ni_nanny_policy_store_new(dir, write_policies, NULL);
+	if (check_loaded("recovered", ni_nanny_policy_store_load(store)) < 0)
+		goto out;
+
+	printf("policy store checks passed\n");
+	rv = 0;
+out:
+	ni_nanny_policy_store_free(store);
+	xml_node_free(policies);
+	snprintf(path, sizeof(path), "rm -rf '%s'", dir);
+	if (system(path) != 0)
+		rv = 1;
+	return rv;
+}
@@ -0,0 +1,171 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <wicked/fsm.h>
+#include <wicked/util.h>
+
+#include "util_priv.h"
+#include "nanny/nanny.h"
+
+/*
+ * Drive the nanny device registry with synthetic register, rename
+ * and delete events and check every lookup against a plain table.
+ */
+#define NDEVICES	20000
+#define NEVENTS		1000000
+
+static ni_ifworker_t *		workers[NDEVICES + 1];
+static ni_managed_device_t *	devices[NDEVICES + 1];
+static unsigned int		renames[NDEVICES + 1];
+
+static void
+device_name(char *buf, size_t len, unsigned int ifindex)
+{
+	if (renames[ifindex])
+		snprintf(buf, len, "ren%u.%u", ifindex, renames[ifindex]);
+	else
+		snprintf(buf, len, "eth%u", ifindex);
+}
+
+static ni_ifworker_t *
+device_worker(unsigned int ifindex)
+{
+	return workers[ifindex];
+}
+
+static void
+device_register(ni_nanny_registry_t *reg, unsigned int ifindex)
+{
+	ni_managed_device_t *mdev;
+	ni_ifworker_t *w = device_worker(ifindex);
+	char name[64];
+
+	device_name(name, sizeof(name), ifindex);
+	ni_string_dup(&w->name, name);
+	w->ifindex = ifindex;
+
+	mdev = xcalloc(1, sizeof(*mdev));
+	mdev->ifindex = ifindex;
+	ni_nanny_registry_insert(reg, mdev, w);
+	devices[ifindex] = mdev;
+}
+
+static void
+device_delete(ni_nanny_registry_t *reg, unsigned int ifindex)
+{
+	ni_managed_device_t *mdev = devices[ifindex];
+
+	ni_nanny_registry_remove(reg, mdev);
+	free(mdev);
+	devices[ifindex] = NULL;
+	renames[ifindex] = 0;
+}
+
+static void
+device_rename(ni_nanny_registry_t *reg, unsigned int ifindex)
+{
+	ni_ifworker_t *w = device_worker(ifindex);
+	char name[64];
+
+	renames[ifindex]++;
+	device_name(name, sizeof(name), ifindex);
+	ni_string_dup(&w->name, name);
+	ni_nanny_registry_rename(reg, devices[ifindex], name);
+}
+
+static int
+device_check(const ni_nanny_registry_t *reg, unsigned int ifindex)
+{
+	ni_managed_device_t *mdev = devices[ifindex];
+	char name[64];
+
+	device_name(name, sizeof(name), ifindex);
+	if (ni_nanny_registry_by_ifindex(reg, ifindex) != mdev) {
+		fprintf(stderr, "ifindex %u: lookup mismatch\n", ifindex);
+		return -1;
+	}
+	if (ni_nanny_registry_by_name(reg, name) != mdev) {
+		fprintf(stderr, "%s: name lookup mismatch\n", name);
+		return -1;
+	}
+	if (mdev && mdev->worker != device_worker(ifindex)) {
+		fprintf(stderr, "%s: worker mismatch\n", name);
+		return -1;
+	}
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_nanny_registry_t reg;
+	unsigned int i, ifindex, present = 0;
+	struct timespec start, end;
+
+	memset(&reg, 0, sizeof(reg));
+	srandom(42);
+
+	for (i = 1; i <= NDEVICES; ++i) {
+		/* synthetic workers, only name and ifindex are used */
+		workers[i] = xcalloc(1, sizeof(ni_ifworker_t));
+		workers[i]->refcount = 1;
+		workers[i]->type = NI_IFWORKER_TYPE_NETDEV;
+		device_register(&reg, i);
+		present++;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NEVENTS; ++i) {
+		ifindex = 1 + random() % NDEVICES;
+
+		switch (random() % 8) {
+		case 0:
+			if (devices[ifindex]) {
+				device_delete(&reg, ifindex);
+				present--;
+			} else {
+				device_register(&reg, ifindex);
+				present++;
+			}
+			break;
+		case 1:
+			if (devices[ifindex])
+				device_rename(&reg, ifindex);
+			break;
+		default:
+			break;
+		}
+
+		if (device_check(&reg, ifindex) < 0)
+			return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 1; i <= NDEVICES; ++i) {
+		if (device_check(&reg, i) < 0)
+			return 1;
+	}
+	if (ni_nanny_registry_count(&reg) != present) {
+		fprintf(stderr, "registry count %u, expected %u\n",
+				ni_nanny_registry_count(&reg), present);
+		return 1;
+	}
+
+	printf("%u devices, %u events in %.3f sec\n", NDEVICES, NEVENTS,
+			(end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9);
+
+	for (i = 1; i <= NDEVICES; ++i) {
+		if (devices[i])
+			device_delete(&reg, i);
+	}
+	ni_nanny_registry_destroy(&reg);
+	for (i = 1; i <= NDEVICES; ++i)
+		ni_ifworker_release(workers[i]);
+	return 0;
+}
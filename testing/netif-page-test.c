@@ -0,0 +1,283 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <linux/rtnetlink.h>
+
+#include <wicked/util.h>
+#include <wicked/address.h>
+#include <wicked/route.h>
+#include <wicked/dbus.h>
+
+#include "dbus-objects/model.h"
+#include "test-util.h"
+
+/*
+ * Page through synthetic address and route lists like the clients
+ * of Interface.getAddresses and Interface.getRoutes do and compare
+ * the reassembled lists with the originals.
+ * With WICKED_TEST_VERBOSE set, compare the time of the whole route
+ * list with the time of paging through it.
+ */
+#define NROUTES		50000
+#define NADDRS		5000
+#define NCHURN		5000
+
+static void
+make_sockaddr(ni_sockaddr_t *sa, unsigned int af, unsigned int n)
+{
+	memset(sa, 0, sizeof(*sa));
+	sa->ss_family = af;
+	if (af == AF_INET) {
+		sa->sin.sin_addr.s_addr = htonl(0x0a000000 | n << 8);
+	} else {
+		sa->six.sin6_addr.s6_addr[0] = 0x20;
+		sa->six.sin6_addr.s6_addr[1] = 0x01;
+		sa->six.sin6_addr.s6_addr[12] = n >> 24;
+		sa->six.sin6_addr.s6_addr[13] = n >> 16;
+		sa->six.sin6_addr.s6_addr[14] = n >> 8;
+		sa->six.sin6_addr.s6_addr[15] = n;
+	}
+}
+
+static int
+make_routes(unsigned int count, ni_route_table_t **routes)
+{
+	ni_sockaddr_t dst;
+	unsigned int i;
+
+	for (i = 0; i < count; ++i) {
+		unsigned int af = i % 3 ? AF_INET : AF_INET6;
+
+		make_sockaddr(&dst, af, i);
+		if (!ni_route_create(af == AF_INET ? 24 : 128, &dst, NULL,
+				i % 5 ? RT_TABLE_MAIN : 100, routes))
+			return -1;
+	}
+	return 0;
+}
+
+static unsigned int
+route_count(const ni_route_table_t *list, unsigned int family)
+{
+	const ni_route_table_t *tab;
+	unsigned int i, count = 0;
+
+	for (tab = list; tab; tab = tab->next) {
+		for (i = 0; i < tab->routes.count; ++i) {
+			if (family == AF_UNSPEC || tab->routes.data[i]->family == family)
+				count++;
+		}
+	}
+	return count;
+}
+
+static int
+routes_compare(const ni_route_table_t *a, ni_route_table_t *b, unsigned int family)
+{
+	const ni_route_table_t *tab;
+	unsigned int i, j;
+
+	if (route_count(a, family) != route_count(b, family))
+		return -1;
+
+	for (tab = a; tab; tab = tab->next) {
+		ni_route_table_t *other = ni_route_tables_find(b, tab->tid);
+
+		for (i = j = 0; i < tab->routes.count; ++i) {
+			if (family != AF_UNSPEC && tab->routes.data[i]->family != family)
+				continue;
+			if (!other || j >= other->routes.count ||
+			    !ni_route_equal(tab->routes.data[i], other->routes.data[j++]))
+				return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+page_routes(ni_route_table_t *list, unsigned int family, unsigned int count,
+		ni_route_table_t **result)
+{
+	ni_dbus_variant_t page = NI_DBUS_VARIANT_INIT;
+	unsigned int cursor = 0;
+	dbus_bool_t rv;
+
+	do {
+		ni_dbus_dict_array_init(&page);
+		rv = __ni_objectmodel_get_route_list_page(list, family, &cursor, count,
+							NULL, &page, NULL);
+		if (rv)
+			rv = __ni_objectmodel_add_route_list(result, &page, NULL);
+		ni_dbus_variant_destroy(&page);
+		if (!rv)
+			return -1;
+	} while (cursor);
+	return 0;
+}
+
+/*
+ * Page through the routes while a route already sent is removed and
+ * a new one appended before every page, and resume each page like
+ * Interface.getRoutes does after the routes changed. Every route of
+ * the initial list has to be sent exactly once.
+ */
+static int
+page_routes_churn(ni_route_table_t **list, const ni_route_table_t *initial,
+		unsigned int count)
+{
+	ni_dbus_variant_t page = NI_DBUS_VARIANT_INIT;
+	ni_route_table_t *copy = NULL, *other;
+	const ni_route_table_t *tab;
+	unsigned int cursor = 0, n = NCHURN, i, j, found;
+	const ni_route_t *last;
+	ni_sockaddr_t dst;
+	char *key = NULL;
+	int rv = 0;
+
+	do {
+		if (cursor) {
+			ni_route_tables_del_route(*list, (*list)->routes.data[0]);
+			make_sockaddr(&dst, AF_INET, n++);
+			ni_route_create(24, &dst, NULL, (*list)->tid, list);
+			cursor = __ni_objectmodel_route_list_resume(*list, cursor, key);
+		}
+
+		ni_dbus_dict_array_init(&page);
+		if (!__ni_objectmodel_get_route_list_page(*list, AF_UNSPEC, &cursor, count,
+							&last, &page, NULL) ||
+		    !__ni_objectmodel_add_route_list(&copy, &page, NULL))
+			rv = -1;
+		ni_dbus_variant_destroy(&page);
+
+		ni_string_free(&key);
+		key = __ni_objectmodel_route_list_resume_key(last);
+	} while (rv == 0 && cursor);
+	ni_string_free(&key);
+
+	for (tab = initial; rv == 0 && tab; tab = tab->next) {
+		other = ni_route_tables_find(copy, tab->tid);
+		for (i = 0; rv == 0 && i < tab->routes.count; ++i) {
+			found = 0;
+			for (j = 0; other && j < other->routes.count; ++j) {
+				if (ni_route_equal(tab->routes.data[i], other->routes.data[j]))
+					found++;
+			}
+			if (found != 1)
+				rv = -1;
+		}
+	}
+	ni_route_tables_destroy(&copy);
+	return rv;
+}
+
+static int
+page_addresses(ni_address_t *list, unsigned int family, unsigned int count,
+		ni_address_t **result)
+{
+	ni_dbus_variant_t page = NI_DBUS_VARIANT_INIT;
+	const ni_address_t *next = NULL;
+	unsigned int cursor = 0;
+	dbus_bool_t rv;
+
+	do {
+		ni_dbus_dict_array_init(&page);
+		rv = __ni_objectmodel_get_address_list_page(list, family, &cursor, &next,
+							count, &page, NULL);
+		if (rv)
+			rv = __ni_objectmodel_add_address_list(result, &page, NULL);
+		ni_dbus_variant_destroy(&page);
+		if (!rv)
+			return -1;
+	} while (cursor);
+	return 0;
+}
+
+static int
+addresses_compare(const ni_address_t *a, const ni_address_t *b, unsigned int family)
+{
+	for (; a; a = a->next) {
+		if (family != AF_UNSPEC && a->family != family)
+			continue;
+		if (!b || !ni_address_equal_local_addr(a, b))
+			return -1;
+		b = b->next;
+	}
+	return b ? -1 : 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const unsigned int families[] = { AF_UNSPEC, AF_INET, AF_INET6 };
+	static const unsigned int counts[] = { 1, 7, 1024 };
+	ni_dbus_variant_t full = NI_DBUS_VARIANT_INIT;
+	ni_route_table_t *routes = NULL, *copy = NULL, *churn = NULL;
+	ni_address_t *addrs = NULL, *acopy = NULL;
+	ni_test_timer_t timer;
+	unsigned int i, f, c;
+	ni_sockaddr_t dst;
+	double whole;
+
+	if (make_routes(NROUTES, &routes) < 0)
+		return 1;
+	for (i = 0; i < NADDRS; ++i) {
+		unsigned int af = i % 2 ? AF_INET : AF_INET6;
+
+		make_sockaddr(&dst, af, i);
+		if (!ni_address_new(af, af == AF_INET ? 24 : 64, &dst, &addrs))
+			return 1;
+	}
+
+	for (f = 0; f < 3; ++f) {
+		for (c = 0; c < 3; ++c) {
+			if (page_routes(routes, families[f], counts[c], &copy) < 0 ||
+			    routes_compare(routes, copy, families[f]) < 0) {
+				fprintf(stderr, "routes: family %u, count %u: mismatch\n",
+						families[f], counts[c]);
+				return 1;
+			}
+			ni_route_tables_destroy(&copy);
+
+			if (page_addresses(addrs, families[f], counts[c], &acopy) < 0 ||
+			    addresses_compare(addrs, acopy, families[f]) < 0) {
+				fprintf(stderr, "addresses: family %u, count %u: mismatch\n",
+						families[f], counts[c]);
+				return 1;
+			}
+			ni_address_list_destroy(&acopy);
+		}
+	}
+
+	for (c = 0; c < 3; ++c) {
+		if (make_routes(NCHURN, &copy) < 0 || make_routes(NCHURN, &churn) < 0 ||
+		    page_routes_churn(&churn, copy, counts[c] + 10) < 0) {
+			fprintf(stderr, "routes: count %u: route skipped or sent twice after a change\n",
+					counts[c] + 10);
+			return 1;
+		}
+		ni_route_tables_destroy(&copy);
+		ni_route_tables_destroy(&churn);
+	}
+
+	if (ni_test_verbose()) {
+		ni_test_timer_start(&timer);
+		ni_dbus_dict_array_init(&full);
+		__ni_objectmodel_get_route_list(routes, &full, NULL);
+		whole = ni_test_timer_elapsed(&timer);
+		ni_dbus_variant_destroy(&full);
+
+		ni_test_timer_start(&timer);
+		page_routes(routes, AF_UNSPEC, 1024, &copy);
+		ni_test_report("%u routes: whole list %.1f msec, in pages of 1024 %.1f msec\n",
+				NROUTES, whole * 1e3, ni_test_timer_elapsed(&timer) * 1e3);
+		ni_route_tables_destroy(&copy);
+	}
+
+	ni_route_tables_destroy(&routes);
+	ni_address_list_destroy(&addrs);
+	return 0;
+}
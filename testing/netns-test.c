@@ -0,0 +1,155 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <wicked/util.h>
+#include <wicked/netinfo.h>
+#include <wicked/netns.h>
+#include <wicked/socket.h>
+#include <wicked/system.h>
+
+#include "netinfo_priv.h"
+#include "kernel.h"
+#include "test-util.h"
+
+/*
+ * Open a number of network namespaces from a private one, discover
+ * their devices and receive the events of a bridge created in one of
+ * them on the event socket of the own namespace.
+ * Needs the privileges to create network namespaces; skipped otherwise.
+ */
+#define NNAMESPACES	64
+
+static const ni_netdev_t *	event_dev;
+static int			event_nsid = NI_NETNS_ID_NONE;
+
+static void
+interface_event(ni_netdev_t *dev, ni_event_t event)
+{
+	if (event == NI_EVENT_DEVICE_CREATE && ni_string_eq(dev->name, "nsbr0")) {
+		event_dev = dev;
+		event_nsid = dev->link.netnsid;
+	}
+}
+
+/* a namespace kept alive by an open file only */
+static int
+create_netns(int host, char *path, size_t size)
+{
+	int fd;
+
+	if (unshare(CLONE_NEWNET) < 0)
+		return -1;
+	fd = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC);
+	if (setns(host, CLONE_NEWNET) < 0 || fd < 0)
+		return -1;
+
+	snprintf(path, size, "/proc/self/fd/%d", fd);
+	return fd;
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_netns_t *ns, *nslist[NNAMESPACES];
+	int fds[NNAMESPACES], host;
+	ni_test_timer_t timer;
+	ni_netconfig_t *nc, *host_nc;
+	ni_netdev_t *dev;
+	char path[64];
+	unsigned int i, loops;
+	double t_open;
+
+	if (unshare(CLONE_NEWNET) < 0) {
+		/* the exit status automake reports as skipped */
+		printf("cannot create network namespace, skipped\n");
+		return 77;
+	}
+
+	if (ni_init("netns-test") < 0 || !(host_nc = ni_global_state_handle(1)))
+		return 1;
+
+	if ((host = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC)) < 0)
+		return 1;
+
+	if (ni_server_listen_interface_events(interface_event) < 0)
+		return 1;
+
+	ni_test_timer_start(&timer);
+	for (i = 0; i < NNAMESPACES; ++i) {
+		if ((fds[i] = create_netns(host, path, sizeof(path))) < 0) {
+			fprintf(stderr, "cannot create network namespace %u\n", i);
+			return 1;
+		}
+		if (!(nslist[i] = ni_netns_open(path)) ||
+		    !ni_netns_state_handle(nslist[i], 1)) {
+			fprintf(stderr, "%s: cannot open network namespace\n", path);
+			return 1;
+		}
+	}
+	t_open = ni_test_timer_elapsed(&timer);
+
+	if (ni_netns_count() != NNAMESPACES || ni_netns_open("/proc/self/ns/net")) {
+		fprintf(stderr, "unexpected namespace count\n");
+		return 1;
+	}
+	for (i = 0; i < NNAMESPACES; ++i) {
+		ns = nslist[i];
+		nc = ni_netns_state_handle(ns, 0);
+
+		if (ni_netns_id(ns) < 0 || ni_netns_by_id(ni_netns_id(ns)) != ns) {
+			fprintf(stderr, "%s: bad namespace id %d\n", ni_netns_name(ns), ni_netns_id(ns));
+			return 1;
+		}
+		if (!(dev = ni_netdev_by_name(nc, "lo")) || dev->next ||
+		    dev->link.netnsid != ni_netns_id(ns)) {
+			fprintf(stderr, "%s: unexpected devices\n", ni_netns_name(ns));
+			return 1;
+		}
+	}
+	if (!(dev = ni_netdev_by_name(host_nc, "lo")) || dev->link.netnsid != NI_NETNS_ID_NONE) {
+		fprintf(stderr, "own namespace devices tagged\n");
+		return 1;
+	}
+	ni_test_report("%u namespaces opened and discovered in %.3f sec\n",
+			NNAMESPACES, t_open);
+
+	/* create a bridge inside one and wait for its event */
+	if (ni_server_enable_netns_events() < 0)
+		return 1;
+
+	ns = nslist[NNAMESPACES / 2];
+	if (ni_netns_enter(ns) < 0 || __ni_brioctl_add_bridge("nsbr0") < 0) {
+		fprintf(stderr, "cannot create bridge inside namespace\n");
+		return 1;
+	}
+	ni_netns_leave();
+	if (ni_netns_current() || if_nametoindex("nsbr0")) {
+		fprintf(stderr, "not back in own namespace\n");
+		return 1;
+	}
+
+	for (loops = 0; !event_dev && loops < 20; ++loops)
+		ni_socket_wait(100);
+
+	nc = ni_netns_state_handle(ns, 0);
+	if (!event_dev || event_nsid != ni_netns_id(ns) ||
+	    ni_netdev_by_name(nc, "nsbr0") != event_dev ||
+	    ni_netdev_by_name(host_nc, "nsbr0")) {
+		fprintf(stderr, "no event for the bridge in namespace %d\n", ni_netns_id(ns));
+		return 1;
+	}
+
+	ni_server_deactivate_interface_events();
+	ni_netns_close_all();
+	for (i = 0; i < NNAMESPACES; ++i)
+		close(fds[i]);
+	close(host);
+	return 0;
+}
@@ -0,0 +1,286 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if_arp.h>
+#include <linux/rtnetlink.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include <wicked/address.h>
+#include <wicked/route.h>
+#include <wicked/snapshot.h>
+
+#include "netinfo_priv.h"
+#include "appconfig.h"
+#include "buffer.h"
+#include "test-util.h"
+
+extern ni_global_t ni_global;
+
+static ni_netconfig_t *
+build_state(void)
+{
+	ni_netconfig_t *nc = ni_netconfig_new();
+	ni_sockaddr_t addr, gw;
+	ni_netdev_t *dev;
+	ni_route_t *rp;
+
+	dev = ni_test_netdev_new(nc, "eth0", 2);
+	dev->link.type = NI_IFTYPE_ETHERNET;
+	dev->link.mtu = 1500;
+	ni_link_address_parse(&dev->link.hwaddr, ARPHRD_ETHER, "02:00:00:00:00:01");
+
+	ni_sockaddr_parse(&addr, "192.168.1.2", AF_INET);
+	ni_address_new(AF_INET, 24, &addr, &dev->addrs);
+	ni_sockaddr_parse(&addr, "2001:db8::2", AF_INET6);
+	ni_address_new(AF_INET6, 64, &addr, &dev->addrs);
+
+	ni_sockaddr_parse(&gw, "192.168.1.1", AF_INET);
+	rp = ni_route_create(0, NULL, &gw, RT_TABLE_MAIN, NULL);
+	rp->nh.device.index = dev->link.ifindex;
+	ni_netconfig_route_add(nc, rp, dev);
+	ni_route_free(rp);
+
+	ni_test_lease_new(dev, NI_ADDRCONF_DHCP, AF_INET, NULL, 0);
+
+	dev = ni_test_netdev_new(nc, "br0", 3);
+	dev->link.type = NI_IFTYPE_BRIDGE;
+	return nc;
+}
+
+static unsigned int
+count_routes(const ni_netdev_t *dev)
+{
+	const ni_route_table_t *tab;
+	unsigned int count = 0;
+
+	for (tab = dev->routes; tab; tab = tab->next)
+		count += tab->routes.count;
+	return count;
+}
+
+static int
+compare_state(ni_netconfig_t *a, ni_netconfig_t *b)
+{
+	ni_netdev_t *da, *db;
+	const ni_address_t *aa, *ab;
+
+	for (da = ni_netconfig_devlist(a), db = ni_netconfig_devlist(b);
+	     da && db; da = da->next, db = db->next) {
+		if (da->link.ifindex != db->link.ifindex || !ni_string_eq(da->name, db->name) ||
+		    da->link.type != db->link.type || da->link.mtu != db->link.mtu ||
+		    ni_link_address_equal(&da->link.hwaddr, &db->link.hwaddr) == FALSE)
+			return -1;
+
+		for (aa = da->addrs, ab = db->addrs; aa && ab; aa = aa->next, ab = ab->next) {
+			if (aa->prefixlen != ab->prefixlen ||
+			    !ni_sockaddr_equal(&aa->local_addr, &ab->local_addr))
+				return -1;
+		}
+		if (aa || ab)
+			return -1;
+
+		if (count_routes(da) != count_routes(db))
+			return -1;
+
+		if (!da->leases != !db->leases || (da->leases &&
+		    !ni_uuid_equal(&da->leases->uuid, &db->leases->uuid)))
+			return -1;
+	}
+	return da || db ? -1 : 0;
+}
+
+typedef struct feed_result {
+	unsigned int	updates;
+	unsigned int	deletes;
+	unsigned int	leases;
+	uint64_t	generation;
+	ni_bool_t	ordered;
+} feed_result_t;
+
+static void
+feed_count(uint64_t generation, ni_event_t event, unsigned int ifindex,
+		const ni_netdev_t *dev, void *user_data)
+{
+	feed_result_t *res = user_data;
+	const ni_addrconf_lease_t *lease;
+
+	if (generation != res->generation + 1)
+		res->ordered = FALSE;
+	res->generation = generation;
+
+	if (!dev) {
+		res->deletes++;
+		return;
+	}
+	if (dev->link.ifindex == ifindex)
+		res->updates++;
+	for (lease = dev->leases; lease; lease = lease->next)
+		res->leases++;
+}
+
+/*
+ * Device deltas through the state feed: in order delivery, loss
+ * detection when the reader falls behind and on a writer restart.
+ */
+static int
+feed_test(ni_netconfig_t *nc)
+{
+	char path[] = "/tmp/wicked-feed-XXXXXX";
+	ni_state_feed_t *writer = NULL, *reader = NULL;
+	feed_result_t res;
+	ni_netdev_t *dev;
+	unsigned int i;
+	int fd, rv = -1;
+
+	if ((fd = mkstemp(path)) < 0)
+		return -1;
+	close(fd);
+
+	writer = ni_state_feed_create(path, 4096);
+	reader = ni_state_feed_open(path);
+	if (!writer || !reader)
+		goto cleanup;
+
+	memset(&res, 0, sizeof(res));
+	res.ordered = TRUE;
+	for (i = 0; i < 10; ++i) {
+		for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
+			ni_state_feed_append(writer, dev, NI_EVENT_LINK_UP);
+	}
+	dev = ni_netconfig_devlist(nc);
+	ni_state_feed_append(writer, dev, NI_EVENT_DEVICE_DELETE);
+
+	if (ni_state_feed_read(reader, feed_count, &res) != 21 || !res.ordered ||
+	    res.updates != 20 || res.deletes != 1 || res.leases != 10 ||
+	    ni_state_feed_generation(reader) != 21) {
+		fprintf(stderr, "state feed entries differ\n");
+		goto cleanup;
+	}
+	if (ni_state_feed_read(reader, feed_count, &res) != 0) {
+		fprintf(stderr, "state feed entries read twice\n");
+		goto cleanup;
+	}
+
+	/* more than the ring holds */
+	for (i = 0; i < 100; ++i)
+		ni_state_feed_append(writer, dev, NI_EVENT_LINK_DOWN);
+	if (ni_state_feed_read(reader, feed_count, &res) != -1) {
+		fprintf(stderr, "state feed overrun not detected\n");
+		goto cleanup;
+	}
+	ni_state_feed_append(writer, dev, NI_EVENT_LINK_UP);
+	res.generation = ni_state_feed_generation(reader);
+	if (ni_state_feed_read(reader, feed_count, &res) != 1 || !res.ordered) {
+		fprintf(stderr, "state feed not usable after overrun\n");
+		goto cleanup;
+	}
+
+	/* writer restart */
+	ni_state_feed_free(writer);
+	writer = ni_state_feed_create(path, 4096);
+	ni_state_feed_append(writer, dev, NI_EVENT_LINK_UP);
+	if (ni_state_feed_read(reader, feed_count, &res) != -1) {
+		fprintf(stderr, "state feed restart not detected\n");
+		goto cleanup;
+	}
+	rv = 0;
+
+cleanup:
+	ni_state_feed_free(reader);
+	ni_state_feed_free(writer);
+	unlink(path);
+	return rv;
+}
+
+int main(int argc, char **argv)
+{
+	char path[] = "/tmp/wicked-snapshot-XXXXXX";
+	ni_netconfig_t *nc, *copy = NULL;
+	ni_state_snapshot_t *writer, *reader;
+	ni_buffer_t buf;
+	int fd, rv = 1;
+
+	ni_global.config = ni_config_new();
+
+	/* offline format round trip */
+	nc = build_state();
+	ni_buffer_init_dynamic(&buf, 64);
+	if (ni_state_snapshot_encode(&buf, nc) < 0)
+		goto done;
+	if (!(copy = ni_state_snapshot_decode(ni_buffer_head(&buf), ni_buffer_count(&buf))))
+		goto done;
+	if (compare_state(nc, copy) < 0) {
+		fprintf(stderr, "decoded state differs\n");
+		goto done;
+	}
+	ni_netconfig_free(copy);
+	copy = NULL;
+
+	/* truncated payload is rejected */
+	if ((copy = ni_state_snapshot_decode(ni_buffer_head(&buf), ni_buffer_count(&buf) - 3))) {
+		fprintf(stderr, "truncated snapshot accepted\n");
+		goto done;
+	}
+
+	/* shared file publish and read */
+	if ((fd = mkstemp(path)) < 0)
+		goto done;
+	close(fd);
+
+	writer = ni_state_snapshot_create(path);
+	reader = ni_state_snapshot_open(path);
+	if (!writer || !reader)
+		goto cleanup;
+
+	/* routes are published only while they are tracked */
+	if (ni_state_snapshot_publish(writer, nc) < 0 ||
+	    ni_state_snapshot_read(reader, &copy) != 1 ||
+	    ni_state_snapshot_has_routes(reader) ||
+	    count_routes(ni_netconfig_devlist(copy))) {
+		fprintf(stderr, "untracked routes published\n");
+		goto cleanup;
+	}
+
+	ni_state_snapshot_track_routes(TRUE);
+	if (ni_state_snapshot_publish(writer, nc) < 0 ||
+	    ni_state_snapshot_read(reader, &copy) != 1 ||
+	    !ni_state_snapshot_has_routes(reader) ||
+	    compare_state(nc, copy) < 0) {
+		fprintf(stderr, "published state differs\n");
+		goto cleanup;
+	}
+	if (ni_state_snapshot_read(reader, &copy) != 0) {
+		fprintf(stderr, "unchanged snapshot decoded again\n");
+		goto cleanup;
+	}
+	if (ni_state_snapshot_publish(writer, nc) < 0 ||
+	    ni_state_snapshot_read(reader, &copy) != 1 ||
+	    ni_state_snapshot_generation(reader) != 3) {
+		fprintf(stderr, "snapshot update not seen\n");
+		goto cleanup;
+	}
+
+	if (feed_test(nc) < 0)
+		goto cleanup;
+
+	printf("state snapshot: %u bytes, generation %llu\n", ni_buffer_count(&buf),
+			(unsigned long long)ni_state_snapshot_generation(reader));
+	rv = 0;
+
+cleanup:
+	ni_state_snapshot_free(reader);
+	ni_state_snapshot_free(writer);
+	unlink(path);
+done:
+	if (copy)
+		ni_netconfig_free(copy);
+	ni_netconfig_free(nc);
+	ni_buffer_destroy(&buf);
+	ni_config_free(ni_global.config);
+	return rv;
+}
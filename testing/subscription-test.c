@@ -0,0 +1,182 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <linux/rtnetlink.h>
+
+#include <wicked/util.h>
+#include <wicked/netinfo.h>
+#include <wicked/address.h>
+#include <wicked/route.h>
+#include <wicked/dbus.h>
+
+#include "util_priv.h"
+#include "dbus-objects/model.h"
+
+/*
+ * Parse subscription filters from dicts as sent by the clients and
+ * check them against synthetic address and route changes.
+ */
+#define NFILTERS	1024
+#define NROUTES		20000
+
+static int
+filter_parse(ni_objectmodel_subscription_filter_t *filter, const char *kind,
+		unsigned int family, unsigned int ifindex, unsigned int table,
+		const char *prefix)
+{
+	ni_dbus_variant_t dict = NI_DBUS_VARIANT_INIT;
+	dbus_bool_t rv;
+
+	ni_dbus_variant_init_dict(&dict);
+	if (kind)
+		ni_dbus_dict_add_string(&dict, "kind", kind);
+	if (family)
+		ni_dbus_dict_add_uint32(&dict, "family", family);
+	if (ifindex)
+		ni_dbus_dict_add_uint32(&dict, "ifindex", ifindex);
+	if (table)
+		ni_dbus_dict_add_uint32(&dict, "table", table);
+	if (prefix)
+		ni_dbus_dict_add_string(&dict, "prefix", prefix);
+
+	rv = ni_objectmodel_subscription_filter_parse(filter, &dict, NULL);
+	ni_dbus_variant_destroy(&dict);
+	return rv ? 0 : -1;
+}
+
+static ni_route_t *
+route_make(const char *dest, unsigned int table, unsigned int ifindex)
+{
+	ni_sockaddr_t sa;
+	unsigned int len;
+	ni_route_t *rp;
+
+	if (!ni_sockaddr_prefix_parse(dest, &sa, &len))
+		return NULL;
+	if (!(rp = ni_route_create(len, &sa, NULL, table, NULL)))
+		return NULL;
+	rp->nh.device.index = ifindex;
+	return rp;
+}
+
+static int
+check_route(const char *kind, unsigned int family, unsigned int ifindex,
+		unsigned int table, const char *prefix, const ni_route_t *rp,
+		ni_bool_t expect)
+{
+	ni_objectmodel_subscription_filter_t filter;
+
+	if (filter_parse(&filter, kind, family, ifindex, table, prefix) < 0) {
+		fprintf(stderr, "filter %s %s: parse failed\n", kind, prefix);
+		return -1;
+	}
+	if (ni_objectmodel_subscription_match_route(&filter, rp) != expect) {
+		fprintf(stderr, "filter %s %s: unexpected route match result\n",
+				kind, prefix);
+		return -1;
+	}
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_objectmodel_subscription_filter_t filter, *filters;
+	ni_route_t *rp, *rp6, **routes;
+	ni_netdev_t *dev;
+	ni_address_t *ap;
+	struct timespec start, end;
+	unsigned int i, j, matches = 0;
+	ni_sockaddr_t sa;
+	char buf[64];
+
+	/* invalid filters */
+	if (filter_parse(&filter, NULL, 0, 0, 0, NULL) == 0 ||
+	    filter_parse(&filter, "links", 0, 0, 0, NULL) == 0 ||
+	    filter_parse(&filter, "routes", 99, 0, 0, NULL) == 0 ||
+	    filter_parse(&filter, "routes", AF_INET6, 0, 0, "10.0.0.0/8") == 0) {
+		fprintf(stderr, "invalid filter accepted\n");
+		return 1;
+	}
+
+	rp = route_make("10.1.2.0/24", RT_TABLE_MAIN, 3);
+	rp6 = route_make("2001:db8::/64", 100, 4);
+	if (!rp || !rp6)
+		return 1;
+
+	if (check_route("routes", 0, 0, 0, NULL, rp, TRUE) < 0 ||
+	    check_route("addresses", 0, 0, 0, NULL, rp, FALSE) < 0 ||
+	    check_route("routes", AF_INET6, 0, 0, NULL, rp, FALSE) < 0 ||
+	    check_route("routes", 0, 3, 0, NULL, rp, TRUE) < 0 ||
+	    check_route("routes", 0, 4, 0, NULL, rp, FALSE) < 0 ||
+	    check_route("routes", 0, 0, 100, NULL, rp6, TRUE) < 0 ||
+	    check_route("routes", 0, 0, RT_TABLE_MAIN, NULL, rp6, FALSE) < 0 ||
+	    check_route("routes", 0, 0, 0, "10.0.0.0/8", rp, TRUE) < 0 ||
+	    check_route("routes", 0, 0, 0, "10.1.2.0/25", rp, FALSE) < 0 ||
+	    check_route("routes", 0, 0, 0, "10.2.0.0/16", rp, FALSE) < 0 ||
+	    check_route("routes", 0, 0, 0, "2001:db8::/32", rp6, TRUE) < 0 ||
+	    check_route("routes", 0, 0, 0, "2001:db8::/32", rp, FALSE) < 0)
+		return 1;
+
+	dev = ni_netdev_new("eth0", 3);
+	ni_sockaddr_parse(&sa, "192.168.1.5", AF_INET);
+	ap = ni_address_new(AF_INET, 24, &sa, NULL);
+	if (filter_parse(&filter, "addresses", 0, 3, 0, "192.168.0.0/16") < 0 ||
+	    !ni_objectmodel_subscription_match_address(&filter, dev, ap) ||
+	    filter_parse(&filter, "addresses", 0, 0, 0, "192.168.2.0/24") < 0 ||
+	    ni_objectmodel_subscription_match_address(&filter, dev, ap) ||
+	    filter_parse(&filter, "addresses", 0, 4, 0, NULL) < 0 ||
+	    ni_objectmodel_subscription_match_address(&filter, dev, ap) ||
+	    filter_parse(&filter, "routes", 0, 0, 0, NULL) < 0 ||
+	    ni_objectmodel_subscription_match_address(&filter, dev, ap)) {
+		fprintf(stderr, "unexpected address match result\n");
+		return 1;
+	}
+
+	/* filters watch a /16 in various tables; each route event matches two */
+	filters = xcalloc(NFILTERS, sizeof(filters[0]));
+	for (i = 0; i < NFILTERS; ++i) {
+		snprintf(buf, sizeof(buf), "10.%u.0.0/16", i % 256);
+		if (filter_parse(&filters[i], "routes", 0, 0, i < 256 ? 0 :
+				i < 512 ? RT_TABLE_MAIN : RT_TABLE_MAIN + i / 256, buf) < 0)
+			return 1;
+	}
+	routes = xcalloc(NROUTES, sizeof(routes[0]));
+	for (i = 0; i < NROUTES; ++i) {
+		snprintf(buf, sizeof(buf), "10.%u.%u.0/24", i % 256, (i / 256) % 256);
+		if (!(routes[i] = route_make(buf, RT_TABLE_MAIN, 1 + i % 8)))
+			return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < NROUTES; ++i) {
+		for (j = 0; j < NFILTERS; ++j) {
+			if (ni_objectmodel_subscription_match_route(&filters[j], routes[i]))
+				matches++;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (matches != NROUTES * 2) {
+		fprintf(stderr, "%u matches, expected %u\n", matches, NROUTES * 2);
+		return 1;
+	}
+	printf("%u route events against %u filters in %.3f sec\n", NROUTES, NFILTERS,
+			(end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9);
+
+	for (i = 0; i < NROUTES; ++i)
+		ni_route_free(routes[i]);
+	free(routes);
+	free(filters);
+	ni_route_free(rp);
+	ni_route_free(rp6);
+	ni_address_free(ap);
+	ni_netdev_put(dev);
+	return 0;
+}
@@ -0,0 +1,210 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netlink/msg.h>
+#include <linux/rtnetlink.h>
+
+#include <wicked/util.h>
+#include <wicked/netinfo.h>
+#include <wicked/system.h>
+#include <wicked/route.h>
+
+#include "netinfo_priv.h"
+#include "kernel.h"
+#include "sysfs.h"
+#include "test-util.h"
+
+/*
+ * Create bridges in a private network namespace and delete them once
+ * one by one and once in a single batch, then flush a few thousand
+ * routes from a device; WICKED_TEST_VERBOSE reports the time taken.
+ * Needs the privileges to create a network namespace; skipped otherwise.
+ */
+#define NDEVICES	200
+#define NROUTES		5000
+
+static int
+create_bridges(ni_netconfig_t *nc, const char *prefix, ni_uint_array_t *ifindexes)
+{
+	ni_netdev_t *dev;
+	unsigned int i;
+	char name[IFNAMSIZ];
+
+	for (i = 0; i < NDEVICES; ++i) {
+		snprintf(name, sizeof(name), "%s%u", prefix, i);
+		if (ni_system_bridge_create(nc, name, NULL, &dev) < 0 || !dev) {
+			fprintf(stderr, "%s: cannot create bridge\n", name);
+			return -1;
+		}
+		ni_uint_array_append(ifindexes, dev->link.ifindex);
+	}
+	return 0;
+}
+
+static unsigned int
+count_devices(ni_netconfig_t *nc, const ni_uint_array_t *ifindexes)
+{
+	unsigned int i, count = 0;
+
+	__ni_system_refresh_interfaces(nc);
+	for (i = 0; i < ifindexes->count; ++i) {
+		if (ni_netdev_by_index(nc, ifindexes->data[i]))
+			count++;
+	}
+	return count;
+}
+
+static struct nl_msg *
+link_up_msg(unsigned int ifindex)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = ifindex;
+	ifi.ifi_flags = IFF_UP;
+	ifi.ifi_change = IFF_UP;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, 0);
+	nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO);
+	return msg;
+}
+
+static struct nl_msg *
+route_msg(unsigned int ifindex, unsigned int n)
+{
+	struct rtmsg rt;
+	struct nl_msg *msg;
+	uint32_t dst = htonl(0x0a000000 | (n << 8));
+
+	memset(&rt, 0, sizeof(rt));
+	rt.rtm_family = AF_INET;
+	rt.rtm_table = RT_TABLE_MAIN;
+	rt.rtm_protocol = RTPROT_BOOT;
+	rt.rtm_scope = RT_SCOPE_LINK;
+	rt.rtm_type = RTN_UNICAST;
+	rt.rtm_dst_len = 24;
+
+	msg = nlmsg_alloc_simple(RTM_NEWROUTE, NLM_F_CREATE | NLM_F_EXCL);
+	nlmsg_append(msg, &rt, sizeof(rt), NLMSG_ALIGNTO);
+	nla_put(msg, RTA_DST, sizeof(dst), &dst);
+	nla_put_u32(msg, RTA_OIF, ifindex);
+	return msg;
+}
+
+static int
+flush_routes(ni_netconfig_t *nc)
+{
+	struct nl_msg **msgs;
+	ni_test_timer_t timer;
+	ni_route_table_t *tab;
+	double t_flush;
+	ni_netdev_t *dev;
+	unsigned int i;
+	int rv;
+
+	if (ni_system_bridge_create(nc, "tdr0", NULL, &dev) < 0 || !dev)
+		return -1;
+
+	/* no kernel managed ipv6 link-local routes */
+	ni_sysctl_ipv6_ifconfig_set_uint(dev->name, "disable_ipv6", 1);
+
+	msgs = calloc(NROUTES, sizeof(msgs[0]));
+	msgs[0] = link_up_msg(dev->link.ifindex);
+	rv = ni_nl_talk_batch(msgs, 1, NULL);
+	nlmsg_free(msgs[0]);
+	if (rv != 0) {
+		fprintf(stderr, "%s: cannot set link up\n", dev->name);
+		return -1;
+	}
+
+	for (i = 0; i < NROUTES; ++i)
+		msgs[i] = route_msg(dev->link.ifindex, i);
+	rv = ni_nl_talk_batch(msgs, NROUTES, NULL);
+	for (i = 0; i < NROUTES; ++i)
+		nlmsg_free(msgs[i]);
+	free(msgs);
+	if (rv != 0) {
+		fprintf(stderr, "%s: cannot add routes\n", dev->name);
+		return -1;
+	}
+
+	ni_test_timer_start(&timer);
+	__ni_system_interface_flush_routes(nc, dev);
+	t_flush = ni_test_timer_elapsed(&timer);
+
+	for (rv = 0, tab = dev->routes; tab; tab = tab->next) {
+		for (i = 0; i < tab->routes.count; ++i)
+			rv += tab->routes.data[i] != NULL;
+	}
+	if (rv != 0) {
+		fprintf(stderr, "%s: routes left after flush\n", dev->name);
+		return -1;
+	}
+
+	ni_test_report("%u routes flushed in %.3f sec\n", NROUTES, t_flush);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_uint_array_t single = NI_UINT_ARRAY_INIT;
+	ni_uint_array_t batch = NI_UINT_ARRAY_INIT;
+	ni_uint_array_t deleted = NI_UINT_ARRAY_INIT;
+	ni_test_timer_t timer;
+	ni_netconfig_t *nc;
+	ni_netdev_t *dev;
+	double t_single, t_batch;
+	unsigned int i;
+
+	if (unshare(CLONE_NEWNET) < 0) {
+		/* the exit status automake reports as skipped */
+		printf("cannot create network namespace, skipped\n");
+		return 77;
+	}
+
+	if (ni_init("teardown-test") < 0 || !(nc = ni_global_state_handle(1)))
+		return 1;
+
+	if (create_bridges(nc, "tds", &single) < 0 ||
+	    create_bridges(nc, "tdb", &batch) < 0)
+		return 1;
+
+	ni_test_timer_start(&timer);
+	for (i = 0; i < single.count; ++i) {
+		if (!(dev = ni_netdev_by_index(nc, single.data[i])) ||
+		    ni_system_bridge_delete(nc, dev) < 0)
+			return 1;
+	}
+	t_single = ni_test_timer_elapsed(&timer);
+
+	ni_test_timer_start(&timer);
+	if (ni_system_interfaces_delete(nc, &batch, &deleted) != NDEVICES)
+		return 1;
+	t_batch = ni_test_timer_elapsed(&timer);
+
+	if (deleted.count != NDEVICES ||
+	    count_devices(nc, &single) || count_devices(nc, &batch)) {
+		fprintf(stderr, "devices left after delete\n");
+		return 1;
+	}
+
+	ni_test_report("%u bridges: %.3f sec one by one, %.3f sec in one batch\n",
+			NDEVICES, t_single, t_batch);
+
+	if (flush_routes(nc) < 0)
+		return 1;
+
+	ni_uint_array_destroy(&deleted);
+	ni_uint_array_destroy(&batch);
+	ni_uint_array_destroy(&single);
+	return 0;
+}
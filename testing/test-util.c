@@ -0,0 +1,104 @@
+/*
+ *	Helpers shared by the test programs
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include <wicked/util.h>
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include <wicked/address.h>
+#include <wicked/socket.h>
+
+#include "netinfo_priv.h"
+#include "test-util.h"
+
+void
+ni_test_timer_start(ni_test_timer_t *timer)
+{
+	clock_gettime(CLOCK_MONOTONIC, &timer->start);
+}
+
+/*
+ * Returns the seconds since the timer was started
+ */
+double
+ni_test_timer_elapsed(const ni_test_timer_t *timer)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - timer->start.tv_sec) +
+		(now.tv_nsec - timer->start.tv_nsec) / 1e9;
+}
+
+ni_bool_t
+ni_test_verbose(void)
+{
+	return !ni_string_empty(getenv("WICKED_TEST_VERBOSE"));
+}
+
+void
+ni_test_report(const char *fmt, ...)
+{
+	va_list ap;
+
+	if (!ni_test_verbose())
+		return;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+}
+
+/*
+ * A device appended to the netconfig
+ */
+ni_netdev_t *
+ni_test_netdev_new(ni_netconfig_t *nc, const char *name, unsigned int ifindex)
+{
+	ni_netdev_t *dev;
+
+	dev = ni_netdev_new(name, ifindex);
+	ni_netconfig_device_append(nc, dev);
+	return dev;
+}
+
+/*
+ * A granted lease of the device, with an address when given
+ */
+ni_addrconf_lease_t *
+ni_test_lease_new(ni_netdev_t *dev, int type, int family,
+		const ni_sockaddr_t *addr, unsigned int prefixlen)
+{
+	ni_addrconf_lease_t *lease;
+
+	lease = ni_addrconf_lease_new(type, family);
+	lease->state = NI_ADDRCONF_STATE_GRANTED;
+	ni_uuid_generate(&lease->uuid);
+	ni_timer_get_time(&lease->acquired);
+	if (addr)
+		ni_address_new(family, prefixlen, addr, &lease->addrs);
+
+	ni_netdev_set_lease(dev, lease);
+	return lease;
+}
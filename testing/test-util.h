@@ -0,0 +1,49 @@
+/*
+ *	Helpers shared by the test programs
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __WICKED_TESTING_TEST_UTIL_H__
+#define __WICKED_TESTING_TEST_UTIL_H__
+
+#include <time.h>
+
+#include <wicked/types.h>
+
+typedef struct ni_test_timer {
+	struct timespec		start;
+} ni_test_timer_t;
+
+extern void			ni_test_timer_start(ni_test_timer_t *);
+extern double			ni_test_timer_elapsed(const ni_test_timer_t *);
+
+/*
+ * Timings are reported only with WICKED_TEST_VERBOSE set in the
+ * environment; the tests pass or fail on their checks alone.
+ */
+extern ni_bool_t		ni_test_verbose(void);
+extern void			ni_test_report(const char *, ...)
+					__attribute__ ((format (printf, 1, 2)));
+
+/*
+ * Fixtures
+ */
+extern ni_netdev_t *		ni_test_netdev_new(ni_netconfig_t *, const char *,
+						unsigned int);
+extern ni_addrconf_lease_t *	ni_test_lease_new(ni_netdev_t *, int, int,
+						const ni_sockaddr_t *, unsigned int);
+
+#endif /* __WICKED_TESTING_TEST_UTIL_H__ */
@@ -0,0 +1,205 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <wicked/util.h>
+#include <wicked/xml.h>
+
+#include "xml-cache.h"
+#include "test-util.h"
+
+/*
+ * Compare documents read from the cache with the parsed ones.
+ * With WICKED_TEST_VERBOSE set, time both, also for further xml
+ * files passed as arguments.
+ */
+#define ROUNDS		200
+
+static char		tempdir[] = "/tmp/xml-cache-test.XXXXXX";
+
+static int
+write_document(const char *filename, unsigned int count, const char *tag)
+{
+	unsigned int i;
+	FILE *fp;
+
+	if (!(fp = fopen(filename, "w")))
+		return -1;
+
+	fprintf(fp, "<config>\n  <!-- generated -->\n");
+	for (i = 0; i < count; ++i) {
+		fprintf(fp, "  <%s name=\"ext%u\" index=\"%u\">\n", tag, i, i);
+		fprintf(fp, "    <script name=\"up\" command=\"/usr/lib/ext%u &amp; up\"/>\n", i);
+		fprintf(fp, "    <description>extension %u</description>\n", i);
+		fprintf(fp, "    <empty/>\n");
+		fprintf(fp, "  </%s>\n", tag);
+	}
+	fprintf(fp, "</config>\n");
+	return fclose(fp);
+}
+
+static char *
+document_dump(const xml_document_t *doc)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	const xml_node_t *node;
+
+	/* the content plus the location of the nodes on the first level */
+	ni_stringbuf_puts(&buf, xml_document_sprint(doc));
+	node = xml_node_get_child(doc->root, "config");
+	for (node = node ? node->children : NULL; node; node = node->next)
+		ni_stringbuf_printf(&buf, "%s\n", xml_node_location(node));
+	return buf.string;
+}
+
+static int
+compare(const char *filename, const char *what)
+{
+	xml_document_t *parsed, *cached;
+	char *a, *b;
+	int rv = 0;
+
+	parsed = xml_document_read(filename);
+	cached = xml_document_read_cached(filename);
+	if (!parsed || !cached) {
+		fprintf(stderr, "%s: %s: unable to read document\n", filename, what);
+		rv = -1;
+	} else {
+		a = document_dump(parsed);
+		b = document_dump(cached);
+		if (!ni_string_eq(a, b)) {
+			fprintf(stderr, "%s: %s: cached document differs\n", filename, what);
+			rv = -1;
+		}
+		free(a);
+		free(b);
+	}
+	xml_document_free(parsed);
+	xml_document_free(cached);
+	return rv;
+}
+
+static int
+benchmark(const char *filename)
+{
+	ni_test_timer_t timer;
+	xml_document_t *doc;
+	double parsed;
+	unsigned int i;
+
+	/* make sure the image exists */
+	xml_document_free(xml_document_read_cached(filename));
+
+	ni_test_timer_start(&timer);
+	for (i = 0; i < ROUNDS; ++i) {
+		if (!(doc = xml_document_read(filename)))
+			return -1;
+		xml_document_free(doc);
+	}
+	parsed = ni_test_timer_elapsed(&timer);
+
+	ni_test_timer_start(&timer);
+	for (i = 0; i < ROUNDS; ++i) {
+		if (!(doc = xml_document_read_cached(filename)))
+			return -1;
+		xml_document_free(doc);
+	}
+
+	ni_test_report("%s: parsed %.1f usec, cached %.1f usec\n", filename,
+			parsed * 1e6 / ROUNDS,
+			ni_test_timer_elapsed(&timer) * 1e6 / ROUNDS);
+	return 0;
+}
+
+static void
+cleanup(void)
+{
+	char path[PATH_MAX];
+	struct dirent *dp;
+	DIR *dir;
+
+	snprintf(path, sizeof(path), "%s/cache", tempdir);
+	if ((dir = opendir(path))) {
+		while ((dp = readdir(dir))) {
+			if (dp->d_name[0] == '.')
+				continue;
+			snprintf(path, sizeof(path), "%s/cache/%s", tempdir, dp->d_name);
+			unlink(path);
+		}
+		closedir(dir);
+	}
+	snprintf(path, sizeof(path), "%s/cache", tempdir);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/test.xml", tempdir);
+	unlink(path);
+	rmdir(tempdir);
+}
+
+int
+main(int argc, char **argv)
+{
+	char filename[PATH_MAX], cachedir[PATH_MAX];
+	char *image = NULL;
+	struct dirent *dp;
+	int i, rv = 1;
+	DIR *dir;
+	FILE *fp;
+
+	if (!mkdtemp(tempdir)) {
+		perror(tempdir);
+		return 1;
+	}
+	snprintf(filename, sizeof(filename), "%s/test.xml", tempdir);
+	snprintf(cachedir, sizeof(cachedir), "%s/cache", tempdir);
+	xml_document_cache_set_dir(cachedir);
+
+	if (write_document(filename, 500, "extension") < 0 ||
+	    compare(filename, "first read") < 0 ||
+	    compare(filename, "cached read") < 0)
+		goto done;
+
+	/* a changed file has to invalidate the image */
+	if (write_document(filename, 300, "updater") < 0 ||
+	    compare(filename, "changed file") < 0)
+		goto done;
+
+	/* as well as a damaged image */
+	if (!(dir = opendir(cachedir)))
+		goto done;
+	while ((dp = readdir(dir))) {
+		if (dp->d_name[0] == '.')
+			continue;
+		ni_string_printf(&image, "%s/%s", cachedir, dp->d_name);
+		if (truncate(image, 1000) < 0 || !(fp = fopen(image, "a"))) {
+			ni_string_free(&image);
+			closedir(dir);
+			goto done;
+		}
+		fprintf(fp, "garbage");
+		fclose(fp);
+	}
+	ni_string_free(&image);
+	closedir(dir);
+	if (compare(filename, "damaged image") < 0 ||
+	    compare(filename, "rewritten image") < 0)
+		goto done;
+
+	if (ni_test_verbose()) {
+		if (benchmark(filename) < 0)
+			goto done;
+		for (i = 1; i < argc; ++i) {
+			if (benchmark(argv[i]) < 0)
+				goto done;
+		}
+	}
+	rv = 0;
+
+done:
+	cleanup();
+	return rv;
+}